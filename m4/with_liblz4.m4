@@ -0,0 +1,79 @@
+
+#
+# Copyright (C) 1994-2018 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# PBS Pro is free software. You can redistribute it and/or modify it under the
+# terms of the GNU Affero General Public License as published by the Free
+# Software Foundation, either version 3 of the License, or (at your option) any
+# later version.
+#
+# PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY
+# WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE.
+# See the GNU Affero General Public License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# For a copy of the commercial license terms and conditions,
+# go to: (http://www.pbspro.com/UserArea/agreement.html)
+# or contact the Altair Legal Department.
+#
+# Altair’s dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of PBS Pro and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair’s trademarks, including but not limited to "PBS™",
+# "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's
+# trademark licensing policies.
+#
+AC_DEFUN([PBS_AC_WITH_LIBLZ4],
+[
+  AC_ARG_WITH([liblz4],
+    AS_HELP_STRING([--with-liblz4@<:@=DIR@:>@],
+      [Enable the LZ4 codec for TPP compression, optionally specifying the directory where liblz4 is installed.]
+    ),
+    [],
+    [with_liblz4=no]
+  )
+  liblz4_inc=""
+  liblz4_lib=""
+  AC_MSG_CHECKING([for liblz4])
+  AS_IF([test "x$with_liblz4" = "xno"],
+    AC_MSG_RESULT([no]),
+    [
+    AS_IF([test "x$with_liblz4" = "xyes"],
+      # Using system installed liblz4
+      AS_IF([test -r "/usr/include/lz4.h"],
+        [liblz4_lib="-llz4"],
+        AC_MSG_ERROR([liblz4 headers not found.])
+      ),
+
+      # Using developer installed liblz4
+      AS_IF([test -r "$with_liblz4/include/lz4.h"],
+        [liblz4_inc="-I$with_liblz4/include"],
+        AC_MSG_ERROR([liblz4 headers not found.])
+      )
+      AS_IF([test -r "${with_liblz4}/lib64/liblz4.a"],
+        [liblz4_lib="${with_liblz4}/lib64/liblz4.a"],
+        AS_IF([test -r "${with_liblz4}/lib/liblz4.a"],
+          [liblz4_lib="${with_liblz4}/lib/liblz4.a"],
+          AC_MSG_ERROR([liblz4 not found.])
+        )
+      )
+    )
+    AC_MSG_RESULT([$with_liblz4])
+    AC_DEFINE([PBS_COMPRESSION_LZ4], [], [Defined when liblz4 is available])
+    ]
+  )
+  AC_SUBST(liblz4_inc)
+  AC_SUBST(liblz4_lib)
+])
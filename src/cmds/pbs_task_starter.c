@@ -0,0 +1,674 @@
+/*
+ * Copyright (C) 1994-2018 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * PBS Pro is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * For a copy of the commercial license terms and conditions,
+ * go to: (http://www.pbspro.com/UserArea/agreement.html)
+ * or contact the Altair Legal Department.
+ *
+ * Altair’s dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of PBS Pro and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair’s trademarks, including but not limited to "PBS™",
+ * "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's
+ * trademark licensing policies.
+ *
+ */
+
+/**
+ * @file pbs_task_starter.c
+ * @brief
+ * pbs_task_starter - start job tasks for MoM
+ *
+ *	MoM runs this program once and keeps it running.  The tasks of a
+ *	job are then forked from this small process instead of from MoM,
+ *	whose size makes each fork slow.  MoM prepares everything that needs
+ *	its job table and sends a ts_request_t, see task_starter.h.  Here
+ *	the child only sets the session, limits, temporary directory, user,
+ *	directory and standard files, connecting them to pbs_demux if asked,
+ *	and execs the program.  The exit of each task is
+ *	reported back to MoM.  When MoM closes the socket, or sends a bad
+ *	request, the starter takes no more requests but stays until the
+ *	tasks it started have exited, reporting them as long as MoM reads
+ *	the socket.  Its tasks are never left without a parent that waits
+ *	for them.
+ */
+
+#include <pbs_config.h>   /* the master config generated by configure */
+#include <pbs_version.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <grp.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "cmds.h"
+#include "server_limits.h"
+#include "task_starter.h"
+
+extern char **environ;
+
+static int	sock = -1;		/* connection to MoM, -1 once MoM is gone */
+static int	reading = 1;		/* still taking requests from MoM */
+static int	ntasks = 0;		/* tasks started and not yet reaped */
+static int	sigpipe[2] = {-1, -1};	/* written to by the SIGCHLD handler */
+
+/**
+ * @brief
+ *	SIGCHLD handler, wake up the main loop
+ *
+ * @param[in] sig - signal number
+ *
+ * @return	void
+ */
+static void
+catch_child(int sig)
+{
+	int	save = errno;
+
+	(void)write(sigpipe[1], "", 1);
+	errno = save;
+}
+
+/**
+ * @brief
+ *	Read exactly len bytes
+ *
+ * @param[in]  fd  - file descriptor
+ * @param[out] buf - buffer
+ * @param[in]  len - number of bytes
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	error or end of file
+ */
+static int
+read_all(int fd, void *buf, size_t len)
+{
+	char	*p = buf;
+	ssize_t	 n;
+
+	while (len > 0) {
+		n = read(fd, p, len);
+		if (n == -1 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return -1;
+		p += n;
+		len -= n;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *	Send a message to MoM.  If MoM is gone the message is dropped and
+ *	the socket closed, the tasks are still reaped.
+ *
+ * @param[in] type   - TS_STARTED, TS_FAILED or TS_EXITED
+ * @param[in] pid    - process id
+ * @param[in] status - errno or wait status
+ * @param[in] stage  - TS_STAGE_* for TS_FAILED
+ *
+ * @return	void
+ */
+static void
+send_reply(int type, pid_t pid, int status, int stage)
+{
+	ts_reply_t	 rp;
+	char		*p = (char *)&rp;
+	size_t		 len = sizeof(rp);
+	ssize_t		 n;
+
+	memset(&rp, 0, sizeof(rp));
+	rp.tp_type = type;
+	rp.tp_pid = pid;
+	rp.tp_status = status;
+	rp.tp_stage = stage;
+	while ((len > 0) && (sock != -1)) {
+		n = write(sock, p, len);
+		if (n == -1 && errno == EINTR)
+			continue;
+		if (n <= 0) {
+			/* MoM is gone */
+			(void)close(sock);
+			sock = -1;
+			reading = 0;
+			return;
+		}
+		p += n;
+		len -= n;
+	}
+}
+
+/**
+ * @brief
+ *	Reap the tasks that have exited and tell MoM
+ *
+ * @return	void
+ */
+static void
+reap_tasks(void)
+{
+	pid_t	pid;
+	int	status;
+	char	buf[64];
+
+	while (read(sigpipe[0], buf, sizeof(buf)) > 0)
+		;
+	while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+		if (ntasks > 0)
+			ntasks--;
+		send_reply(TS_EXITED, pid, status, 0);
+	}
+}
+
+/**
+ * @brief
+ *	Become the user, as becomeuser_args() does in MoM
+ *
+ * @param[in] user - user name
+ * @param[in] uid  - user id
+ * @param[in] gid  - group id
+ * @param[in] rgid - login group, added to the supplementary groups
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	failure
+ */
+static int
+become_user(char *user, uid_t uid, gid_t gid, gid_t rgid)
+{
+	gid_t	*grplist;
+	long	 maxgroups;
+	int	 numsup;
+	int	 i;
+
+	if (initgroups(user, gid) == -1)
+		return -1;
+	maxgroups = sysconf(_SC_NGROUPS_MAX);
+	if ((grplist = calloc((size_t)maxgroups + 1, sizeof(gid_t))) == NULL)
+		return -1;
+	numsup = getgroups((int)maxgroups, grplist);
+	for (i = 0; i < numsup; i++) {
+		if (grplist[i] == rgid)
+			break;
+	}
+	if (i == numsup) {
+		if (numsup == maxgroups) {
+			free(grplist);
+			errno = EINVAL;
+			return -1;
+		}
+		grplist[numsup++] = rgid;
+	}
+	if ((setgroups((size_t)numsup, grplist) == -1) ||
+		(setgid(gid) == -1) ||
+		(setuid(uid) == -1)) {
+		free(grplist);
+		return -1;
+	}
+	free(grplist);
+	return 0;
+}
+
+/**
+ * @brief
+ *	Make the temporary directory of the job, as mktmpdir() does in MoM
+ *
+ * @param[in] tmpdir - the directory
+ * @param[in] uid    - user id
+ * @param[in] gid    - group id
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	failure, errno is EEXIST if the directory is not ours
+ */
+static int
+make_tmpdir(char *tmpdir, uid_t uid, gid_t gid)
+{
+	struct stat	sb;
+
+	if (mkdir(tmpdir, 0700) == -1) {
+		if (errno != EEXIST)
+			return -1;
+		if (lstat(tmpdir, &sb) == -1)
+			return -1;
+		if (!S_ISDIR(sb.st_mode) ||
+			!((sb.st_uid == uid || sb.st_uid == 0) &&
+			(sb.st_gid == gid || sb.st_gid == 0))) {
+			errno = EEXIST;
+			return -1;
+		}
+	}
+	/* umask affects mkdir() */
+	if ((chmod(tmpdir, 0700) == -1) || (chown(tmpdir, uid, gid) == -1))
+		return -1;
+	return 0;
+}
+
+/**
+ * @brief
+ *	Connect to pbs_demux, as open_demux() does in MoM, and write the
+ *	job cookie
+ *
+ * @param[in] addr   - address of Mother Superior, network order
+ * @param[in] port   - port of pbs_demux
+ * @param[in] cookie - the job cookie
+ *
+ * @return	int
+ * @retval	>=0	the socket
+ * @retval	-1	failure
+ */
+static int
+open_demux(in_addr_t addr, int port, char *cookie)
+{
+	struct sockaddr_in	remote;
+	int			sock;
+	int			i;
+
+	memset(&remote, 0, sizeof(remote));
+	remote.sin_addr.s_addr = addr;
+	remote.sin_port = htons((unsigned short)port);
+	remote.sin_family = AF_INET;
+
+	if ((sock = socket(AF_INET, SOCK_STREAM, 0)) == -1)
+		return -1;
+	for (i = 0; i < 3; i++) {
+		if (connect(sock, (struct sockaddr *)&remote,
+			sizeof(remote)) == 0) {
+			(void)write(sock, cookie, strlen(cookie));
+			return sock;
+		}
+		if ((errno != EINTR) && (errno != EADDRINUSE) &&
+			(errno != ETIMEDOUT) && (errno != ECONNREFUSED))
+			break;
+		sleep(2);
+	}
+	i = errno;
+	(void)close(sock);
+	errno = i;
+	return -1;
+}
+
+/**
+ * @brief
+ *	In the child, set up the task and exec it.  The outcome of the set
+ *	up is written to the status pipe before the exec; if the exec
+ *	itself fails the task exits 254 with a message on its standard
+ *	error, as when MoM starts the task.
+ *
+ * @param[in] rq   - the request
+ * @param[in] strs - the strings of the request, see task_starter.h
+ * @param[in] fds  - standard input, output and error
+ * @param[in] wfd  - write end of the status pipe
+ *
+ * @return	does not return
+ */
+static void
+start_child(ts_request_t *rq, char *strs, int *fds, int wfd)
+{
+	struct sigaction act;
+	struct rlimit	 rl;
+	char		*user;
+	char		*cwd;
+	char		*tmpdir;
+	char		*cookie;
+	char		*prog;
+	char		**argv;
+	char		**envp;
+	char		*p;
+	int		 res[2] = {0, 0};	/* stage, errno */
+	int		 i;
+
+	(void)close(sock);
+	(void)close(sigpipe[0]);
+	(void)close(sigpipe[1]);
+	sigemptyset(&act.sa_mask);
+	act.sa_flags = 0;
+	act.sa_handler = SIG_DFL;
+	(void)sigaction(SIGCHLD, &act, NULL);
+	(void)sigprocmask(SIG_SETMASK, &act.sa_mask, NULL);
+
+	daemon_protect(0, PBS_DAEMON_PROTECT_OFF);
+
+	/* unpack the strings */
+	argv = calloc(rq->tr_argc + 1, sizeof(char *));
+	envp = calloc(rq->tr_envc + 1, sizeof(char *));
+	if ((argv == NULL) || (envp == NULL)) {
+		res[0] = TS_STAGE_FORK;
+		res[1] = ENOMEM;
+		goto fail;
+	}
+	p = strs;
+	user = p;
+	p += strlen(p) + 1;
+	cwd = p;
+	p += strlen(p) + 1;
+	tmpdir = p;
+	p += strlen(p) + 1;
+	cookie = p;
+	p += strlen(p) + 1;
+	prog = p;
+	p += strlen(p) + 1;
+	for (i = 0; i < rq->tr_argc; i++) {
+		argv[i] = p;
+		p += strlen(p) + 1;
+	}
+	for (i = 0; i < rq->tr_envc; i++) {
+		envp[i] = p;
+		p += strlen(p) + 1;
+	}
+
+	if (setsid() == -1) {
+		res[0] = TS_STAGE_SETSID;
+		goto fail;
+	}
+
+	res[0] = TS_STAGE_LIMITS;
+	if (rq->tr_unnice && (setpriority(PRIO_PROCESS, 0, 0) == -1))
+		goto fail;
+	if (rq->tr_nice != 0) {
+		errno = 0;
+		if ((nice(rq->tr_nice) == -1) && (errno != 0))
+			goto fail;
+	}
+	for (i = 0; i < rq->tr_nlimits; i++) {
+		rl.rlim_cur = rl.rlim_max = rq->tr_limits[i].tl_value;
+		if (setrlimit(rq->tr_limits[i].tl_resource, &rl) == -1)
+			goto fail;
+	}
+	(void)umask(rq->tr_umask);
+
+	if ((*tmpdir != '\0') &&
+		(make_tmpdir(tmpdir, rq->tr_uid, rq->tr_gid) == -1)) {
+		res[0] = TS_STAGE_TMPDIR;
+		goto fail;
+	}
+
+	if (become_user(user, rq->tr_uid, rq->tr_gid, rq->tr_rgid) == -1) {
+		res[0] = TS_STAGE_USER;
+		goto fail;
+	}
+	if (chdir(cwd) == -1) {
+		res[0] = TS_STAGE_CHDIR;
+		goto fail;
+	}
+
+	res[0] = TS_STAGE_FDS;
+	if (rq->tr_demux_addr != 0) {
+		/* replaces the standard output and error MoM passed */
+		for (i = 1; i < TS_NFDS; i++) {
+			(void)close(fds[i]);
+			fds[i] = open_demux(rq->tr_demux_addr,
+				rq->tr_demux_port[i - 1], cookie);
+			if (fds[i] == -1)
+				goto fail;
+		}
+	}
+	for (i = 0; i < TS_NFDS; i++) {
+		if ((fds[i] != i) && (dup2(fds[i], i) == -1)) {
+			res[0] = TS_STAGE_FDS;
+			goto fail;
+		}
+	}
+	for (i = 0; i < TS_NFDS; i++) {
+		if (fds[i] >= TS_NFDS)
+			(void)close(fds[i]);
+	}
+
+	res[0] = 0;
+	(void)write(wfd, res, sizeof(res));
+
+	environ = envp;
+	execvp(prog, argv);
+	fprintf(stderr, "%s: %s\n", prog, strerror(errno));
+	exit(254);
+
+fail:
+	res[1] = (res[1] != 0) ? res[1] : errno;
+	(void)write(wfd, res, sizeof(res));
+	exit(254);
+}
+
+/**
+ * @brief
+ *	Read a request from MoM, start the task and answer
+ *
+ * @return	int
+ * @retval	0	request handled
+ * @retval	-1	MoM closed the socket or sent garbage, stop reading
+ */
+static int
+start_task(void)
+{
+	ts_request_t	 rq;
+	struct msghdr	 msg;
+	struct iovec	 iov;
+	struct cmsghdr	*cmsg;
+	union {
+		struct cmsghdr	cm;
+		char		buf[CMSG_SPACE(TS_NFDS * sizeof(int))];
+	} ctl;
+	int		 fds[TS_NFDS] = {-1, -1, -1};
+	int		 pfd[2];
+	int		 res[2];
+	char		*strs = NULL;
+	char		*p;
+	size_t		 got;
+	ssize_t		 n;
+	pid_t		 pid;
+	int		 i;
+
+	memset(&msg, 0, sizeof(msg));
+	iov.iov_base = &rq;
+	iov.iov_len = sizeof(rq);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = ctl.buf;
+	msg.msg_controllen = sizeof(ctl.buf);
+	do {
+		n = recvmsg(sock, &msg, 0);
+	} while (n == -1 && errno == EINTR);
+	if (n <= 0)
+		return -1;
+
+	for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL;
+		cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+		if ((cmsg->cmsg_level == SOL_SOCKET) &&
+			(cmsg->cmsg_type == SCM_RIGHTS) &&
+			(cmsg->cmsg_len == CMSG_LEN(TS_NFDS * sizeof(int))))
+			memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+	}
+
+	/* rest of the fixed part, if it came in pieces */
+	got = (size_t)n;
+	if ((got < sizeof(rq)) &&
+		(read_all(sock, (char *)&rq + got, sizeof(rq) - got) == -1))
+		goto bad;
+	if ((rq.tr_version != TS_VERSION) || (rq.tr_strlen == 0) ||
+		(rq.tr_strlen > TS_MAXSTRLEN) || (rq.tr_argc < 0) ||
+		(rq.tr_envc < 0) || (rq.tr_nlimits < 0) ||
+		(rq.tr_nlimits > TS_MAXLIMITS))
+		goto bad;
+	if ((strs = malloc(rq.tr_strlen)) == NULL)
+		goto bad;
+	if (read_all(sock, strs, rq.tr_strlen) == -1)
+		goto bad;
+
+	/* the strings must all be there */
+	p = strs;
+	for (i = 0; i < TS_NSTRS + rq.tr_argc + rq.tr_envc; i++) {
+		p = memchr(p, '\0', strs + rq.tr_strlen - p);
+		if (p == NULL)
+			goto bad;
+		p++;
+	}
+
+	if (fds[0] == -1) {
+		send_reply(TS_FAILED, -1, EBADF, TS_STAGE_FDS);
+		free(strs);
+		return 0;
+	}
+
+	if (pipe(pfd) == -1) {
+		send_reply(TS_FAILED, -1, errno, TS_STAGE_FORK);
+	} else {
+		(void)fcntl(pfd[0], F_SETFD, FD_CLOEXEC);
+		(void)fcntl(pfd[1], F_SETFD, FD_CLOEXEC);
+		pid = fork();
+		if (pid == 0)
+			start_child(&rq, strs, fds, pfd[1]);
+		(void)close(pfd[1]);
+		if (pid == -1) {
+			send_reply(TS_FAILED, -1, errno, TS_STAGE_FORK);
+		} else if (read_all(pfd[0], res, sizeof(res)) == -1) {
+			/* died before saying anything */
+			(void)waitpid(pid, NULL, 0);
+			send_reply(TS_FAILED, -1, EIO, TS_STAGE_FORK);
+		} else if (res[0] != 0) {
+			(void)waitpid(pid, NULL, 0);
+			send_reply(TS_FAILED, -1, res[1], res[0]);
+		} else {
+			ntasks++;
+			send_reply(TS_STARTED, pid, 0, 0);
+		}
+		(void)close(pfd[0]);
+	}
+
+	for (i = 0; i < TS_NFDS; i++)
+		(void)close(fds[i]);
+	free(strs);
+	return 0;
+
+bad:
+	/* MoM's sends fail from now on, answer in case MoM waits for it */
+	(void)shutdown(sock, SHUT_RD);
+	send_reply(TS_FAILED, -1, EINVAL, TS_STAGE_FORK);
+	for (i = 0; i < TS_NFDS; i++) {
+		if (fds[i] != -1)
+			(void)close(fds[i]);
+	}
+	free(strs);
+	return -1;
+}
+
+/**
+ * @brief
+ *	main - the entry point in pbs_task_starter.c
+ *
+ * @param[in] argc - argument count
+ * @param[in] argv - argument variables, the socket to MoM
+ *
+ * @return	int
+ * @retval	0	MoM closed the socket and the tasks have exited
+ * @retval	1	error
+ */
+int
+main(int argc, char *argv[])
+{
+	struct sigaction act;
+	struct pollfd	 pfd[2];
+	int		 fd;
+	int		 i;
+
+	/*test for real deal or just version and exit*/
+
+	execution_mode(argc, argv);
+
+	if ((argc != 2) || ((sock = atoi(argv[1])) < 3)) {
+		fprintf(stderr, "usage: %s socket\n", argv[0]);
+		return 1;
+	}
+
+	/* keep only the socket, and stdin, stdout and stderr on /dev/null */
+	if ((fd = open("/dev/null", O_RDWR)) != -1) {
+		for (i = 0; i < 3; i++) {
+			if (fd != i)
+				(void)dup2(fd, i);
+		}
+		if (fd > 2)
+			(void)close(fd);
+	}
+	for (i = sysconf(_SC_OPEN_MAX) - 1; i > 2; i--) {
+		if (i != sock)
+			(void)close(i);
+	}
+	(void)fcntl(sock, F_SETFD, FD_CLOEXEC);
+
+	if (pipe(sigpipe) == -1)
+		return 1;
+	for (i = 0; i < 2; i++) {
+		(void)fcntl(sigpipe[i], F_SETFL, O_NONBLOCK);
+		(void)fcntl(sigpipe[i], F_SETFD, FD_CLOEXEC);
+	}
+	sigemptyset(&act.sa_mask);
+	act.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+	act.sa_handler = catch_child;
+	(void)sigaction(SIGCHLD, &act, NULL);
+	act.sa_flags = 0;
+	act.sa_handler = SIG_IGN;
+	(void)sigaction(SIGPIPE, &act, NULL);
+	(void)sigaction(SIGHUP, &act, NULL);
+
+	send_reply(TS_READY, getpid(), 0, 0);
+
+	pfd[0].events = POLLIN;
+	pfd[1].fd = sigpipe[0];
+	pfd[1].events = POLLIN;
+	for (;;) {
+		if (!reading && (ntasks == 0))
+			return 0;
+		/* a negative fd is not polled */
+		pfd[0].fd = reading ? sock : -1;
+		pfd[0].revents = pfd[1].revents = 0;
+		if (poll(pfd, 2, -1) == -1) {
+			if (errno == EINTR)
+				continue;
+			return 1;
+		}
+		if (pfd[1].revents)
+			reap_tasks();
+		if (pfd[0].revents) {
+			/* no more requests, wait for the tasks still running */
+			if (start_task() == -1)
+				reading = 0;
+			/* a task may have exited while we were busy */
+			reap_tasks();
+		}
+	}
+}
@@ -1207,6 +1207,8 @@ main(int argc, char *argv[])
 
 		case ALL:
 
+			if (output_format == FORMAT_JSON)
+				(void)json_stream_open(stdout);
 			if (prt_summary) {
 				if (prt_node_summary(def_server, bstat_head, job_summary, long_summary)) {
 					fprintf(stderr, "pbsnodes: out of memory\n");
@@ -1242,6 +1244,8 @@ main(int argc, char *argv[])
 		case LISTSP:
 
 			/* list the specified nodes or vnodes */
+			if (output_format == FORMAT_JSON)
+				(void)json_stream_open(stdout);
 			for (pa = argv+optind; *pa; pa++) {
 				if (do_vnodes)
 					bstat = pbs_statvnode(con, *pa, NULL, NULL);
@@ -1283,6 +1287,8 @@ main(int argc, char *argv[])
 		case LISTSPNV:
 
 			/*list nodes and vnodes associated with them.*/
+			if (output_format == FORMAT_JSON)
+				(void)json_stream_open(stdout);
 			if (argc-optind) {
 				for (bstat = bstat_head; bstat;bstat = bstat->next) {
 					int matched;
@@ -1232,6 +1232,8 @@ display_statjob(struct batch_status *status, struct batch_status *prtheader, int
 	}
 
 	if (output_format == FORMAT_JSON && first_stat) {
+		if (json_stream_open(stdout))
+			return 1;
 		if (add_json_node(JSON_OBJECT, JSON_NULL, JSON_FULLESCAPE, "Jobs", NULL) == NULL)
 			return 1;
 		first_stat = 0;
@@ -1487,6 +1489,8 @@ display_statque(struct batch_status *status, int prtheader, int full, int alt_op
 	}
 
 	if (output_format == FORMAT_JSON && first_stat) {
+		if (json_stream_open(stdout))
+			return 1;
 		if (add_json_node(JSON_OBJECT, JSON_NULL, JSON_FULLESCAPE, "Queue", NULL) == NULL)
 			return 1;
 		first_stat = 0;
@@ -1636,6 +1640,8 @@ display_statserver(struct batch_status *status, int prtheader, int full, int alt
 	}
 
 	if(output_format == FORMAT_JSON && first_stat) {
+		if (json_stream_open(stdout))
+			return 1;
 		if (add_json_node(JSON_OBJECT, JSON_NULL, JSON_NOVALUE, "Server", NULL) == NULL)
 			return 1;
 		first_stat = 0;
@@ -54,7 +54,7 @@ CREATE TABLE pbs.info (
     pbs_schema_version TEXT 		NOT NULL
 );
 
-INSERT INTO pbs.info values('1.4.0'); /* schema version */
+INSERT INTO pbs.info values('1.5.0'); /* schema version */
 
 ---------------------- SERVER ------------------------------
 
@@ -163,8 +163,14 @@ CREATE TABLE pbs.resv (
 
 ---------------------- JOB ---------------------------------
 
+/*
+ * Sequence pbs.job_saveseq numbers the saves of job rows, see ji_saveseq
+ */
+CREATE SEQUENCE pbs.job_saveseq;
+
 /*
  * Table pbs.job holds job information
+ * - ji_saveseq is taken from pbs.job_saveseq each time the row is saved
  */
 CREATE TABLE pbs.job (
     ji_jobid		TEXT		NOT NULL,
@@ -192,6 +198,7 @@ CREATE TABLE pbs.job (
     ji_qrank		INTEGER		NOT NULL,
     ji_savetm		TIMESTAMP	NOT NULL,
     ji_creattm		TIMESTAMP	NOT NULL,
+    ji_saveseq		BIGINT		NOT NULL DEFAULT nextval('pbs.job_saveseq'),
     attributes		hstore		NOT NULL default '',
     CONSTRAINT jobid_pk PRIMARY KEY (ji_jobid)
 );
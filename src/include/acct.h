@@ -79,7 +79,32 @@ extern "C" {
 #define PBS_ACCT_PROV_START	(int)'P'	/* Provisioning start record */
 #define PBS_ACCT_PROV_END	(int)'p'	/* Provisioning end record */
 
+/*
+ * The accounting file is fully buffered in a stdio buffer of this size;
+ * buffered records are written out by acct_flush().
+ */
+#define PBS_ACCT_WRITE_BUFSIZE	65536
+
+/*
+ * Binary accounting file, written next to the text file when
+ * PBS_ACCOUNTING_BINARY is set.  It starts with PBS_ACCT_BIN_MAGIC and
+ * holds one record per text record, all integers in network byte order:
+ *
+ *	u32 length of the rest of the record
+ *	u8  record type (PBS_ACCT_*), u8 reserved, u16 number of fields
+ *	u32 time high word, u32 time low word
+ *	u16 id length, id
+ *	per field: u16 key length, key, u32 value length, value
+ *
+ * A field is a "key=value" word of the text record with any quotes
+ * around the value removed; a word without '=' has an empty key.
+ */
+#define PBS_ACCT_BIN_SUFFIX	".bin"
+#define PBS_ACCT_BIN_MAGIC	"PBSACCT\001"
+#define PBS_ACCT_BIN_MAGIC_LEN	8
+
 extern int  acct_open(char *filename);
+extern void acct_flush(void);
 extern void acct_close(void);
 extern void account_record(int acctype, job *pjob, char *text);
 extern void write_account_record(int acctype, char *jobid, char *text);
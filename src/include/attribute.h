@@ -249,6 +249,7 @@ typedef struct ecl_attribute_def ecl_attribute_def;
 #define ATR_VFLAG_INDIRECT	0x10	/* indirect pointer to resource */
 #define ATR_VFLAG_TARGET	0x20	/* target of indirect resource  */
 #define ATR_VFLAG_HOOK		0x40	/* value set by a hook script   */
+#define ATR_VFLAG_SHARED	0x80	/* value borrowed, not to be freed */
 
 /* Defines for Parent Object type field in the attribute definition	*/
 /* really only used for telling queue types apart			*/
@@ -311,6 +312,7 @@ extern int  find_attr  (attribute_def *attrdef, char *name, int limit);
 extern int  recov_attr_fs(int fd, void *parent, attribute_def *padef,
 	attribute *pattr, int limit, int unknown);
 extern void free_null  (attribute *attr);
+extern int  unshare_attr(attribute *attr);
 extern void free_none  (attribute *attr);
 extern svrattrl *attrlist_alloc(int szname, int szresc, int szval);
 extern svrattrl *attrlist_create(char *aname, char *rname, int szval);
@@ -453,6 +455,7 @@ extern void free_depend(attribute *attr);
 extern void free_unkn(attribute *attr);
 extern int   parse_equal_string(char  *start, char **name, char **value);
 extern char *parse_comma_string(char *start);
+extern char *parse_comma_string_next(char **pnext);
 extern char *return_external_value(char *name, char *val);
 extern char *return_internal_value(char *name, char *val);
 
@@ -589,6 +592,11 @@ extern int encode_attr_db(struct attribute_def *padef, struct attribute *pattr,
 	int numattr, pbs_db_attr_list_t *attr_list, int all);
 extern int decode_attr_db(void *parent, pbs_db_attr_list_t *attr_list,
 	struct attribute_def *padef, struct attribute *pattr, int limit, int unknown);
+extern void *decode_attr_db_prep(pbs_db_attr_list_t *attr_list,
+	struct attribute_def *padef, struct attribute *pattr, int limit, int unknown);
+extern void decode_attr_db_finish(void *parent, void *handle,
+	struct attribute_def *padef, struct attribute *pattr);
+extern void decode_attr_db_free(void *handle);
 
 extern int is_attr(int, char *, int);
 
@@ -454,6 +454,16 @@ struct ajtrkhd {
 	/* of tkm_tbl entries (ct-1) will be included			   */
 };
 
+/*
+ * copy of the Array Job's string and string array attributes whose values
+ * the subjobs borrow (ATR_VFLAG_SHARED) instead of copying, see
+ * create_subjob().  Freed when the parent and all those subjobs are gone.
+ */
+struct ajattrs {
+	int		aja_refct;		 /* parent + subjobs using it */
+	attribute	aja_attr[JOB_ATR_LAST];	 /* only shared ones are set  */
+};
+
 /*
  * Discard Job Structure,  see Server's discard_job function
  *	Used to record which Mom has responded to when we need to tell them
@@ -540,6 +550,11 @@ struct job {
 	int		ji_parent2child_moms_status_pipe;	/* write pipe for parent mom to send sister moms status to child starter process */
 	int		ji_updated;	/* set to 1 if job's node assignment was updated */
 	time_t		ji_walltime_stamp;	/* time stamp for accumulating walltime */
+	pbs_list_head	ji_rused_sent;	/* session id and resources_used last sent to server */
+	long		ji_rused_hop;	/* run version ji_rused_sent was sent for */
+	pbs_list_link	ji_exitlink;	/* link on mom_exitjobs, see mom_exiting_job() */
+	void		*ji_cgacct;	/* machine dependent: job cgroup accounting */
+	void		*ji_env;	/* environment common to the job's tasks */
 #ifdef WIN32
 	HANDLE		ji_momsubt;	/* process HANDLE to mom subtask */
 #else	/* not WIN32 */
@@ -593,6 +608,7 @@ struct job {
 	struct job     *ji_parentaj;	/* subjob:   parent Array Job */
 	struct ajtrkhd *ji_ajtrk;	/* ArrayJob: index tracking table */
 	int		ji_subjindx;	/* subjob:   its index into the table */
+	struct ajattrs *ji_ajattrs;	/* attribute values shared by subjobs */
 	struct jbdscrd *ji_discard;	/* see discard_job() */
 	int		ji_jdcd_waiting;/* set if waiting on a mom for a response to discard job request */
 	char	       *ji_acctrec;	/* holder for accounting info */
@@ -881,6 +897,11 @@ event_alloc	(job		*pjob,
 
 pbs_task	*momtask_create	(job		*pjob);
 
+extern pbs_task	*find_session(pid_t sid);
+extern void	task_set_sid(pbs_task *ptask, pid_t sid);
+extern void	task_unindex_sid(pbs_task *ptask);
+extern void	mom_avljob_oper(job *pjob, int delkey);
+
 pbs_task	*
 task_find	(job		*pjob,
 	tm_task_id	taskid);
@@ -70,6 +70,13 @@
 /* The following macro assist in sharing code between the Server and Mom */
 #define LOG_EVENT log_event
 
+/* lets gcc check the arguments of the printf style logging functions */
+#ifdef __GNUC__
+#define LOG_PRINTF_FORMAT(fmt, args) __attribute__((format(printf, fmt, args)))
+#else
+#define LOG_PRINTF_FORMAT(fmt, args)
+#endif
+
 /*
  ** Set up a debug print macro.
  */
@@ -104,11 +111,14 @@ extern void log_close(int close_msg);
 extern void log_err(int err, const char *func, const char *text);
 extern void log_joberr(int err, const char *func, const char *text, const char *pjid);
 extern void log_event(int type, int objclass, int severity, const char *objname, const char *text);
+extern void log_eventf(int type, int objclass, int severity, const char *objname, const char *fmt, ...) LOG_PRINTF_FORMAT(5, 6);
 extern int will_log_event(int type);
 extern void log_suspect_file(const char *func, const char *text, const char *file, struct stat *sb);
 extern int  log_open(char *name, char *directory);
 extern int  log_open_main(char *name, char *directory, int silent);
 extern void log_record(int type, int objclass, int severity, const char *objname, const char *text);
+extern int  log_async_start(void);
+extern void log_async_stop(void);
 extern char log_buffer[LOG_BUF_SIZE];
 extern int log_level_2_etype(int level);
 
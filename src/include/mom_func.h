@@ -57,6 +57,8 @@ struct var_table {
 	char **v_envp;
 	int    v_ensize;
 	int    v_used;
+	int   *v_index;		/* hash index of the names in v_envp */
+	int    v_isize;		/* number of slots in v_index */
 };
 
 /* struct sig_tbl = used to hold map of local signal names to values */
@@ -353,6 +355,14 @@ extern int recv_rq_cpyfile_cred(struct rq_cpyfile *);
 extern int remdir(char *);
 #else
 extern void  bld_env_variables(struct var_table *, char *, char *);
+extern void  free_job_env(job *);
+struct ts_request;
+struct ts_reply;
+extern int   task_starter_ready(void);
+extern int   task_starter_run(struct ts_request *, char *, int *,
+	struct ts_reply *);
+extern pid_t task_starter_reaped(int *);
+extern void  task_starter_close(void);
 extern int   mktmpdir(char *, uid_t, gid_t, struct var_table *);
 extern int   mkjobdir(char *, char *, uid_t, gid_t);
 extern int   impersonate_user(uid_t, gid_t);
@@ -382,6 +392,7 @@ extern int   rcvwinsize(int);
 extern int   remtree(char *);
 extern void  rid_job(char *jobid);
 extern void  scan_for_exiting(void);
+extern void  mom_exiting_job(job *pjob);
 extern void  scan_for_terminated(void);
 extern int   setwinsize(int);
 extern void  set_termcc(int);
@@ -310,14 +310,24 @@ typedef struct pbs_db_jobscr_info pbs_db_jobscr_info_t;
  *  Timestamp field can be used to pass a timestamp, to return rows that have
  *  a modification timestamp newer (more recent) than the timestamp passed.
  *  (Basically to return rows that have been modified since a point of time)
+ *  Saveseq is the save sequence number for FIND_JOBS_ATTRS_SINCE.
  *
  */
 struct pbs_db_query_options {
 	int	flags;
 	time_t	timestamp;
+	BIGINT	saveseq;
 };
 typedef struct pbs_db_query_options pbs_db_query_options_t;
 
+/*
+ * Flag for a PBS_DB_JOB cursor: return all the jobs, but the attributes only
+ * of the jobs saved after the save sequence number in saveseq.  The other
+ * rows have an empty attribute list, their attributes come from a job
+ * snapshot.
+ */
+#define FIND_JOBS_ATTRS_SINCE	2
+
 #define PBS_DB_JOB 			0
 #define PBS_DB_RESV			1
 #define PBS_DB_SVR			2
@@ -618,6 +628,21 @@ int pbs_db_get_rowcount(void *state);
  */
 int pbs_db_execute_str(pbs_db_conn_t *conn, char *sql);
 
+/**
+ * @brief
+ *	Take a number from the job save sequence.  Job rows saved from then
+ *	on get a higher ji_saveseq.
+ *
+ * @param[in]	conn - Connected database handle
+ * @param[out]	pseq - The sequence number
+ *
+ * @return      int
+ * @retval      -1  - Error
+ * @retval       0  - success
+ *
+ */
+int pbs_db_get_job_saveseq(pbs_db_conn_t *conn, BIGINT *pseq);
+
 /**
  * @brief
  *	Insert a new object into the database
@@ -232,8 +232,14 @@ struct pbs_config
 	char *pbs_comm_routers;		/* for this router, the optional list of other routers to talk to */
 	long  pbs_comm_log_events;      /* log_events for pbs_comm process, default 0 */
 	unsigned int pbs_comm_threads;	/* number of threads for router, default 4 */
+	int pbs_comm_coalesce_delay;	/* ms pbs_comm batches data to a leaf, -1 disables */
 	char *pbs_mom_node_name;	/* mom short name used for natural node, default NULL */
 	unsigned int pbs_log_highres_timestamp; /* high resolution logging */
+	unsigned int pbs_log_async;		/* records buffered for the log writer thread, 0 for synchronous logging */
+	unsigned int pbs_acct_binary;		/* server also writes binary accounting records */
+	unsigned int pbs_server_snapshot;	/* seconds between job snapshots of the server, 0 disables */
+	unsigned int pbs_compression_codec;	/* codec used to compress communication data */
+	unsigned int pbs_compression_threshold; /* compress only messages larger than this, in bytes */
 #ifdef WIN32
 	char *pbs_conf_remote_viewer; /* Remote viewer client executable for PBS GUI jobs, along with launch options */
 #endif
@@ -265,6 +271,11 @@ extern struct pbs_config pbs_conf;
 #define PBS_CONF_DATA_SERVICE_HOST           "PBS_DATA_SERVICE_HOST"
 #define PBS_CONF_USE_TCP		     "PBS_USE_TCP"
 #define PBS_CONF_USE_COMPRESSION     	     "PBS_USE_COMPRESSION"
+#define PBS_CONF_COMPRESSION_CODEC	     "PBS_COMPRESSION_CODEC"
+#define PBS_CONF_COMPRESSION_THRESHOLD	     "PBS_COMPRESSION_THRESHOLD"
+#define PBS_COMPRESSION_CODEC_ZLIB	0	/* values of pbs_compression_codec */
+#define PBS_COMPRESSION_CODEC_LZ4	1
+#define PBS_COMPRESSION_THRESHOLD_DEFAULT 8192
 #define PBS_CONF_USE_MCAST		     "PBS_USE_MCAST"
 #define PBS_CONF_FORCE_FT_COMM		     "PBS_FORCE_FT_COMM"
 #define PBS_CONF_LEAF_NAME		     "PBS_LEAF_NAME"
@@ -273,6 +284,7 @@ extern struct pbs_config pbs_conf;
 #define PBS_CONF_COMM_ROUTERS		     "PBS_COMM_ROUTERS"
 #define PBS_CONF_COMM_THREADS		     "PBS_COMM_THREADS"
 #define PBS_CONF_COMM_LOG_EVENTS	     "PBS_COMM_LOG_EVENTS"
+#define PBS_CONF_COMM_COALESCE_DELAY	     "PBS_COMM_COALESCE_DELAY"
 #define PBS_CONF_HOME		"PBS_HOME"	 	 /* path to pbs home */
 #define PBS_CONF_EXEC		"PBS_EXEC"		 /* path to pbs exec */
 #define PBS_CONF_DEFAULT_NAME	"PBS_DEFAULT"	  /* old name for PBS_SERVER */
@@ -297,6 +309,9 @@ extern struct pbs_config pbs_conf;
 #define PBS_CONF_SCHEDULER_MODIFY_EVENT	"PBS_SCHEDULER_MODIFY_EVENT"
 #define PBS_CONF_MOM_NODE_NAME	"PBS_MOM_NODE_NAME"
 #define PBS_CONF_LOG_HIGHRES_TIMESTAMP	"PBS_LOG_HIGHRES_TIMESTAMP"
+#define PBS_CONF_LOG_ASYNC	"PBS_LOG_ASYNC"
+#define PBS_CONF_ACCT_BINARY	"PBS_ACCOUNTING_BINARY"
+#define PBS_CONF_SERVER_SNAPSHOT	"PBS_SERVER_SNAPSHOT"
 #ifdef WIN32
 #define PBS_CONF_REMOTE_VIEWER "PBS_REMOTE_VIEWER"	/* Executable for remote viewer application alongwith its launch options, for PBS GUI jobs */
 #endif
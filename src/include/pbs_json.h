@@ -37,5 +37,6 @@ struct JsonNode{
 };
 JsonNode* add_json_node(JsonNodeType ntype, JsonValueType vtype, JsonEscapeType esc_type, char *key, void *value);
 char *strdup_escape(JsonEscapeType esc_type, const char *str);
+int  json_stream_open(FILE *stream);
 int  generate_json(FILE *stream);
 void free_json_node();
@@ -66,6 +66,10 @@ extern "C" {
 #define TPP_AUTH_RESV_PORT	1
 #define TPP_AUTH_EXTERNAL	2
 
+/* TPP compression codecs */
+#define TPP_COMPR_ZLIB		0
+#define TPP_COMPR_LZ4		1
+
 struct tpp_config {
 	int    node_type; /* leaf, proxy */
 	char   **routers; /* other proxy names (and backups) to connect to */
@@ -75,12 +79,15 @@ struct tpp_config {
 	void * (*get_ext_auth_data)(int auth_type, int *data_len, char *ebuf, int ebufsz);
 	int    (*validate_ext_auth_data) (int auth_type, void *data, int data_len, char *ebuf, int ebufsz);
 	int    compress;
+	int    compress_codec; /* TPP_COMPR_ZLIB or TPP_COMPR_LZ4 */
+	unsigned int compress_threshold; /* compress only data larger than this */
 	int    tcp_keepalive; /* use keepalive? */
 	int    tcp_keep_idle;
 	int    tcp_keep_intvl;
 	int    tcp_keep_probes;
 	int    buf_limit_per_conn; /* buffer limit per physical connection */
 	int    force_fault_tolerance; /* by default disabled */
+	int    coalesce_delay; /* ms to batch data to a leaf at the router, -1 disables */
 };
 
 /* rpp node types, leaf and router */
@@ -182,6 +189,9 @@ extern int *tpp_mcast_members(int mtfd, int *count);
 extern int tpp_mcast_send(int mtfd, void *data, unsigned int len, unsigned int full_len, unsigned int compress);
 extern int tpp_mcast_close(int mtfd);
 
+/* append runtime statistics of the tpp layer to a file, as a line of JSON */
+extern int tpp_dump_stats(char *path, char *daemon);
+
 /* utility for getting checksum of a file */
 extern unsigned long crc_file(char *fname);
 #endif
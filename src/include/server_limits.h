@@ -97,6 +97,7 @@ extern "C" {
 #define PBS_SCHEDDB		"scheddb"
 #define PBS_SCHED_PRIVATE	"sched_priv"
 #define PBS_SVRLIVE		"svrlive"
+#define PBS_JOB_SNAPSHOT	"job_snapshot"
 
 
 #define PBS_LOCAL_CONNECTION INT_MAX
@@ -185,6 +185,7 @@ extern char *lastname(char *shell);
 extern void  chk_array_doneness(job *parent);
 extern void  update_array_indices_remaining_attr(job *parent);
 extern job  *create_subjob(job *parent, char *newjid, int *rc);
+extern void  release_subjob_attrs(job *pjob);
 extern char *cvt_range(struct ajtrkhd *t, int state);
 extern job  *find_arrayparent(char *subjobid);
 extern int   get_subjob_state(job *parent, int offset);
@@ -364,6 +365,10 @@ extern int   node_spec(struct spec_and_context *, int);
  * The request currently may be in the following states:
  *	Pending - waiting for the next scheduling cycle
  *	Sent    - sent to the Scheduler
+ * A request for a Scheduler which is in the middle of a cycle is sent on the
+ * secondary connection so it can be run without waiting for the cycle to end.
+ * If the Scheduler closes the cycle without replying, such a request goes
+ * back to Pending rather than failing.
  * When the Scheduler deals with the request, it will use the Deferred
  * Scheduler Reply request;  the Server will look in the list for one with
  * a matching Job ID and on finding it, reply to the original runjob request
@@ -375,6 +380,7 @@ struct deferred_request {
 	char			dr_id[PBS_MAXSVRJOBID+1];
 	struct batch_request   *dr_preq;
 	int			dr_sent;	/* sent to Scheduler */
+	int			dr_sent_busy;	/* sent on the secondary connection */
 };
 
 #endif /* _LIST_LINK_H */
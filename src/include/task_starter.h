@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 1994-2018 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * PBS Pro is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * For a copy of the commercial license terms and conditions,
+ * go to: (http://www.pbspro.com/UserArea/agreement.html)
+ * or contact the Altair Legal Department.
+ *
+ * Altair’s dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of PBS Pro and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair’s trademarks, including but not limited to "PBS™",
+ * "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's
+ * trademark licensing policies.
+ *
+ */
+
+#ifndef	_TASK_STARTER_H
+#define	_TASK_STARTER_H
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/*
+ * task_starter.h - messages between MoM and pbs_task_starter
+ *
+ * MoM runs pbs_task_starter as a child and talks to it over a stream
+ * socket passed as its only argument.  The starter first sends TS_READY.
+ * To start a task MoM sends a ts_request_t with the task's standard
+ * input, output and error attached as SCM_RIGHTS, followed by tr_strlen
+ * bytes of null terminated strings: the user name, the working directory,
+ * the job's temporary directory, the job cookie, the program, tr_argc
+ * arguments and tr_envc environment variables.  The starter forks, sets
+ * up the child and answers with TS_STARTED or TS_FAILED.  When one of its
+ * tasks exits the starter sends TS_EXITED with the wait status.
+ *
+ * The child, not MoM, makes the temporary directory (unless its name is
+ * empty) and, if tr_demux_addr is set, connects standard output and error
+ * to pbs_demux and writes the cookie to them, as the child forked by MoM
+ * does.  A temporary directory that exists and is not owned by the user
+ * fails with TS_STAGE_TMPDIR and EEXIST.
+ *
+ * Other Required Header Files:
+ *	<sys/types.h>
+ *	<sys/resource.h>
+ *	<netinet/in.h>
+ */
+
+#define TS_VERSION	2
+#define TS_MAXLIMITS	4	/* file, vmem, mem and cput */
+#define TS_NFDS		3	/* stdin, stdout, stderr */
+#define TS_NSTRS	5	/* strings before the arguments */
+#define TS_MAXSTRLEN	(64 * 1024 * 1024)
+
+typedef struct ts_limit {
+	int	tl_resource;		/* RLIMIT_* */
+	rlim_t	tl_value;		/* both soft and hard limit */
+} ts_limit_t;
+
+typedef struct ts_request {
+	int		tr_version;	/* TS_VERSION */
+	uid_t		tr_uid;
+	gid_t		tr_gid;
+	gid_t		tr_rgid;	/* login group, added to the groups */
+	mode_t		tr_umask;
+	int		tr_unnice;	/* reset the priority to 0 */
+	int		tr_nice;	/* then nice() by this much */
+	int		tr_nlimits;
+	ts_limit_t	tr_limits[TS_MAXLIMITS];
+	in_addr_t	tr_demux_addr;	/* pbs_demux host, network order, or 0 */
+	int		tr_demux_port[2];	/* pbs_demux stdout and stderr */
+	int		tr_argc;
+	int		tr_envc;
+	size_t		tr_strlen;	/* bytes of strings that follow */
+} ts_request_t;
+
+/* tp_type */
+#define TS_STARTED	1	/* tp_pid is the task, its session id */
+#define TS_FAILED	2	/* tp_status is errno, tp_stage what failed */
+#define TS_EXITED	3	/* tp_status is the wait status of tp_pid */
+#define TS_READY	4	/* the starter is running, tp_pid is its pid */
+
+/* tp_stage */
+#define TS_STAGE_FORK	1
+#define TS_STAGE_SETSID	2
+#define TS_STAGE_LIMITS	3
+#define TS_STAGE_USER	4
+#define TS_STAGE_CHDIR	5
+#define TS_STAGE_FDS	6
+#define TS_STAGE_TMPDIR	7
+
+typedef struct ts_reply {
+	int		tp_type;
+	pid_t		tp_pid;
+	int		tp_status;
+	int		tp_stage;
+} ts_reply_t;
+
+#ifdef	__cplusplus
+}
+#endif
+#endif	/* _TASK_STARTER_H */
@@ -254,7 +254,8 @@ attr_atomic_copy(attribute *to, attribute *from, attribute_def *pdef, int limit)
 			clear_attr(to + i, pdef + i);
 		if ((from + i)->at_flags & ATR_VFLAG_SET) {
 			(pdef + i)->at_set((to + i), (from + i), SET);
-			(to + i)->at_flags = (from + i)->at_flags;
+			/* the copy has its own value, even of a shared one */
+			(to + i)->at_flags = (from + i)->at_flags & ~ATR_VFLAG_SHARED;
 		}
 	}
 }
@@ -350,6 +350,8 @@ set_allacl(struct attribute *attr, struct attribute *new, enum batch_op op, int
 
 	assert(attr && new && (new->at_flags & ATR_VFLAG_SET));
 
+	if (unshare_attr(attr) != 0)
+		return (PBSE_SYSTEM);
 	pas = attr->at_val.at_arst;	/* array of strings control struct */
 	newpas = new->at_val.at_arst;	/* array of strings control struct */
 	if (!newpas)
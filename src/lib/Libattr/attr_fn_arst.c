@@ -111,6 +111,7 @@ decode_arst_direct(struct attribute *patr, char *val)
 	char			*pbuf = NULL;
 	char			*pc;
 	char			*pstr;
+	char			*pnext;
 	struct array_strings	*stp = NULL;
 	int			 rc;
 	char			 strbuf[BUF_SIZE];	/* Should handle most values */
@@ -170,14 +171,15 @@ decode_arst_direct(struct attribute *patr, char *val)
 	/* now copy in substrings and set pointers */
 	pc = pbuf;
 	j = 0;
-	pstr = parse_comma_string(sbufp);
+	pnext = sbufp;
+	pstr = parse_comma_string_next(&pnext);
 	while ((pstr != NULL) && (j < ns)) {
 		stp->as_string[j] = pc;
 		while (*pstr) {
 			*pc++ = *pstr++;
 		}
 		*pc++ = '\0';
-		pstr = parse_comma_string(NULL);
+		pstr = parse_comma_string_next(&pnext);
 		j++;
 	}
 
@@ -378,6 +380,8 @@ set_arst(struct attribute *attr, struct attribute *new, enum batch_op op)
 
 	assert(attr && new && (new->at_flags & ATR_VFLAG_SET));
 
+	if (unshare_attr(attr) != 0)
+		return (PBSE_SYSTEM);
 	pas = attr->at_val.at_arst;
 	xpasx = new->at_val.at_arst;
 	if (!xpasx)
@@ -572,7 +576,8 @@ comp_arst(struct attribute *attr, struct attribute *with)
 void
 free_arst(struct attribute *attr)
 {
-	if ((attr->at_flags & ATR_VFLAG_SET) && (attr->at_val.at_arst)) {
+	if ((attr->at_flags & ATR_VFLAG_SET) && (attr->at_val.at_arst) &&
+		((attr->at_flags & ATR_VFLAG_SHARED) == 0)) {
 		(void)free(attr->at_val.at_arst->as_buf);
 		(void)free((char *)attr->at_val.at_arst);
 	}
@@ -620,18 +625,16 @@ arst_string(char *str, attribute *pattr)
  *		value1 [, value2 ...]
  *
  *	For use by decode_arst_direct_bs(), the old 8.0 version.
- *	On the first call, start is non null, a pointer to the first value
- *	element upto a comma, new-line, or end of string is returned.
+ *	Each call returns a pointer to the next value element upto a comma
+ *	or end of string and advances *pnext past it.  The position is kept
+ *	by the caller, not in a static, so this is safe to use from threads.
  *
  *	Commas escaped by a back-slash '\' are ignored.
  *
  *	Newlines (\n) are allowed because they could be present in
  *	environment variables.
  *
- *	On any following calls with start set to a null pointer NULL,
- *	the next value element is returned...
- *
- * @param[in] start - string to be parsed
+ * @param[in,out] pnext - address of pointer to the rest of the string
  *
  * @return 	string
  * @retval	start address for string	Success
@@ -640,16 +643,13 @@ arst_string(char *str, attribute *pattr)
  */
 
 static char *
-parse_comma_string_bs(char *start)
+parse_comma_string_bs(char **pnext)
 {
-	static char *pc = NULL;	/* if start is null, restart from here */
+	char	    *pc = *pnext;
 	char	    *dest;
 	char	    *back;
 	char	    *rv;
 
-	if (start != NULL)
-		pc = start;
-
 	/* skip over leading white space */
 	while (pc && *pc && isspace((int)*pc))
 		pc++;
@@ -695,6 +695,7 @@ parse_comma_string_bs(char *start)
 	while (isspace((int)*--back))	/* strip trailing spaces */
 		*back = '\0';
 
+	*pnext = pc;
 	return (rv);
 }
 
@@ -778,6 +779,7 @@ decode_arst_direct_bs(struct attribute *patr, char *val)
 	char			*pbuf = NULL;
 	char			*pc;
 	char			*pstr;
+	char			*pnext;
 	char			*sbufp = NULL;
 	struct array_strings	*stp = NULL;
 	char			 strbuf[BUF_SIZE];	/* Should handle most values */
@@ -834,14 +836,15 @@ decode_arst_direct_bs(struct attribute *patr, char *val)
 	/* now copy in substrings and set pointers */
 	pc = pbuf;
 	j = 0;
-	pstr = parse_comma_string_bs(sbufp);
+	pnext = sbufp;
+	pstr = parse_comma_string_bs(&pnext);
 	while ((pstr != NULL) && (j < ns)) {
 		stp->as_string[j] = pc;
 		while (*pstr) {
 			*pc++ = *pstr++;
 		}
 		*pc++ = '\0';
-		pstr = parse_comma_string_bs(NULL);
+		pstr = parse_comma_string_bs(&pnext);
 		j++;
 	}
 
@@ -1065,6 +1068,8 @@ set_arst_uniq(struct attribute *attr, struct attribute *new, enum batch_op op)
 	if (op == DECR)
 		return (set_arst(attr, new, op));
 
+	if (unshare_attr(attr) != 0)
+		return (PBSE_SYSTEM);
 	pas = attr->at_val.at_arst;	/* old attribute, A */
 	xpasx = new->at_val.at_arst;	/* new attribute, B */
 	if (!xpasx)
@@ -97,8 +97,10 @@ decode_str(struct attribute *patr, char *name, char *rescn, char *val)
 {
 	size_t len;
 
-	if ((patr->at_flags & ATR_VFLAG_SET) && (patr->at_val.at_str))
+	if ((patr->at_flags & ATR_VFLAG_SET) && (patr->at_val.at_str) &&
+		((patr->at_flags & ATR_VFLAG_SHARED) == 0))
 		(void)free(patr->at_val.at_str);
+	patr->at_flags &= ~ATR_VFLAG_SHARED;
 
 	if ((val != NULL) && ((len = strlen(val) + 1) > 1)) {
 		patr->at_val.at_str = malloc((unsigned) len);
@@ -189,6 +191,8 @@ set_str(struct attribute *attr, struct attribute *new, enum batch_op op)
 	size_t nsize;
 
 	assert(attr && new && new->at_val.at_str && (new->at_flags & ATR_VFLAG_SET));
+	if (unshare_attr(attr) != 0)
+		return (PBSE_SYSTEM);
 	nsize = strlen(new->at_val.at_str) + 1;	/* length of new string */
 	if ((op == INCR) && !attr->at_val.at_str)
 		op = SET;	/* no current string, change INCR to SET */
@@ -279,7 +283,8 @@ comp_str(struct attribute *attr, struct attribute *with)
 void
 free_str(struct attribute *attr)
 {
-	if ((attr->at_flags & ATR_VFLAG_SET) && (attr->at_val.at_str)) {
+	if ((attr->at_flags & ATR_VFLAG_SET) && (attr->at_val.at_str) &&
+		((attr->at_flags & ATR_VFLAG_SHARED) == 0)) {
 		(void)free(attr->at_val.at_str);
 	}
 	free_null(attr);
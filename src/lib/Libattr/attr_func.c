@@ -64,6 +64,7 @@
  *	free_attrlist()
  *	parse_equal_string()
  *	parse_comma_string()
+ *	parse_comma_string_next()
  *	count_substrings()
  *	add_to_svrattrl_list()
  *	add_to_svrattrl_list_sorted()
@@ -197,11 +198,67 @@ free_null(struct attribute *attr)
 	memset(&attr->at_val, 0, sizeof(attr->at_val));
 	if (attr->at_type == ATR_TYPE_SIZE)
 		attr->at_val.at_size.atsv_shift = 10;
-	attr->at_flags &= ~(ATR_VFLAG_SET|ATR_VFLAG_INDIRECT|ATR_VFLAG_TARGET);
+	attr->at_flags &= ~(ATR_VFLAG_SET|ATR_VFLAG_INDIRECT|ATR_VFLAG_TARGET|ATR_VFLAG_SHARED);
 	if (attr->at_user_encoded != NULL || attr->at_priv_encoded != NULL)
 		free_svrcache(attr);
 }
 
+/**
+ * @brief
+ *	unshare_attr - give an attribute whose value is borrowed from
+ *	another object (ATR_VFLAG_SHARED) its own copy of the value, so the
+ *	value may be changed in place.  Only string and array of strings
+ *	values are ever shared.
+ *
+ * @param[in,out] attr - pointer to attribute structure
+ *
+ * @return	int
+ * @retval	0		Success, or the value was not shared
+ * @retval	PBSE_SYSTEM	Error, malloc failed
+ *
+ */
+
+int
+unshare_attr(struct attribute *attr)
+{
+	struct array_strings	*pas;
+	struct array_strings	*npas;
+	size_t			 need;
+	int			 i;
+
+	if ((attr->at_flags & ATR_VFLAG_SHARED) == 0)
+		return (0);
+
+	if ((attr->at_flags & ATR_VFLAG_SET) == 0) {
+		attr->at_val.at_str = NULL;
+	} else if (attr->at_type == ATR_TYPE_STR) {
+		if ((attr->at_val.at_str != NULL) &&
+			((attr->at_val.at_str = strdup(attr->at_val.at_str)) == NULL))
+			return (PBSE_SYSTEM);
+	} else if ((attr->at_type == ATR_TYPE_ARST) &&
+		((pas = attr->at_val.at_arst) != NULL)) {
+		need = sizeof(struct array_strings) +
+			(pas->as_npointers - 1) * sizeof(char *);
+		if ((npas = (struct array_strings *)malloc(need)) == NULL)
+			return (PBSE_SYSTEM);
+		memcpy(npas, pas, need);
+		if (pas->as_buf != NULL) {
+			if ((npas->as_buf = malloc(pas->as_bufsize)) == NULL) {
+				free(npas);
+				return (PBSE_SYSTEM);
+			}
+			memcpy(npas->as_buf, pas->as_buf, pas->as_bufsize);
+			npas->as_next = npas->as_buf + (pas->as_next - pas->as_buf);
+			for (i = 0; i < pas->as_usedptr; i++)
+				npas->as_string[i] = npas->as_buf +
+					(pas->as_string[i] - pas->as_buf);
+		}
+		attr->at_val.at_arst = npas;
+	}
+	attr->at_flags &= ~ATR_VFLAG_SHARED;
+	return (0);
+}
+
 /**
  * @brief
  * 		decode_null - Null attribute decode routine for Read Only (server
@@ -417,6 +474,8 @@ free_svrattrl(svrattrl *pal)
  *	the next value element is returned...
  *
  *	A null pointer is returned when there are no (more) value elements.
+ *
+ * @see parse_comma_string_next
  */
 
 char *
@@ -424,12 +483,36 @@ parse_comma_string(char *start)
 {
 	static char *pc;	/* if start is null, restart from here */
 
-	char	    *back;
-	char	    *rv;
-
 	if (start != NULL)
 		pc = start;
 
+	return (parse_comma_string_next(&pc));
+}
+
+/**
+ * @brief
+ * 	parse_comma_string_next() - reentrant form of parse_comma_string()
+ *
+ *	The position in the string is kept by the caller in *pnext rather
+ *	than in a static, so different threads may parse different strings
+ *	at the same time.  Set *pnext to the string before the first call.
+ *
+ * @param[in,out] pnext - address of pointer to the rest of the string,
+ *			  advanced past the returned value element
+ *
+ * @return	char *
+ * @retval	pointer to the next value element
+ * @retval	NULL if there are no (more) value elements
+ */
+
+char *
+parse_comma_string_next(char **pnext)
+{
+	char	    *pc;
+	char	    *back;
+	char	    *rv;
+
+	pc = *pnext;
 	if (*pc == '\0')
 		return NULL;	/* already at end, no strings */
 
@@ -454,6 +537,7 @@ parse_comma_string(char *start)
 	if (*pc)
 		*pc++ = '\0';	/* if not end, terminate this and adv past */
 
+	*pnext = pc;
 	return (rv);
 }
 
@@ -48,6 +48,19 @@ struct JsonLink{
 
 static JsonLink *head = NULL, *prev_link = NULL;
 
+/*
+ * Output state.  Once json_stream_open() has been called nodes are
+ * written to json_stream as they are added instead of being linked.
+ */
+static FILE	*json_stream = NULL;
+static int	 json_indent = 0;
+static int	 json_prnt_comma = 0;
+static int	 json_curnt_arr_lvl = 0;
+static int	 json_arr_lvl[ARRAY_NESTING_LEVEL];
+static JsonNode	 json_stream_node;	/* node being written when streaming */
+static char	*json_escbuf = NULL;	/* escaped value, reused when streaming */
+static int	 json_escbuf_len = 0;
+
 /**
  * @brief
  *	create_json_node
@@ -95,6 +108,104 @@ link_node(JsonNode *node) {
 	return 0;
 }
 
+/**
+ * @brief
+ *	Escape a string so that it conforms to JSON, into a buffer that is
+ *	grown as needed
+ *
+ * @param[in] esc_type - JSON_ESCAPE or JSON_FULLESCAPE
+ * @param[in] str - string to be escaped
+ * @param[in,out] pbuf - buffer, may be NULL
+ * @param[in,out] plen - size of *pbuf
+ *
+ * @return int
+ * @retval 0	success
+ * @retval 1	out of memory, *pbuf is freed
+ *
+ */
+static int
+escape_into(JsonEscapeType esc_type, const char *str, char **pbuf, int *plen)
+{
+	int       i = 0;
+	int       len = *plen;
+	char      *temp = NULL;
+	char      *buf = *pbuf;
+
+	if (buf == NULL || len < MAXBUFLEN) {
+		len = MAXBUFLEN;
+		temp = (char *) realloc(buf, len);
+		if (temp == NULL)
+			goto err;
+		buf = temp;
+	}
+	while (*str) {
+		switch (*str) {
+		case '\b':
+			buf[i++] = '\\';
+			buf[i++] = 'b';
+			str++;
+			break;
+		case '\f':
+			buf[i++] = '\\';
+			buf[i++] = 'f';
+			str++;
+			break;
+		case '\n':
+			buf[i++] = '\\';
+			buf[i++] = 'n';
+			str++;
+			break;
+		case '\r':
+			buf[i++] = '\\';
+			buf[i++] = 'r';
+			str++;
+			break;
+		case '\t':
+			buf[i++] = '\\';
+			buf[i++] = 't';
+			str++;
+			break;
+		case '"':
+			if (esc_type == JSON_ESCAPE) {
+				buf[i++] = *str++;
+				break;
+			} /* else JSON_FULLESCAPE */
+			buf[i++] = '\\';
+			buf[i++] = '"';
+			str++;
+			break;
+		case '\\':
+			if (esc_type == JSON_ESCAPE) {
+				buf[i++] = *str++;
+				break;
+			} /* else JSON_FULLESCAPE */
+			buf[i++] = '\\';
+			buf[i++] = '\\';
+			str++;
+			break;
+		default:
+			buf[i++] = *str++;
+		}
+		if (i >= len - 2) {
+			len *= BUFFER_GROWTH_RATE;
+			temp = (char *) realloc(buf, len);
+			if (temp == NULL)
+				goto err;
+			buf = temp;
+		}
+	}
+	buf[i] = '\0';
+	*pbuf = buf;
+	*plen = len;
+	return 0;
+
+err:
+	free(buf);
+	*pbuf = NULL;
+	*plen = 0;
+	return 1;
+}
+
 /**
  * @brief
  * Duplicates a string where the new string conforms to JSON
@@ -109,83 +220,175 @@ link_node(JsonNode *node) {
 char*
 strdup_escape(JsonEscapeType esc_type, const char *str)
 {
-	int       i = 0;
-	int       len = 0;
-	char      *temp = NULL;
-	char      *buf = NULL;
-	if (str != NULL) {
-		i = 0;
-		len = MAXBUFLEN;
-		buf = (char *) malloc(len);
-		if (buf == NULL)
-			return NULL;
-		while (*str) {
-			switch (*str) {
-			case '\b':
-				buf[i++] = '\\';
-				buf[i++] = 'b';
-				str++;
-				break;
-			case '\f':
-				buf[i++] = '\\';
-				buf[i++] = 'f';
-				str++;
-				break;
-			case '\n':
-				buf[i++] = '\\';
-				buf[i++] = 'n';
-				str++;
-				break;
-			case '\r':
-				buf[i++] = '\\';
-				buf[i++] = 'r';
-				str++;
-				break;
-			case '\t':
-				buf[i++] = '\\';
-				buf[i++] = 't';
-				str++;
-				break;
-			case '"':
-				if (esc_type == JSON_ESCAPE) {
-					buf[i++] = *str++;
-					break;
-				} /* else JSON_FULLESCAPE */
-				buf[i++] = '\\';
-				buf[i++] = '"';
-				str++;
-				break;
-			case '\\':
-				if (esc_type == JSON_ESCAPE) {
-					buf[i++] = *str++;
-					break;
-				} /* else JSON_FULLESCAPE */
-				buf[i++] = '\\';
-				buf[i++] = '\\';
-				str++;
-				break;
-			default:
-				buf[i++] = *str++;
-			}
-			if (i >= len - 2) {
-				len *= BUFFER_GROWTH_RATE;
-				temp = (char *) realloc(buf, len);
-				if (temp == NULL) {
-					free(buf);
-					return NULL;
-				}
-				buf = temp;
-			}
+	char *buf = NULL;
+	int len = 0;
+
+	if (str == NULL)
+		return NULL;
+	if (escape_into(esc_type, str, &buf, &len))
+		return NULL;
+	return buf;
+}
+
+/**
+ * @brief
+ *	write one json node to json_stream
+ *
+ * @param[in] node - node to write
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	1	error
+ *
+ */
+static int
+emit_json_node(JsonNode *node) {
+	FILE	*stream = json_stream;
+	int	 indent = json_indent;
+	int	 last_object_value = 0;
+	int	 last_array_value = 0;
+
+	switch (node->node_type) {
+		case JSON_OBJECT:
+			if (json_prnt_comma)
+				fprintf(stream, ",\n");
+			else
+				fprintf(stream, "\n");
+			if (json_arr_lvl[json_curnt_arr_lvl] == indent)
+				fprintf(stream, "%*.*s{", indent, indent, " ");
+			else
+				fprintf(stream, "%*.*s\"%s\":{", indent, indent, " ", node->key);
+			json_indent += 4;
+			json_prnt_comma = 0;
+			/* there's no value associated within an OBJECT type node */
+			return 0;
+
+		case JSON_OBJECT_END:
+			last_object_value = 1;
+			break;
+
+		case JSON_ARRAY:
+			if (json_curnt_arr_lvl + 1 >= ARRAY_NESTING_LEVEL)
+				return 1;
+			if (json_prnt_comma)
+				fprintf(stream, ",\n");
+			else
+				fprintf(stream, "\n");
+			if (json_arr_lvl[json_curnt_arr_lvl] == indent)
+				fprintf(stream, "%*.*s[",indent,indent," ");
+			else
+				fprintf(stream, "%*.*s\"%s\":[", indent, indent, " ", node->key);
+			indent += 4;
+			json_prnt_comma = 0;
+			json_arr_lvl[json_curnt_arr_lvl+1] = indent;
+			json_curnt_arr_lvl++;
+			break;
+
+		case JSON_ARRAY_END:
+			last_array_value = 1;
+			break;
+
+		case JSON_VALUE:
+			break;
+
+		default:
+			return 1;
+	}
+	switch (node->value_type) {
+		case JSON_STRING:
+			if (json_prnt_comma)
+				fprintf(stream, ",\n");
+			else
+				fprintf(stream, "\n");
+			if (json_arr_lvl[json_curnt_arr_lvl]==indent)
+				fprintf(stream, "%*.*s\"%s\"", indent, indent, " ", node->value.string);
+			else
+				fprintf(stream, "%*.*s\"%s\":\"%s\"", indent, indent, " ", node->key, node->value.string);
+			json_prnt_comma = 1;
+			break;
+
+		case JSON_INT:
+			if (json_prnt_comma)
+				fprintf(stream, ",\n");
+			else
+				fprintf(stream, "\n");
+
+			if (json_arr_lvl[json_curnt_arr_lvl] == indent)
+				fprintf(stream, "%*.*s%ld",indent,indent," ", node->value.inumber);
+			else
+				fprintf(stream, "%*.*s\"%s\":%ld", indent, indent, " ", node->key, node->value.inumber);
+			json_prnt_comma = 1;
+			break;
+		case JSON_FLOAT:
+			if (json_prnt_comma)
+				fprintf(stream, ",\n");
+			else
+				fprintf(stream, "\n");
+
+
+			if (json_arr_lvl[json_curnt_arr_lvl] == indent)
+				fprintf(stream, "%*.*s%lf",indent,indent," ", node->value.fnumber);
+			else
+				fprintf(stream, "%*.*s\"%s\":%lf", indent, indent, " ", node->key, node->value.fnumber);
+			json_prnt_comma = 1;
+			break;
+
+		case JSON_NULL:
+			break;
+
+		default:
+			return 1;
+	}
+
+	if (last_array_value) {
+		indent -= 4;
+		fprintf(stream, "\n%*.*s]", indent, indent, " ");
+		json_curnt_arr_lvl--;
+		json_prnt_comma = 1;
+	} else if (last_object_value) {
+		indent -= 4;
+		fprintf(stream, "\n%*.*s}", indent, indent, " ");
+		json_prnt_comma = 1;
+	}
+	json_indent = indent;
+	return 0;
+}
+
+/**
+ * @brief
+ *	free the list of json nodes not written yet
+ *
+ * @return	Void
+ *
+ */
+static void
+free_json_list() {
+
+	JsonLink *link = head;
+	while (link != NULL) {
+		if (link->node->value_type == JSON_STRING) {
+			if (link->node->value.string != NULL)
+				free(link->node->value.string);
 		}
-		buf[i] = '\0';
+		if (link->node->key != NULL)
+			free(link->node->key);
+		free(link->node);
+		head = link->next;
+		free(link);
+		link = head;
 	}
-	return buf;
+	head = NULL;
+	prev_link = NULL;
 }
 
 /**
  * @brief
  *	add node to json list
  *
+ * @par
+ *	After json_stream_open() the node is written out right away and
+ *	is not kept; the returned pointer is only good until the next call.
+ *
  * @param[in] ntype - node type
  * @param[in] vtype - value type
  * @param[in] key - node key
@@ -205,20 +408,27 @@ add_json_node(JsonNodeType ntype, JsonValueType vtype, JsonEscapeType esc_type,
 	long int  ivalue = 0;
 	JsonNode  *node = NULL;
 
-	node = create_json_node();
-	if (node == NULL) {
-		fprintf(stderr, "Json Node: out of memory\n");
-		return NULL;
-	}
-	node->node_type = ntype;
-	if (key != NULL) {
-		ptr = strdup((char *)key);
-		if (ptr == NULL) {
+	if (json_stream != NULL) {
+		node = &json_stream_node;
+		node->node_type  = JSON_VALUE;
+		node->value_type = JSON_NULL;
+		node->key = key;
+	} else {
+		node = create_json_node();
+		if (node == NULL) {
 			fprintf(stderr, "Json Node: out of memory\n");
 			return NULL;
 		}
-		node->key = ptr;
+		if (key != NULL) {
+			ptr = strdup((char *)key);
+			if (ptr == NULL) {
+				fprintf(stderr, "Json Node: out of memory\n");
+				return NULL;
+			}
+			node->key = ptr;
+		}
 	}
+	node->node_type = ntype;
 	if (vtype == JSON_NULL && value != NULL) {
 		val = strtod(value, &pc);
 		while (pc) {
@@ -247,6 +457,19 @@ add_json_node(JsonNodeType ntype, JsonValueType vtype, JsonEscapeType esc_type,
 			node->value.fnumber = *((double *)value);
 	}
 
+	if (json_stream != NULL) {
+		if (node->value_type == JSON_STRING) {
+			if (escape_into(esc_type, value != NULL ? value : "",
+				&json_escbuf, &json_escbuf_len)) {
+				fprintf(stderr, "Json Node: out of memory\n");
+				return NULL;
+			}
+			node->value.string = json_escbuf;
+		}
+		if (emit_json_node(node))
+			return NULL;
+		return node;
+	}
 
 	if (node->value_type == JSON_STRING) {
 		if (value != NULL) {
@@ -267,7 +490,7 @@ add_json_node(JsonNodeType ntype, JsonValueType vtype, JsonEscapeType esc_type,
 
 /**
  * @brief
- *	frees a json node
+ *	frees the json nodes and ends any json output in progress
  *
  * @return	Void
  *
@@ -275,29 +498,20 @@ add_json_node(JsonNodeType ntype, JsonValueType vtype, JsonEscapeType esc_type,
 void
 free_json_node() {
 
-	JsonLink *link = head;
-	while (link != NULL) {
-		if (link->node->value_type == JSON_STRING) {
-			if (link->node->value.string != NULL)
-				free(link->node->value.string);
-		}
-		if (link->node->key != NULL)
-			free(link->node->key);
-		free(link->node);
-		head = link->next;
-		free(link);
-		link = head;
-	}
-	head = NULL;
-	prev_link = NULL;
+	free_json_list();
+	json_stream = NULL;
+	free(json_escbuf);
+	json_escbuf = NULL;
+	json_escbuf_len = 0;
 }
 
 /**
  * @brief
- *	generate_json_node
- *	Takes a JsonNode type link list and file stream as an input.
- * 	Reads the link-list node by node and write the json output
- * 	on the passed file stream.
+ *	json_stream_open
+ *	Start json output on the passed file stream.  Writes the opening
+ * 	brace and the nodes added so far; nodes added from now on are
+ * 	written as they are added, so the output does not have to be held
+ * 	in memory.
  *
  * @param[in] stream - fd to which json o/p written
  *
@@ -307,133 +521,50 @@ free_json_node() {
  *
  */
 int
-generate_json(FILE * stream) {
-	int	  indent = 0;
-	int	  prnt_comma = 0;
-	int	  last_object_value = 0;
-	int	  last_array_value = 0;
-	int	 *arr_lvl = NULL;
-	int	  curnt_arr_lvl= 0;
-	JsonNode *node = NULL;
-	JsonLink *link = head;
-
-	fprintf(stream, "{");
-	indent += 4;
-	arr_lvl = malloc(ARRAY_NESTING_LEVEL * sizeof(int*));
-	memset(arr_lvl, 0, (ARRAY_NESTING_LEVEL * sizeof(int)));
-
-	while (link) {
-		node = link->node;
-		switch (node->node_type) {
-			case JSON_OBJECT:
-				if (prnt_comma)
-					fprintf(stream, ",\n");
-				else
-					fprintf(stream, "\n");
-				if (arr_lvl[curnt_arr_lvl] == indent)
-					fprintf(stream, "%*.*s{", indent, indent, " ");
-				else
-					fprintf(stream, "%*.*s\"%s\":{", indent, indent, " ", node->key);
-				indent += 4;
-				prnt_comma = 0;
-				/*moving to next node since there's no value associated within an OBJECT type node*/
-				link = link->next;
-				continue;
-
-			case JSON_OBJECT_END:
-				last_object_value = 1;
-				break;
+json_stream_open(FILE *stream) {
+	JsonLink *link;
 
-			case JSON_ARRAY:
-				if (prnt_comma)
-					fprintf(stream, ",\n");
-				else
-					fprintf(stream, "\n");
-				if (arr_lvl[curnt_arr_lvl] == indent)
-					fprintf(stream, "%*.*s[",indent,indent," ");
-				else
-					fprintf(stream, "%*.*s\"%s\":[", indent, indent, " ", node->key);
-				indent += 4;
-				prnt_comma = 0;
-				arr_lvl[curnt_arr_lvl+1] = indent;
-				curnt_arr_lvl++;
-				break;
-
-			case JSON_ARRAY_END:
-				last_array_value = 1;
-				break;
-
-			case JSON_VALUE:
-				break;
-
-			default:
-				free(arr_lvl);
-				return 1;
-		}
-		switch (node->value_type) {
-			case JSON_STRING:
-				if (prnt_comma)
-					fprintf(stream, ",\n");
-				else
-					fprintf(stream, "\n");
-				if (arr_lvl[curnt_arr_lvl]==indent)
-					fprintf(stream, "%*.*s\"%s\"", indent, indent, " ", node->value.string);
-				else
-					fprintf(stream, "%*.*s\"%s\":\"%s\"", indent, indent, " ", node->key, node->value.string);
-				prnt_comma = 1;
-				break;
-
-			case JSON_INT:
-				if (prnt_comma)
-					fprintf(stream, ",\n");
-				else
-					fprintf(stream, "\n");
-
-				if (arr_lvl[curnt_arr_lvl] == indent)
-					fprintf(stream, "%*.*s%ld",indent,indent," ", node->value.inumber);
-				else
-					fprintf(stream, "%*.*s\"%s\":%ld", indent, indent, " ", node->key, node->value.inumber);
-				prnt_comma = 1;
-				break;
-			case JSON_FLOAT:
-				if (prnt_comma)
-					fprintf(stream, ",\n");
-				else
-					fprintf(stream, "\n");
-
-
-				if (arr_lvl[curnt_arr_lvl] == indent)
-					fprintf(stream, "%*.*s%lf",indent,indent," ", node->value.fnumber);
-				else
-					fprintf(stream, "%*.*s\"%s\":%lf", indent, indent, " ", node->key, node->value.fnumber);
-				prnt_comma = 1;
-				break;
+	if (json_stream != NULL)
+		return (json_stream == stream ? 0 : 1);
 
-			case JSON_NULL:
-				break;
+	json_stream = stream;
+	json_indent = 0;
+	json_prnt_comma = 0;
+	json_curnt_arr_lvl = 0;
+	memset(json_arr_lvl, 0, sizeof(json_arr_lvl));
 
-			default:
-				free(arr_lvl);
-				return 1;
-		}
+	fprintf(stream, "{");
+	json_indent += 4;
 
-		if (last_array_value) {
-			indent -= 4;
-			fprintf(stream, "\n%*.*s]", indent, indent, " ");
-			last_array_value = 0;
-			curnt_arr_lvl--;
-			prnt_comma = 1;
-		} else if (last_object_value) {
-			indent -= 4;
-			fprintf(stream, "\n%*.*s}", indent, indent, " ");
-			last_object_value = 0;
-			prnt_comma = 1;
+	for (link = head; link != NULL; link = link->next) {
+		if (emit_json_node(link->node)) {
+			free_json_list();
+			return 1;
 		}
-		link = link->next;
 	}
-	free(arr_lvl);
-	indent -= 4;
-	if (indent != 0)
+	free_json_list();
+	return 0;
+}
+
+/**
+ * @brief
+ *	generate_json_node
+ *	Finishes the json output on the passed file stream, writing any
+ * 	nodes not written yet and the closing brace.
+ *
+ * @param[in] stream - fd to which json o/p written
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	1	error
+ *
+ */
+int
+generate_json(FILE * stream) {
+	if (json_stream_open(stream))
+		return 1;
+	json_indent -= 4;
+	if (json_indent != 0)
 		return 1;
 	fprintf(stream, "\n}\n");
 	return 0;
@@ -516,6 +516,37 @@ pbs_db_execute_str(pbs_db_conn_t *conn, char *sql)
 	return 0;
 }
 
+/**
+ * @brief
+ *	Take a number from the job save sequence.  Job rows saved from then
+ *	on get a higher ji_saveseq.
+ *
+ * @param[in]	conn - Connected database handle
+ * @param[out]	pseq - The sequence number
+ *
+ * @return      Error code
+ * @retval	-1  - Error
+ * @retval       0  - success
+ *
+ */
+int
+pbs_db_get_job_saveseq(pbs_db_conn_t *conn, BIGINT *pseq)
+{
+	PGresult *res;
+	char *sql = "select nextval('pbs.job_saveseq')";
+
+	res = PQexec((PGconn*) conn->conn_db_handle, sql);
+	if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) != 1) {
+		pg_set_error(conn, "Execution of string statement\n", sql);
+		PQclear(res);
+		return -1;
+	}
+	*pseq = strtoll(PQgetvalue(res, 0, 0), NULL, 10);
+
+	PQclear(res);
+	return 0;
+}
+
 /**
  * @brief
  *	Check whether connection to pbs dataservice is fine
@@ -124,6 +124,7 @@ pg_db_prepare_job_sqls(pbs_db_conn_t *conn)
 		"ji_credtype = $22,"
 		"ji_qrank = $23,"
 		"ji_savetm = localtimestamp,"
+		"ji_saveseq = nextval('pbs.job_saveseq'),"
 		"attributes = attributes || hstore($24::text[]) "
 		"where ji_jobid = $1");
 	if (pg_prepare_stmt(conn, STMT_UPDATE_JOB, conn->conn_sql, 24) != 0)
@@ -131,6 +132,7 @@ pg_db_prepare_job_sqls(pbs_db_conn_t *conn)
 
 	snprintf(conn->conn_sql, MAX_SQL_LENGTH, "update pbs.job set "
 		"ji_savetm = localtimestamp,"
+		"ji_saveseq = nextval('pbs.job_saveseq'),"
 		"attributes = attributes - hstore($2::text[]) "
 		"where ji_jobid = $1");
 	if (pg_prepare_stmt(conn, STMT_REMOVE_JOBATTRS, conn->conn_sql, 2) != 0)
@@ -159,7 +161,8 @@ pg_db_prepare_job_sqls(pbs_db_conn_t *conn)
 		"ji_4ash = $21,"
 		"ji_credtype = $22,"
 		"ji_qrank = $23,"
-		"ji_savetm = localtimestamp "
+		"ji_savetm = localtimestamp,"
+		"ji_saveseq = nextval('pbs.job_saveseq') "
 		"where ji_jobid = $1");
 	if (pg_prepare_stmt(conn, STMT_UPDATE_JOB_QUICK, conn->conn_sql, 23) != 0)
 		return -1;
@@ -287,6 +290,39 @@ pg_db_prepare_job_sqls(pbs_db_conn_t *conn)
 		conn->conn_sql, 1) != 0)
 		return -1;
 
+	snprintf(conn->conn_sql, MAX_SQL_LENGTH, "select "
+		"ji_jobid,"
+		"ji_state,"
+		"ji_substate,"
+		"ji_svrflags,"
+		"ji_numattr,"
+		"ji_ordering,"
+		"ji_priority,"
+		"ji_stime,"
+		"ji_endtBdry,"
+		"ji_queue,"
+		"ji_destin,"
+		"ji_un_type,"
+		"ji_momaddr,"
+		"ji_momport,"
+		"ji_exitstat,"
+		"ji_quetime,"
+		"ji_rteretry,"
+		"ji_fromsock,"
+		"ji_fromaddr,"
+		"ji_4jid,"
+		"ji_4ash,"
+		"ji_credtype,"
+		"ji_qrank,"
+		"extract(epoch from ji_savetm)::bigint as ji_savetm, "
+		"extract(epoch from ji_creattm)::bigint as ji_creattm, "
+		"case when ji_saveseq > $1 "
+		"then hstore_to_array(attributes) end as attributes "
+		"from pbs.job order by ji_qrank");
+	if (pg_prepare_stmt(conn, STMT_FINDJOBS_SINCE_ORDBY_QRANK,
+		conn->conn_sql, 1) != 0)
+		return -1;
+
 	snprintf(conn->conn_sql, MAX_SQL_LENGTH, "delete from pbs.job where ji_jobid = $1");
 	if (pg_prepare_stmt(conn, STMT_DELETE_JOB, conn->conn_sql, 1) != 0)
 		return -1;
@@ -380,6 +416,13 @@ load_job(const  PGresult *res, pbs_db_job_info_t *pj, int row)
 	GET_PARAM_INTEGER(res, row, pj->ji_qrank, ji_qrank_fnum);
 	GET_PARAM_BIGINT(res, row, pj->ji_savetm, ji_savetm_fnum);
 	GET_PARAM_BIGINT(res, row, pj->ji_creattm, ji_creattm_fnum);
+
+	/* see FIND_JOBS_ATTRS_SINCE */
+	if (PQgetisnull(res, row, attributes_fnum)) {
+		pj->attr_list.attr_count = 0;
+		pj->attr_list.attributes = NULL;
+		return 0;
+	}
 	GET_PARAM_BIN(res, row, raw_array, attributes_fnum);
 
 	/* convert attributes from postgres raw array format */
@@ -523,6 +566,10 @@ pg_db_find_job(pbs_db_conn_t *conn, void *st, pbs_db_obj_info_t *obj,
 		SET_PARAM_STR(conn, pdjob->ji_queue, 0);
 		params=1;
 		strcpy(conn->conn_sql, STMT_FINDJOBS_BYQUE_ORDBY_QRANK);
+	} else if (opts != NULL && opts->flags == FIND_JOBS_ATTRS_SINCE) {
+		SET_PARAM_BIGINT(conn, opts->saveseq, 0);
+		params=1;
+		strcpy(conn->conn_sql, STMT_FINDJOBS_SINCE_ORDBY_QRANK);
 	} else {
 		strcpy(conn->conn_sql, STMT_FINDJOBS_ORDBY_QRANK);
 		params=0;
@@ -121,8 +121,14 @@ struct pbs_config pbs_conf = {
 	NULL,					/* for router, default communication routers list */
 	0,					/* default comm logevent mask */
 	4,					/* default number of threads */
+	-1,					/* pbs_comm data coalescing disabled */
 	NULL,					/* mom short name override */
-	0					/* high resolution timestamp logging */
+	0,					/* high resolution timestamp logging */
+	0,					/* synchronous logging */
+	0,					/* no binary accounting */
+	0,					/* no job snapshots */
+	PBS_COMPRESSION_CODEC_ZLIB,		/* compress communication data with zlib */
+	PBS_COMPRESSION_THRESHOLD_DEFAULT	/* compress messages larger than 8k */
 #ifdef WIN32
 	,NULL					/* remote viewer launcher executable along with launch options */
 #endif
@@ -249,6 +255,29 @@ parse_config_line(FILE *fp, char **key, char **val)
 	return ret;
 }
 
+/**
+ * @brief
+ *	parse_compression_codec - Set pbs_compression_codec from its name
+ *
+ * @param[in] value	codec name, "zlib" or "lz4"
+ *
+ * @return int
+ * @retval 0 codec recognized
+ * @retval -1 unknown codec, zlib is used
+ */
+static int
+parse_compression_codec(char *value)
+{
+	if (strcasecmp(value, "lz4") == 0) {
+		pbs_conf.pbs_compression_codec = PBS_COMPRESSION_CODEC_LZ4;
+		return 0;
+	}
+	pbs_conf.pbs_compression_codec = PBS_COMPRESSION_CODEC_ZLIB;
+	if (strcasecmp(value, "zlib") == 0)
+		return 0;
+	return -1;
+}
+
 /**
  * @brief
  *	pbs_loadconf - Populate the pbs_conf structure
@@ -285,6 +314,7 @@ pbs_loadconf(int reload)
 	char *conf_value;		/* the value from the conf file or env*/
 	char *gvalue;			/* used with getenv() */
 	unsigned int uvalue;		/* used with sscanf() */
+	int ivalue;			/* used with sscanf() */
 #ifndef WIN32
 	struct servent *servent;	/* for use with getservent */
 	char **servalias;		/* service alias list */
@@ -447,6 +477,15 @@ pbs_loadconf(int reload)
 				if (sscanf(conf_value, "%u", &uvalue) == 1)
 					pbs_conf.pbs_use_compression = ((uvalue > 0) ? 1 : 0);
 			}
+			else if (!strcmp(conf_name, PBS_CONF_COMPRESSION_CODEC)) {
+				if (parse_compression_codec(conf_value) == -1)
+					fprintf(stderr, "Unknown %s value %s, using zlib\n",
+						PBS_CONF_COMPRESSION_CODEC, conf_value);
+			}
+			else if (!strcmp(conf_name, PBS_CONF_COMPRESSION_THRESHOLD)) {
+				if (sscanf(conf_value, "%u", &uvalue) == 1)
+					pbs_conf.pbs_compression_threshold = uvalue;
+			}
 			else if (!strcmp(conf_name, PBS_CONF_USE_MCAST)) {
 				if (sscanf(conf_value, "%u", &uvalue) == 1)
 					pbs_conf.pbs_use_mcast = ((uvalue > 0) ? 1 : 0);
@@ -479,6 +518,10 @@ pbs_loadconf(int reload)
 				if (sscanf(conf_value, "%u", &uvalue) == 1)
 					pbs_conf.pbs_comm_threads = uvalue;
 			}
+			else if (!strcmp(conf_name, PBS_CONF_COMM_COALESCE_DELAY)) {
+				if (sscanf(conf_value, "%d", &ivalue) == 1)
+					pbs_conf.pbs_comm_coalesce_delay = ivalue;
+			}
 			else if (!strcmp(conf_name, PBS_CONF_COMM_LOG_EVENTS)) {
 				if (sscanf(conf_value, "%u", &uvalue) == 1)
 					pbs_conf.pbs_comm_log_events = uvalue;
@@ -570,6 +613,18 @@ pbs_loadconf(int reload)
 				if (sscanf(conf_value, "%u", &uvalue) == 1)
 					pbs_conf.pbs_log_highres_timestamp = ((uvalue > 0) ? 1 : 0);
 			}
+			else if (!strcmp(conf_name, PBS_CONF_LOG_ASYNC)) {
+				if (sscanf(conf_value, "%u", &uvalue) == 1)
+					pbs_conf.pbs_log_async = uvalue;
+			}
+			else if (!strcmp(conf_name, PBS_CONF_ACCT_BINARY)) {
+				if (sscanf(conf_value, "%u", &uvalue) == 1)
+					pbs_conf.pbs_acct_binary = ((uvalue > 0) ? 1 : 0);
+			}
+			else if (!strcmp(conf_name, PBS_CONF_SERVER_SNAPSHOT)) {
+				if (sscanf(conf_value, "%u", &uvalue) == 1)
+					pbs_conf.pbs_server_snapshot = uvalue;
+			}
 #ifdef WIN32
 			else if (!strcmp(conf_name, PBS_CONF_REMOTE_VIEWER)) {
 				free(pbs_conf.pbs_conf_remote_viewer);
@@ -723,6 +778,15 @@ pbs_loadconf(int reload)
 		if (sscanf(gvalue, "%u", &uvalue) == 1)
 			pbs_conf.pbs_use_compression = ((uvalue > 0) ? 1 : 0);
 	}
+	if ((gvalue = getenv(PBS_CONF_COMPRESSION_CODEC)) != NULL) {
+		if (parse_compression_codec(gvalue) == -1)
+			fprintf(stderr, "Unknown %s value %s, using zlib\n",
+				PBS_CONF_COMPRESSION_CODEC, gvalue);
+	}
+	if ((gvalue = getenv(PBS_CONF_COMPRESSION_THRESHOLD)) != NULL) {
+		if (sscanf(gvalue, "%u", &uvalue) == 1)
+			pbs_conf.pbs_compression_threshold = uvalue;
+	}
 	if ((gvalue = getenv(PBS_CONF_USE_MCAST)) != NULL) {
 		if (sscanf(gvalue, "%u", &uvalue) == 1)
 			pbs_conf.pbs_use_mcast = ((uvalue > 0) ? 1 : 0);
@@ -755,6 +819,10 @@ pbs_loadconf(int reload)
 		if (sscanf(gvalue, "%u", &uvalue) == 1)
 			pbs_conf.pbs_comm_threads = uvalue;
 	}
+	if ((gvalue = getenv(PBS_CONF_COMM_COALESCE_DELAY)) != NULL) {
+		if (sscanf(gvalue, "%d", &ivalue) == 1)
+			pbs_conf.pbs_comm_coalesce_delay = ivalue;
+	}
 	if ((gvalue = getenv(PBS_CONF_COMM_LOG_EVENTS)) != NULL) {
 		if (sscanf(gvalue, "%u", &uvalue) == 1)
 			pbs_conf.pbs_comm_log_events = uvalue;
@@ -801,6 +869,18 @@ pbs_loadconf(int reload)
 		if (sscanf(gvalue, "%u", &uvalue) == 1)
 			pbs_conf.pbs_log_highres_timestamp = ((uvalue > 0) ? 1 : 0);
 	}
+	if ((gvalue = getenv(PBS_CONF_LOG_ASYNC)) != NULL) {
+		if (sscanf(gvalue, "%u", &uvalue) == 1)
+			pbs_conf.pbs_log_async = uvalue;
+	}
+	if ((gvalue = getenv(PBS_CONF_ACCT_BINARY)) != NULL) {
+		if (sscanf(gvalue, "%u", &uvalue) == 1)
+			pbs_conf.pbs_acct_binary = ((uvalue > 0) ? 1 : 0);
+	}
+	if ((gvalue = getenv(PBS_CONF_SERVER_SNAPSHOT)) != NULL) {
+		if (sscanf(gvalue, "%u", &uvalue) == 1)
+			pbs_conf.pbs_server_snapshot = uvalue;
+	}
 
 #ifdef WIN32
 	if ((gvalue = getenv(PBS_CONF_REMOTE_VIEWER)) != NULL) {
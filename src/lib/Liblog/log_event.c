@@ -44,6 +44,7 @@
  *
  * @par Functions included are:
  *	log_event()
+ *	log_eventf()
  *	log_change()
  */
 
@@ -56,6 +57,7 @@
 #include <time.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include "log.h"
 #include "server_limits.h"
 #include "list_link.h"
@@ -122,3 +124,34 @@ log_event(int eventtype, int objclass, int sev, const char *objname, const char
 	if (will_log_event(eventtype))
 		log_record(eventtype, objclass, sev, objname, text);
 }
+
+/**
+ * @brief
+ * 	log_eventf - format and log a server event to the log file
+ *
+ *	Like log_event(), but takes a printf style format and arguments.
+ *	The message is only formatted when the event type is being
+ *	recorded, so callers need not build it into log_buffer first.
+ *
+ * @param[in] eventtype - event type
+ * @param[in] objclass - event object class
+ * @param[in] sev - indication for whether to syslogging enabled or not
+ * @param[in] objname - object name stating log msg related to which object
+ * @param[in] fmt - printf style format of the log msg
+ * @param[in] ... - arguments for fmt
+ */
+
+void
+log_eventf(int eventtype, int objclass, int sev, const char *objname, const char *fmt, ...)
+{
+	va_list args;
+	char buf[LOG_BUF_SIZE];
+
+	if (!will_log_event(eventtype))
+		return;
+
+	va_start(args, fmt);
+	vsnprintf(buf, sizeof(buf), fmt, args);
+	va_end(args);
+	log_record(eventtype, objclass, sev, objname, buf);
+}
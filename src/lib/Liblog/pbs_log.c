@@ -47,6 +47,8 @@
  *	log_err()
  *	log_joberr()
  *	log_record()
+ *	log_async_start()
+ *	log_async_stop()
  *	log_close()
  *	log_add_debug_info()
  *	log_add_if_info()
@@ -71,6 +73,9 @@
 #include <errno.h>
 #include <stdlib.h>
 #include <pthread.h>
+#ifndef WIN32
+#include <poll.h>
+#endif
 #include "log.h"
 #include "pbs_ifl.h"
 #include "pbs_internal.h"
@@ -111,6 +116,36 @@ static volatile int  log_opened = 0;
 static int	     syslogopen = 0;
 #endif	/* SYSLOG */
 
+#ifndef WIN32
+/*
+ * Async logging: log_record() copies each record into a bounded ring and
+ * a writer thread formats and writes them. See log_async_start().
+ */
+#define LOG_ASYNC_OBJNAME	512	/* longer object names are truncated */
+#define LOG_WRITER_POLL_MS	100	/* writer rechecks the ring this often */
+#define LOG_ASYNC_MAX_RECS	65536	/* a slot takes about 5k, cap the ring */
+
+typedef struct {
+	volatile unsigned long seq;	/* slot state, see log_async_put() */
+	struct timeval tv;
+	int eventtype;
+	int objclass;
+	char objname[LOG_ASYNC_OBJNAME];
+	char text[LOG_BUF_SIZE];
+} log_rec_t;
+
+static log_rec_t	      *log_ring = NULL;
+static unsigned long	       log_ring_mask;
+static volatile unsigned long  log_ring_head;	/* next slot to fill */
+static volatile unsigned long  log_ring_tail;	/* next slot to write */
+static volatile unsigned long  log_dropped;	/* records dropped, ring full */
+static volatile int	       log_async_active = 0;
+static volatile int	       log_writer_idle;
+static volatile int	       log_writer_stop;
+static pthread_t	       log_writer_id;
+static int		       log_wake_pipe[2] = {-1, -1};
+#endif
+
 /*
  * the order of these names MUST match the defintions of
  * PBS_EVENTCLASS_* in log.h
@@ -353,12 +388,14 @@ log_atfork_parent()
 
 /**
  * @brief
- *	wrapper function for log_mutex_unlock().
+ *	wrapper function for log_mutex_unlock(). The log writer thread
+ *	does not exist in the child, so the child logs synchronously.
  *
  */
 void
 log_atfork_child()
 {
+	log_async_active = 0;
 	log_mutex_unlock();
 }
 #endif
@@ -841,73 +878,59 @@ log_suspect_file(const char *func, const char *text, const char *file, struct st
 
 /**
  * @brief
- * 	log_record - log a message to the log file
- *	The log file must have been opened by log_open().
- *
- *	The caller should ensure proper formating of the message if "text"
- *	is to contain "continuation lines".
+ *	log_write_record - format a record and write it to the log file,
+ *	switching the log first if the day has changed.
  *
+ * @param[in] tp - time of the record
  * @param[in] eventtype - event type
  * @param[in] objclass - event object class
- * @param[in] sev - indication for whether to syslogging enabled or not
  * @param[in] objname - object name stating log msg related to which object
  * @param[in] text - log msg to be logged.
  *
- *	Note, "sev" (for severity) is used  only if syslogging is enabled.
- *	See syslog(3) for details.
+ * @par
+ *	The "MM/DD/YYYY hh:mm:ss" prefix is formatted once per second and
+ *	cached, so a burst of records does not call localtime for each one.
+ *
+ * @par MT-safe: Yes, takes the log mutex
  */
-
-void
-log_record(int eventtype, int objclass, int sev, const char *objname, const char *text)
+static void
+log_write_record(struct timeval *tp, int eventtype, int objclass, const char *objname, const char *text)
 {
-	time_t now = 0;
+	static time_t ts_sec = -1;	/* second of the cached prefix */
+	static int ts_yday;		/* day of the year of the cached prefix */
+	static char ts_prefix[80];	/* cached "MM/DD/YYYY hh:mm:ss", sized for any int fields */
+	time_t now;
 	struct tm *ptm;
 #ifndef WIN32
 	struct tm ltm;
 #endif
 	int    rc = 0;
 	FILE  *savlog;
-	static char slogbuf[LOG_BUF_SIZE];
-	struct timeval tp;
 	char microsec_buf[8] = {0};
 
-#if SYSLOG
-	if (syslogopen != 0) {
-		snprintf(slogbuf, LOG_BUF_SIZE,
-			"%s;%s;%s\n",
-			class_names[objclass],
-			objname,
-			text);
-		syslog(sev, "%s", slogbuf);
-	}
-#endif  /* SYSLOG */
-
-	if (log_opened <= 0)
-		return;
+	if (pbs_conf.pbs_log_highres_timestamp)
+		snprintf(microsec_buf, sizeof(microsec_buf), ".%06ld", (long)tp->tv_usec);
 
-	if ((text == NULL) || (objname == NULL))
+	/* lock the log mutex */
+	if (log_mutex_lock() != 0)
 		return;
 
-	/* if gettimeofday() fails, log messages will be printed at the epoch */
-	if (gettimeofday(&tp, NULL) != -1) {
-		now = tp.tv_sec;
-
-		if (pbs_conf.pbs_log_highres_timestamp)
-			snprintf(microsec_buf, sizeof(microsec_buf), ".%06ld", (long)tp.tv_usec);
-	}
-
+	if (tp->tv_sec != ts_sec) {
+		now = tp->tv_sec;
 #ifdef WIN32
-	ptm = localtime(&now);
+		ptm = localtime(&now);
 #else
-	ptm = localtime_r(&now, &ltm);
+		ptm = localtime_r(&now, &ltm);
 #endif
-
-	/* lock the log mutex */
-	if (log_mutex_lock() != 0)
-		return;
+		snprintf(ts_prefix, sizeof(ts_prefix), "%02d/%02d/%04d %02d:%02d:%02d",
+			ptm->tm_mon + 1, ptm->tm_mday, ptm->tm_year + 1900,
+			ptm->tm_hour, ptm->tm_min, ptm->tm_sec);
+		ts_yday = ptm->tm_yday;
+		ts_sec = now;
+	}
 
 	/* Do we need to switch the log? */
-	if (log_auto_switch && (ptm->tm_yday != log_open_day)) {
+	if (log_auto_switch && (ts_yday != log_open_day)) {
 		log_close(1);
 		log_open(NULL, log_directory);
 	}
@@ -924,10 +947,8 @@ log_record(int eventtype, int objclass, int sev, const char *objname, const char
 	}
 
 	if (pbs_conf.locallog != 0 || pbs_conf.syslogfac == 0) {
-		rc = fprintf(logfile,
-			     "%02d/%02d/%04d %02d:%02d:%02d%s;%04x;%s;%s;%s;%s\n",
-			     ptm->tm_mon + 1, ptm->tm_mday, ptm->tm_year + 1900,
-			     ptm->tm_hour, ptm->tm_min, ptm->tm_sec, microsec_buf,
+		rc = fprintf(logfile, "%s%s;%04x;%s;%s;%s;%s\n",
+			     ts_prefix, microsec_buf,
 			     eventtype & ~PBSEVENT_FORCE, msg_daemonname,
 			     class_names[objclass], objname, text);
 
@@ -960,6 +981,342 @@ log_record(int eventtype, int objclass, int sev, const char *objname, const char
 	}
 }
 
+#ifndef WIN32
+/**
+ * @brief
+ *	log_async_put - copy a record into the log ring for the writer thread.
+ *
+ * @par
+ *	Each slot carries a sequence number: a producer claims the slot at
+ *	the head by advancing log_ring_head, fills it and then publishes it
+ *	by setting its sequence to pos + 1; the writer frees it again by
+ *	setting the sequence to pos + ring size. If the slot at the head has
+ *	not yet been freed, the ring is full and the record is dropped.
+ *	No lock is taken, so this may be called from a signal handler.
+ *
+ * @param[in] tp - time of the record
+ * @param[in] eventtype - event type
+ * @param[in] objclass - event object class
+ * @param[in] objname - object name
+ * @param[in] text - log msg to be logged.
+ */
+static void
+log_async_put(struct timeval *tp, int eventtype, int objclass, const char *objname, const char *text)
+{
+	unsigned long pos;
+	long dif;
+	size_t len;
+	log_rec_t *rec;
+
+	pos = log_ring_head;
+	for (;;) {
+		rec = &log_ring[pos & log_ring_mask];
+		dif = (long) (rec->seq - pos);
+		if (dif == 0) {
+			if (__sync_bool_compare_and_swap(&log_ring_head, pos, pos + 1))
+				break;
+		} else if (dif < 0) {
+			__sync_add_and_fetch(&log_dropped, 1);
+			return;
+		}
+		pos = log_ring_head;
+	}
+
+	rec->tv = *tp;
+	rec->eventtype = eventtype;
+	rec->objclass = objclass;
+	len = strlen(objname);
+	if (len >= sizeof(rec->objname))
+		len = sizeof(rec->objname) - 1;
+	memcpy(rec->objname, objname, len);
+	rec->objname[len] = '\0';
+	len = strlen(text);
+	if (len >= sizeof(rec->text))
+		len = sizeof(rec->text) - 1;
+	memcpy(rec->text, text, len);
+	rec->text[len] = '\0';
+
+	__sync_synchronize();
+	rec->seq = pos + 1;
+
+	if (log_writer_idle)
+		(void)write(log_wake_pipe[1], "", 1);
+}
+
+/**
+ * @brief
+ *	log_async_drain - write the records at the tail of the log ring
+ *	until reaching one that has not been published yet.
+ *
+ * @par
+ *	Only one thread drains at a time: the writer thread, or the thread
+ *	that stopped it.
+ */
+static void
+log_async_drain(void)
+{
+	log_rec_t *rec;
+
+	for (;;) {
+		rec = &log_ring[log_ring_tail & log_ring_mask];
+		if (rec->seq != log_ring_tail + 1)
+			break;
+		__sync_synchronize();
+		log_write_record(&rec->tv, rec->eventtype, rec->objclass,
+			rec->objname, rec->text);
+		__sync_synchronize();
+		rec->seq = log_ring_tail + log_ring_mask + 1;
+		log_ring_tail++;
+	}
+}
+
+/**
+ * @brief
+ *	log_writer - body of the log writer thread. Writes the records in
+ *	the log ring in order, and after each batch logs how many records
+ *	were dropped because the ring was full, if any.
+ *
+ * @param[in] arg - unused
+ *
+ * @return NULL
+ */
+static void *
+log_writer(void *arg)
+{
+	unsigned long dropped;
+	struct timeval tp;
+	struct pollfd pfd;
+	char buf[64];
+
+	pfd.fd = log_wake_pipe[0];
+	pfd.events = POLLIN;
+
+	for (;;) {
+		log_async_drain();
+
+		if ((dropped = __sync_fetch_and_and(&log_dropped, 0)) != 0) {
+			snprintf(buf, sizeof(buf),
+				"%lu log records dropped, log buffer full", dropped);
+			gettimeofday(&tp, NULL);
+			log_write_record(&tp, PBSEVENT_ERROR | PBSEVENT_FORCE,
+				PBS_EVENTCLASS_SERVER, msg_daemonname, buf);
+		}
+
+		if (log_writer_stop)
+			break;
+
+		/* ring is empty, sleep until a producer wakes us */
+		log_writer_idle = 1;
+		__sync_synchronize();
+		if (log_ring[log_ring_tail & log_ring_mask].seq != log_ring_tail + 1) {
+			if (poll(&pfd, 1, LOG_WRITER_POLL_MS) > 0)
+				while (read(log_wake_pipe[0], buf, sizeof(buf)) > 0)
+					;
+		}
+		log_writer_idle = 0;
+	}
+	return NULL;
+}
+
+/**
+ * @brief
+ *	log_async_flush - wait until the writer thread has written every
+ *	record queued before the call.
+ *
+ * @par
+ *	Polls instead of waiting on a condition so that it is safe to call
+ *	from the signal handlers that close and reopen the log.
+ */
+static void
+log_async_flush(void)
+{
+	unsigned long head = log_ring_head;
+	struct timespec ts = {0, 1000000};
+	int i;
+
+	/* give up after a few seconds rather than hang the daemon */
+	for (i = 0; i < 5000 && log_async_active && (long) (log_ring_tail - head) < 0; i++) {
+		if (log_writer_idle)
+			(void)write(log_wake_pipe[1], "", 1);
+		nanosleep(&ts, NULL);
+	}
+}
+#endif	/* WIN32 */
+
+/**
+ * @brief
+ *	log_async_start - start the log writer thread, so that log_record()
+ *	queues records instead of writing them on the calling thread.
+ *
+ * @par
+ *	The number of records buffered comes from PBS_LOG_ASYNC, rounded up
+ *	to a power of two and capped at LOG_ASYNC_MAX_RECS; if it is 0,
+ *	logging stays synchronous. Daemons
+ *	call this after they have forked into the background. Children
+ *	forked later log synchronously. Pending records are written at exit.
+ *
+ * @return	int
+ * @retval	0	async logging started, or not configured
+ * @retval	-1	failure, logging stays synchronous
+ */
+int
+log_async_start(void)
+{
+#ifndef WIN32
+	unsigned long size;
+	unsigned long i;
+	pthread_attr_t attr;
+	static int atexit_set = 0;
+
+	if (pbs_conf.pbs_log_async == 0 || log_async_active)
+		return 0;
+
+	for (size = 2; size < pbs_conf.pbs_log_async && size < LOG_ASYNC_MAX_RECS; size <<= 1)
+		;
+	if (log_ring == NULL || size != log_ring_mask + 1) {
+		free(log_ring);
+		log_ring = malloc(size * sizeof(log_rec_t));
+		if (log_ring == NULL) {
+			log_err(errno, __func__, "Unable to allocate log buffer");
+			return -1;
+		}
+	}
+	for (i = 0; i < size; i++)
+		log_ring[i].seq = i;
+	log_ring_mask = size - 1;
+	log_ring_head = 0;
+	log_ring_tail = 0;
+	log_dropped = 0;
+	log_writer_idle = 0;
+	log_writer_stop = 0;
+
+	if (log_wake_pipe[0] == -1) {
+		if (pipe(log_wake_pipe) == -1) {
+			log_err(errno, __func__, "pipe");
+			return -1;
+		}
+		for (i = 0; i < 2; i++) {
+			(void)fcntl(log_wake_pipe[i], F_SETFD, FD_CLOEXEC);
+			(void)fcntl(log_wake_pipe[i], F_SETFL, O_NONBLOCK);
+		}
+	}
+
+	if (pthread_attr_init(&attr) != 0)
+		return -1;
+	if (pthread_create(&log_writer_id, &attr, log_writer, NULL) != 0) {
+		pthread_attr_destroy(&attr);
+		log_err(errno, __func__, "Unable to create log writer thread");
+		return -1;
+	}
+	pthread_attr_destroy(&attr);
+	log_async_active = 1;
+
+	if (!atexit_set) {
+		atexit(log_async_stop);
+		atexit_set = 1;
+	}
+#endif
+	return 0;
+}
+
+/**
+ * @brief
+ *	log_async_stop - write the records still queued, stop the log writer
+ *	thread and go back to synchronous logging.
+ */
+void
+log_async_stop(void)
+{
+#ifndef WIN32
+	if (!log_async_active || pthread_equal(pthread_self(), log_writer_id))
+		return;
+
+	log_writer_stop = 1;
+	(void)write(log_wake_pipe[1], "", 1);
+	pthread_join(log_writer_id, NULL);
+	log_async_active = 0;
+
+	/* records queued while the writer was exiting */
+	log_async_drain();
+#endif
+}
+
+/**
+ * @brief
+ *	log_syslog_record - send a log message to syslog, if syslog is open.
+ *
+ * @param[in] objclass - event object class
+ * @param[in] sev - syslog severity
+ * @param[in] objname - object name
+ * @param[in] text - log msg
+ */
+static void
+log_syslog_record(int objclass, int sev, const char *objname, const char *text)
+{
+#if SYSLOG
+	static char slogbuf[LOG_BUF_SIZE];
+
+	if (syslogopen != 0) {
+		snprintf(slogbuf, LOG_BUF_SIZE,
+			"%s;%s;%s\n",
+			class_names[objclass],
+			objname,
+			text);
+		syslog(sev, "%s", slogbuf);
+	}
+#endif  /* SYSLOG */
+}
+
+/**
+ * @brief
+ * 	log_record - log a message to the log file
+ *	The log file must have been opened by log_open().
+ *
+ *	The caller should ensure proper formating of the message if "text"
+ *	is to contain "continuation lines".
+ *
+ * @param[in] eventtype - event type
+ * @param[in] objclass - event object class
+ * @param[in] sev - indication for whether to syslogging enabled or not
+ * @param[in] objname - object name stating log msg related to which object
+ * @param[in] text - log msg to be logged.
+ *
+ *	Note, "sev" (for severity) is used  only if syslogging is enabled.
+ *	See syslog(3) for details.
+ *
+ *	When async logging has been started by log_async_start(), the record
+ *	is queued for the log writer thread instead of being written here.
+ */
+
+void
+log_record(int eventtype, int objclass, int sev, const char *objname, const char *text)
+{
+	struct timeval tp;
+
+	log_syslog_record(objclass, sev, objname, text);
+
+	if (log_opened <= 0)
+		return;
+
+	if ((text == NULL) || (objname == NULL))
+		return;
+
+	/* if gettimeofday() fails, log messages will be printed at the epoch */
+	if (gettimeofday(&tp, NULL) == -1) {
+		tp.tv_sec = 0;
+		tp.tv_usec = 0;
+	}
+
+#ifndef WIN32
+	if (log_async_active && !pthread_equal(pthread_self(), log_writer_id)) {
+		log_async_put(&tp, eventtype, objclass, objname, text);
+		return;
+	}
+#endif
+
+	log_write_record(&tp, eventtype, objclass, objname, text);
+}
+
 /**
  * @brief
  * 	log_close - close the current open log file
@@ -968,19 +1325,36 @@ log_record(int eventtype, int objclass, int sev, const char *objname, const char
  *
  * @return	Void
  *
+ * @par
+ *	With async logging, the queued records are written to the log
+ *	being closed first.
+ *
  */
 
 void
 log_close(int msg)
 {
-	if (log_opened == 1) {
-		log_auto_switch = 0;
-		if (msg) {
-			log_record(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER,
-				LOG_INFO, "Log", "Log closed");
+	struct timeval tp;
+
+#ifndef WIN32
+	if (log_async_active && !pthread_equal(pthread_self(), log_writer_id))
+		log_async_flush();
+#endif
+	if (log_opened == 1 && log_mutex_lock() == 0) {
+		if (log_opened == 1) {
+			log_auto_switch = 0;
+			if (msg) {
+				/* written here, not queued, to land in this log */
+				log_syslog_record(PBS_EVENTCLASS_SERVER, LOG_INFO,
+					"Log", "Log closed");
+				gettimeofday(&tp, NULL);
+				log_write_record(&tp, PBSEVENT_SYSTEM,
+					PBS_EVENTCLASS_SERVER, "Log", "Log closed");
+			}
+			(void)fclose(logfile);
+			log_opened = 0;
 		}
-		(void)fclose(logfile);
-		log_opened = 0;
+		log_mutex_unlock();
 	}
 #if SYSLOG
 	if (syslogopen) {
@@ -301,6 +301,18 @@ int active_router = -1;
 int app_thread_active_router = -1;
 int no_active_router = 1;
 
+/*
+ * Process wide counters of the leaf protocol, added to the records written
+ * by tpp_dump_stats. Each field has a single writer.
+ */
+static struct {
+	unsigned long long retransmits;    /* IO thread, data pkts resent for lack of an ack */
+	unsigned long long out_raw_bytes;  /* APP thread, data handed to tpp_send */
+	unsigned long long out_wire_bytes; /* APP thread, same data after compression */
+	unsigned long long in_wire_bytes;  /* IO thread, data received for streams */
+	unsigned long long in_raw_bytes;   /* IO thread, same data after decompression */
+} leaf_stats;
+
 /* forward declarations of functions used by this code file */
 
 /* function pointers */
@@ -333,8 +345,8 @@ static int queue_ack(stream_t *strm, unsigned char type, unsigned int seq_no_rec
 static int send_ack_packet(ack_info_t *ack);
 static int send_retry_packet(tpp_packet_t *pkt);
 static int unshelve_pkt(stream_t *strm, int seq_no_acked);
-static void *add_part_packet(stream_t *strm, void *data, int sz);
-static int send_pkt_to_app(stream_t *strm, unsigned char type, void *data, int sz);
+static void *add_part_packet(stream_t *strm, void *data, int sz, tpp_router_t *r);
+static int send_pkt_to_app(stream_t *strm, unsigned char type, void *data, int sz, tpp_router_t *r);
 static stream_t *find_stream_with_dest(tpp_addr_t *dest_addr, unsigned int dest_sd, unsigned int dest_magic);
 static int tpp_send_inner(int sd, void *data, int len, int full_len, int cmprsd_len);
 static int send_spl_packet(stream_t *strm, int type);
@@ -348,6 +360,7 @@ int leaf_pkt_handler(int tfd, void *data, int len, void *ctx);
 int leaf_close_handler(int tfd, int error, void *ctx);
 int leaf_timer_handler(time_t now);
 int leaf_post_connect_handler(int tfd, void *data, void *c);
+void leaf_stats_handler(FILE *fp);
 
 /*
  * Whether tpp is in fault tolerant mode.
@@ -502,7 +515,8 @@ leaf_post_connect_handler(int tfd, void *data, void *c)
 	tpp_context_t *ctx = (tpp_context_t *) c;
 	tpp_router_t *r;
 	tpp_join_pkt_hdr_t hdr;
-	tpp_chunk_t chunks[2];
+	tpp_chunk_t chunks[3];
+	unsigned int caps = 0;
 
 	if (!ctx)
 		return 0;
@@ -572,7 +586,13 @@ leaf_post_connect_handler(int tfd, void *data, void *c)
 		chunks[1].data = leaf_addrs;
 		chunks[1].len = (leaf_addr_count * sizeof(tpp_addr_t));
 
-		if (tpp_transport_vsend(r->conn_fd, chunks, 2) != 0) {
+		if (tpp_conf->coalesce_delay >= 0)
+			caps |= TPP_CAP_ACCEPTS_BATCH;
+		caps = htonl(caps);
+		chunks[2].data = &caps;
+		chunks[2].len = sizeof(caps);
+
+		if (tpp_transport_vsend(r->conn_fd, chunks, 3) != 0) {
 			snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "tpp_transport_vsend failed, err=%d", errno);
 			tpp_log_func(LOG_CRIT, __func__, tpp_get_logbuf());
 			return -1;
@@ -726,6 +746,7 @@ tpp_init(struct tpp_config *cnf)
 		leaf_post_connect_handler, /* called when connection restores */
 		leaf_timer_handler /* called after amt of time from previous handler */
 		);
+	tpp_transport_set_stats_handler(leaf_stats_handler);
 
 	/* initialize the tpp transport layer */
 	if ((rc = tpp_transport_init(tpp_conf)) == -1)
@@ -765,6 +786,10 @@ tpp_init(struct tpp_config *cnf)
 		routers[i]->state = TPP_ROUTER_STATE_DISCONNECTED;
 		routers[i]->index = i;
 		routers[i]->delay = 0;
+		routers[i]->out_raw_bytes = 0;
+		routers[i]->out_wire_bytes = 0;
+		routers[i]->in_wire_bytes = 0;
+		routers[i]->in_raw_bytes = 0;
 
 		sprintf(tpp_get_logbuf(), "Connecting to pbs_comm %s", routers[i]->router_name);
 		tpp_log_func(LOG_INFO, NULL, tpp_get_logbuf());
@@ -1037,12 +1062,12 @@ tpp_send(int sd, void *data, int len)
 
 	TPP_DBPRT(("Sending: sd=%d, len=%d", sd, len));
 
-	if ((tpp_conf->compress == 1) && (len > TPP_SEND_SIZE)) {
+	if ((tpp_conf->compress == 1) && (len > tpp_conf->compress_threshold)) {
 		void *outbuf;
 
-		outbuf = tpp_deflate(data, len, &cmprsd_len);
+		outbuf = tpp_compress(tpp_conf->compress_codec, data, len, &cmprsd_len);
 		if (outbuf == NULL) {
-			tpp_log_func(LOG_CRIT, __func__, "tpp deflate failed");
+			tpp_log_func(LOG_CRIT, __func__, "tpp compress failed");
 			return -1;
 		}
 		pkt = tpp_cr_pkt(outbuf, cmprsd_len, 0);
@@ -1064,6 +1089,13 @@ tpp_send(int sd, void *data, int len)
 			tpp_free_pkt(pkt);
 			return -1;
 		}
+		/* tpp_send_inner left the router it sent the data to as active */
+		if (app_thread_active_router != -1) {
+			routers[app_thread_active_router]->out_raw_bytes += len;
+			routers[app_thread_active_router]->out_wire_bytes += to_send;
+		}
+		leaf_stats.out_raw_bytes += len;
+		leaf_stats.out_wire_bytes += to_send;
 	}
 	tpp_free_pkt(pkt);
 	return len;
@@ -2210,7 +2242,7 @@ tpp_mcast_send(int mtfd, void *data, unsigned int len, unsigned int full_len, un
 	chunks[0].len = sizeof(tpp_mcast_pkt_hdr_t);
 	totlen = chunks[0].len;
 
-	if (tpp_conf->compress == 1 && minfo_len > TPP_SEND_SIZE) {
+	if (tpp_conf->compress == 1 && minfo_len > tpp_conf->compress_threshold) {
 		def_ctx = tpp_multi_deflate_init(minfo_len);
 		if (def_ctx == NULL)
 			goto err;
@@ -3013,7 +3045,10 @@ send_retry_packet(tpp_packet_t *pkt)
 	 */
 	if (rt->data_pkt != NULL) {
 		totlen = pkt->len + rt->data_pkt->len;
-		p = realloc(pkt->data, totlen);
+		if (pkt->pooled)
+			p = tpp_buf_realloc(pkt->data, totlen);
+		else
+			p = realloc(pkt->data, totlen);
 		if (!p)
 			return -1;
 
@@ -3036,6 +3071,7 @@ send_retry_packet(tpp_packet_t *pkt)
 	 */
 	rt->retry_count++;
 	rt->sent_to_transport = 1;
+	leaf_stats.retransmits++;
 
 	if (tpp_transport_send_raw(routers[active_router]->conn_fd, pkt) != 0) {
 		tpp_log_func(LOG_ERR, __func__, "tpp_transport_send_raw failed");
@@ -3339,6 +3375,51 @@ del_retries(stream_t *strm)
 	}
 }
 
+/**
+ * @brief
+ *	The stats handler registered with the transport layer. Adds the leaf
+ *	protocol counters and the application mbox to a tpp_dump_stats record:
+ *
+ *	,"leaf":{"retransmits":..,"out_raw_bytes":..,"out_wire_bytes":..,
+ *	 "in_wire_bytes":..,"in_raw_bytes":..,"app_mbox_depth":..,
+ *	 "app_mbox_max_depth":..,"app_mbox_wait":{..},
+ *	 "routers":[{"name":..,"out_raw_bytes":..,"out_wire_bytes":..,
+ *	 "in_wire_bytes":..,"in_raw_bytes":..},..]}
+ *
+ *	The "routers" list has the compression counters of each connection
+ *	to a pbs_comm.
+ *
+ * @param[in] fp - The stream to print to
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: No
+ *
+ */
+void
+leaf_stats_handler(FILE *fp)
+{
+	int i;
+	int n = 0;
+
+	fprintf(fp, ",\"leaf\":{\"retransmits\":%llu,\"out_raw_bytes\":%llu,\"out_wire_bytes\":%llu,"
+		"\"in_wire_bytes\":%llu,\"in_raw_bytes\":%llu,\"app_mbox_depth\":%u,\"app_mbox_max_depth\":%u,",
+		leaf_stats.retransmits, leaf_stats.out_raw_bytes, leaf_stats.out_wire_bytes,
+		leaf_stats.in_wire_bytes, leaf_stats.in_raw_bytes, app_mbox.depth, app_mbox.max_depth);
+	tpp_hist_print(fp, "app_mbox_wait", &app_mbox.wait_hist);
+	fprintf(fp, ",\"routers\":[");
+	for (i = 0; i < max_routers; i++) {
+		if (routers[i] == NULL)
+			continue;
+		fprintf(fp, "%s{\"name\":\"%s\",\"out_raw_bytes\":%llu,\"out_wire_bytes\":%llu,"
+			"\"in_wire_bytes\":%llu,\"in_raw_bytes\":%llu}", (n++ > 0) ? "," : "",
+			routers[i]->router_name, routers[i]->out_raw_bytes, routers[i]->out_wire_bytes,
+			routers[i]->in_wire_bytes, routers[i]->in_raw_bytes);
+	}
+	fprintf(fp, "]}");
+}
+
 /**
  * @brief
  *	The timer handler function registered with the IO thread.
@@ -3514,6 +3595,8 @@ unshelve_pkt(stream_t *strm, int seq_no_acked)
  * @param[in] sd - The descriptor of the stream
  * @param[in] data - The data that has to be stored
  * @param[in] sz - The size of the data
+ * @param[in] r - The router the data arrived from, its counters are updated
+ *		  when the packet is complete
  *
  * @par Side Effects:
  *	None
@@ -3522,7 +3605,7 @@ unshelve_pkt(stream_t *strm, int seq_no_acked)
  *
  */
 static void *
-add_part_packet(stream_t *strm, void *data, int sz)
+add_part_packet(stream_t *strm, void *data, int sz, tpp_router_t *r)
 {
 	tpp_packet_t *pkt;
 	char *q;
@@ -3557,11 +3640,17 @@ add_part_packet(stream_t *strm, void *data, int sz)
 		strm->part_recv_pkt->pos = strm->part_recv_pkt->data;
 		obj = strm->part_recv_pkt;
 		strm->part_recv_pkt = NULL; /* reset */
+		if (r) {
+			r->in_wire_bytes += cmprsd_len;
+			r->in_raw_bytes += totlen;
+		}
+		leaf_stats.in_wire_bytes += cmprsd_len;
+		leaf_stats.in_raw_bytes += totlen;
 		if (cmprsd_len != totlen) {
 			tpp_packet_t *tmp = obj;
 			void *uncmpr_data;
 
-			if ((uncmpr_data = tpp_inflate(tmp->data, cmprsd_len, totlen))) {
+			if ((uncmpr_data = tpp_decompress(tmp->data, cmprsd_len, totlen))) {
 				obj = tpp_cr_pkt(uncmpr_data, totlen, 0);
 				if (!obj)
 					free(uncmpr_data);
@@ -3588,6 +3677,7 @@ add_part_packet(stream_t *strm, void *data, int sz)
  * @param[in] type - The type of the data packet (data, close etc)
  * @param[in] data - The data that has to be stored
  * @param[in] sz - The size of the data
+ * @param[in] r - The router the data arrived from, NULL if not data
  *
  * @return Error code
  * @retval 0 - Success
@@ -3600,13 +3690,13 @@ add_part_packet(stream_t *strm, void *data, int sz)
  *
  */
 static int
-send_pkt_to_app(stream_t *strm, unsigned char type, void *data, int sz)
+send_pkt_to_app(stream_t *strm, unsigned char type, void *data, int sz, tpp_router_t *r)
 {
 	int cmd;
 	tpp_packet_t *obj;
 
 	if (type == TPP_DATA) {
-		obj = add_part_packet(strm, data, sz);
+		obj = add_part_packet(strm, data, sz, r);
 		if (obj == NULL)
 			return 0; /* more data required */
 		cmd = TPP_CMD_NET_DATA;
@@ -4191,7 +4281,7 @@ check_strm_valid(unsigned int src_sd, tpp_addr_t *dest_addr, int dest_sd)
  * @param[in] data - The pointer to the data that arrived
  * @param[in] len  - Length of the arrived data
  * @param[in] ctx - The context (prior associated, if any) with the IO thread
- *		    (unused at the leaf)
+ *		    (the router the data arrived from)
  *
  * @par Side Effects:
  *	None
@@ -4205,6 +4295,10 @@ leaf_pkt_handler(int tfd, void *data, int len, void *ctx)
 	stream_t *strm;
 	unsigned int sd = UNINITIALIZED_INT;
 	unsigned char type;
+	tpp_router_t *r = NULL;
+
+	if (ctx && ((tpp_context_t *) ctx)->type == TPP_ROUTER_NODE)
+		r = (tpp_router_t *) ((tpp_context_t *) ctx)->ptr;
 
 	type = *((char *) data);
 	errno = 0;
@@ -4402,7 +4496,7 @@ leaf_pkt_handler(int tfd, void *data, int len, void *ctx)
 				 */
 				if (strm->u_state == TPP_STRM_STATE_CLOSE && seq_no_acked == strm->send_seq_no) {
 					TPP_DBPRT(("sd=%u PEER acked CLOSE, sending CLOSE to APP", strm->sd));
-					send_pkt_to_app(strm, TPP_CLOSE_STRM, NULL, 0);
+					send_pkt_to_app(strm, TPP_CLOSE_STRM, NULL, 0, NULL);
 				}
 			}
 
@@ -4418,7 +4512,7 @@ leaf_pkt_handler(int tfd, void *data, int len, void *ctx)
 				int oo_cleared = 1;
 
 				TPP_DBPRT(("Sending in sequence to app, sd=%u, seq=%u", sd, seq_no_expected));
-				send_pkt_to_app(strm, type, data, sz);
+				send_pkt_to_app(strm, type, data, sz, r);
 				seq_no_expected = get_next_seq(seq_no_expected);
 
 				/*
@@ -4437,7 +4531,7 @@ leaf_pkt_handler(int tfd, void *data, int len, void *ctx)
 							snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "Sending OO packets to app, sd=%u, seq=%u", sd, seq_no_expected);
 							tpp_log_func(LOG_INFO, NULL, tpp_get_logbuf());
 
-							send_pkt_to_app(strm, dhdr->type, oo_pkt->data, oo_pkt->len - sizeof(tpp_data_pkt_hdr_t));
+							send_pkt_to_app(strm, dhdr->type, oo_pkt->data, oo_pkt->len - sizeof(tpp_data_pkt_hdr_t), r);
 							seq_no_expected = get_next_seq(seq_no_expected);
 
 							tpp_free_pkt(oo_pkt);
@@ -4541,6 +4635,35 @@ leaf_pkt_handler(int tfd, void *data, int len, void *ctx)
 		}
 		break; /* TPP_DATA, TPP_CLOSE_STRM */
 
+		case TPP_DATA_BATCH: {
+			tpp_batch_pkt_hdr_t *bhdr = (tpp_batch_pkt_hdr_t *) data;
+			unsigned int num_pkts = ntohl(bhdr->num_pkts);
+			char *p = (char *) data + sizeof(tpp_batch_pkt_hdr_t);
+			char *end = (char *) data + len;
+			int plen;
+
+			/* hand each packet of the batch to this handler in turn */
+			while (num_pkts-- > 0) {
+				if (p + sizeof(int) > end)
+					break;
+				memcpy(&plen, p, sizeof(int));
+				plen = ntohl(plen);
+				p += sizeof(int);
+				if (plen <= 0 || p + plen > end)
+					break;
+				if (leaf_pkt_handler(tfd, p, plen, ctx) != 0)
+					return -1;
+				p += plen;
+			}
+			if (p != end) {
+				snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "Malformed batch packet on fd %d", tfd);
+				tpp_log_func(LOG_ERR, NULL, tpp_get_logbuf());
+				return -1;
+			}
+			return 0;
+		}
+		break; /* TPP_DATA_BATCH */
+
 		default:
 			snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "Bad header for incoming packet on fd %d, header = %d", tfd, type);
 			tpp_log_func(LOG_ERR, NULL, tpp_get_logbuf());
@@ -134,6 +134,9 @@ typedef struct {
 	char *pos;	/* current position - till which data is consumed */
 	void *extra_data;	/* any additional data */
 	int ref_count;	/* number of accessors */
+	int pooled;	/* data is a refcounted tpp_buf_alloc() buffer */
+	long long qtime;	/* usec time at which it was put on a send queue */
+	long long rtime;	/* usec time at which the data was received, if relayed */
 } tpp_packet_t;
 
 /*
@@ -166,6 +169,13 @@ typedef struct {
 } tpp_join_pkt_hdr_t;
 /* a bunch of tpp_addr structs follow this packet */
 
+/*
+ * A leaf may follow the addresses of its join with an unsigned int (network
+ * order) of the capabilities below. Routers that do not know of it ignore
+ * the trailing bytes, and a join without it has no capabilities.
+ */
+#define TPP_CAP_ACCEPTS_BATCH   0x1 /* leaf accepts TPP_DATA_BATCH packets */
+
 /*
  * The Leave packet header structure
  */
@@ -211,6 +221,16 @@ typedef struct {
 	tpp_addr_t dest_addr; /* dest host address */
 } tpp_data_pkt_hdr_t;
 
+/*
+ * The batch packet header structure. A router coalesces data packets bound
+ * to the same leaf into one batch packet, if the leaf accepts batches
+ */
+typedef struct {
+	unsigned char type;     /* type of packet - TPP_DATA_BATCH */
+	unsigned int num_pkts;  /* number of packets in the batch */
+} tpp_batch_pkt_hdr_t;
+/* num_pkts times an int length (network order) followed by the packet */
+
 /*
  * The multicast packet header structure
  */
@@ -253,6 +273,7 @@ enum TPP_MSG_TYPES {
         TPP_CTL_MSG,
         TPP_CLOSE_STRM,
         TPP_MCAST_DATA,
+        TPP_DATA_BATCH,
         TPP_LAST_MSG
 };
 
@@ -270,6 +291,8 @@ enum TPP_MSG_TYPES {
 #define TPP_STRM_TIMEOUT        600
 #define TPP_MIN_WAIT            2
 #define TPP_SEND_SIZE           8192
+#define TPP_BATCH_SIZE          65536 /* max size of a TPP_DATA_BATCH packet */
+#define TPP_MAX_BATCH_TARGETS   8     /* leaves a router thread batches to at a time */
 
 /* tpp cmds used internally by the layer to notify messages between threads */
 #define TPP_CMD_SEND            1
@@ -286,6 +309,7 @@ enum TPP_MSG_TYPES {
 
 #define TPP_DEF_ROUTER_PORT     17001
 #define TPP_SCRATCHSIZE         8192
+#define TPP_MAX_IOV             64 /* max packets gathered into one write */
 
 #define TPP_ROUTER_STATE_DISCONNECTED	0   /* Leaf not connected to router */
 #define TPP_ROUTER_STATE_CONNECTING		1   /* Leaf is connecting to router */
@@ -318,6 +342,12 @@ typedef struct {
 	int delay;       /* time delay in re-connecting to the router */
 	int index;		 /* the preference of data going over this connection */
 	AVL_IX_DESC *AVL_my_leaves; /* leaves connected to this router, used by comm only */
+
+	/* compression counters of a leaf's connection, bytes before and after compression */
+	unsigned long long out_raw_bytes;  /* APP thread only, data handed to tpp_send */
+	unsigned long long out_wire_bytes; /* APP thread only, same data after compression */
+	unsigned long long in_wire_bytes;  /* IO thread only, data received */
+	unsigned long long in_raw_bytes;   /* IO thread only, same data after decompression */
 } tpp_router_t;
 
 /*
@@ -333,6 +363,9 @@ typedef struct {
 
 	int   num_addrs;
 	tpp_addr_t *leaf_addrs; /* list of leaf's addresses */
+
+	unsigned char accepts_batch; /* leaf joined saying it accepts TPP_DATA_BATCH */
+	unsigned int conn_gen;       /* changes each time the leaf joins directly */
 } tpp_leaf_t;
 
 /* routines and headers to manage FIFO queues */
@@ -357,8 +390,23 @@ typedef struct {
 	unsigned int tfd;
 	int cmdval;
 	void *data;
+	long long post_time; /* usec time at which the cmd was posted */
 } tpp_cmd_t;
 
+/*
+ * Latency histogram used by the runtime statistics. Bucket i counts the
+ * samples that took less than 2^i microseconds (and at least 2^(i-1)),
+ * the last bucket also holds everything slower than that.
+ */
+#define TPP_HIST_BUCKETS 24
+
+typedef struct {
+	unsigned long long count;	/* number of samples */
+	unsigned long long total;	/* sum of all samples, usec */
+	unsigned long long max;		/* largest sample, usec */
+	unsigned long long bucket[TPP_HIST_BUCKETS];
+} tpp_hist_t;
+
 /*
  * mbox is the "message box" for each thread
  * When a thread wants to send a msg/cmd to another
@@ -374,6 +422,9 @@ typedef struct {
 #else
 	int mbox_pipe[2]; /* may be unused */
 #endif
+	unsigned int depth;	/* cmds currently queued */
+	unsigned int max_depth;	/* high water mark of depth */
+	tpp_hist_t wait_hist;	/* time cmds waited in the mbox - reader only */
 } tpp_mbox_t;
 
 
@@ -390,6 +441,9 @@ typedef struct {
 	char tppstaticbuf[TPP_LOGBUF_SZ];
 	void *log_data; /* data created by the logging layer for the TPP threads */
 	void *avl_data; /* data created by the avl tree functions for the TPP threads */
+	void *pkt_pool; /* packet and buffer free lists of the thread */
+	void *rtr_batches; /* router only, data being coalesced by the thread */
+	long long rtime; /* usec receipt time of the pkt being handled, else 0 */
 } tpp_tls_t;
 
 tpp_que_elem_t* tpp_enque(tpp_que_t *l, void *data);
@@ -423,6 +477,11 @@ void tpp_terminate(void);
 int tpp_poll(void);
 char *tpp_parse_hostname(char *full, int *port);
 tpp_packet_t *tpp_cr_pkt(void *data, int len, int mk_data);
+tpp_packet_t *tpp_share_pkt(tpp_packet_t *opkt);
+void *tpp_buf_alloc(int len);
+void *tpp_buf_realloc(void *buf, int len);
+void tpp_buf_free(void *buf);
+void tpp_pool_destroy(void *pool);
 
 void tpp_router_shutdown(void);
 void tpp_router_terminate(void);
@@ -432,6 +491,7 @@ int tpp_transport_connect(char *hostname, int authtype, int delay, void *ctx, in
 int tpp_transport_vsend(int tfd, tpp_chunk_t *chunk, int count);
 int tpp_transport_isresvport(int tfd);
 int tpp_transport_vsend_extra(int tfd, tpp_chunk_t *chunk, int count, void *extra);
+int tpp_transport_vsend_many(int *tfds, int num_tfds, tpp_chunk_t *chunk, int count);
 int tpp_transport_init(struct tpp_config *conf);
 void tpp_transport_set_handlers(
 	int (*pkt_presend_handler)(int phy_con, tpp_packet_t *pkt),
@@ -441,6 +501,8 @@ void tpp_transport_set_handlers(
 	int (*post_connect_handler)(int sd, void *data, void *ctx),
 	int (*timer_handler)(time_t now)
 	);
+void tpp_transport_set_flush_handler(int (*flush_handler)(void));
+void tpp_transport_set_stats_handler(void (*stats_handler)(FILE *fp));
 void tpp_set_logmask(long logmask);
 void tpp_transport_shutdown(void);
 int tpp_transport_terminate(void);
@@ -487,12 +549,16 @@ void *tpp_inflate(void *inbuf, unsigned int inlen, unsigned int totlen);
 void *tpp_multi_deflate_init(int len);
 int tpp_multi_deflate_do(void *ctx, int fini, void *inbuf, unsigned int inlen);
 void *tpp_multi_deflate_done(void *c, unsigned int *cmpr_len);
+void *tpp_compress(int codec, void *inbuf, unsigned int inlen, unsigned int *outlen);
+void *tpp_decompress(void *inbuf, unsigned int inlen, unsigned int totlen);
 
 int tpp_add_fd(int ctl_fd, int fd, int event);
 int tpp_del_fd(int ctl_fd, int fd);
 int tpp_mod_fd(int ctl_fd, int fd, int event);
 
 int tpp_validate_hdr(int tfd, char *pkt_start);
+void tpp_hist_add(tpp_hist_t *hist, long long usec);
+void tpp_hist_print(FILE *fp, char *name, tpp_hist_t *hist);
 tpp_addr_t *tpp_get_addresses(char *node_names, int *leaf_addr_count);
 tpp_addr_t *tpp_get_local_host(int sock);
 tpp_addr_t *tpp_get_connected_host(int sock);
@@ -885,6 +885,21 @@ set_tpp_config(struct pbs_config *pbs_conf,
 #else
 	tpp_conf->compress = 0;
 #endif
+	tpp_conf->compress_codec = TPP_COMPR_ZLIB;
+	if (pbs_conf->pbs_compression_codec == PBS_COMPRESSION_CODEC_LZ4) {
+#ifdef PBS_COMPRESSION_LZ4
+		tpp_conf->compress_codec = TPP_COMPR_LZ4;
+#else
+		tpp_log_func(LOG_WARNING, NULL, "TPP built without LZ4 support, using zlib compression");
+#endif
+	}
+	tpp_conf->compress_threshold = pbs_conf->pbs_compression_threshold;
+	tpp_conf->coalesce_delay = pbs_conf->pbs_comm_coalesce_delay;
+	if (tpp_conf->compress) {
+		snprintf(log_buffer, TPP_LOGBUF_SZ, "TPP set to use %s compression for data larger than %u bytes",
+			(tpp_conf->compress_codec == TPP_COMPR_LZ4) ? "lz4" : "zlib", tpp_conf->compress_threshold);
+		tpp_log_func(LOG_INFO, NULL, log_buffer);
+	}
 
 	/* set default parameters for keepalive */
 	tpp_conf->tcp_keepalive = 1;
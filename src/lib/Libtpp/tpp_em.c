@@ -929,6 +929,9 @@ tpp_mbox_init(tpp_mbox_t *mbox)
 {
 	tpp_init_lock(&mbox->mbox_mutex);
 	TPP_QUE_CLEAR(&mbox->mbox_queue);
+	mbox->depth = 0;
+	mbox->max_depth = 0;
+	memset(&mbox->wait_hist, 0, sizeof(mbox->wait_hist));
 
 #ifdef HAVE_SYS_EVENTFD_H
 	if ((mbox->mbox_eventfd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) == -1) {
@@ -1089,6 +1092,8 @@ tpp_mbox_read(tpp_mbox_t *mbox, unsigned int *tfd, int *cmdval, void **data)
 
 	/* read the data from the mbox cmd queue head */
 	cmd = (tpp_cmd_t *) tpp_deque(&mbox->mbox_queue);
+	if (cmd)
+		mbox->depth--;
 
 	/* if no more data, clear all notifications */
 	if (cmd == NULL) {
@@ -1110,6 +1115,8 @@ tpp_mbox_read(tpp_mbox_t *mbox, unsigned int *tfd, int *cmdval, void **data)
 	*cmdval = cmd->cmdval;
 	*data = cmd->data;
 
+	tpp_hist_add(&mbox->wait_hist, tpp_time_us() - cmd->post_time);
+
 	free(cmd);
 	return 0;
 }
@@ -1147,6 +1154,7 @@ tpp_mbox_clear(tpp_mbox_t *mbox, tpp_que_elem_t **n, unsigned int tfd, int *cmdv
 		cmd = TPP_QUE_DATA(*n);
 		if (cmd && cmd->tfd == tfd) {
 			*n = tpp_que_del_elem(&mbox->mbox_queue, *n);
+			mbox->depth--;
 			*cmdval = cmd->cmdval;
 			*data = cmd->data;
 			free(cmd);
@@ -1200,6 +1208,7 @@ tpp_mbox_post(tpp_mbox_t *mbox, unsigned int tfd, int cmdval, void *data)
 	cmd->cmdval = cmdval;
 	cmd->tfd = tfd;
 	cmd->data = data;
+	cmd->post_time = tpp_time_us();
 
 	/* add the cmd to the threads queue */
 	tpp_lock(&mbox->mbox_mutex);
@@ -1209,6 +1218,8 @@ tpp_mbox_post(tpp_mbox_t *mbox, unsigned int tfd, int cmdval, void *data)
 		tpp_log_func(LOG_CRIT, __func__, tpp_get_logbuf());
 		return -1;
 	}
+	if (++mbox->depth > mbox->max_depth)
+		mbox->max_depth = mbox->depth;
 	tpp_unlock(&mbox->mbox_mutex);
 
 	while (1) {
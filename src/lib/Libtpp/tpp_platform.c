@@ -59,6 +59,9 @@
 #ifndef WIN32
 #include <netinet/tcp.h>
 #include <sys/resource.h>
+#include <sys/uio.h>
+#include <sys/time.h>
+#include <time.h>
 #include <signal.h>
 #endif
 
@@ -375,6 +378,54 @@ tpp_sock_send(int s, const char *buf, int len, int flags)
 	return ret;
 }
 
+/*
+ * wrapper to call windows WSASend() to send out several buffers
+ * in one call, map windows error code to errno and massage the
+ * return value so that callers do not need conditionally compiled
+ * code
+ */
+int
+tpp_sock_writev(int s, tpp_chunk_t *chunks, int count)
+{
+	WSABUF bufs[TPP_MAX_IOV];
+	DWORD sent = 0;
+	int i;
+
+	if (count > TPP_MAX_IOV)
+		count = TPP_MAX_IOV;
+
+	for (i = 0; i < count; i++) {
+		bufs[i].buf = chunks[i].data;
+		bufs[i].len = chunks[i].len;
+	}
+	if (WSASend(s, bufs, count, &sent, 0, NULL, NULL) == SOCKET_ERROR) {
+		errno = tr_2_errno(WSAGetLastError());
+		return -1;
+	}
+	return ((int) sent);
+}
+
+/*
+ * wrapper to get a millisecond clock on windows, only
+ * differences between two values are meaningful
+ */
+long long
+tpp_time_ms(void)
+{
+	return ((long long) GetTickCount64());
+}
+
+/*
+ * wrapper to get a microsecond clock on windows, only
+ * differences between two values are meaningful, and
+ * the resolution is that of GetTickCount64
+ */
+long long
+tpp_time_us(void)
+{
+	return ((long long) GetTickCount64() * 1000);
+}
+
 /*
  * wrapper to call windows select() and map windows
  * error code to errno and massage the return value
@@ -591,6 +642,86 @@ tpp_get_nfiles()
 	return (rlp.rlim_cur);
 }
 
+/**
+ * @brief
+ *	Send out several buffers with a single writev() call
+ *
+ * @param[in] s - The socket to send on
+ * @param[in] chunks - The buffers to send
+ * @param[in] count - The number of buffers, at most TPP_MAX_IOV
+ *
+ * @return  number of bytes sent
+ * @retval  -1 - Failure (errno set)
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: Yes
+ *
+ */
+int
+tpp_sock_writev(int s, tpp_chunk_t *chunks, int count)
+{
+	struct iovec iov[TPP_MAX_IOV];
+	int i;
+
+	if (count > TPP_MAX_IOV)
+		count = TPP_MAX_IOV;
+
+	for (i = 0; i < count; i++) {
+		iov[i].iov_base = chunks[i].data;
+		iov[i].iov_len = chunks[i].len;
+	}
+	return (writev(s, iov, count));
+}
+
+/**
+ * @brief
+ *	Get a millisecond clock that is not affected by changes to the
+ *	time of day. Only differences between two values are meaningful.
+ *
+ * @return  milliseconds since an arbitrary point in the past
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: Yes
+ *
+ */
+long long
+tpp_time_ms(void)
+{
+	return (tpp_time_us() / 1000);
+}
+
+/**
+ * @brief
+ *	Get a microsecond clock that is not affected by changes to the
+ *	time of day. Only differences between two values are meaningful.
+ *
+ * @return  microseconds since an arbitrary point in the past
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: Yes
+ *
+ */
+long long
+tpp_time_us(void)
+{
+	struct timeval tv;
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+		return ((long long) ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+#endif
+
+	gettimeofday(&tv, NULL);
+	return ((long long) tv.tv_sec * 1000000 + tv.tv_usec);
+}
+
 /**
  * @brief
  *	Setup SIGPIPE disposition properly
@@ -71,10 +71,16 @@ extern "C" {
 #define tpp_sock_getsockopt(a, b, c, d, e)   getsockopt(a, b, c, d, e)
 #define tpp_sock_setsockopt(a, b, c, d, e)   setsockopt(a, b, c, d, e)
 
+#define tpp_atomic_inc(a)            __sync_add_and_fetch(a, 1)
+#define tpp_atomic_dec(a)            __sync_sub_and_fetch(a, 1)
+
 #else
 
 #define EINPROGRESS   EAGAIN
 
+#define tpp_atomic_inc(a)            InterlockedIncrement((LONG volatile *)(a))
+#define tpp_atomic_dec(a)            InterlockedDecrement((LONG volatile *)(a))
+
 int tpp_pipe_cr(int fds[2]);
 int tpp_pipe_read(int s, char *buf, int len);
 int tpp_pipe_write(int s, char *buf, int len);
@@ -95,6 +101,9 @@ int tpp_sock_setsockopt(int s, int level, int optname, const int *optval, int op
 #endif
 
 int tpp_sock_layer_init();
+int tpp_sock_writev(int s, tpp_chunk_t *chunks, int count);
+long long tpp_time_ms(void);
+long long tpp_time_us(void);
 int tpp_get_nfiles();
 int set_pipe_disposition();
 int tpp_sock_attempt_connection(int fd, char *host, int port);
@@ -81,6 +81,7 @@
 
 #include "rpp.h"
 #include "tpp_common.h"
+#include "tpp_platform.h"
 
 #define RLIST_INC 100
 #define TPP_MAX_ROUTERS 5000
@@ -109,11 +110,36 @@ static int add_route_to_leaf(tpp_leaf_t *l, tpp_router_t *r, int index);
 static tpp_router_t *del_router_from_leaf(tpp_leaf_t *l, int tfd);
 static int leaf_get_router_index(tpp_leaf_t *l, tpp_router_t *r);
 static int router_timer_handler(time_t now);
+static int router_flush_handler(void);
+static void drop_batch(int tfd);
 static int router_post_connect_handler(int tfd, void *data, void *c);
 
 /* structure identifying this router */
 static tpp_router_t *this_router = NULL;
 
+/* last conn_gen handed to a leaf, protected by router_lock */
+static unsigned int leaf_conn_gen = 0;
+
+/*
+ * Data packets bound to a leaf that accepts batches are coalesced by each IO
+ * thread into a TPP_DATA_BATCH packet, which is sent out when the thread is
+ * done with its current round of events, or after coalesce_delay ms
+ */
+typedef struct {
+	int fd;               /* connection of the target leaf, -1 if slot free */
+	unsigned int conn_gen; /* conn_gen of the target leaf when batching started */
+	tpp_addr_t dest;      /* an address of the target leaf */
+	int num_pkts;         /* number of packets in the batch */
+	int len;              /* length of batch filled so far */
+	long long flush_time; /* ms at which to send out the batch */
+	long long rtime;      /* usec receipt time of the first packet */
+	char buf[TPP_BATCH_SIZE];
+} rtr_batch_t;
+
+typedef struct {
+	rtr_batch_t slot[TPP_MAX_BATCH_TARGETS];
+} rtr_batches_t;
+
 static tpp_router_t *
 alloc_router(char *name, tpp_addr_t *address)
 {
@@ -333,7 +359,6 @@ broadcast_to_my_routers(tpp_chunk_t *chunks, int count, int origin_tfd)
 	tpp_router_t *r;
 	int list[TPP_MAX_ROUTERS];
 	int max_cons = 0;
-	int i;
 
 	pkey = avlkey_create(AVL_routers, NULL);
 	if (pkey == NULL) {
@@ -356,10 +381,8 @@ broadcast_to_my_routers(tpp_chunk_t *chunks, int count, int origin_tfd)
 
 	free(pkey);
 
-	for (i = 0; i < max_cons; i++) {
-		if (tpp_transport_vsend(list[i], chunks, count) != 0) {
-			tpp_log_func(LOG_ERR, __func__, "send failed");
-		}
+	if (tpp_transport_vsend_many(list, max_cons, chunks, count) != 0) {
+		tpp_log_func(LOG_ERR, __func__, "send failed");
 	}
 	return 0;
 }
@@ -399,7 +422,6 @@ broadcast_to_my_leaves(tpp_chunk_t *chunks, int count, int origin_tfd, int type)
 	int list_size = TPP_MAX_ROUTERS; /* initial size */
 	void *p;
 	int max_cons = 0;
-	int i;
 	AVL_IX_DESC *AVL_traverse_tree = NULL;
 
 	if (type == 1)
@@ -451,11 +473,9 @@ broadcast_to_my_leaves(tpp_chunk_t *chunks, int count, int origin_tfd, int type)
 	tpp_unlock(&router_lock);
 	free(pkey);
 
-	for (i = 0; i < max_cons; i++) {
-		if (tpp_transport_vsend(list[i], chunks, count) != 0) {
-			if (errno != ENOTCONN)
-				tpp_log_func(LOG_ERR, __func__, "send failed");
-		}
+	if (tpp_transport_vsend_many(list, max_cons, chunks, count) != 0) {
+		if (errno != ENOTCONN)
+			tpp_log_func(LOG_ERR, __func__, "send failed");
 	}
 
 	free(list);
@@ -950,6 +970,9 @@ static int
 router_close_handler(int tfd, int error, void *c)
 {
 	int rc;
+
+	drop_batch(tfd);
+
 	/* set hop to 1 and send to inner */
 	if ((rc = router_close_handler_inner(tfd, error, c, 1)) == 0) {
 		tpp_transport_set_conn_ctx(tfd, NULL);
@@ -959,6 +982,257 @@ router_close_handler(int tfd, int error, void *c)
 	return rc;
 }
 
+/**
+ * @brief
+ *	Get the batches being coalesced by this IO thread
+ *
+ * @return - the batches of the thread
+ * @retval NULL - Out of memory
+ *
+ * @par MT-safe: Yes
+ *
+ */
+static rtr_batches_t *
+get_thrd_batches(void)
+{
+	tpp_tls_t *tls;
+	rtr_batches_t *b;
+	int i;
+
+	if ((tls = tpp_get_tls()) == NULL)
+		return NULL;
+
+	if (tls->rtr_batches == NULL) {
+		if ((b = malloc(sizeof(rtr_batches_t))) == NULL) {
+			tpp_log_func(LOG_CRIT, __func__, "Out of memory allocating batches");
+			return NULL;
+		}
+		for (i = 0; i < TPP_MAX_BATCH_TARGETS; i++) {
+			b->slot[i].fd = -1;
+			b->slot[i].num_pkts = 0;
+		}
+		tls->rtr_batches = b;
+	}
+	return (rtr_batches_t *) tls->rtr_batches;
+}
+
+/**
+ * @brief
+ *	Send out a batch to its leaf and free the batch slot.
+ *	A batch of a single packet is sent as the packet itself.
+ *
+ * @par Functionality:
+ *	The batch may have been started by this thread before the leaf's
+ *	connection was closed by another thread, and the tfd reused since for
+ *	another connection. The batch is only sent if the leaf is still
+ *	directly connected over the same connection and accepts batches,
+ *	otherwise it is dropped like any other data to a gone leaf.
+ *
+ * @param[in] b - The batch to send
+ *
+ * @par MT-safe: No
+ *
+ */
+static void
+flush_batch(rtr_batch_t *b)
+{
+	tpp_batch_pkt_hdr_t *hdr = (tpp_batch_pkt_hdr_t *) b->buf;
+	tpp_chunk_t chunks[1];
+	tpp_leaf_t *l;
+	tpp_tls_t *tls;
+	long long rtime = 0;
+	int valid = 0;
+
+	if (b->num_pkts == 0)
+		goto done;
+
+	tpp_lock(&router_lock);
+	l = find_tree(AVL_cluster_leaves, &b->dest);
+	if (l && l->conn_fd == b->fd && l->conn_gen == b->conn_gen && l->accepts_batch)
+		valid = 1;
+	tpp_unlock(&router_lock);
+
+	if (!valid) {
+		snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "tfd=%d, Leaf connection gone, dropping batch of %d packets", b->fd, b->num_pkts);
+		tpp_log_func(LOG_WARNING, __func__, tpp_get_logbuf());
+		goto done;
+	}
+
+	if (b->num_pkts == 1) {
+		chunks[0].data = b->buf + sizeof(tpp_batch_pkt_hdr_t) + sizeof(int);
+		chunks[0].len = b->len - sizeof(tpp_batch_pkt_hdr_t) - sizeof(int);
+	} else {
+		hdr->type = TPP_DATA_BATCH;
+		hdr->num_pkts = htonl(b->num_pkts);
+		chunks[0].data = b->buf;
+		chunks[0].len = b->len;
+	}
+
+	/* the relay latency of a batch is counted from its first packet */
+	if ((tls = tpp_get_tls()) != NULL) {
+		rtime = tls->rtime;
+		tls->rtime = b->rtime;
+	}
+	if (tpp_transport_vsend(b->fd, chunks, 1) != 0) {
+		/* same as an unbatched send, drop the connection to the leaf */
+		snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "tfd=%d, Failed to send batch of %d packets, errno = %d", b->fd, b->num_pkts, errno);
+		tpp_log_func(LOG_ERR, __func__, tpp_get_logbuf());
+		tpp_transport_close(b->fd);
+	}
+	if (tls)
+		tls->rtime = rtime;
+
+done:
+	b->fd = -1;
+	b->num_pkts = 0;
+	b->len = 0;
+}
+
+/**
+ * @brief
+ *	Add a data packet bound to a leaf to this thread's batch for the leaf
+ *
+ * @param[in] tfd - The connection of the target leaf
+ * @param[in] conn_gen - The conn_gen of the target leaf
+ * @param[in] dest - The destination address of the packet
+ * @param[in] data - The data packet
+ * @param[in] len - Length of the data packet
+ *
+ * @return Whether the packet was batched
+ * @retval  0 - The packet is batched
+ * @retval  1 - The packet could not be batched, the caller must send it.
+ *		Anything batched earlier for the leaf has already been sent
+ *		so that the packet does not overtake it
+ *
+ * @par MT-safe: No
+ *
+ */
+static int
+batch_pkt(int tfd, unsigned int conn_gen, tpp_addr_t *dest, void *data, int len)
+{
+	rtr_batches_t *batches;
+	rtr_batch_t *b = NULL;
+	tpp_tls_t *tls;
+	int nlen;
+	int i;
+
+	if ((batches = get_thrd_batches()) == NULL)
+		return 1;
+
+	for (i = 0; i < TPP_MAX_BATCH_TARGETS; i++) {
+		if (batches->slot[i].fd == tfd) {
+			b = &batches->slot[i];
+			break;
+		}
+		if (b == NULL && batches->slot[i].fd == -1)
+			b = &batches->slot[i];
+	}
+	if (b != NULL && b->fd == tfd && b->conn_gen != conn_gen) {
+		/* left over for an earlier connection that used the same tfd */
+		b->fd = -1;
+		b->num_pkts = 0;
+		b->len = 0;
+	}
+	if (b == NULL)
+		return 1; /* all slots in use for other leaves */
+
+	if (len > TPP_BATCH_SIZE - (int) (sizeof(tpp_batch_pkt_hdr_t) + sizeof(int))) {
+		if (b->fd == tfd)
+			flush_batch(b);
+		return 1;
+	}
+
+	if (b->fd == tfd && b->len + sizeof(int) + len > TPP_BATCH_SIZE)
+		flush_batch(b);
+
+	if (b->fd == -1) {
+		b->fd = tfd;
+		b->conn_gen = conn_gen;
+		memcpy(&b->dest, dest, sizeof(tpp_addr_t));
+		b->num_pkts = 0;
+		b->len = sizeof(tpp_batch_pkt_hdr_t);
+		b->flush_time = tpp_time_ms() + tpp_conf->coalesce_delay;
+		b->rtime = ((tls = tpp_get_tls()) != NULL) ? tls->rtime : 0;
+	}
+
+	nlen = htonl(len);
+	memcpy(b->buf + b->len, &nlen, sizeof(int));
+	memcpy(b->buf + b->len + sizeof(int), data, len);
+	b->len += sizeof(int) + len;
+	b->num_pkts++;
+
+	return 0;
+}
+
+/**
+ * @brief
+ *	Discard this thread's batch to a leaf whose connection closed
+ *
+ * @param[in] tfd - The connection that closed
+ *
+ * @par MT-safe: No
+ *
+ */
+static void
+drop_batch(int tfd)
+{
+	tpp_tls_t *tls;
+	rtr_batches_t *batches;
+	int i;
+
+	if ((tls = tpp_get_tls()) == NULL || (batches = tls->rtr_batches) == NULL)
+		return;
+
+	for (i = 0; i < TPP_MAX_BATCH_TARGETS; i++) {
+		if (batches->slot[i].fd == tfd) {
+			batches->slot[i].fd = -1;
+			batches->slot[i].num_pkts = 0;
+			batches->slot[i].len = 0;
+		}
+	}
+}
+
+/**
+ * @brief
+ *	The flush handler registered with the IO thread. Sends out the batches
+ *	of this thread that are due.
+ *
+ * @return - ms till the next batch is due
+ * @retval -1 - No pending batches
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: No
+ *
+ */
+static int
+router_flush_handler(void)
+{
+	tpp_tls_t *tls;
+	rtr_batches_t *batches;
+	long long now;
+	int wait = -1;
+	int i;
+
+	if ((tls = tpp_get_tls()) == NULL || (batches = tls->rtr_batches) == NULL)
+		return -1;
+
+	now = tpp_time_ms();
+	for (i = 0; i < TPP_MAX_BATCH_TARGETS; i++) {
+		rtr_batch_t *b = &batches->slot[i];
+
+		if (b->fd == -1)
+			continue;
+		if (b->flush_time <= now) {
+			flush_batch(b);
+		} else if (wait == -1 || b->flush_time - now < wait) {
+			wait = (int) (b->flush_time - now);
+		}
+	}
+	return wait;
+}
+
 /**
  * @brief
  *	The timer handler function registered with the IO thread.
@@ -1012,6 +1286,31 @@ router_timer_handler(time_t now)
 	return ret;
 }
 
+/**
+ * @brief
+ *	Get the capabilities a leaf sent after the addresses of its join
+ *
+ * @param[in] hdr - The join packet
+ * @param[in] len - The length of the join packet
+ *
+ * @return - TPP_CAP_* bits, 0 if the join does not carry any
+ *
+ * @par MT-safe: Yes
+ *
+ */
+static unsigned int
+join_caps(tpp_join_pkt_hdr_t *hdr, int len)
+{
+	int off = sizeof(tpp_join_pkt_hdr_t) + hdr->num_addrs * sizeof(tpp_addr_t);
+	unsigned int caps;
+
+	if (len < off + (int) sizeof(caps))
+		return 0;
+
+	memcpy(&caps, ((char *) hdr) + off, sizeof(caps));
+	return ntohl(caps);
+}
+
 /**
  * @brief
  *	Handler function for the router to handle incoming data. When a data
@@ -1305,6 +1604,8 @@ router_pkt_handler(int tfd, void *data, int len, void *c)
 						return -1;
 					}
 					l->conn_fd = tfd;
+					l->accepts_batch = (join_caps(hdr, len) & TPP_CAP_ACCEPTS_BATCH) ? 1 : 0;
+					l->conn_gen = ++leaf_conn_gen;
 
 					/*
 					 * Set a context only if the JOIN came from a direct connection
@@ -1690,6 +1991,8 @@ router_pkt_handler(int tfd, void *data, int len, void *c)
 			tpp_addr_t *src_host, *dest_host;
 			unsigned int src_sd;
 			tpp_data_pkt_hdr_t *dhdr = (tpp_data_pkt_hdr_t *) data;
+			int batch = 0;
+			unsigned int conn_gen = 0;
 
 			src_host = &dhdr->src_addr;
 			dest_host = &dhdr->dest_addr;
@@ -1710,6 +2013,10 @@ router_pkt_handler(int tfd, void *data, int len, void *c)
 
 			/* find a router that is still connected */
 			target_router = get_preferred_router(l, this_router, &target_fd);
+			if (target_router == this_router && l->accepts_batch && tpp_conf->coalesce_delay >= 0) {
+				batch = 1;
+				conn_gen = l->conn_gen;
+			}
 
 			tpp_unlock(&router_lock);
 			if (target_router == NULL) {
@@ -1720,6 +2027,8 @@ router_pkt_handler(int tfd, void *data, int len, void *c)
 				return 0;
 			}
 
+			if (batch == 1 && batch_pkt(target_fd, conn_gen, dest_host, data, len) == 0)
+				return 0;
 
 			chunks[0].data = data;
 			chunks[0].len = len;
@@ -2055,6 +2364,12 @@ tpp_init_router(struct tpp_config *cnf)
 	/* first set the transport handlers */
 	tpp_transport_set_handlers(NULL, NULL, router_pkt_handler, router_close_handler, router_post_connect_handler,
 		router_timer_handler);
+	if (tpp_conf->coalesce_delay >= 0) {
+		tpp_transport_set_flush_handler(router_flush_handler);
+		snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "Coalescing data to leaves accepting batches, delay %d ms",
+			tpp_conf->coalesce_delay);
+		tpp_log_func(LOG_INFO, NULL, tpp_get_logbuf());
+	}
 
 	if ((tpp_transport_init(tpp_conf)) == -1)
 		return -1;
@@ -146,6 +146,13 @@ typedef struct {
 	tpp_que_t close_conn_que;  /* The closed connection queue on this thread */
 	tpp_mbox_t mbox;     /* message box for this thread */
 	tpp_tls_t *tpp_tls;	/* tls data related to tpp work */
+
+	/* statistics, written only by this thread, see tpp_dump_stats */
+	unsigned long long pkts_sent;	/* pkts fully written, all connections */
+	unsigned long long bytes_sent;
+	unsigned long long pkts_recvd;	/* pkts handed to the upper layer */
+	unsigned long long bytes_recvd;
+	tpp_hist_t sendq_hist;	/* time pkts spent on the send queues */
 } thrd_data_t;
 
 #ifdef NAS /* localmod 149 */
@@ -187,9 +194,18 @@ typedef struct {
 
 	unsigned long send_queue_size;  /* total bytes waiting on send queue */
 	tpp_que_t send_queue;      /* queue of pkts to send */
+	int send_prepared;         /* pkts at head of send_queue already through presend */
 	tpp_packet_t scratch;      /* scratch to work on incoming data */
 	thrd_data_t *td;                  /* connections controller thread */
 
+	/* statistics, written only by the controller thread */
+	unsigned long long pkts_sent;
+	unsigned long long bytes_sent;
+	unsigned long long pkts_recvd;
+	unsigned long long bytes_recvd;
+	unsigned long send_queue_max;	/* high water mark of send_queue_size */
+	tpp_hist_t relay_hist;	/* time relayed pkts took from receipt to being written here */
+
 	tpp_context_t *ctx;        /* upper layers context information */
 } phy_conn_t;
 
@@ -648,6 +664,12 @@ int (*the_pkt_postsend_handler)(int tfd, tpp_packet_t *pkt) = NULL;
 /* upper layer timer handler */
 int (*the_timer_handler)(time_t now) = NULL;
 
+/* upper layer handler to flush coalesced data, returns ms till the next flush */
+int (*the_flush_handler)(void) = NULL;
+
+/* upper layer handler to add its own statistics to a tpp_dump_stats record */
+void (*the_stats_handler)(FILE *fp) = NULL;
+
 /**
  * @brief
  *	Function to register the upper layer handler functions
@@ -681,6 +703,46 @@ tpp_transport_set_handlers(int (*pkt_presend_handler)(int phy_con, tpp_packet_t
 	the_timer_handler = timer_handler;
 }
 
+/**
+ * @brief
+ *	Register the upper layer handler that flushes data it coalesces.
+ *	It is called by each IO thread before it waits for events, and returns
+ *	the number of milliseconds till it needs to be called again (-1 if not)
+ *
+ * @param[in] flush_handler - function ptr to the flush handler
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: No
+ *
+ */
+void
+tpp_transport_set_flush_handler(int (*flush_handler)(void))
+{
+	the_flush_handler = flush_handler;
+}
+
+/**
+ * @brief
+ *	Register the upper layer handler that adds its own members to the
+ *	JSON record written by tpp_dump_stats. The handler prints each member
+ *	preceded by a comma.
+ *
+ * @param[in] stats_handler - function ptr to the stats handler
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: No
+ *
+ */
+void
+tpp_transport_set_stats_handler(void (*stats_handler)(FILE *fp))
+{
+	the_stats_handler = stats_handler;
+}
+
 /**
  * @brief
  *	Allocate a physical connection structure and initialize it
@@ -713,6 +775,7 @@ alloc_conn(int tfd)
 	}
 	conn->sock_fd = tfd;
 	conn->send_queue_size = 0;
+	conn->send_prepared = 0;
 	TPP_QUE_CLEAR(&conn->send_queue);
 	/* initialize the send queue to empty */
 
@@ -1081,41 +1144,34 @@ check_buffer_limits(phy_conn_t *conn)
 
 /**
  * @brief
- *	Queue data to be sent out by the IO thread. This function can take a
- *	set of data buffers and sends them out after concatenating
+ *	Concatenate a set of data buffers into a new packet, preceded by the
+ *	length of the data. When called while an IO thread handles a received
+ *	packet (a router relaying it), the packet carries the receipt time.
  *
- * @param[in] tfd   - The file descriptor of the connection
  * @param[in] chunk - Array of chunks that describes each data buffer
  * @param[in] count - Number of chunks in the array of chunks
- * @param[in] totlen  - total length of data to be sent out
- * @param[in] extra - Extra data to be associated with the data packet
  *
- * @return  Error code
- * @retval  -1 - Failure
- * @retval   0 - Success
+ * @return  The packet
+ * @retval  NULL - Failure
  *
- * @par Side Effects:
- *	None
- *
- * @par MT-safe: No
+ * @par MT-safe: Yes
  *
  */
-int
-tpp_transport_vsend_extra(int tfd, tpp_chunk_t *chunk, int count, void *extra)
+static tpp_packet_t *
+mk_vpkt(tpp_chunk_t *chunk, int count)
 {
 	tpp_packet_t *pkt;
+	tpp_tls_t *tls;
 	int i;
 	int ntotlen;
 	int totlen = 0;
 
-	errno = 0;
-
 	for (i = 0; i < count; i++)
 		totlen += chunk[i].len;
 
 	pkt = tpp_cr_pkt(NULL, totlen + sizeof(int), 1);
 	if (!pkt)
-		return -1;
+		return NULL;
 
 	ntotlen = htonl(totlen);
 	memcpy(pkt->pos, &ntotlen, sizeof(int));
@@ -1127,6 +1183,43 @@ tpp_transport_vsend_extra(int tfd, tpp_chunk_t *chunk, int count, void *extra)
 	}
 	pkt->len = totlen + sizeof(int);
 	pkt->pos = pkt->data;
+	if ((tls = tpp_get_tls()) != NULL)
+		pkt->rtime = tls->rtime;
+
+	return pkt;
+}
+
+/**
+ * @brief
+ *	Queue data to be sent out by the IO thread. This function can take a
+ *	set of data buffers and sends them out after concatenating
+ *
+ * @param[in] tfd   - The file descriptor of the connection
+ * @param[in] chunk - Array of chunks that describes each data buffer
+ * @param[in] count - Number of chunks in the array of chunks
+ * @param[in] totlen  - total length of data to be sent out
+ * @param[in] extra - Extra data to be associated with the data packet
+ *
+ * @return  Error code
+ * @retval  -1 - Failure
+ * @retval   0 - Success
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: No
+ *
+ */
+int
+tpp_transport_vsend_extra(int tfd, tpp_chunk_t *chunk, int count, void *extra)
+{
+	tpp_packet_t *pkt;
+
+	errno = 0;
+
+	pkt = mk_vpkt(chunk, count);
+	if (!pkt)
+		return -1;
 	pkt->extra_data = extra;
 
 	/* write to worker threads send pipe */
@@ -1163,6 +1256,62 @@ tpp_transport_vsend(int tfd, tpp_chunk_t *chunk, int count)
 	return (tpp_transport_vsend_extra(tfd, chunk, count, NULL));
 }
 
+/**
+ * @brief
+ *	Queue the same data to be sent out on several connections. The data
+ *	is concatenated once, and the packets queued on each connection share
+ *	that single buffer.
+ *
+ * @param[in] tfds  - The file descriptors of the connections
+ * @param[in] num_tfds - Number of connections
+ * @param[in] chunk - Array of chunks that describes each data buffer
+ * @param[in] count - Number of chunks in the array of chunks
+ *
+ * @return  Error code
+ * @retval  -1 - Failure to queue on one or more connections
+ * @retval   0 - Success
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: No
+ *
+ */
+int
+tpp_transport_vsend_many(int *tfds, int num_tfds, tpp_chunk_t *chunk, int count)
+{
+	tpp_packet_t *pkt;
+	tpp_packet_t *spkt;
+	int rc = 0;
+	int i;
+
+	errno = 0;
+
+	if (num_tfds <= 0)
+		return 0;
+
+	pkt = mk_vpkt(chunk, count);
+	if (!pkt)
+		return -1;
+
+	for (i = 0; i < num_tfds; i++) {
+		/* the last connection gets the original packet */
+		if (i == num_tfds - 1)
+			spkt = pkt;
+		else if ((spkt = tpp_share_pkt(pkt)) == NULL) {
+			rc = -1;
+			continue;
+		}
+
+		/* write to worker threads send pipe */
+		if (tpp_post_cmd(tfds[i], TPP_CMD_SEND, (void *) spkt) != 0) {
+			tpp_free_pkt(spkt);
+			rc = -1;
+		}
+	}
+	return rc;
+}
+
 /**
  * @brief
  *	Whether the underlying connection is from a reserved port or not
@@ -1447,6 +1596,9 @@ handle_cmd(thrd_data_t *td, int tfd, int cmd, void *data)
 
 		/* clean up any tls memory, just for valgrind's sake */
 		if ((p = tpp_get_tls())) {
+			tpp_pool_destroy(p->pkt_pool);
+			p->pkt_pool = NULL;
+			free(p->rtr_batches);
 			free(p->log_data);
 			free(p->avl_data);
 			free(p);
@@ -1480,11 +1632,14 @@ handle_cmd(thrd_data_t *td, int tfd, int cmd, void *data)
 			tpp_free_pkt(pkt);
 			return;
 		}
+		pkt->qtime = tpp_time_us();
 		if (tpp_enque(&conn->send_queue, pkt) == NULL) {
 			tpp_log_func(LOG_CRIT, __func__, "Out of memory enqueing to send queue");
 			return;
 		}
 		conn->send_queue_size += pkt->len;
+		if (conn->send_queue_size > conn->send_queue_max)
+			conn->send_queue_max = conn->send_queue_size;
 
 		/* handle socket add calls */
 		send_data(conn);
@@ -1636,6 +1791,12 @@ work(void *v)
 				timeout = timeout * 1000; /* milliseconds */
 			}
 
+			if (the_flush_handler) {
+				timeout2 = the_flush_handler();
+				if (timeout2 != -1 && (timeout == -1 || timeout2 < timeout))
+					timeout = timeout2;
+			}
+
 			errno = 0;
 			nfds = tpp_em_wait(td->em_context, &events, timeout);
 			if (nfds <= 0) {
@@ -1951,15 +2112,9 @@ handle_incoming_data(phy_conn_t *conn)
 			torecv = space_left;
 
 		/*
-		 * do not receive any more than TPP_SCRATCHSIZE data
-		 * because that can cause add_pkts to do a lot of
-		 * memmove() unnecessarily. If there is more data
-		 * we will circle right back from epoll() anyway
+		 * receive as much as the scratch space can hold, add_pkts
+		 * carves all complete packets out of it in one pass
 		 */
-		if (torecv > TPP_SCRATCHSIZE)
-			torecv = TPP_SCRATCHSIZE;
-
-		/* receive as much as we can */
 		closed = 0;
 		amt = 0;
 		while (torecv > 0) {
@@ -1979,6 +2134,8 @@ handle_incoming_data(phy_conn_t *conn)
 			amt += rc;
 			conn->scratch.pos += rc;
 		}
+		conn->bytes_recvd += amt;
+		conn->td->bytes_recvd += amt;
 		rc = add_pkts(conn);
 		if (rc == -1) {
 			/* a disconnect had happened in the flow, quit this routine */
@@ -2016,13 +2173,12 @@ add_pkts(phy_conn_t *conn)
 {
 	char *pkt_start;
 	int avl_len;
+	int offset = 0;
 	int rc = 0;
 	int tfd = conn->sock_fd;
 	int slot_state;
-	int count = 0;
 
 	int recv_len = conn->scratch.pos - conn->scratch.data;
-	pkt_start = conn->scratch.data;
 	avl_len = recv_len;
 
 	while (avl_len >= (sizeof(int) + sizeof(char))) {
@@ -2030,6 +2186,9 @@ add_pkts(phy_conn_t *conn)
 		int data_len;
 		char *data;
 
+		/* the handler may have moved us to a new conn, so index from data */
+		pkt_start = conn->scratch.data + offset;
+
 		/*  We have enough data now to validate the header */
 		if (tpp_validate_hdr(tfd, pkt_start) != 0) {
 			handle_disconnect(conn);
@@ -2042,8 +2201,13 @@ add_pkts(phy_conn_t *conn)
 			break;
 
 		data = pkt_start + sizeof(int);
+		conn->pkts_recvd++;
+		conn->td->pkts_recvd++;
 		if (the_pkt_handler) {
-			if ((rc = the_pkt_handler(conn->sock_fd, data, data_len, conn->ctx)) != 0) {
+			conn->td->tpp_tls->rtime = tpp_time_us();
+			rc = the_pkt_handler(conn->sock_fd, data, data_len, conn->ctx);
+			conn->td->tpp_tls->rtime = 0;
+			if (rc != 0) {
 				/* upper layer rejected data, disconnect */
 				handle_disconnect(conn);
 				return -1;
@@ -2054,266 +2218,313 @@ add_pkts(phy_conn_t *conn)
 				return -1;
 		}
 
-		count++;
-		/* coalesce before next packet to maintain alignment */
-		avl_len = avl_len - pkt_len;
-		memmove(conn->scratch.data, conn->scratch.data + pkt_len, (size_t)avl_len); /* area OVERLAP - use memmove */
-		conn->scratch.pos = conn->scratch.data + avl_len;
+		offset += pkt_len;
+		avl_len -= pkt_len;
 	}
 
-	if (count > 50) {
-		snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "Received many small packets(%d)", count);
-		tpp_log_func(LOG_INFO, __func__, tpp_get_logbuf());
+	/*
+	 * move the partial packet left over to the front once, rather than
+	 * after every packet, so a read holding many small packets is not
+	 * quadratic in the number of packets
+	 */
+	if (offset > 0) {
+		memmove(conn->scratch.data, conn->scratch.data + offset, (size_t)avl_len); /* area OVERLAP - use memmove */
+		conn->scratch.pos = conn->scratch.data + avl_len;
 	}
+
 	return rc;
 }
 
+#ifdef NAS /* localmod 149 */
 /**
  * @brief
- *	Loop over the list of queued data and send out packet by packet
- *	Stop if sending would block.
+ *	Account for a send in the per thread NAS instrumentation and print
+ *	the statistics to the log when a period is over.
  *
  * @param[in] conn - The physical connection
- *
- * @par Side Effects:
- *	None
+ * @param[in] tosend - The number of bytes we tried to send
+ * @param[in] rc - The number of bytes actually sent
  *
  * @par MT-safe: No
  *
  */
 static void
-send_data(phy_conn_t *conn)
+nas_account_send(phy_conn_t *conn, int tosend, int rc)
 {
-	tpp_packet_t *p = NULL;
-	int rc;
-	int can_send_more;
-	tpp_que_elem_t *n;
-#ifdef NAS /* localmod 149 */
 	time_t curr;
 	int rc_iflag;
-#endif /* localmod 149 */
-
 
-	/*
-	 * if a socket is still connecting, we will wait to send out data,
-	 * even if app called close - so check this first
-	 */
-	if (conn->net_state == TPP_CONN_CONNECTING || conn->net_state == TPP_CONN_INITIATING)
+	if (rc <= 0)
 		return;
 
-	n = TPP_QUE_HEAD(&conn->send_queue);
-	p = TPP_QUE_DATA(n);
+	curr = time(0);
 
-	if (conn->can_send == 0)
-		return;
+	conn->td->nas_kb_sent_A += ((double) rc) / 1024.0;
+	conn->td->nas_kb_sent_B += ((double) rc) / 1024.0;
+	conn->td->nas_kb_sent_C += ((double) rc) / 1024.0;
 
-	can_send_more = 1;
+	if (tosend > TPP_SCRATCHSIZE) {
+		conn->td->nas_num_lrg_sends_A++;
+		conn->td->nas_lrg_send_sum_kb_A += ((double) tosend) / 1024.0;
 
-	while (p && can_send_more) {
-		int tosend;
+		if (rc != tosend) {
+			conn->td->nas_num_qual_lrg_sends_A++;
+		}
 
-		tosend = p->len - (p->pos - p->data);
-		if (p->pos == p->data) {
-			if (the_pkt_presend_handler) {
-				if (the_pkt_presend_handler(conn->sock_fd, p) != 0) {
-					/* handler asked not to send data, skip packet */
-					conn->send_queue_size -= tosend;
-					n = tpp_que_del_elem(&conn->send_queue, n);
-					n = TPP_QUE_HEAD(&conn->send_queue);
-					p = TPP_QUE_DATA(n);
-					continue;
-				}
-			}
+		if (tosend > conn->td->nas_max_bytes_lrg_send_A) {
+			conn->td->nas_max_bytes_lrg_send_A = tosend;
 		}
 
-		while (tosend > 0) {
-			rc = tpp_sock_send(conn->sock_fd, p->pos, tosend, 0);
-#ifdef NAS /* localmod 149 */
-			if (rc > 0) {
-				curr = time(0);
+		if (tosend < conn->td->nas_min_bytes_lrg_send_A) {
+			conn->td->nas_min_bytes_lrg_send_A = tosend;
+		}
 
-				conn->td->nas_kb_sent_A += ((double) rc) / 1024.0;
-				conn->td->nas_kb_sent_B += ((double) rc) / 1024.0;
-				conn->td->nas_kb_sent_C += ((double) rc) / 1024.0;
 
-				if (tosend > TPP_SCRATCHSIZE) {
-					conn->td->nas_num_lrg_sends_A++;
-					conn->td->nas_lrg_send_sum_kb_A += ((double) tosend) / 1024.0;
 
-					if (rc != tosend) {
-						conn->td->nas_num_qual_lrg_sends_A++;
-					}
+		conn->td->nas_num_lrg_sends_B++;
+		conn->td->nas_lrg_send_sum_kb_B += ((double) tosend) / 1024.0;
 
-					if (tosend > conn->td->nas_max_bytes_lrg_send_A) {
-						conn->td->nas_max_bytes_lrg_send_A = tosend;
-					}
+		if (rc != tosend) {
+			conn->td->nas_num_qual_lrg_sends_B++;
+		}
 
-					if (tosend < conn->td->nas_min_bytes_lrg_send_A) {
-						conn->td->nas_min_bytes_lrg_send_A = tosend;
-					}
+		if (tosend > conn->td->nas_max_bytes_lrg_send_B) {
+			conn->td->nas_max_bytes_lrg_send_B = tosend;
+		}
 
+		if (tosend < conn->td->nas_min_bytes_lrg_send_B) {
+			conn->td->nas_min_bytes_lrg_send_B = tosend;
+		}
 
 
-					conn->td->nas_num_lrg_sends_B++;
-					conn->td->nas_lrg_send_sum_kb_B += ((double) tosend) / 1024.0;
 
-					if (rc != tosend) {
-						conn->td->nas_num_qual_lrg_sends_B++;
-					}
+		conn->td->nas_num_lrg_sends_C++;
+		conn->td->nas_lrg_send_sum_kb_C += ((double) tosend) / 1024.0;
 
-					if (tosend > conn->td->nas_max_bytes_lrg_send_B) {
-						conn->td->nas_max_bytes_lrg_send_B = tosend;
-					}
+		if (rc != tosend) {
+			conn->td->nas_num_qual_lrg_sends_C++;
+		}
 
-					if (tosend < conn->td->nas_min_bytes_lrg_send_B) {
-						conn->td->nas_min_bytes_lrg_send_B = tosend;
-					}
+		if (tosend > conn->td->nas_max_bytes_lrg_send_C) {
+			conn->td->nas_max_bytes_lrg_send_C = tosend;
+		}
 
+		if (tosend < conn->td->nas_min_bytes_lrg_send_C) {
+			conn->td->nas_min_bytes_lrg_send_C = tosend;
+		}
+	}
 
+	if (curr > (conn->td->nas_last_time_A + conn->td->NAS_TPP_LOG_PERIOD_A)) {
+		rc_iflag = access(tpp_instr_flag_file, F_OK);
+		if (rc_iflag != 0) {
+			conn->td->nas_tpp_log_enabled = 0;
+		} else {
+			conn->td->nas_tpp_log_enabled = 1;
+		}
 
-					conn->td->nas_num_lrg_sends_C++;
-					conn->td->nas_lrg_send_sum_kb_C += ((double) tosend) / 1024.0;
+		if (conn->td->nas_tpp_log_enabled) {
+			snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ,
+				 "tpp_instr period_A %d last %d secs (mb=%.3f, mb/min=%.3f) lrg send over %d (sends=%d, qualified=%d, minbytes=%d, maxbytes=%d, avgkb=%.1f)",
+				 conn->td->NAS_TPP_LOG_PERIOD_A,
+				 (int) (curr - conn->td->nas_last_time_A),
+				 conn->td->nas_kb_sent_A / 1024.0,
+				 (conn->td->nas_kb_sent_A / 1024.0) / (((double) (curr - conn->td->nas_last_time_A)) / 60.0),
+				 TPP_SCRATCHSIZE,
+				 conn->td->nas_num_lrg_sends_A,
+				 conn->td->nas_num_qual_lrg_sends_A,
+				 conn->td->nas_num_lrg_sends_A > 0 ? conn->td->nas_min_bytes_lrg_send_A : 0,
+				 conn->td->nas_max_bytes_lrg_send_A,
+				 conn->td->nas_num_lrg_sends_A > 0 ? conn->td->nas_lrg_send_sum_kb_A / ((double) conn->td->nas_num_lrg_sends_A) : 0.0);
+			tpp_log_func(LOG_ERR, __func__, tpp_get_logbuf());
+		}
 
-					if (rc != tosend) {
-						conn->td->nas_num_qual_lrg_sends_C++;
-					}
+		conn->td->nas_last_time_A = curr;
+		conn->td->nas_kb_sent_A = 0.0;
+		conn->td->nas_num_lrg_sends_A = 0;
+		conn->td->nas_num_qual_lrg_sends_A = 0;
+		conn->td->nas_max_bytes_lrg_send_A = 0;
+		conn->td->nas_min_bytes_lrg_send_A = INT_MAX - 1;
+		conn->td->nas_lrg_send_sum_kb_A = 0.0;
+	}
 
-					if (tosend > conn->td->nas_max_bytes_lrg_send_C) {
-						conn->td->nas_max_bytes_lrg_send_C = tosend;
-					}
+	if (curr > (conn->td->nas_last_time_B + conn->td->NAS_TPP_LOG_PERIOD_B)) {
+		if (conn->td->nas_tpp_log_enabled) {
+			snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ,
+				 "tpp_instr period_B %d last %d secs (mb=%.3f, mb/min=%.3f) lrg send over %d (sends=%d, qualified=%d, minbytes=%d, maxbytes=%d, avgkb=%.1f)",
+				 conn->td->NAS_TPP_LOG_PERIOD_B,
+				 (int) (curr - conn->td->nas_last_time_B),
+				 conn->td->nas_kb_sent_B / 1024.0,
+				 (conn->td->nas_kb_sent_B / 1024.0) / (((double) (curr - conn->td->nas_last_time_B)) / 60.0),
+				 TPP_SCRATCHSIZE,
+				 conn->td->nas_num_lrg_sends_B,
+				 conn->td->nas_num_qual_lrg_sends_B,
+				 conn->td->nas_num_lrg_sends_B > 0 ? conn->td->nas_min_bytes_lrg_send_B : 0,
+				 conn->td->nas_max_bytes_lrg_send_B,
+				 conn->td->nas_num_lrg_sends_B > 0 ? conn->td->nas_lrg_send_sum_kb_B / ((double) conn->td->nas_num_lrg_sends_B) : 0.0);
+			tpp_log_func(LOG_ERR, __func__, tpp_get_logbuf());
+		}
 
-					if (tosend < conn->td->nas_min_bytes_lrg_send_C) {
-						conn->td->nas_min_bytes_lrg_send_C = tosend;
-					}
-				}
+		conn->td->nas_last_time_B = curr;
+		conn->td->nas_kb_sent_B = 0.0;
+		conn->td->nas_num_lrg_sends_B = 0;
+		conn->td->nas_num_qual_lrg_sends_B = 0;
+		conn->td->nas_max_bytes_lrg_send_B = 0;
+		conn->td->nas_min_bytes_lrg_send_B = INT_MAX - 1;
+		conn->td->nas_lrg_send_sum_kb_B = 0.0;
+	}
 
-				if (curr > (conn->td->nas_last_time_A + conn->td->NAS_TPP_LOG_PERIOD_A)) {
-					rc_iflag = access(tpp_instr_flag_file, F_OK);
-					if (rc_iflag != 0) {
-						conn->td->nas_tpp_log_enabled = 0;
-					} else {
-						conn->td->nas_tpp_log_enabled = 1;
-					}
+	if (curr > (conn->td->nas_last_time_C + conn->td->NAS_TPP_LOG_PERIOD_C)) {
+		if (conn->td->nas_tpp_log_enabled) {
+			snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ,
+				 "tpp_instr period_C %d last %d secs (mb=%.3f, mb/min=%.3f) lrg send over %d (sends=%d, qualified=%d, minbytes=%d, maxbytes=%d, avgkb=%.1f)",
+				conn->td->NAS_TPP_LOG_PERIOD_C,
+				(int) (curr - conn->td->nas_last_time_C),
+				conn->td->nas_kb_sent_C / 1024.0,
+				(conn->td->nas_kb_sent_C / 1024.0) / (((double) (
+				curr - conn->td->nas_last_time_C)) / 60.0),
+				TPP_SCRATCHSIZE,
+				conn->td->nas_num_lrg_sends_C,
+				conn->td->nas_num_qual_lrg_sends_C,
+				conn->td->nas_num_lrg_sends_C > 0 ? conn->td->nas_min_bytes_lrg_send_C : 0,
+				conn->td->nas_max_bytes_lrg_send_C,
+				conn->td->nas_num_lrg_sends_C > 0 ? conn->td->nas_lrg_send_sum_kb_C / ((double) conn->td->nas_num_lrg_sends_C) : 0.0);
+			tpp_log_func(LOG_ERR, __func__, tpp_get_logbuf());
+		}
 
-					if (conn->td->nas_tpp_log_enabled) {
-						snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ,
-							 "tpp_instr period_A %d last %d secs (mb=%.3f, mb/min=%.3f) lrg send over %d (sends=%d, qualified=%d, minbytes=%d, maxbytes=%d, avgkb=%.1f)",
-							 conn->td->NAS_TPP_LOG_PERIOD_A,
-							 (int) (curr - conn->td->nas_last_time_A),
-							 conn->td->nas_kb_sent_A / 1024.0,
-							 (conn->td->nas_kb_sent_A / 1024.0) / (((double) (curr - conn->td->nas_last_time_A)) / 60.0),
-							 TPP_SCRATCHSIZE,
-							 conn->td->nas_num_lrg_sends_A,
-							 conn->td->nas_num_qual_lrg_sends_A,
-							 conn->td->nas_num_lrg_sends_A > 0 ? conn->td->nas_min_bytes_lrg_send_A : 0,
-							 conn->td->nas_max_bytes_lrg_send_A,
-							 conn->td->nas_num_lrg_sends_A > 0 ? conn->td->nas_lrg_send_sum_kb_A / ((double) conn->td->nas_num_lrg_sends_A) : 0.0);
-						tpp_log_func(LOG_ERR, __func__, tpp_get_logbuf());
-					}
+		conn->td->nas_last_time_C = curr;
+		conn->td->nas_kb_sent_C = 0.0;
+		conn->td->nas_num_lrg_sends_C = 0;
+		conn->td->nas_num_qual_lrg_sends_C = 0;
+		conn->td->nas_max_bytes_lrg_send_C = 0;
+		conn->td->nas_min_bytes_lrg_send_C = INT_MAX - 1;
+		conn->td->nas_lrg_send_sum_kb_C = 0.0;
+	}
+}
+#endif /* localmod 149 */
 
-					conn->td->nas_last_time_A = curr;
-					conn->td->nas_kb_sent_A = 0.0;
-					conn->td->nas_num_lrg_sends_A = 0;
-					conn->td->nas_num_qual_lrg_sends_A = 0;
-					conn->td->nas_max_bytes_lrg_send_A = 0;
-					conn->td->nas_min_bytes_lrg_send_A = INT_MAX - 1;
-					conn->td->nas_lrg_send_sum_kb_A = 0.0;
-				}
+/**
+ * @brief
+ *	Loop over the list of queued data and send it out, gathering up to
+ *	TPP_MAX_IOV packets from the head of the queue into a single writev.
+ *	A short write leaves the position of the packet where the write
+ *	ended, and the next write picks up from there.
+ *	Stop if sending would block.
+ *
+ * @param[in] conn - The physical connection
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: No
+ *
+ */
+static void
+send_data(phy_conn_t *conn)
+{
+	tpp_chunk_t chunks[TPP_MAX_IOV];
+	tpp_packet_t *p = NULL;
+	tpp_que_elem_t *n;
+	int count;
+	int tosend;
+	int rc;
+	int i;
+	long long now;
 
-				if (curr > (conn->td->nas_last_time_B + conn->td->NAS_TPP_LOG_PERIOD_B)) {
-					if (conn->td->nas_tpp_log_enabled) {
-						snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ,
-							 "tpp_instr period_B %d last %d secs (mb=%.3f, mb/min=%.3f) lrg send over %d (sends=%d, qualified=%d, minbytes=%d, maxbytes=%d, avgkb=%.1f)",
-							 conn->td->NAS_TPP_LOG_PERIOD_B,
-							 (int) (curr - conn->td->nas_last_time_B),
-							 conn->td->nas_kb_sent_B / 1024.0,
-							 (conn->td->nas_kb_sent_B / 1024.0) / (((double) (curr - conn->td->nas_last_time_B)) / 60.0),
-							 TPP_SCRATCHSIZE,
-							 conn->td->nas_num_lrg_sends_B,
-							 conn->td->nas_num_qual_lrg_sends_B,
-							 conn->td->nas_num_lrg_sends_B > 0 ? conn->td->nas_min_bytes_lrg_send_B : 0,
-							 conn->td->nas_max_bytes_lrg_send_B,
-							 conn->td->nas_num_lrg_sends_B > 0 ? conn->td->nas_lrg_send_sum_kb_B / ((double) conn->td->nas_num_lrg_sends_B) : 0.0);
-						tpp_log_func(LOG_ERR, __func__, tpp_get_logbuf());
-					}
+	/*
+	 * if a socket is still connecting, we will wait to send out data,
+	 * even if app called close - so check this first
+	 */
+	if (conn->net_state == TPP_CONN_CONNECTING || conn->net_state == TPP_CONN_INITIATING)
+		return;
 
-					conn->td->nas_last_time_B = curr;
-					conn->td->nas_kb_sent_B = 0.0;
-					conn->td->nas_num_lrg_sends_B = 0;
-					conn->td->nas_num_qual_lrg_sends_B = 0;
-					conn->td->nas_max_bytes_lrg_send_B = 0;
-					conn->td->nas_min_bytes_lrg_send_B = INT_MAX - 1;
-					conn->td->nas_lrg_send_sum_kb_B = 0.0;
-				}
+	if (conn->can_send == 0)
+		return;
 
-				if (curr > (conn->td->nas_last_time_C + conn->td->NAS_TPP_LOG_PERIOD_C)) {
-					if (conn->td->nas_tpp_log_enabled) {
-						snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ,
-							 "tpp_instr period_C %d last %d secs (mb=%.3f, mb/min=%.3f) lrg send over %d (sends=%d, qualified=%d, minbytes=%d, maxbytes=%d, avgkb=%.1f)",
-							conn->td->NAS_TPP_LOG_PERIOD_C,
-							(int) (curr - conn->td->nas_last_time_C),
-							conn->td->nas_kb_sent_C / 1024.0,
-							(conn->td->nas_kb_sent_C / 1024.0) / (((double) (
-							curr - conn->td->nas_last_time_C)) / 60.0),
-							TPP_SCRATCHSIZE,
-							conn->td->nas_num_lrg_sends_C,
-							conn->td->nas_num_qual_lrg_sends_C,
-							conn->td->nas_num_lrg_sends_C > 0 ? conn->td->nas_min_bytes_lrg_send_C : 0,
-							conn->td->nas_max_bytes_lrg_send_C,
-							conn->td->nas_num_lrg_sends_C > 0 ? conn->td->nas_lrg_send_sum_kb_C / ((double) conn->td->nas_num_lrg_sends_C) : 0.0);
-						tpp_log_func(LOG_ERR, __func__, tpp_get_logbuf());
-					}
+	while (1) {
+		count = 0;
+		tosend = 0;
+		n = TPP_QUE_HEAD(&conn->send_queue);
+		while (n && count < TPP_MAX_IOV) {
+			p = TPP_QUE_DATA(n);
 
-					conn->td->nas_last_time_C = curr;
-					conn->td->nas_kb_sent_C = 0.0;
-					conn->td->nas_num_lrg_sends_C = 0;
-					conn->td->nas_num_qual_lrg_sends_C = 0;
-					conn->td->nas_max_bytes_lrg_send_C = 0;
-					conn->td->nas_min_bytes_lrg_send_C = INT_MAX - 1;
-					conn->td->nas_lrg_send_sum_kb_C = 0.0;
+			/*
+			 * the first send_prepared packets have already been through
+			 * the presend handler in an earlier, partial, write
+			 */
+			if (count >= conn->send_prepared) {
+				if (the_pkt_presend_handler) {
+					if (the_pkt_presend_handler(conn->sock_fd, p) != 0) {
+						/* handler asked not to send data, skip packet */
+						conn->send_queue_size -= p->len;
+						n = tpp_que_del_elem(&conn->send_queue, n);
+						n = TPP_QUE_NEXT(&conn->send_queue, n);
+						continue;
+					}
 				}
+				conn->send_prepared++;
 			}
-#endif /* localmod 149 */
 
-			if (rc < 0) {
-				if (errno == EWOULDBLOCK || errno == EAGAIN) {
-					/* set this socket in POLLOUT */
-					if (tpp_em_mod_fd(conn->td->em_context, conn->sock_fd,
-						EM_IN | EM_OUT | EM_HUP | EM_ERR)	== -1) {
-						tpp_log_func(LOG_ERR, __func__, "Multiplexing failed");
-						exit(1);
-					}
+			chunks[count].data = p->pos;
+			chunks[count].len = p->len - (p->pos - p->data);
+			tosend += chunks[count].len;
+			count++;
+			n = TPP_QUE_NEXT(&conn->send_queue, n);
+		}
 
-					/* set to cannot send data any more */
-					conn->can_send = 0;
-				} else {
-					handle_disconnect(conn);
-					return;
+		if (count == 0)
+			break;
+
+		rc = tpp_sock_writev(conn->sock_fd, chunks, count);
+#ifdef NAS /* localmod 149 */
+		nas_account_send(conn, tosend, rc);
+#endif /* localmod 149 */
+		if (rc < 0) {
+			if (errno == EWOULDBLOCK || errno == EAGAIN) {
+				/* set this socket in POLLOUT */
+				if (tpp_em_mod_fd(conn->td->em_context, conn->sock_fd,
+					EM_IN | EM_OUT | EM_HUP | EM_ERR)	== -1) {
+					tpp_log_func(LOG_ERR, __func__, "Multiplexing failed");
+					exit(1);
 				}
-				can_send_more = 0;
+
+				/* set to cannot send data any more */
+				conn->can_send = 0;
+			} else
+				handle_disconnect(conn);
+			return;
+		}
+		TPP_DBPRT(("tfd=%d, sending out %d bytes in %d packets", conn->sock_fd, rc, count));
+		conn->bytes_sent += rc;
+		conn->td->bytes_sent += rc;
+
+		/*
+		 * all data in the packets that were fully written has been sent or
+		 * done with. delete them from the head of the queue
+		 */
+		for (i = 0; i < count; i++) {
+			n = TPP_QUE_HEAD(&conn->send_queue);
+			p = TPP_QUE_DATA(n);
+			if (rc < chunks[i].len) {
+				p->pos += rc;
 				break;
 			}
-			TPP_DBPRT(("tfd=%d, sending out %d bytes", conn->sock_fd, rc));
-			p->pos += rc;
-			tosend -= rc;
-		}
+			rc -= chunks[i].len;
 
-		if (tosend == 0) {
 			conn->send_queue_size -= p->len;
+			conn->send_prepared--;
+			conn->pkts_sent++;
+			conn->td->pkts_sent++;
+			now = tpp_time_us();
+			tpp_hist_add(&conn->td->sendq_hist, now - p->qtime);
+			if (p->rtime)
+				tpp_hist_add(&conn->relay_hist, now - p->rtime);
 
 			if (the_pkt_postsend_handler)
 				the_pkt_postsend_handler(conn->sock_fd, p);
 			else {
 				tpp_free_pkt(p);
 			}
-
-			/*
-			 * all data in this packet has been sent or done with.
-			 * delete this node and get next node in queue
-			 */
-			n = tpp_que_del_elem(&conn->send_queue, n);
-			n = TPP_QUE_HEAD(&conn->send_queue);
-			p = TPP_QUE_DATA(n);
+			tpp_que_del_elem(&conn->send_queue, n);
 		}
 	}
 }
@@ -2365,6 +2576,121 @@ tpp_dummy_logfunc(int level, const char *id, char *mess)
 {
 }
 
+/**
+ * @brief
+ *	Append the runtime statistics of the TPP layer to a file, as one line
+ *	of JSON:
+ *
+ *	{"daemon":"pbs_comm","time":1500000000,
+ *	 "threads":[{"index":0,"pkts_sent":..,"bytes_sent":..,"pkts_recvd":..,
+ *	   "bytes_recvd":..,"mbox_depth":..,"mbox_max_depth":..,
+ *	   "mbox_wait":{..},"sendq_wait":{..}},...],
+ *	 "conns":[{"tfd":7,"thread":0,"peer":"10.0.0.1:15001","pkts_sent":..,
+ *	   "bytes_sent":..,"pkts_recvd":..,"bytes_recvd":..,"send_queue":..,
+ *	   "send_queue_max":..,"relay_wait":{..}},...]}
+ *
+ *	followed by whatever the upper layer stats handler adds. The latency
+ *	histograms (see tpp_hist_print) are in microseconds: mbox_wait is the
+ *	time commands waited for the thread, sendq_wait the time packets sat
+ *	on a send queue till they were fully written to the socket, and
+ *	relay_wait the time packets relayed by a router took from being read
+ *	off their incoming connection to being fully written to this one, the
+ *	router's part of the hop towards that peer. The
+ *	counters are read without stopping the IO threads, so they may be a
+ *	little inconsistent with each other.
+ *
+ * @param[in] path   - The file to append to
+ * @param[in] daemon - Name of the daemon, included in the record
+ *
+ * @return Error code
+ * @retval -1 Failure
+ * @retval  0 Success
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: No
+ *
+ */
+int
+tpp_dump_stats(char *path, char *daemon)
+{
+	FILE *fp;
+	thrd_data_t *td;
+	phy_conn_t *conn;
+	tpp_addr_t *addr;
+	char *peer;
+	int first = 1;
+	int i;
+
+	if (thrd_pool == NULL)
+		return -1;
+
+	if ((fp = fopen(path, "a")) == NULL) {
+		snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "Can not open stats file %s, errno=%d", path, errno);
+		tpp_log_func(LOG_ERR, __func__, tpp_get_logbuf());
+		return -1;
+	}
+
+	fprintf(fp, "{\"daemon\":\"%s\",\"time\":%ld,\"threads\":[", daemon, (long) time(NULL));
+	for (i = 0; i < num_threads; i++) {
+		td = thrd_pool[i];
+		fprintf(fp, "%s{\"index\":%d,\"pkts_sent\":%llu,\"bytes_sent\":%llu,"
+			"\"pkts_recvd\":%llu,\"bytes_recvd\":%llu,\"mbox_depth\":%u,\"mbox_max_depth\":%u,",
+			i == 0 ? "" : ",", td->thrd_index, td->pkts_sent, td->bytes_sent,
+			td->pkts_recvd, td->bytes_recvd, td->mbox.depth, td->mbox.max_depth);
+		tpp_hist_print(fp, "mbox_wait", &td->mbox.wait_hist);
+		fprintf(fp, ",");
+		tpp_hist_print(fp, "sendq_wait", &td->sendq_hist);
+		fprintf(fp, "}");
+	}
+
+	/*
+	 * hold the array lock, so that a connection being closed is not
+	 * freed while we look at it (its slot is released under this lock
+	 * before the structure is freed)
+	 */
+	fprintf(fp, "],\"conns\":[");
+	tpp_lock(&cons_array_lock);
+	for (i = 0; i < conns_array_size; i++) {
+		conn = conns_array[i].conn;
+		if (conn == NULL || conns_array[i].slot_state != TPP_SLOT_BUSY)
+			continue;
+
+		addr = NULL;
+		if (conn->conn_params && conn->conn_params->hostname)
+			peer = conn->conn_params->hostname;
+		else if (conn->net_state == TPP_CONN_CONNECTED && (addr = tpp_get_connected_host(conn->sock_fd)))
+			peer = tpp_netaddr(addr);
+		else
+			peer = "";
+
+		fprintf(fp, "%s{\"tfd\":%d,\"thread\":%d,\"peer\":\"%s\",\"pkts_sent\":%llu,"
+			"\"bytes_sent\":%llu,\"pkts_recvd\":%llu,\"bytes_recvd\":%llu,"
+			"\"send_queue\":%lu,\"send_queue_max\":%lu,",
+			first ? "" : ",", i, conn->td ? conn->td->thrd_index : -1, peer,
+			conn->pkts_sent, conn->bytes_sent, conn->pkts_recvd, conn->bytes_recvd,
+			conn->send_queue_size, conn->send_queue_max);
+		tpp_hist_print(fp, "relay_wait", &conn->relay_hist);
+		fprintf(fp, "}");
+		first = 0;
+		free(addr);
+	}
+	tpp_unlock(&cons_array_lock);
+	fprintf(fp, "]");
+
+	if (the_stats_handler)
+		the_stats_handler(fp);
+	fprintf(fp, "}\n");
+
+	if (fclose(fp) != 0) {
+		snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "Can not write stats file %s, errno=%d", path, errno);
+		tpp_log_func(LOG_ERR, __func__, tpp_get_logbuf());
+		return -1;
+	}
+	return 0;
+}
+
 /**
  * @brief
  *	Shut down this layer, send "exit" commands to all threads, and then
@@ -2394,6 +2720,7 @@ tpp_transport_shutdown()
 		free(thrd_pool[i]);
 	}
 	free(thrd_pool);
+	thrd_pool = NULL;
 
 	for (i = 0; i < conns_array_size; i++) {
 		if (conns_array[i].conn) {
@@ -75,6 +75,9 @@
 #ifdef PBS_COMPRESSION_ENABLED
 #include <zlib.h>
 #endif
+#ifdef PBS_COMPRESSION_LZ4
+#include <lz4.h>
+#endif
 
 /*
  *	Global Variables
@@ -89,6 +92,269 @@ long tpp_log_event_mask = 0;
 
 void (*tpp_log_func)(int level, const char *id, char *mess) = NULL;
 
+/*
+ * Packets and their data buffers are recycled through free lists kept
+ * in the TLS of each thread, so the IO threads do not all contend on
+ * malloc. Data buffers come in a few size classes; larger ones go
+ * straight to malloc. A buffer is preceded by a small header holding
+ * its capacity and a reference count, so a single buffer can be shared
+ * by several packets (for example the copies of a broadcast queued on
+ * each connection). A buffer freed by a thread other than the one that
+ * allocated it simply lands in the freeing thread's lists.
+ */
+#define TPP_POOL_CLASSES	4
+#define TPP_POOL_MAX_FREE	256	/* max free items kept per list */
+
+static int tpp_pool_sizes[TPP_POOL_CLASSES] = {256, 1024, 4096, 16384};
+
+typedef union {
+	struct {
+		int size;	/* capacity of the buffer that follows */
+		int ref_count;	/* number of packets referencing the buffer */
+	} h;
+	double align;	/* keep the buffer that follows aligned */
+} tpp_buf_hdr_t;
+
+typedef struct tpp_pool_item {
+	struct tpp_pool_item *next;
+} tpp_pool_item_t;
+
+typedef struct {
+	tpp_pool_item_t *bufs[TPP_POOL_CLASSES]; /* free buffers, by class */
+	int num_bufs[TPP_POOL_CLASSES];
+	tpp_pool_item_t *pkts;	/* free packet structures */
+	int num_pkts;
+} tpp_pool_t;
+
+/**
+ * @brief
+ *	Get the packet pool of the calling thread, creating it if needed
+ *
+ * @return The pool
+ * @retval NULL - Failure (no TLS or out of memory), callers use malloc
+ *
+ * @par MT-safe: Yes
+ *
+ */
+static tpp_pool_t *
+tpp_get_pool(void)
+{
+	tpp_tls_t *tls;
+
+	if ((tls = tpp_get_tls()) == NULL)
+		return NULL;
+
+	if (tls->pkt_pool == NULL)
+		tls->pkt_pool = calloc(1, sizeof(tpp_pool_t));
+
+	return (tpp_pool_t *) tls->pkt_pool;
+}
+
+/**
+ * @brief
+ *	Free a thread's packet pool and everything on its free lists
+ *
+ * @param[in] - pool - The pool (the pkt_pool member of the TLS)
+ *
+ * @par MT-safe: No
+ *
+ */
+void
+tpp_pool_destroy(void *pool)
+{
+	tpp_pool_t *pl = pool;
+	tpp_pool_item_t *it;
+	int i;
+
+	if (pl == NULL)
+		return;
+
+	for (i = 0; i < TPP_POOL_CLASSES; i++) {
+		while ((it = pl->bufs[i])) {
+			pl->bufs[i] = it->next;
+			free(it);
+		}
+	}
+	while ((it = pl->pkts)) {
+		pl->pkts = it->next;
+		free(it);
+	}
+	free(pl);
+}
+
+/**
+ * @brief
+ *	Allocate a refcounted data buffer, from the thread's pool if the
+ *	size fits one of the size classes
+ *
+ * @param[in] - len - Length of the buffer needed
+ *
+ * @return The buffer, with a reference count of 1
+ * @retval NULL - Failure (Out of memory)
+ *
+ * @par MT-safe: Yes
+ *
+ */
+void *
+tpp_buf_alloc(int len)
+{
+	tpp_pool_t *pl;
+	tpp_buf_hdr_t *hdr = NULL;
+	int size = len;
+	int i;
+
+	for (i = 0; i < TPP_POOL_CLASSES; i++) {
+		if (len <= tpp_pool_sizes[i]) {
+			size = tpp_pool_sizes[i];
+			break;
+		}
+	}
+
+	if (i < TPP_POOL_CLASSES && (pl = tpp_get_pool()) && pl->bufs[i]) {
+		hdr = (tpp_buf_hdr_t *) pl->bufs[i];
+		pl->bufs[i] = pl->bufs[i]->next;
+		pl->num_bufs[i]--;
+	} else {
+#ifdef DEBUG
+		/* use calloc() to satisfy valgrind in debug mode */
+		hdr = calloc(sizeof(tpp_buf_hdr_t) + size, 1);
+#else
+		/* use malloc() in non-debug mode for performance */
+		hdr = malloc(sizeof(tpp_buf_hdr_t) + size);
+#endif
+		if (hdr == NULL)
+			return NULL;
+	}
+	hdr->h.size = size;
+	hdr->h.ref_count = 1;
+
+	return ((char *) hdr + sizeof(tpp_buf_hdr_t));
+}
+
+/**
+ * @brief
+ *	Drop a reference to a buffer from tpp_buf_alloc(). The last
+ *	reference returns the buffer to the pool of the calling thread.
+ *
+ * @param[in] - buf - The buffer
+ *
+ * @par MT-safe: Yes
+ *
+ */
+void
+tpp_buf_free(void *buf)
+{
+	tpp_buf_hdr_t *hdr;
+	tpp_pool_item_t *it;
+	tpp_pool_t *pl;
+	int i;
+
+	if (buf == NULL)
+		return;
+
+	hdr = (tpp_buf_hdr_t *) ((char *) buf - sizeof(tpp_buf_hdr_t));
+	if (tpp_atomic_dec(&hdr->h.ref_count) > 0)
+		return;
+
+	for (i = 0; i < TPP_POOL_CLASSES; i++) {
+		if (hdr->h.size == tpp_pool_sizes[i])
+			break;
+	}
+	if (i < TPP_POOL_CLASSES && (pl = tpp_get_pool()) && pl->num_bufs[i] < TPP_POOL_MAX_FREE) {
+		it = (tpp_pool_item_t *) hdr;
+		it->next = pl->bufs[i];
+		pl->bufs[i] = it;
+		pl->num_bufs[i]++;
+		return;
+	}
+	free(hdr);
+}
+
+/**
+ * @brief
+ *	Grow a buffer from tpp_buf_alloc(), keeping its contents. The buffer
+ *	must not be shared.
+ *
+ * @param[in] - buf - The buffer (NULL to allocate a new one)
+ * @param[in] - len - The new length
+ *
+ * @return The buffer, possibly moved
+ * @retval NULL - Failure (Out of memory), buf is left alone
+ *
+ * @par MT-safe: Yes
+ *
+ */
+void *
+tpp_buf_realloc(void *buf, int len)
+{
+	tpp_buf_hdr_t *hdr;
+	void *nbuf;
+
+	if (buf == NULL)
+		return tpp_buf_alloc(len);
+
+	hdr = (tpp_buf_hdr_t *) ((char *) buf - sizeof(tpp_buf_hdr_t));
+	if (len <= hdr->h.size)
+		return buf;
+
+	if ((nbuf = tpp_buf_alloc(len)) == NULL)
+		return NULL;
+	memcpy(nbuf, buf, hdr->h.size);
+	tpp_buf_free(buf);
+
+	return nbuf;
+}
+
+/**
+ * @brief
+ *	Get a packet structure from the thread's pool
+ *
+ * @return The packet structure
+ * @retval NULL - Failure (Out of memory)
+ *
+ * @par MT-safe: Yes
+ *
+ */
+static tpp_packet_t *
+tpp_alloc_pkt(void)
+{
+	tpp_pool_t *pl;
+	tpp_pool_item_t *it;
+
+	if ((pl = tpp_get_pool()) && pl->pkts) {
+		it = pl->pkts;
+		pl->pkts = it->next;
+		pl->num_pkts--;
+		return (tpp_packet_t *) it;
+	}
+	return malloc(sizeof(tpp_packet_t));
+}
+
+/**
+ * @brief
+ *	Return a packet structure to the thread's pool
+ *
+ * @param[in] - pkt - The packet structure
+ *
+ * @par MT-safe: Yes
+ *
+ */
+static void
+tpp_release_pkt(tpp_packet_t *pkt)
+{
+	tpp_pool_t *pl;
+	tpp_pool_item_t *it;
+
+	if ((pl = tpp_get_pool()) && pl->num_pkts < TPP_POOL_MAX_FREE) {
+		it = (tpp_pool_item_t *) pkt;
+		it->next = pl->pkts;
+		pl->pkts = it;
+		pl->num_pkts++;
+		return;
+	}
+	free(pkt);
+}
+
 /**
  * @brief
  *	Create a packet structure from the inputs provided
@@ -113,26 +379,22 @@ tpp_cr_pkt(void *data, int len, int mk_data)
 {
 	tpp_packet_t *pkt;
 
-	if ((pkt = malloc(sizeof(tpp_packet_t))) == NULL) {
+	if ((pkt = tpp_alloc_pkt()) == NULL) {
 		tpp_log_func(LOG_CRIT, __func__, "Out of memory allocating packet");
 		return NULL;
 	}
-	if (mk_data == 0)
+	if (mk_data == 0) {
 		pkt->data = data;
-	else {
-#ifdef DEBUG
-		/* use calloc() to satisfy valgrind in debug mode */
-		pkt->data = calloc(len, 1);
-#else
-		/* use malloc() in non-debug mode for performance */
-		pkt->data = malloc(len);
-#endif
+		pkt->pooled = 0;
+	} else {
+		pkt->data = tpp_buf_alloc(len);
 		if (!pkt->data) {
-			free(pkt);
+			tpp_release_pkt(pkt);
 			snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "Out of memory allocating packet data of %d bytes", len);
 			tpp_log_func(LOG_CRIT, __func__, tpp_get_logbuf());
 			return NULL;
 		}
+		pkt->pooled = 1;
 		if (data)
 			memcpy(pkt->data, data, len);
 	}
@@ -140,6 +402,46 @@ tpp_cr_pkt(void *data, int len, int mk_data)
 	pkt->extra_data = NULL;
 	pkt->len = len;
 	pkt->ref_count = 1;
+	pkt->rtime = 0;
+
+	return pkt;
+}
+
+/**
+ * @brief
+ *	Create a packet which shares the data buffer of another packet.
+ *	Each packet has its own send position, so the two can be queued on
+ *	different connections. Neither must modify the shared data.
+ *
+ * @param[in] - opkt - The packet whose data is to be shared. Its data
+ *		       must come from tpp_cr_pkt() with mk_data set.
+ *
+ * @return Newly allocated packet structure
+ * @retval NULL - Failure (Out of memory, or data cannot be shared)
+ *
+ * @par MT-safe: Yes
+ *
+ */
+tpp_packet_t *
+tpp_share_pkt(tpp_packet_t *opkt)
+{
+	tpp_packet_t *pkt;
+
+	if (opkt == NULL || opkt->pooled == 0)
+		return NULL;
+
+	if ((pkt = tpp_alloc_pkt()) == NULL) {
+		tpp_log_func(LOG_CRIT, __func__, "Out of memory allocating packet");
+		return NULL;
+	}
+	tpp_atomic_inc(&((tpp_buf_hdr_t *) (opkt->data - sizeof(tpp_buf_hdr_t)))->h.ref_count);
+	pkt->data = opkt->data;
+	pkt->pooled = 1;
+	pkt->pos = pkt->data;
+	pkt->extra_data = NULL;
+	pkt->len = opkt->len;
+	pkt->ref_count = 1;
+	pkt->rtime = opkt->rtime;
 
 	return pkt;
 }
@@ -163,11 +465,15 @@ tpp_free_pkt(tpp_packet_t *pkt)
 		pkt->ref_count--;
 
 		if (pkt->ref_count <= 0) {
-			if (pkt->data)
-				free(pkt->data);
+			if (pkt->data) {
+				if (pkt->pooled)
+					tpp_buf_free(pkt->data);
+				else
+					free(pkt->data);
+			}
 			if (pkt->extra_data)
 				free(pkt->extra_data);
-			free(pkt);
+			tpp_release_pkt(pkt);
 		}
 	}
 }
@@ -1356,6 +1662,124 @@ tpp_inflate(void *inbuf, unsigned int inlen, unsigned int totlen)
 }
 #endif
 
+/*
+ * LZ4 compressed data carries a small magic prefix so that the receiver can
+ * tell it apart from a zlib stream (whose first byte always has 8 in its low
+ * nibble) without any change to the data packet header.
+ */
+#define TPP_LZ4_MAGIC		"LZ4"
+#define TPP_LZ4_MAGIC_LEN	4
+
+/**
+ * @brief Compress data using the given codec
+ *
+ * @param[in] codec   - TPP_COMPR_ZLIB or TPP_COMPR_LZ4
+ * @param[in] inbuf   - Ptr to buffer to compress
+ * @param[in] inlen   - The size of input buffer
+ * @param[out] outlen - The size of the compressed data
+ *
+ * @return      - Ptr to the compressed data buffer
+ * @retval  !NULL - Success
+ * @retval   NULL - Failure
+ *
+ * @par MT-safe: Yes
+ **/
+void *
+tpp_compress(int codec, void *inbuf, unsigned int inlen, unsigned int *outlen)
+{
+#ifdef PBS_COMPRESSION_LZ4
+	char *data;
+	void *p;
+	int bound;
+	int filled;
+
+	if (codec != TPP_COMPR_LZ4)
+		return tpp_deflate(inbuf, inlen, outlen);
+
+	*outlen = 0;
+	bound = LZ4_compressBound(inlen);
+	if (bound <= 0) {
+		tpp_log_func(LOG_CRIT, __func__, "Compression failed, input too large");
+		return NULL;
+	}
+
+	data = malloc(bound + TPP_LZ4_MAGIC_LEN);
+	if (!data) {
+		snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "Out of memory allocating compress buffer %d bytes", bound);
+		tpp_log_func(LOG_CRIT, __func__, tpp_get_logbuf());
+		return NULL;
+	}
+	memcpy(data, TPP_LZ4_MAGIC, TPP_LZ4_MAGIC_LEN);
+
+	filled = LZ4_compress_default(inbuf, data + TPP_LZ4_MAGIC_LEN, inlen, bound);
+	if (filled <= 0) {
+		free(data);
+		tpp_log_func(LOG_CRIT, __func__, "Compression (LZ4) failed");
+		return NULL;
+	}
+	filled += TPP_LZ4_MAGIC_LEN;
+
+	/* reduce the memory area occupied */
+	if ((p = realloc(data, filled)))
+		data = p;
+
+	*outlen = filled;
+	return data;
+#else
+	return tpp_deflate(inbuf, inlen, outlen);
+#endif
+}
+
+/**
+ * @brief Decompress data compressed by tpp_compress
+ *
+ * @par Functionality:
+ *	The codec is detected from the data itself, so data compressed by
+ *	either codec can be received regardless of the local setting.
+ *
+ * @param[in] inbuf  - Ptr to compress data buffer
+ * @param[in] inlen  - The size of input buffer
+ * @param[in] totlen - The total size of the uncompress data
+ *
+ * @return      - Ptr to the uncompressed data buffer
+ * @retval  !NULL - Success
+ * @retval   NULL - Failure
+ *
+ * @par MT-safe: Yes
+ **/
+void *
+tpp_decompress(void *inbuf, unsigned int inlen, unsigned int totlen)
+{
+	if (inlen < TPP_LZ4_MAGIC_LEN || memcmp(inbuf, TPP_LZ4_MAGIC, TPP_LZ4_MAGIC_LEN) != 0)
+		return tpp_inflate(inbuf, inlen, totlen);
+
+#ifdef PBS_COMPRESSION_LZ4
+	{
+		char *outbuf;
+		int ret;
+
+		outbuf = malloc(totlen);
+		if (!outbuf) {
+			snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "Out of memory allocating decompress buffer %u bytes", totlen);
+			tpp_log_func(LOG_CRIT, __func__, tpp_get_logbuf());
+			return NULL;
+		}
+		ret = LZ4_decompress_safe((char *) inbuf + TPP_LZ4_MAGIC_LEN, outbuf,
+			inlen - TPP_LZ4_MAGIC_LEN, totlen);
+		if (ret < 0 || (unsigned int) ret != totlen) {
+			free(outbuf);
+			snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ, "Decompression (LZ4) failed, ret = %d", ret);
+			tpp_log_func(LOG_CRIT, __func__, tpp_get_logbuf());
+			return NULL;
+		}
+		return outbuf;
+	}
+#else
+	tpp_log_func(LOG_CRIT, __func__, "Received LZ4 compressed data, but TPP built without LZ4 support");
+	return NULL;
+#endif
+}
+
 /**
  * @brief Convenience function to validate a tpp header
  *
@@ -1381,7 +1805,7 @@ tpp_validate_hdr(int tfd, char *pkt_start)
 	type = *((unsigned char *) data);
 
 	if ((data_len < 0 || type >= TPP_LAST_MSG) ||
-		(data_len > TPP_SEND_SIZE && type != TPP_DATA && type != TPP_MCAST_DATA)) {
+		(data_len > TPP_SEND_SIZE && type != TPP_DATA && type != TPP_MCAST_DATA && type != TPP_DATA_BATCH)) {
 		snprintf(tpp_get_logbuf(), TPP_LOGBUF_SZ,
 				 "tfd=%d, Received invalid packet type with type=%d? data_len=%d", tfd, type, data_len);
 		tpp_log_func(LOG_CRIT, __func__, tpp_get_logbuf());
@@ -1390,6 +1814,58 @@ tpp_validate_hdr(int tfd, char *pkt_start)
 	return 0;
 }
 
+/**
+ * @brief
+ *	Add a latency sample to a histogram
+ *
+ * @param[in] hist - The histogram to update
+ * @param[in] usec - The sample, in microseconds
+ *
+ * @par MT-safe: No, each histogram must have a single writer
+ *
+ **/
+void
+tpp_hist_add(tpp_hist_t *hist, long long usec)
+{
+	int i = 0;
+
+	if (usec < 0)
+		usec = 0; /* clock stepped back */
+
+	while (i < TPP_HIST_BUCKETS - 1 && usec >= (1LL << i))
+		i++;
+
+	hist->bucket[i]++;
+	hist->count++;
+	hist->total += usec;
+	if ((unsigned long long) usec > hist->max)
+		hist->max = usec;
+}
+
+/**
+ * @brief
+ *	Print a histogram as a named JSON object, for example
+ *	"name":{"count":3,"total":12,"max":8,"buckets":[0,1,...]}
+ *
+ * @param[in] fp   - The stream to print to
+ * @param[in] name - The name of the object
+ * @param[in] hist - The histogram to print
+ *
+ * @par MT-safe: No
+ *
+ **/
+void
+tpp_hist_print(FILE *fp, char *name, tpp_hist_t *hist)
+{
+	int i;
+
+	fprintf(fp, "\"%s\":{\"count\":%llu,\"total\":%llu,\"max\":%llu,\"buckets\":[",
+		name, hist->count, hist->total, hist->max);
+	for (i = 0; i < TPP_HIST_BUCKETS; i++)
+		fprintf(fp, "%s%llu", i == 0 ? "" : ",", hist->bucket[i]);
+	fprintf(fp, "]}");
+}
+
 /**
  * @brief Get a list of addresses for a given hostname
  *
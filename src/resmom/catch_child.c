@@ -97,6 +97,7 @@ extern pbs_list_head	svr_alljobs;
 extern int		exiting_tasks;
 extern char		*msg_daemonname;
 extern int		svr_hook_resend_job_attrs;
+extern int		svr_rused_resync;
 #ifdef	WIN32
 extern char		*mom_home;
 #endif
@@ -107,6 +108,7 @@ extern int		resc_access_perm;
 extern int		server_stream;
 extern time_t		time_now;
 extern pbs_list_head	mom_polljobs;
+extern pbs_list_head	mom_exitjobs;
 extern unsigned int	pbs_mom_port;
 #if MOM_ALPS
 extern useconds_t	alps_release_wait_time;
@@ -1099,6 +1101,10 @@ update_ajob_status_using_cmd(job *pjob, int cmd, int use_rtn_list_ext)
 		/* now append resources used */
 
 		encode_used(pjob, &rused.ru_attr);
+
+		/* the next periodic update must not be a delta on top of */
+		/* values older than the ones sent here		  */
+		free_attrlist(&pjob->ji_rused_sent);
 	}
 
 	/* now send info to server via rpp */
@@ -1128,6 +1134,75 @@ update_ajob_status(job *pjob)
 	update_ajob_status_using_cmd(pjob, IS_RESCUSED, 0);
 }
 
+/**
+ * @brief
+ * 	rused_delta - reduce the session id and resources_used entries in
+ *	'phead' to those that changed since the last periodic update
+ *
+ * @par
+ *	The full list becomes the job's new ji_rused_sent.  Everything is kept
+ *	if the job's run version changed or a resync was requested, as after
+ *	a new server stream was opened.  The server merges resources_used
+ *	entries into the job's existing value, so omitted entries keep their
+ *	last sent value.
+ *
+ * @param[in,out] pjob - job the update is for
+ * @param[in,out] phead - full list on input, the changed entries on output
+ * @param[in] hop - run version of the update
+ *
+ * @return Void
+ *
+ */
+static void
+rused_delta(job *pjob, pbs_list_head *phead, long hop)
+{
+	svrattrl	*pal;
+	svrattrl	*pnext;
+	svrattrl	*psent;
+	svrattrl	*pcursor;
+	pbs_list_head	 changed;
+
+	if (svr_rused_resync || (pjob->ji_rused_hop != hop))
+		free_attrlist(&pjob->ji_rused_sent);
+	pjob->ji_rused_hop = hop;
+
+	CLEAR_HEAD(changed);
+	pcursor = (svrattrl *)GET_NEXT(pjob->ji_rused_sent);
+	for (pal = (svrattrl *)GET_NEXT(*phead); pal != NULL; pal = pnext) {
+		pnext = (svrattrl *)GET_NEXT(pal->al_link);
+
+		/* entries come in the same order each time, try the next one first */
+		psent = pcursor;
+		if ((psent == NULL) || (strcmp(psent->al_name, pal->al_name) != 0) ||
+			(strcmp(psent->al_resc ? psent->al_resc : "",
+				pal->al_resc ? pal->al_resc : "") != 0)) {
+			for (psent = (svrattrl *)GET_NEXT(pjob->ji_rused_sent);
+				psent != NULL;
+				psent = (svrattrl *)GET_NEXT(psent->al_link)) {
+				if ((strcmp(psent->al_name, pal->al_name) == 0) &&
+					(strcmp(psent->al_resc ? psent->al_resc : "",
+					pal->al_resc ? pal->al_resc : "") == 0))
+					break;
+			}
+		}
+		if (psent != NULL)
+			pcursor = (svrattrl *)GET_NEXT(psent->al_link);
+
+		if ((psent != NULL) &&
+			(strcmp(psent->al_value ? psent->al_value : "",
+				pal->al_value ? pal->al_value : "") == 0))
+			continue;	/* unchanged, not sent */
+
+		(void)add_to_svrattrl_list(&changed, pal->al_name,
+			pal->al_resc, pal->al_value, pal->al_op, NULL);
+	}
+
+	/* the full list is what the server now has */
+	free_attrlist(&pjob->ji_rused_sent);
+	list_move(phead, &pjob->ji_rused_sent);
+	list_move(&changed, phead);
+}
+
 /**
  * @brief
  * 	update_jobs_status - return the status of jobs to the server
@@ -1154,6 +1229,8 @@ update_jobs_status(void)
 
 	resc_access_perm = ATR_DFLAG_MGRD;
 	prusednext = &prusedtop;
+	if (server_stream < 0)
+		return;		/* nothing could be sent, resync when reconnected */
 
 	for (pjob = (job *)GET_NEXT(svr_alljobs);
 		pjob; pjob = (job *)GET_NEXT(pjob->ji_alljobs)) {
@@ -1163,7 +1240,6 @@ update_jobs_status(void)
 		if (pjob->ji_qs.ji_substate != JOB_SUBSTATE_RUNNING)
 			continue;
 
-		++count;
 		/* allocate reply structure and fill in header portion */
 		prused = (struct resc_used_update *)
 			malloc(sizeof(struct resc_used_update));
@@ -1177,17 +1253,17 @@ update_jobs_status(void)
 			prused->ru_hop    = pjob->ji_wattr[(int)JOB_ATR_runcount].at_val.at_long;
 		}
 		CLEAR_HEAD(prused->ru_attr);
-		*prusednext	  = prused;	/* make last on list */
 		prused->ru_next   = NULL;	/* terminate list */
-		prusednext	  = &prused->ru_next;	/* track last link */
 
-		/* now append the session id and resources used */
+		/* now append the session id and resources used, */
+		/* and keep only what changed since the last update */
 		(void)job_attr_def[(int)JOB_ATR_session_id].at_encode(
 			&pjob->ji_wattr[(int)JOB_ATR_session_id],
 			&prused->ru_attr,
 			job_attr_def[(int)JOB_ATR_session_id].at_name,
 			NULL, ATR_ENCODE_CLIENT, NULL);
 		encode_used(pjob, &prused->ru_attr);
+		rused_delta(pjob, &prused->ru_attr, prused->ru_hop);
 
 		if (svr_hook_resend_job_attrs != 0) {
 			int		 index;
@@ -1213,6 +1289,14 @@ update_jobs_status(void)
 			}
 
 		}
+
+		if (GET_NEXT(prused->ru_attr) == NULL) {
+			free(prused);	/* nothing changed, job not sent */
+			continue;
+		}
+		++count;
+		*prusednext	  = prused;	/* make last on list */
+		prusednext	  = &prused->ru_next;	/* track last link */
 	}
 
 	/* now send info to server via rpp */
@@ -1233,6 +1317,7 @@ update_jobs_status(void)
 	}
 
 	svr_hook_resend_job_attrs = 0;	/* clear the send hooked flag */
+	svr_rused_resync = 0;
 }
 
 /**
@@ -1391,12 +1476,36 @@ send_obit(job *pjob, int exval)
 	}
 }
 
+/**
+ * @brief
+ *	Queue a job for scan_for_exiting() and flag that there is exit
+ *	work to do.  Used wherever a task of the job has EXITED or the
+ *	job has been put into the EXITING substate.
+ *
+ * @param[in] pjob - job to look at in the next scan
+ *
+ * @return Void
+ *
+ */
+void
+mom_exiting_job(job *pjob)
+{
+	/* a cleared link points at itself */
+	if (pjob->ji_exitlink.ll_next == &pjob->ji_exitlink)
+		append_link(&mom_exitjobs, &pjob->ji_exitlink, pjob);
+	exiting_tasks = 1;
+}
+
 /**
  * @brief
  * 	Look for job tasks that have terminated (see scan_for_terminating),
  *	and for each task, find which job the task was part, and if the top
  *	shell, start end of job processing by running the epilogue.
  *
+ *	Only the jobs queued on mom_exitjobs by mom_exiting_job() are
+ *	examined, so the cost follows the number of jobs with exit work
+ *	rather than the number of jobs on the node.
+ *
  * @return Void
  *
  */
@@ -1417,6 +1526,7 @@ scan_for_exiting(void)
 	pbs_task		*ptask;
 	obitent			*pobit;
 	char			*cookie;
+	pbs_list_head		scanq;
 	u_long	gettime(resource *pres);
 	u_long	getsize(resource *pres);
 	int	im_compose(int, char *, char *, int, tm_event_t, tm_task_id, int);
@@ -1434,19 +1544,30 @@ scan_for_exiting(void)
 	}
 #endif
 
+	/*
+	 ** Take the queued jobs.  Jobs queued again while these are
+	 ** handled wait for the next pass.
+	 */
+	CLEAR_HEAD(scanq);
+	list_move(&mom_exitjobs, &scanq);
+	exiting_tasks = 0;
+
 	/*
 	 ** Look through the jobs.  Each one has it's tasks examined
 	 ** and if the job is EXITING, it meets it's fate depending
 	 ** on whether this is the Mother Superior or not.
 	 */
-	for (pjob = (job *)GET_NEXT(svr_alljobs); pjob; pjob = nxjob) {
-		nxjob = (job *)GET_NEXT(pjob->ji_alljobs);
+	for (pjob = (job *)GET_NEXT(scanq); pjob; pjob = nxjob) {
+		nxjob = (job *)GET_NEXT(pjob->ji_exitlink);
+		delete_link(&pjob->ji_exitlink);
 
 		/*
 		 ** If a restart is active, skip this job since
 		 ** not all of the tasks may have started yet.
+		 ** Leave it queued for a later pass.
 		 */
 		if (pjob->ji_flags & MOM_RESTART_ACTIVE) {
+			append_link(&mom_exitjobs, &pjob->ji_exitlink, pjob);
 			continue;
 		}
 		/*
@@ -1456,6 +1577,7 @@ scan_for_exiting(void)
 		 */
 		if ((pjob->ji_flags & MOM_CHKPT_ACTIVE) &&
 			(pjob->ji_mompost != NULL)) {
+			append_link(&mom_exitjobs, &pjob->ji_exitlink, pjob);
 			continue;
 		}
 		/*
@@ -1612,13 +1734,13 @@ end_loop:
 			 ** to the negative of itself.
 			 */
 			if (ptask->ti_qs.ti_sid <= 1) {
-				ptask->ti_qs.ti_sid = 0;
+				task_set_sid(ptask, 0);
 #ifdef	_SX
 				ptask->ti_qs.ti_u.ti_ext.ti_jid = 0;
 #endif
 			}
 			else
-				ptask->ti_qs.ti_sid = -ptask->ti_qs.ti_sid;
+				task_set_sid(ptask, -ptask->ti_qs.ti_sid);
 			task_save(ptask);
 		}
 
@@ -1855,8 +1977,11 @@ end_loop:
 			} else {
 				break;	/* five at a time is our limit */
 			}
-		} else if (cpid < 0)
-			continue;	/* curses, foiled again */
+		} else if (cpid < 0) {
+			/* curses, foiled again; try it in the next pass */
+			mom_exiting_job(pjob);
+			continue;
+		}
 
 		/* child: change to the user's home directory or PBS_JOBDIR */
 		/* and run the epilogue script				    */
@@ -1901,8 +2026,14 @@ end_loop:
 #endif	/* WIN32/UNIX */
 
 	}
-	if (pjob == NULL)
-		exiting_tasks = 0;	/* went through all jobs */
+	if (GET_NEXT(scanq) != NULL) {
+		/* hit the epilogue limit, the rest go in the next pass */
+		while ((pjob = (job *)GET_NEXT(scanq)) != NULL) {
+			delete_link(&pjob->ji_exitlink);
+			append_link(&mom_exitjobs, &pjob->ji_exitlink, pjob);
+		}
+		exiting_tasks = 1;
+	}
 }
 
 /**
@@ -2141,8 +2272,11 @@ init_abort_jobs(int recover)
 		pj->ji_grpcache = NULL;
 		check_pwd(pj);
 		append_link(&svr_alljobs, &pj->ji_alljobs, pj);
+		mom_avljob_oper(pj, 0);
 		job_nodes(pj);
 		task_recov(pj);
+		/* recovered tasks may already be EXITED, look at it next scan */
+		mom_exiting_job(pj);
 
 		/*
 		 ** Check to see if a checkpoint.old dir exists.
@@ -2254,7 +2388,7 @@ init_abort_jobs(int recover)
 
 			pj->ji_qs.ji_substate = JOB_SUBSTATE_EXITING;
 			job_save(pj, SAVEJOB_QUICK);
-			exiting_tasks = 1;
+			mom_exiting_job(pj);
 		} else if (recover == 2) {
 			pbs_task	*ptask;
 
@@ -393,7 +393,7 @@ cput_sum(job *pjob)
 			if (pjob->ji_qs.ji_un.ji_momt.ji_exitstat >= 0)
 				pjob->ji_qs.ji_un.ji_momt.ji_exitstat = 0;
 			task_save(ptask);
-			exiting_tasks = 1;
+			mom_exiting_job(pjob);
 		}
 	}
 
@@ -260,7 +260,7 @@ void scan_for_terminated()
 		log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_JOB, LOG_DEBUG,
 			pjob->ji_qs.ji_jobid, log_buffer);
 
-		exiting_tasks = 1;
+		mom_exiting_job(pjob);
 	}
 }
 
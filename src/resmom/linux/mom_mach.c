@@ -68,6 +68,11 @@
 #include <sys/wait.h>
 #include <syscall.h>
 #include <signal.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/netlink.h>
+#include <linux/connector.h>
+#include <linux/cn_proc.h>
 
 #include "pbs_error.h"
 #include "portability.h"
@@ -85,6 +90,9 @@
 #include "pbs_ifl.h"
 #include "placementsets.h"
 #include "mom_vnode.h"
+#include "avltree.h"
+#include "net_connect.h"
+#include "task_starter.h"
 #ifndef NAS /* localmod 113 */
 #include "hwloc.h"
 #endif /* localmod 113 */
@@ -164,6 +172,8 @@ extern	int			reqnum;
 extern	double	cputfactor;
 extern	double	wallfactor;
 extern  pid_t	mom_pid;
+extern	int	cgroup_accounting;
+extern	int	proc_connector;
 extern	int	num_acpus;
 extern	int	num_pcpus;
 extern	int	num_oscpus;
@@ -5133,7 +5143,7 @@ cput_sum(job *pjob)
 			ps = &proc_info[i];
 
 			/* is this process part of the task? */
-			if (ptask->ti_qs.ti_sid != ps->session)
+			if (ptask->ti_qs.ti_sid != ps->tsid)
 				continue;
 
 			nps++;
@@ -5228,7 +5238,7 @@ cput_sum(job *pjob)
 				log_buffer);
 			ptask->ti_qs.ti_status = TI_STATE_EXITED;
 			task_save(ptask);
-			exiting_tasks = 1;
+			mom_exiting_job(pjob);
 		}
 	}
 
@@ -5282,7 +5292,7 @@ mem_sum(job *pjob)
 
 		ps = &proc_info[i];
 
-		if (!injob(pjob, ps->session))
+		if (!injob(pjob, ps->tsid))
 			continue;
 		segadd += ps->vsize;
 		DBPRT(("%s: pid: %d  pr_size: %lu  total: %lu\n",
@@ -5316,7 +5326,7 @@ resi_sum(job *pjob)
 
 		ps = &proc_info[i];
 
-		if (!injob(pjob, ps->session))
+		if (!injob(pjob, ps->tsid))
 			continue;
 
 		/*
@@ -5335,6 +5345,506 @@ resi_sum(job *pjob)
 	return (resisize);
 }
 
+/*
+ * Job cgroup accounting ($cgroup_accounting).
+ *
+ * When a job's processes have been placed in a cgroup of their own
+ * (as the cgroups hook does), cpu time and memory usage are read from
+ * that cgroup instead of being summed over the /proc snapshot.  This
+ * is a few file reads per job and also counts processes which have
+ * left the job's sessions.  Both cgroup v1 (cpuacct, memory) and v2
+ * (unified) hierarchies are understood.
+ */
+struct cgacct {
+	int	ca_cpu_v2;		/* ca_cpu is a cgroup v2 directory */
+	int	ca_mem_v2;		/* ca_mem is a cgroup v2 directory */
+	char	ca_cpu[MAXPATHLEN+1];	/* cgroup with cpu usage, "" if none */
+	char	ca_mem[MAXPATHLEN+1];	/* cgroup with memory usage, "" if none */
+};
+
+#define	CGACCT_RESI	0x1	/* cgacct_mem() found resident memory */
+#define	CGACCT_VMEM	0x2	/* cgacct_mem() found memory + swap */
+
+static int	cg_init = 0;
+static char	cg_v1_cpu[MAXPATHLEN+1];	/* cpuacct hierarchy mount */
+static char	cg_v1_mem[MAXPATHLEN+1];	/* memory hierarchy mount */
+static char	cg_v2[MAXPATHLEN+1];		/* unified hierarchy mount */
+static char	cg_my_cpu[MAXPATHLEN+1];	/* MoM's own cgroups */
+static char	cg_my_mem[MAXPATHLEN+1];
+static char	cg_my_v2[MAXPATHLEN+1];
+
+/**
+ * @brief
+ *	Return true if the comma separated controller list has ctl.
+ *
+ * @param[in] list - controller list from /proc/<pid>/cgroup
+ * @param[in] ctl - controller name
+ *
+ * @return	int
+ * @retval	1	found
+ * @retval	0	not found
+ */
+static int
+cg_has_ctl(const char *list, const char *ctl)
+{
+	size_t	len = strlen(ctl);
+
+	while (*list != '\0') {
+		if ((strncmp(list, ctl, len) == 0) &&
+			((list[len] == ',') || (list[len] == '\0')))
+			return 1;
+		if ((list = strchr(list, ',')) == NULL)
+			break;
+		list++;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *	Read the cgroups of a process from /proc/<pid>/cgroup.
+ *
+ * @param[in]  pid - process id
+ * @param[out] cpu - v1 cpuacct cgroup, "" if none
+ * @param[out] mem - v1 memory cgroup, "" if none
+ * @param[out] v2 - v2 cgroup, "" if none
+ *
+ * @note	All output buffers are MAXPATHLEN+1 bytes.
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	could not read the file
+ */
+static int
+cg_proc_paths(pid_t pid, char *cpu, char *mem, char *v2)
+{
+	char	fname[64];
+	char	line[MAXPATHLEN+128];
+	char	*ctl, *path, *nl;
+	FILE	*fp;
+
+	cpu[0] = mem[0] = v2[0] = '\0';
+	if (pid == 0)
+		strcpy(fname, "/proc/self/cgroup");
+	else
+		sprintf(fname, "/proc/%d/cgroup", (int)pid);
+	if ((fp = fopen(fname, "r")) == NULL)
+		return -1;
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if ((ctl = strchr(line, ':')) == NULL)
+			continue;
+		ctl++;
+		if ((path = strchr(ctl, ':')) == NULL)
+			continue;
+		*path++ = '\0';
+		if ((nl = strchr(path, '\n')) != NULL)
+			*nl = '\0';
+		if (*ctl == '\0') {
+			snprintf(v2, MAXPATHLEN+1, "%s", path);
+			continue;
+		}
+		if (cg_has_ctl(ctl, "cpuacct"))
+			snprintf(cpu, MAXPATHLEN+1, "%s", path);
+		if (cg_has_ctl(ctl, "memory"))
+			snprintf(mem, MAXPATHLEN+1, "%s", path);
+	}
+	fclose(fp);
+	return 0;
+}
+
+/**
+ * @brief
+ *	Find the cgroup mount points and MoM's own cgroups, once.
+ *
+ * @return	void
+ */
+static void
+cg_setup(void)
+{
+	FILE		*fp;
+	struct mntent	*me;
+
+	if (cg_init)
+		return;
+	cg_init = 1;
+
+	if ((fp = setmntent("/proc/mounts", "r")) == NULL)
+		return;
+	while ((me = getmntent(fp)) != NULL) {
+		if (strcmp(me->mnt_type, "cgroup2") == 0) {
+			if (cg_v2[0] == '\0')
+				snprintf(cg_v2, sizeof(cg_v2), "%s",
+					me->mnt_dir);
+		} else if (strcmp(me->mnt_type, "cgroup") == 0) {
+			if ((cg_v1_cpu[0] == '\0') &&
+				(hasmntopt(me, "cpuacct") != NULL))
+				snprintf(cg_v1_cpu, sizeof(cg_v1_cpu), "%s",
+					me->mnt_dir);
+			if ((cg_v1_mem[0] == '\0') &&
+				(hasmntopt(me, "memory") != NULL))
+				snprintf(cg_v1_mem, sizeof(cg_v1_mem), "%s",
+					me->mnt_dir);
+		}
+	}
+	endmntent(fp);
+
+	(void)cg_proc_paths(0, cg_my_cpu, cg_my_mem, cg_my_v2);
+	log_eventf(PBSEVENT_DEBUG3, 0, LOG_DEBUG, __func__,
+		"cgroup mounts: cpuacct=%s memory=%s unified=%s",
+		cg_v1_cpu, cg_v1_mem, cg_v2);
+}
+
+/**
+ * @brief
+ *	Decide whether a cgroup of a job process is the job's own cgroup:
+ *	it must differ from MoM's cgroup (the process was moved) and its
+ *	last component must carry the job sequence number.
+ *
+ * @param[in] path - cgroup path of the job process
+ * @param[in] mine - same hierarchy cgroup path of MoM
+ * @param[in] seq - job sequence number
+ *
+ * @return	int
+ * @retval	1	job cgroup
+ * @retval	0	not a job cgroup
+ */
+static int
+cg_is_job(const char *path, const char *mine, const char *seq)
+{
+	const char	*last, *hit;
+	size_t		len = strlen(seq);
+
+	if ((path[0] == '\0') || (len == 0) || (strcmp(path, mine) == 0))
+		return 0;
+	if ((last = strrchr(path, '/')) == NULL)
+		last = path;
+	for (hit = strstr(last, seq); hit != NULL; hit = strstr(hit + 1, seq)) {
+		if (((hit == last) || !isdigit((int)hit[-1])) &&
+			!isdigit((int)hit[len]))
+			return 1;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *	Put a cgroup path under its hierarchy mount point.
+ *
+ * @param[out] buf - MAXPATHLEN+1 buffer for the result
+ * @param[in] mnt - mount point
+ * @param[in] path - cgroup path, as read from /proc/<pid>/cgroup
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	result too long, buf is left empty
+ */
+static int
+cg_join(char *buf, const char *mnt, const char *path)
+{
+	size_t	len = strlen(mnt);
+
+	buf[0] = '\0';
+	if (len + strlen(path) > MAXPATHLEN)
+		return -1;
+	strcpy(buf, mnt);
+	strcpy(buf + len, path);
+	return 0;
+}
+
+/**
+ * @brief
+ *	Get the cgroup accounting data of a job, locating the job's
+ *	cgroups from a running task the first time they can be found.
+ *
+ * @param[in] pjob - job pointer
+ *
+ * @return	struct cgacct *
+ * @retval	NULL	job has no cgroup of its own (yet)
+ */
+static struct cgacct *
+cgacct_get(job *pjob)
+{
+	struct cgacct	*ca;
+	task		*ptask;
+	pid_t		sid = 0;
+	char		seq[PBS_MAXSEQNUM+1];
+	char		cpu[MAXPATHLEN+1];
+	char		mem[MAXPATHLEN+1];
+	char		v2[MAXPATHLEN+1];
+	size_t		len;
+
+	if (pjob->ji_cgacct != NULL)
+		return ((struct cgacct *)pjob->ji_cgacct);
+
+	for (ptask = (task *)GET_NEXT(pjob->ji_tasks);
+		ptask != NULL;
+		ptask = (task *)GET_NEXT(ptask->ti_jobtask)) {
+		if ((ptask->ti_qs.ti_sid > 1) &&
+			(ptask->ti_qs.ti_status == TI_STATE_RUNNING)) {
+			sid = ptask->ti_qs.ti_sid;
+			break;
+		}
+	}
+	if (sid == 0)
+		return NULL;
+
+	cg_setup();
+	if (cg_proc_paths(sid, cpu, mem, v2) == -1)
+		return NULL;
+
+	len = strspn(pjob->ji_qs.ji_jobid, "0123456789");
+	if (len > PBS_MAXSEQNUM)
+		len = PBS_MAXSEQNUM;
+	strncpy(seq, pjob->ji_qs.ji_jobid, len);
+	seq[len] = '\0';
+
+	if ((ca = (struct cgacct *)calloc(1, sizeof(struct cgacct))) == NULL)
+		return NULL;
+	if ((cg_v1_cpu[0] != '\0') && cg_is_job(cpu, cg_my_cpu, seq)) {
+		(void)cg_join(ca->ca_cpu, cg_v1_cpu, cpu);
+	} else if ((cg_v2[0] != '\0') && cg_is_job(v2, cg_my_v2, seq)) {
+		if (cg_join(ca->ca_cpu, cg_v2, v2) == 0)
+			ca->ca_cpu_v2 = 1;
+	}
+	if ((cg_v1_mem[0] != '\0') && cg_is_job(mem, cg_my_mem, seq)) {
+		(void)cg_join(ca->ca_mem, cg_v1_mem, mem);
+	} else if ((cg_v2[0] != '\0') && cg_is_job(v2, cg_my_v2, seq)) {
+		if (cg_join(ca->ca_mem, cg_v2, v2) == 0)
+			ca->ca_mem_v2 = 1;
+	}
+	if ((ca->ca_cpu[0] == '\0') && (ca->ca_mem[0] == '\0')) {
+		free(ca);
+		return NULL;
+	}
+
+	log_eventf(PBSEVENT_DEBUG3, PBS_EVENTCLASS_JOB, LOG_DEBUG,
+		pjob->ji_qs.ji_jobid, "cgroup accounting: cpu=%s mem=%s",
+		ca->ca_cpu, ca->ca_mem);
+	pjob->ji_cgacct = ca;
+	return ca;
+}
+
+/**
+ * @brief
+ *	Read an unsigned value from a cgroup file.  With a key, the file
+ *	is taken to hold "key value" lines (e.g. cpu.stat).
+ *
+ * @param[in]  dir - cgroup directory
+ * @param[in]  file - file in dir
+ * @param[in]  key - key to look for, or NULL for the first value
+ * @param[out] val - value read
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	not readable or not found
+ */
+static int
+cg_read_val(const char *dir, const char *file, const char *key,
+	unsigned long long *val)
+{
+	char	path[MAXPATHLEN+1];
+	char	line[256];
+	FILE	*fp;
+	size_t	klen;
+	int	rc = -1;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, file);
+	if ((fp = fopen(path, "r")) == NULL)
+		return -1;
+	if (key == NULL) {
+		if (fscanf(fp, "%llu", val) == 1)
+			rc = 0;
+	} else {
+		klen = strlen(key);
+		while (fgets(line, sizeof(line), fp) != NULL) {
+			if ((strncmp(line, key, klen) == 0) &&
+				(line[klen] == ' ') &&
+				(sscanf(line + klen, "%llu", val) == 1)) {
+				rc = 0;
+				break;
+			}
+		}
+	}
+	fclose(fp);
+	return rc;
+}
+
+/**
+ * @brief
+ *	cpu time used by the job's cgroup.
+ *
+ * @param[in]  ca - job cgroup accounting data
+ * @param[out] cput - cpu time in seconds, not adjusted by cputfactor
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	not available
+ */
+static int
+cgacct_cput(struct cgacct *ca, ulong *cput)
+{
+	unsigned long long	val;
+
+	if (ca->ca_cpu[0] == '\0')
+		return -1;
+	if (ca->ca_cpu_v2) {
+		if (cg_read_val(ca->ca_cpu, "cpu.stat", "usage_usec", &val))
+			return -1;
+		*cput = (ulong)(val / 1000000ULL);
+	} else {
+		if (cg_read_val(ca->ca_cpu, "cpuacct.usage", NULL, &val))
+			return -1;
+		*cput = (ulong)(val / 1000000000ULL);
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *	Memory high water marks of the job's cgroup.  vmem is reported as
+ *	memory plus swap, the same way the cgroups hook reports it.
+ *
+ * @param[in]  ca - job cgroup accounting data
+ * @param[out] resi - resident memory in bytes
+ * @param[out] vmem - memory plus swap in bytes
+ *
+ * @return	int
+ * @retval	mask of CGACCT_RESI and CGACCT_VMEM for the values set
+ */
+static int
+cgacct_mem(struct cgacct *ca, u_Long *resi, u_Long *vmem)
+{
+	unsigned long long	mem, swap;
+	int			found = 0;
+
+	if (ca->ca_mem[0] == '\0')
+		return 0;
+	if (ca->ca_mem_v2) {
+		if ((cg_read_val(ca->ca_mem, "memory.peak", NULL, &mem) == 0) ||
+			(cg_read_val(ca->ca_mem, "memory.current", NULL,
+			&mem) == 0)) {
+			*resi = mem;
+			found |= CGACCT_RESI;
+			if ((cg_read_val(ca->ca_mem, "memory.swap.peak", NULL,
+				&swap) == 0) ||
+				(cg_read_val(ca->ca_mem, "memory.swap.current",
+				NULL, &swap) == 0)) {
+				*vmem = mem + swap;
+				found |= CGACCT_VMEM;
+			}
+		}
+	} else {
+		if (cg_read_val(ca->ca_mem, "memory.max_usage_in_bytes", NULL,
+			&mem) == 0) {
+			*resi = mem;
+			found |= CGACCT_RESI;
+		}
+		if (cg_read_val(ca->ca_mem, "memory.memsw.max_usage_in_bytes",
+			NULL, &swap) == 0) {
+			*vmem = swap;
+			found |= CGACCT_VMEM;
+		}
+	}
+	return found;
+}
+
+/*
+ * The limits mom_set_limits() sets on the processes of a task, from the
+ * job's resources and the node's mem and vmem limits.  The sizes are in
+ * bytes, cput in seconds, and 0 means no limit.
+ */
+typedef struct task_limits {
+	ulong	tl_file;
+	ulong	tl_vmem;
+	ulong	tl_mem;
+	ulong	tl_cput;
+	int	tl_setfile;	/* tl_file is set, may be 0 */
+	int	tl_nice;	/* nice() increment, 0 for none */
+} task_limits_t;
+
+/**
+ * @brief
+ *	Work out the limits to set on the processes of a job's task.
+ *
+ * @param[in]  pjob     - job pointer
+ * @param[in]  set_mode - SET_LIMIT_SET or SET_LIMIT_ALTER, file and nice
+ *			  are only looked at for SET_LIMIT_SET
+ * @param[out] ptl      - the limits
+ *
+ * @return	int
+ * @retval	PBSE_NONE	Success
+ * @retval	PBSE_*		Error, a message was printed on standard error
+ *
+ */
+static int
+get_task_limits(job *pjob, int set_mode, task_limits_t *ptl)
+{
+	char		*pname;
+	int		retval;
+	ulong		value;	/* place in which to build resource value */
+	resource	*pres;
+
+	assert(pjob != NULL);
+	assert(pjob->ji_wattr[(int)JOB_ATR_resource].at_type == ATR_TYPE_RESC);
+	pres = (resource *)
+		GET_NEXT(pjob->ji_wattr[(int)JOB_ATR_resource].at_val.at_list);
+
+	memset(ptl, 0, sizeof(*ptl));
+
+	/* mem and vmem limits come from the local node limits, not the job */
+	ptl->tl_mem = pjob->ji_hosts[pjob->ji_nodeid].hn_nrlimit.rl_mem << 10;
+	ptl->tl_vmem = pjob->ji_hosts[pjob->ji_nodeid].hn_nrlimit.rl_vmem << 10;
+
+	/*
+	 * Cycle through all the resource specifications,
+	 * checking the values and keeping the lesser of each limit.
+	 */
+	while (pres != NULL) {
+		assert(pres->rs_defin != NULL);
+		pname = pres->rs_defin->rs_name;
+		assert(pname != NULL);
+		assert(*pname != '\0');
+
+		if (strcmp(pname, "cput") == 0 ||
+			strcmp(pname, "pcput") == 0) {
+			retval = local_gettime(pres, &value);
+			if (retval != PBSE_NONE)
+				return (error(pname, retval));
+			if ((ptl->tl_cput == 0) || (value < ptl->tl_cput))
+				ptl->tl_cput = value;
+		} else if (strcmp(pname, "pvmem") == 0) {
+			retval = local_getsize(pres, &value);
+			if (retval != PBSE_NONE)
+				return (error(pname, retval));
+			if ((ptl->tl_vmem == 0) || (value < ptl->tl_vmem))
+				ptl->tl_vmem = value;
+		} else if (strcmp(pname, "pmem") == 0) {	/* set */
+			retval = local_getsize(pres, &value);
+			if (retval != PBSE_NONE)
+				return (error(pname, retval));
+			if ((ptl->tl_mem == 0) || (value < ptl->tl_mem))
+				ptl->tl_mem = value;
+		} else if (strcmp(pname, "walltime") == 0) {	/* Check */
+			retval = local_gettime(pres, &value);
+			if (retval != PBSE_NONE)
+				return (error(pname, retval));
+		} else if (strcmp(pname, "nice") == 0) {	/* set nice */
+			if (set_mode == SET_LIMIT_SET)
+				ptl->tl_nice = (int)pres->rs_value.at_val.at_long;
+		} else if (strcmp(pname, "file") == 0) {	/* set */
+			if (set_mode == SET_LIMIT_SET) {
+				retval = local_getsize(pres, &value);
+				if (retval != PBSE_NONE)
+					return (error(pname, retval));
+				ptl->tl_file = value;
+				ptl->tl_setfile = 1;
+			}
+		}
+		pres = (resource *)GET_NEXT(pres->rs_link);
+	}
+	return (PBSE_NONE);
+}
+
 /**
  * @brief
  * 	Establish system-enforced limits for the job.
@@ -5356,204 +5866,734 @@ resi_sum(job *pjob)
  *	    2.	The child is still running as root.
  *	    3.  Standard error is open to the user's file.
  *
- *	If set_mode is SET_LIMIT_ALTER, we are beening called to modify
- *	existing limits.  Cannot alter those set by setrlimit (kernel)
- *	because we are the wrong process.
+ *	If set_mode is SET_LIMIT_ALTER, we are beening called to modify
+ *	existing limits.  Cannot alter those set by setrlimit (kernel)
+ *	because we are the wrong process.
+ *
+ * @return	int
+ * @retval	PBSE_NONE	Success
+ * @retval	PBSE_*		Error
+ *
+ */
+int
+mom_set_limits(job *pjob, int set_mode)
+{
+	int		retval;
+	struct rlimit	reslim;
+	task_limits_t	tl;
+
+	DBPRT(("%s: entered\n", __func__))
+	if ((retval = get_task_limits(pjob, set_mode, &tl)) != PBSE_NONE)
+		return (retval);
+	if (set_mode != SET_LIMIT_SET)
+		return (PBSE_NONE);
+
+	if (tl.tl_nice != 0) {
+		errno = 0;
+		if ((nice(tl.tl_nice) == -1) && (errno != 0))
+			return (error("nice", PBSE_BADATVAL));
+	}
+
+	if (tl.tl_setfile) {
+		reslim.rlim_cur = reslim.rlim_max = tl.tl_file;
+		if (setrlimit(RLIMIT_FSIZE, &reslim) < 0)
+			return (error("file", PBSE_SYSTEM));
+	}
+
+	/* if either vmem or pvmem was given, set sys limit to lesser */
+	if (tl.tl_vmem != 0) {
+		reslim.rlim_cur = reslim.rlim_max = tl.tl_vmem;
+		if (setrlimit(RLIMIT_AS, &reslim) < 0)
+			return (error("RLIMIT_AS", PBSE_SYSTEM));
+	}
+
+	/* if either mem or pmem was given, set sys limit to lesser */
+	if (tl.tl_mem != 0) {
+		reslim.rlim_cur = reslim.rlim_max = tl.tl_mem;
+		if (setrlimit(RLIMIT_RSS, &reslim) < 0)
+			return (error("RLIMIT_RSS", PBSE_SYSTEM));
+	}
+
+	/* if either cput or pcput was given, set sys limit to lesser */
+	if (tl.tl_cput != 0) {
+		reslim.rlim_cur = reslim.rlim_max =
+			(ulong)((double)tl.tl_cput / cputfactor);
+		if (setrlimit(RLIMIT_CPU, &reslim) < 0)
+			return (error("RLIMIT_CPU", PBSE_SYSTEM));
+	}
+	return (PBSE_NONE);
+}
+
+/**
+ * @brief
+ *	Put the limits mom_set_limits() would set for a task into a request
+ *	for pbs_task_starter, which sets them in the task.
+ *
+ * @param[in]  pjob - job pointer
+ * @param[out] treq - request to fill in
+ *
+ * @return	int
+ * @retval	PBSE_NONE	Success
+ * @retval	PBSE_*		Error
+ *
+ */
+int
+mom_task_limits(job *pjob, ts_request_t *treq)
+{
+	int		retval;
+	int		n = 0;
+	task_limits_t	tl;
+
+	if ((retval = get_task_limits(pjob, SET_LIMIT_SET, &tl)) != PBSE_NONE)
+		return (retval);
+
+	treq->tr_nice = tl.tl_nice;
+	if (tl.tl_setfile) {
+		treq->tr_limits[n].tl_resource = RLIMIT_FSIZE;
+		treq->tr_limits[n++].tl_value = tl.tl_file;
+	}
+	if (tl.tl_vmem != 0) {
+		treq->tr_limits[n].tl_resource = RLIMIT_AS;
+		treq->tr_limits[n++].tl_value = tl.tl_vmem;
+	}
+	if (tl.tl_mem != 0) {
+		treq->tr_limits[n].tl_resource = RLIMIT_RSS;
+		treq->tr_limits[n++].tl_value = tl.tl_mem;
+	}
+	if (tl.tl_cput != 0) {
+		treq->tr_limits[n].tl_resource = RLIMIT_CPU;
+		treq->tr_limits[n++].tl_value =
+			(ulong)((double)tl.tl_cput / cputfactor);
+	}
+	treq->tr_nlimits = n;
+	return (PBSE_NONE);
+}
+
+/**
+ * @brief
+ * 	State whether MOM main loop has to poll this job to determine if some
+ * 	limits are being exceeded.
+ *
+ * @param[in] pjob - job pointer
+ *
+ * @return	int
+ * @retval	TRUE	if polling is necessary
+ * @retval	FALSE 	otherwise.
+ *
+ * NOTE: Actual polling is done using the mom_over_limit machine-dependent function.
+ *
+ */
+int
+mom_do_poll(job *pjob)
+{
+	char		*pname;
+	resource	*pres;
+
+	DBPRT(("%s: entered\n", __func__))
+	assert(pjob != NULL);
+	assert(pjob->ji_wattr[(int)JOB_ATR_resource].at_type == ATR_TYPE_RESC);
+	pres = (resource *)
+		GET_NEXT(pjob->ji_wattr[(int)JOB_ATR_resource].at_val.at_list);
+
+	while (pres != NULL) {
+		assert(pres->rs_defin != NULL);
+		pname = pres->rs_defin->rs_name;
+		assert(pname != NULL);
+		assert(*pname != '\0');
+
+		if (strcmp(pname, "walltime") == 0 ||
+			strcmp(pname, "cput") == 0 ||
+			strcmp(pname, "mem") == 0 ||
+			strcmp(pname, "vmem") == 0 ||
+			strcmp(pname, "ncpus") == 0)
+			return (TRUE);
+		pres = (resource *)GET_NEXT(pres->rs_link);
+	}
+
+	return (FALSE);
+}
+
+/**
+ * @brief
+ * 	Setup for polling.
+ *	Open kernel device and get namelist info.
+ *
+ * @return	int
+ * @retval	PBSE_NONE		Success
+ * @retval	PBSE_SYSTEM		Error
+ *
+ */
+int
+mom_open_poll(void)
+{
+	DBPRT(("%s: entered\n", __func__))
+	pagesize = getpagesize();
+	proc_info = (proc_stat_t *)malloc(sizeof(proc_stat_t) * TBL_INC);
+	if (proc_info == NULL) {
+		log_err(errno, __func__, "malloc");
+		return (PBSE_SYSTEM);
+	}
+	max_proc = TBL_INC;
+
+	return (PBSE_NONE);
+}
+
+/*
+ * Process events connector ($proc_connector).
+ *
+ * When enabled, MoM subscribes to the kernel fork and exit events and keeps
+ * pc_pids, a table of the live processes that belong to a task, keyed by
+ * pid with the session id of the owning task as data.  A child is added
+ * when its parent is in the table or is a task session leader, so a
+ * process that calls setsid() or is reparented to init stays with its
+ * task.  The periodic sample then reads only the pids in the table.  A
+ * full scan of /proc is still done for resource monitor queries, when a
+ * new task has started and after events were lost; the full scan
+ * rebuilds the table.
+ */
+static int		pc_fd = -1;		/* connector socket */
+static int		pc_lost = 1;		/* events may have been missed */
+static int		pc_failed = 0;		/* could not open, don't retry */
+static AVL_IX_DESC	*pc_pids = NULL;	/* pid -> task session id */
+static int		sample_full = 0;	/* last sample read all of /proc */
+
+/**
+ * @brief
+ *	Return the task session id recorded for a process, 0 if the
+ *	process is not in the table.
+ *
+ * @param[in] pid - process id
+ *
+ * @return	pid_t
+ */
+static pid_t
+pc_lookup(pid_t pid)
+{
+	if (pc_pids == NULL)
+		return 0;
+	return ((pid_t)(long)find_tree(pc_pids, &pid));
+}
+
+/**
+ * @brief
+ *	Record that a process belongs to the task with session id sid.
+ *
+ * @param[in] pid - process id
+ * @param[in] sid - session id of the owning task
+ *
+ * @return	int
+ * @retval	1	pid was not in the table before
+ * @retval	0	pid was already recorded or could not be added
+ */
+static int
+pc_track(pid_t pid, pid_t sid)
+{
+	pid_t	old;
+
+	if (pc_pids == NULL)
+		return 0;
+	if ((old = pc_lookup(pid)) == sid)
+		return 0;
+	if (old != 0)
+		(void)tree_add_del(pc_pids, &pid, NULL, TREE_OP_DEL);
+	if (tree_add_del(pc_pids, &pid, (void *)(long)sid, TREE_OP_ADD) != 0) {
+		pc_lost = 1;
+		return 0;
+	}
+	return (old == 0);
+}
+
+/**
+ * @brief
+ *	Remove a process from the table.
+ *
+ * @param[in] pid - process id
+ *
+ * @return	void
+ */
+static void
+pc_forget(pid_t pid)
+{
+	if (pc_pids != NULL)
+		(void)tree_add_del(pc_pids, &pid, NULL, TREE_OP_DEL);
+}
+
+/**
+ * @brief
+ *	Free the process table.
+ *
+ * @return	void
+ */
+static void
+pc_destroy(AVL_IX_DESC *pix)
+{
+	if (pix != NULL) {
+		avl_destroy_index(pix);
+		free(pix);
+	}
+}
+
+/**
+ * @brief
+ *	Stop listening for process events.
+ *
+ * @return	void
+ */
+static void
+procconn_close(void)
+{
+	if (pc_fd >= 0) {
+		close_conn(pc_fd);
+		pc_fd = -1;
+	}
+	pc_destroy(pc_pids);
+	pc_pids = NULL;
+	pc_lost = 1;
+}
+
+/**
+ * @brief
+ *	Read the pending process events from the connector socket and
+ *	update the process table.  Called from wait_request().
+ *
+ * @param[in] fd - connector socket
+ *
+ * @return	void
+ */
+static void
+procconn_read(int fd)
+{
+	union {
+		struct nlmsghdr	nl_hdr;
+		char		buf[8192];
+	} u;
+	struct sockaddr_nl	from;
+	socklen_t		fromlen;
+	struct nlmsghdr		*nlh;
+	struct cn_msg		*cn;
+	struct proc_event	*ev;
+	ssize_t			len;
+	pid_t			sid;
+
+	for (;;) {
+		fromlen = sizeof(from);
+		len = recvfrom(fd, &u, sizeof(u), 0,
+			(struct sockaddr *)&from, &fromlen);
+		if (len == -1) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return;
+			if (errno == ENOBUFS) {
+				/* socket overran, events were dropped */
+				pc_lost = 1;
+				continue;
+			}
+			log_err(errno, __func__, "recvfrom");
+			procconn_close();
+			pc_failed = 1;
+			return;
+		}
+		if (len == 0)
+			return;
+		if (from.nl_pid != 0)		/* only trust the kernel */
+			continue;
+
+		for (nlh = &u.nl_hdr; NLMSG_OK(nlh, len);
+			nlh = NLMSG_NEXT(nlh, len)) {
+			if (nlh->nlmsg_type == NLMSG_NOOP)
+				continue;
+			if (nlh->nlmsg_type == NLMSG_ERROR ||
+				nlh->nlmsg_type == NLMSG_OVERRUN) {
+				pc_lost = 1;
+				continue;
+			}
+			cn = NLMSG_DATA(nlh);
+			if (cn->id.idx != CN_IDX_PROC ||
+				cn->id.val != CN_VAL_PROC)
+				continue;
+			ev = (struct proc_event *)cn->data;
+
+			switch (ev->what) {
+				case PROC_EVENT_FORK:
+					/* threads share their process' entry */
+					if (ev->event_data.fork.child_pid !=
+						ev->event_data.fork.child_tgid)
+						break;
+					sid = pc_lookup(
+						ev->event_data.fork.parent_tgid);
+					if (sid == 0 && find_session(
+						ev->event_data.fork.parent_tgid) != NULL)
+						sid = ev->event_data.fork.parent_tgid;
+					if (sid != 0)
+						(void)pc_track(
+							ev->event_data.fork.child_tgid,
+							sid);
+					break;
+
+				case PROC_EVENT_EXIT:
+					/* a task's leader stays until the task ends */
+					if (ev->event_data.exit.process_pid ==
+						ev->event_data.exit.process_tgid &&
+						find_session(ev->event_data.exit.process_pid) == NULL)
+						pc_forget(ev->event_data.exit.process_pid);
+					break;
+
+				default:
+					break;
+			}
+		}
+	}
+}
+
+/**
+ * @brief
+ *	Open the process events connector and add it to the connections
+ *	served by wait_request().
+ *
+ * @return	int
+ * @retval	0	Success
+ * @retval	-1	Error, the connector is not used
+ */
+static int
+procconn_open(void)
+{
+	struct sockaddr_nl	sa;
+	struct {
+		struct nlmsghdr		nl_hdr;
+		struct cn_msg		cn;
+		enum proc_cn_mcast_op	op;
+	} __attribute__((packed)) req;
+	int			fd;
+	int			bufsize = 1024 * 1024;
+
+	if ((fd = socket(PF_NETLINK, SOCK_DGRAM, NETLINK_CONNECTOR)) == -1) {
+		log_err(errno, __func__, "socket");
+		return -1;
+	}
+	if ((fcntl(fd, F_SETFL, O_NONBLOCK) == -1) ||
+		(fcntl(fd, F_SETFD, FD_CLOEXEC) == -1)) {
+		log_err(errno, __func__, "fcntl");
+		close(fd);
+		return -1;
+	}
+	(void)setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufsize, sizeof(bufsize));
+
+	memset(&sa, 0, sizeof(sa));
+	sa.nl_family = AF_NETLINK;
+	sa.nl_groups = CN_IDX_PROC;
+	sa.nl_pid = getpid();
+	if (bind(fd, (struct sockaddr *)&sa, sizeof(sa)) == -1) {
+		log_err(errno, __func__, "bind");
+		close(fd);
+		return -1;
+	}
+
+	memset(&req, 0, sizeof(req));
+	req.nl_hdr.nlmsg_len = sizeof(req);
+	req.nl_hdr.nlmsg_type = NLMSG_DONE;
+	req.nl_hdr.nlmsg_pid = getpid();
+	req.cn.id.idx = CN_IDX_PROC;
+	req.cn.id.val = CN_VAL_PROC;
+	req.cn.len = sizeof(enum proc_cn_mcast_op);
+	req.op = PROC_CN_MCAST_LISTEN;
+	if (send(fd, &req, sizeof(req), 0) == -1) {
+		log_err(errno, __func__, "send");
+		close(fd);
+		return -1;
+	}
+
+	if ((pc_pids = create_tree(AVL_NO_DUP_KEYS, sizeof(pid_t))) == NULL) {
+		log_err(errno, __func__, "create_tree");
+		close(fd);
+		return -1;
+	}
+	if (add_conn(fd, ChildPipe, (pbs_net_t)0, 0, procconn_read) == NULL) {
+		log_err(-1, __func__, "add_conn");
+		pc_destroy(pc_pids);
+		pc_pids = NULL;
+		close(fd);
+		return -1;
+	}
+	pc_fd = fd;
+	pc_lost = 1;
+	log_event(PBSEVENT_SYSTEM, 0, LOG_INFO, __func__,
+		"listening for process events");
+	return 0;
+}
+
+/**
+ * @brief
+ *	Open or close the connector to follow the $proc_connector setting.
+ *
+ * @return	void
+ */
+static void
+procconn_setup(void)
+{
+	if (!proc_connector) {
+		if (pc_fd >= 0)
+			procconn_close();
+		pc_failed = 0;
+		return;
+	}
+	if (pc_fd < 0 && !pc_failed && procconn_open() == -1)
+		pc_failed = 1;
+}
+
+/**
+ * @brief
+ *	Set the session id of the task a sampled process belongs to.  A
+ *	process outside any task session that the connector saw being
+ *	forked from a task keeps that task's session id.
  *
- * @return	int
- * @retval	PBSE_NONE	Success
- * @retval	PBSE_*		Error
+ * @param[in,out] ps - process entry
  *
+ * @return	void
  */
-int
-mom_set_limits(job *pjob, int set_mode)
+static void
+pc_set_tsid(proc_stat_t *ps)
 {
-	char		*pname;
-	int		retval;
-	ulong		value;	/* place in which to build resource value */
-	resource	*pres;
-	struct rlimit	reslim;
-	ulong		mem_limit = 0;
-	ulong		vmem_limit = 0;
-	ulong		cput_limit = 0;
-
-	DBPRT(("%s: entered\n", __func__))
-	assert(pjob != NULL);
-	assert(pjob->ji_wattr[(int)JOB_ATR_resource].at_type == ATR_TYPE_RESC);
-	pres = (resource *)
-		GET_NEXT(pjob->ji_wattr[(int)JOB_ATR_resource].at_val.at_list);
-
-	/*
-	 * Cycle through all the resource specifications,
-	 * setting limits appropriately.
-	 */
+	pid_t	sid;
 
-	/* mem and vmem limits come from the local node limits, not the job */
-	mem_limit = pjob->ji_hosts[pjob->ji_nodeid].hn_nrlimit.rl_mem << 10;
-	vmem_limit = pjob->ji_hosts[pjob->ji_nodeid].hn_nrlimit.rl_vmem << 10;
+	ps->tsid = ps->session;
+	if (pc_pids == NULL || find_session(ps->session) != NULL)
+		return;
+	if ((sid = pc_lookup(ps->pid)) != 0 && find_session(sid) != NULL)
+		ps->tsid = sid;
+}
 
-	while (pres != NULL) {
-		assert(pres->rs_defin != NULL);
-		pname = pres->rs_defin->rs_name;
-		assert(pname != NULL);
-		assert(*pname != '\0');
+/**
+ * @brief
+ *	Replace the process table with the processes of the full sample
+ *	just taken that belong to a live task.
+ *
+ * @return	void
+ */
+static void
+pc_rebuild(void)
+{
+	AVL_IX_DESC	*old = pc_pids;
+	int		i;
 
-		if (strcmp(pname, "cput") == 0 ||
-			strcmp(pname, "pcput") == 0) {
-			retval = local_gettime(pres, &value);
-			if (retval != PBSE_NONE)
-				return (error(pname, retval));
-			if ((cput_limit == 0) || (value < cput_limit))
-				cput_limit = value;
-		} else if (strcmp(pname, "pvmem") == 0) {
-			retval = local_getsize(pres, &value);
-			if (retval != PBSE_NONE)
-				return (error(pname, retval));
-			if ((vmem_limit == 0) || (value < vmem_limit))
-				vmem_limit = value;
-		} else if (strcmp(pname, "pmem") == 0) {	/* set */
-			retval = local_getsize(pres, &value);
-			if (retval != PBSE_NONE)
-				return (error(pname, retval));
-			if ((mem_limit == 0) || (value < mem_limit))
-				mem_limit = value;
-		} else if (strcmp(pname, "walltime") == 0) {	/* Check */
-			retval = local_gettime(pres, &value);
-			if (retval != PBSE_NONE)
-				return (error(pname, retval));
-		} else if (strcmp(pname, "nice") == 0) {	/* set nice */
-			if (set_mode == SET_LIMIT_SET) {
-				errno = 0;
-				if ((nice((int)pres->rs_value.at_val.at_long) == -1)
-					&& (errno != 0))
-					return (error(pname, PBSE_BADATVAL));
-			}
-		} else if (strcmp(pname, "file") == 0) {	/* set */
-			if (set_mode == SET_LIMIT_SET) {
-				retval = local_getsize(pres, &value);
-				if (retval != PBSE_NONE)
-					return (error(pname, retval));
-				reslim.rlim_cur = reslim.rlim_max = value;
-				if (setrlimit(RLIMIT_FSIZE, &reslim) < 0)
-					return (error(pname, PBSE_SYSTEM));
-			}
-		}
-		pres = (resource *)GET_NEXT(pres->rs_link);
+	if ((pc_pids = create_tree(AVL_NO_DUP_KEYS, sizeof(pid_t))) == NULL) {
+		pc_pids = old;
+		return;
 	}
+	pc_lost = 0;
+	for (i = 0; i < nproc; i++) {
+		proc_stat_t	*ps = &proc_info[i];
 
-	if (set_mode == SET_LIMIT_SET) {
-		/* if either vmem or pvmem was given, set sys limit to lesser */
-		if (vmem_limit != 0) {
-			reslim.rlim_cur = reslim.rlim_max = vmem_limit;
-			if (setrlimit(RLIMIT_AS, &reslim) < 0)
-				return (error("RLIMIT_AS", PBSE_SYSTEM));
-		}
-
-		/* if either mem or pmem was given, set sys limit to lesser */
-		if (mem_limit != 0) {
-			reslim.rlim_cur = reslim.rlim_max = mem_limit;
-			if (setrlimit(RLIMIT_RSS, &reslim) < 0)
-				return (error("RLIMIT_RSS", PBSE_SYSTEM));
-		}
-
-		/* if either cput or pcput was given, set sys limit to lesser */
-		if (cput_limit != 0) {
-			reslim.rlim_cur = reslim.rlim_max =
-				(ulong)((double)cput_limit / cputfactor);
-			if (setrlimit(RLIMIT_CPU, &reslim) < 0)
-				return (error("RLIMIT_CPU", PBSE_SYSTEM));
-		}
+		if (find_session(ps->tsid) != NULL)
+			(void)pc_track(ps->pid, ps->tsid);
 	}
-	return (PBSE_NONE);
+	pc_destroy(old);
 }
 
 /**
  * @brief
- * 	State whether MOM main loop has to poll this job to determine if some
- * 	limits are being exceeded.
+ *	Read /proc/<dname>/stat into a process entry.
  *
- * @param[in] pjob - job pointer
+ * @param[in]	dname - name of the process directory in /proc
+ * @param[in]	nomem - don't count the memory of the process (.pid thread)
+ * @param[in]	stat_str - format of the stat file
+ * @param[out]	ps - process entry
  *
  * @return	int
- * @retval	TRUE	if polling is necessary
- * @retval	FALSE 	otherwise.
- *
- * NOTE: Actual polling is done using the mom_over_limit machine-dependent function.
- *
+ * @retval	0	Success
+ * @retval	-1	the stat file could not be read
  */
-int
-mom_do_poll(job *pjob)
+static int
+proc_stat_read(char *dname, int nomem, char *stat_str, proc_stat_t *ps)
 {
-	char		*pname;
-	resource	*pres;
+	FILE			*fd = NULL;
+	static char		path[MAXPATHLEN + 1];
+	char			procname[384]; /* space for dent->d_name plus extra */
+	struct stat		sb;
+	unsigned long long 	starttime;
 
-	DBPRT(("%s: entered\n", __func__))
-	assert(pjob != NULL);
-	assert(pjob->ji_wattr[(int)JOB_ATR_resource].at_type == ATR_TYPE_RESC);
-	pres = (resource *)
-		GET_NEXT(pjob->ji_wattr[(int)JOB_ATR_resource].at_val.at_list);
+	sprintf(procname, "/proc/%s/stat", dname);
 
-	while (pres != NULL) {
-		assert(pres->rs_defin != NULL);
-		pname = pres->rs_defin->rs_name;
-		assert(pname != NULL);
-		assert(*pname != '\0');
+	if ((fd = fopen(procname, "r")) == NULL)
+		return -1;
 
-		if (strcmp(pname, "walltime") == 0 ||
-			strcmp(pname, "cput") == 0 ||
-			strcmp(pname, "mem") == 0 ||
-			strcmp(pname, "vmem") == 0 ||
-			strcmp(pname, "ncpus") == 0)
-			return (TRUE);
-		pres = (resource *)GET_NEXT(pres->rs_link);
+	if (fscanf(fd, stat_str,
+		   &ps->pid,		/* "%d "	1  pid %d The process id */
+		   path,		/* "(%[^)]) "	2  comm %s The filename of the executable */
+		   &ps->state,		/* "%c "	3  state %c "RSDZTW" */
+		   &ps->ppid,		/* "%d "	4  ppid %d The PID of the parent */
+		   &ps->pgrp,		/* "%d "	5  pgrp %d The process group ID */
+		   &ps->session,	/* "%d "	6  session %d The session ID */
+			   		/* "%*d "	7  ignored:  tty_nr */
+ 		   			/* "%*d "	8  ignored:  tpgid */
+		   &ps->flags,		/* "%u or %lu"	9  flags */
+				   	/* "%*lu "	10 ignored:  minflt */
+				   	/* "%*lu "	11 ignored:  cminflt */
+				   	/* "%*lu "	12 ignored:  majflt */
+				   	/* "%*lu "	13 ignored:  cmajflt */
+		   &ps->utime,		/* "%lu "	14 utime %lu */
+		   &ps->stime,		/* "%lu "	15 stime %lu */
+		   &ps->cutime,		/* "%ld "	16 cutime %ld */
+		   &ps->cstime,		/* "%ld "	17 cstime %ld */
+			   		/* "%*ld "	18 ignored:  priority %ld */
+		   			/* "%*ld "	19 ignored:  nice %ld */
+		   			/* "%*ld "	20 ignored:  num_threads %ld */
+		   			/* "%*ld "	21 ignored:  itrealvalue %ld - no longer maintained */
+		   &starttime,		/* "%llu "	22 starttime (was %lu before Linux 2.6 - see proc(5) for conversion details */
+		   &ps->vsize,		/* "%lu "	23 vsize (bytes) */
+		   &ps->rss		/* "%ld "	24 rss (number of pages) */
+		) != 14) {
+		fclose(fd);
+		return -1;
 	}
 
-	return (FALSE);
+	if (fstat(fileno(fd), &sb) == -1) {
+		fclose(fd);
+		return -1;
+	}
+	ps->uid = sb.st_uid;
+	fclose(fd);
+
+	/*
+	 ** A .pid thread shows the memory of the process
+	 ** but we only want to count it once.
+	 */
+	if (nomem) {
+		ps->vsize = 0;
+		ps->rss = 0;
+	}
+
+	ps->start_time = linux_time + (starttime / hz);
+	snprintf(ps->comm, sizeof(ps->comm), "%.*s",
+		(int)(sizeof(ps->comm) - 1), path);
+
+	ps->utime = JTOS(ps->utime);
+	ps->stime = JTOS(ps->stime);
+	ps->cutime = JTOS(ps->cutime);
+	ps->cstime = JTOS(ps->cstime);
+	return 0;
 }
 
 /**
  * @brief
- * 	Setup for polling.
- *	Open kernel device and get namelist info.
+ *	Make room for one more entry in proc_info.
  *
- * @return	int
- * @retval	PBSE_NONE		Success
- * @retval	PBSE_SYSTEM		Error
+ * @return	void
+ */
+static void
+proc_info_grow(void)
+{
+	void	*hold;
+
+	if (nproc < max_proc)
+		return;
+	DBPRT(("%s: alloc more proc table space %d\n", __func__, nproc))
+	max_proc += TBL_INC;
+	hold = realloc((void *)proc_info, max_proc*sizeof(proc_stat_t));
+	assert(hold != NULL);
+	proc_info = (proc_stat_t *)hold;
+}
+
+/**
+ * @brief
+ *	Sample only the processes in the connector's process table.
  *
+ * @param[in] stat_str - format of the stat file
+ *
+ * @return	int
+ * @retval	0	Success
+ * @retval	-1	a new task has started, a full scan is needed
  */
-int
-mom_open_poll(void)
+static int
+pc_sample(char *stat_str)
 {
-	DBPRT(("%s: entered\n", __func__))
-	pagesize = getpagesize();
-	proc_info = (proc_stat_t *)malloc(sizeof(proc_stat_t) * TBL_INC);
-	if (proc_info == NULL) {
-		log_err(errno, __func__, "malloc");
-		return (PBSE_SYSTEM);
+	static pid_t	*pids = NULL;
+	static int	maxpids = 0;
+	int		npids = 0;
+	int		ngone = 0;
+	int		i;
+	int		newtask = 0;
+	job		*pjob;
+	task		*ptask;
+	AVL_IX_REC	*pe;
+	char		dname[32];
+	extern pbs_list_head	svr_alljobs;
+
+	/*
+	 * The leader of a task may have forked before MoM learned its
+	 * session id; its children are only found by a full scan.
+	 */
+	for (pjob = (job *)GET_NEXT(svr_alljobs);
+		pjob != NULL;
+		pjob = (job *)GET_NEXT(pjob->ji_alljobs)) {
+		for (ptask = (task *)GET_NEXT(pjob->ji_tasks);
+			ptask != NULL;
+			ptask = (task *)GET_NEXT(ptask->ti_jobtask)) {
+			if (ptask->ti_qs.ti_sid > 1 &&
+				ptask->ti_qs.ti_status == TI_STATE_RUNNING)
+				newtask += pc_track(ptask->ti_qs.ti_sid,
+					ptask->ti_qs.ti_sid);
+		}
 	}
-	max_proc = TBL_INC;
+	if (newtask)
+		return -1;
 
-	return (PBSE_NONE);
+	if ((pe = malloc(sizeof(AVL_IX_REC))) == NULL)
+		return -1;
+	avl_first_key(pc_pids);
+	while (avl_next_key(pe, pc_pids) == AVL_IX_OK) {
+		if (npids == maxpids) {
+			pid_t	*hold;
+
+			hold = realloc(pids, (maxpids + TBL_INC) * sizeof(pid_t));
+			if (hold == NULL) {
+				free(pe);
+				return -1;
+			}
+			pids = hold;
+			maxpids += TBL_INC;
+		}
+		memcpy(&pids[npids++], pe->key, sizeof(pid_t));
+	}
+	free(pe);
+
+	for (i = 0; i < npids; i++) {
+		proc_stat_t	*ps = &proc_info[nproc];
+
+		sprintf(dname, "%d", pids[i]);
+		if (proc_stat_read(dname, 0, stat_str, ps) == -1) {
+			/* exited without an event being seen */
+			if (find_session(pids[i]) == NULL)
+				pc_forget(pids[i]);
+			ngone++;
+			continue;
+		}
+		pc_set_tsid(ps);
+		nproc++;
+		proc_info_grow();
+	}
+
+	sprintf(log_buffer, "tracked procs:  %d, gone:  %d", npids, ngone);
+	log_event(PBSEVENT_DEBUG4, 0, LOG_DEBUG, __func__, log_buffer);
+	return 0;
 }
 
 /**
  * @brief
- * 	Declare start of polling loop.
+ * 	Read the process table.
+ *
+ * @param[in] all - read every process in /proc, not just the processes
+ *		    of the tasks tracked by the process events connector
  *
  * @return	int
  * @retval	PBSE_INTERNAL	Dir pdir in NULL
  * @retval	PBSE_NONE	Success
  *
  */
-int
-mom_get_sample(void)
+static int
+get_sample(int all)
 {
 	struct dirent		*dent = NULL;
-	FILE			*fd = NULL;
-	static char		path[MAXPATHLEN + 1];
-	char			procname[384]; /* space for dent->d_name plus extra */
-	struct stat		sb;
-	proc_stat_t		*ps = NULL;
 #if MOM_CPUSET
 	pidcachetype_t		*pidcache = NULL;
 #endif	/* MOM_CPUSET */
@@ -5561,7 +6601,6 @@ mom_get_sample(void)
 	int			ncached = 0;
 	int			ncantstat = 0;
 	int			nnomem = 0;
-	unsigned long long 	starttime;
 	int			nskipped = 0;
 	extern time_t		time_last_sample;
 	char			*stat_str = NULL;
@@ -5570,6 +6609,28 @@ mom_get_sample(void)
 	if (pdir == NULL)
 		return PBSE_INTERNAL;
 
+	stat_str = choose_procflagsfmt();
+	if (stat_str == NULL) {
+		log_err(errno, __func__, "choose_procflagsfmt allocation failed");
+		return PBSE_INTERNAL;
+	}
+	procconn_setup();
+
+	nproc = 0;
+	if (hz == 0)
+		hz = sysconf(_SC_CLK_TCK);
+	time_last_sample = time(0);
+	sampletime_floor = time_last_sample;
+
+	if (!all && pc_fd >= 0 && !pc_lost) {
+		if (pc_sample(stat_str) == 0) {
+			sampletime_ceil = time_last_sample;
+			sample_full = 0;
+			return (PBSE_NONE);
+		}
+		nproc = 0;
+	}
+
 #if MOM_CPUSET
 	if (((pidcache = pidcache_getarena()) == NULL) && pidcache_needed()) {
 		if ((pidcache = pidcache_create()) == NULL)
@@ -5581,12 +6642,6 @@ mom_get_sample(void)
 	}
 #endif /* MOM_CPUSET */
 	rewinddir(pdir);
-	nproc = 0;
-	fd = NULL;
-	if (hz == 0)
-		hz = sysconf(_SC_CLK_TCK);
-	time_last_sample = time(0);
-	sampletime_floor = time_last_sample;
 	while (errno = 0, (dent = readdir(pdir)) != NULL) {
 		int	nomem = 0;
 
@@ -5612,87 +6667,21 @@ mom_get_sample(void)
 			}
 		}
 #endif	/* MOM_CPUSET */
-		sprintf(procname, "/proc/%s/stat", dent->d_name);
-
-		if ((fd = fopen(procname, "r")) == NULL) {
+		if (proc_stat_read(dent->d_name, nomem, stat_str,
+			&proc_info[nproc]) == -1) {
 			ncantstat++;
 			continue;
 		}
-
-		ps = &proc_info[nproc];
-		stat_str = choose_procflagsfmt();
-		if (stat_str == NULL) {
-			log_err(errno, __func__, "choose_procflagsfmt allocation failed");
-			return PBSE_INTERNAL;
-		}
-		if (fscanf(fd, stat_str,
-			   &ps->pid,		/* "%d "	1  pid %d The process id */
-			   path,		/* "(%[^)]) "	2  comm %s The filename of the executable */
-			   &ps->state,		/* "%c "	3  state %c "RSDZTW" */
-			   &ps->ppid,		/* "%d "	4  ppid %d The PID of the parent */
-			   &ps->pgrp,		/* "%d "	5  pgrp %d The process group ID */
-			   &ps->session,	/* "%d "	6  session %d The session ID */
-				   		/* "%*d "	7  ignored:  tty_nr */
-	 		   			/* "%*d "	8  ignored:  tpgid */
-			   &ps->flags,		/* "%u or %lu"	9  flags */
-					   	/* "%*lu "	10 ignored:  minflt */
-					   	/* "%*lu "	11 ignored:  cminflt */
-					   	/* "%*lu "	12 ignored:  majflt */
-					   	/* "%*lu "	13 ignored:  cmajflt */
-			   &ps->utime,		/* "%lu "	14 utime %lu */
-			   &ps->stime,		/* "%lu "	15 stime %lu */
-			   &ps->cutime,		/* "%ld "	16 cutime %ld */
-			   &ps->cstime,		/* "%ld "	17 cstime %ld */
-				   		/* "%*ld "	18 ignored:  priority %ld */
-			   			/* "%*ld "	19 ignored:  nice %ld */
-			   			/* "%*ld "	20 ignored:  num_threads %ld */
-			   			/* "%*ld "	21 ignored:  itrealvalue %ld - no longer maintained */
-			   &starttime,		/* "%llu "	22 starttime (was %lu before Linux 2.6 - see proc(5) for conversion details */
-			   &ps->vsize,		/* "%lu "	23 vsize (bytes) */
-			   &ps->rss		/* "%ld "	24 rss (number of pages) */
-			) != 14) {
-			ncantstat++;
-			fclose(fd);
-			continue;
-		}
-
-		if (fstat(fileno(fd), &sb) == -1) {
-			fclose(fd);
-			continue;
-		}
-		ps->uid = sb.st_uid;
-		fclose(fd);
-
-		/*
-		 ** A .pid thread shows the memory of the process
-		 ** but we only want to count it once.
-		 */
-		if (nomem) {
-			ps->vsize = 0;
-			ps->rss = 0;
-		}
-
-		ps->start_time = linux_time + (starttime / hz);
-		snprintf(ps->comm, sizeof(ps->comm), "%.*s",
-			(int)(sizeof(ps->comm) - 1), path);
-
-		ps->utime = JTOS(ps->utime);
-		ps->stime = JTOS(ps->stime);
-		ps->cutime = JTOS(ps->cutime);
-		ps->cstime = JTOS(ps->cstime);
-		if (++nproc == max_proc) {
-			void	*hold;
-			DBPRT(("%s: alloc more proc table space %d\n", __func__, nproc))
-			max_proc += TBL_INC;
-			hold = realloc((void *)proc_info,
-				max_proc*sizeof(proc_stat_t));
-			assert(hold != NULL);
-			proc_info = (proc_stat_t *)hold;
-		}
+		pc_set_tsid(&proc_info[nproc]);
+		nproc++;
+		proc_info_grow();
 	}
 	if (errno != 0 && errno != ENOENT)
 		log_err(errno, __func__, "readdir");
 	sampletime_ceil = time_last_sample;
+	sample_full = 1;
+	if (pc_fd >= 0)
+		pc_rebuild();
 	sprintf(log_buffer,
 		"nprocs:  %d, cantstat:  %d, nomem:  %d, skipped:  %d, "
 		"cached:  %d",
@@ -5706,6 +6695,21 @@ mom_get_sample(void)
 	return (PBSE_NONE);
 }
 
+/**
+ * @brief
+ * 	Declare start of polling loop.
+ *
+ * @return	int
+ * @retval	PBSE_INTERNAL	Dir pdir in NULL
+ * @retval	PBSE_NONE	Success
+ *
+ */
+int
+mom_get_sample(void)
+{
+	return (get_sample(0));
+}
+
 /**
  * @brief
  * 	Update the resources used.<attributes> of a job.
@@ -5734,6 +6738,10 @@ mom_set_use(job *pjob)
 	u_Long 		*lp_sz, lnum_sz;
 	ulong		*lp, lnum, oldcput;
 	long		ncpus_req;
+	struct cgacct	*ca = NULL;
+	ulong		cgcput;
+	u_Long		cgresi = 0, cgvmem = 0;
+	int		cgmem = 0;
 
 	assert(pjob != NULL);
 	at = &pjob->ji_wattr[(int)JOB_ATR_resc_used];
@@ -5782,6 +6790,12 @@ mom_set_use(job *pjob)
 	lp = (ulong *)&pres->rs_value.at_val.at_long;
 	oldcput = *lp;
 	lnum = cput_sum(pjob);
+	if (cgroup_accounting && ((ca = cgacct_get(pjob)) != NULL)) {
+		/* the cgroup also holds processes that left the sessions */
+		if (cgacct_cput(ca, &cgcput) == 0)
+			lnum = MAX(lnum, (ulong)((double)cgcput * cputfactor));
+		cgmem = cgacct_mem(ca, &cgresi, &cgvmem);
+	}
 	lnum = MAX(*lp, lnum);
 	if ((pres->rs_value.at_flags & ATR_VFLAG_HOOK) == 0) {
 		/* don't conflict with hook setting a value */
@@ -5815,7 +6829,10 @@ mom_set_use(job *pjob)
 		pres->rs_value.at_val.at_size.atsv_units = ATR_SV_BYTESZ;
 	} else if ((pres->rs_value.at_flags & ATR_VFLAG_HOOK) == 0) {
 		lp_sz = &pres->rs_value.at_val.at_size.atsv_num;
-		lnum_sz = (mem_sum(pjob) + 1023) >> 10;		/* as KB */
+		if (cgmem & CGACCT_VMEM)
+			lnum_sz = (cgvmem + 1023) >> 10;	/* as KB */
+		else
+			lnum_sz = (mem_sum(pjob) + 1023) >> 10;	/* as KB */
 		*lp_sz = MAX(*lp_sz, lnum_sz);
 	}
 
@@ -5833,7 +6850,10 @@ mom_set_use(job *pjob)
 		pres->rs_value.at_val.at_size.atsv_units = ATR_SV_BYTESZ;
 	} else if ((pres->rs_value.at_flags & ATR_VFLAG_HOOK) == 0) {
 		lp_sz = &pres->rs_value.at_val.at_size.atsv_num;
-		lnum_sz = (resi_sum(pjob) + 1023) >> 10; /* as KB */
+		if (cgmem & CGACCT_RESI)
+			lnum_sz = (cgresi + 1023) >> 10;	/* as KB */
+		else
+			lnum_sz = (resi_sum(pjob) + 1023) >> 10; /* as KB */
 		*lp_sz = MAX(*lp_sz, lnum_sz);
 	}
 
@@ -6098,10 +7118,10 @@ getprocs(void)
 {
 	static unsigned int	lastproc = 0;
 
-	if (lastproc == reqnum)		/* don't need new proc table */
+	if (lastproc == reqnum && sample_full)	/* don't need new proc table */
 		return 1;
 
-	if (mom_get_sample() != PBSE_NONE)
+	if (get_sample(1) != PBSE_NONE)
 		return 0;
 
 	lastproc = reqnum;
@@ -6173,7 +7193,7 @@ cput_proc(pid_t pid)
 
 	cputime = 0.0;
 
-	mom_get_sample();
+	get_sample(1);
 	for (i=0; i<nproc; i++) {
 		ps = &proc_info[i];
 		if (ps->pid == pid)
@@ -6252,7 +7272,7 @@ mem_job(pid_t sid)
 
 	memsize = 0;
 
-	mom_get_sample();
+	get_sample(1);
 	for (i=0; i<nproc; i++) {
 
 		ps = &proc_info[i];
@@ -6289,7 +7309,7 @@ mem_proc(pid_t pid)
 	int		i;
 	proc_stat_t	*ps = NULL;
 
-	mom_get_sample();
+	get_sample(1);
 	for (i=0; i<nproc; i++) {
 		ps = &proc_info[i];
 		if (ps->pid == pid)
@@ -6368,7 +7388,7 @@ resi_job(pid_t jobid)
 	proc_stat_t	*ps;
 
 	resisize = 0;
-	mom_get_sample();
+	get_sample(1);
 
 	for (i=0; i<nproc; i++) {
 
@@ -6419,7 +7439,7 @@ resi_proc(pid_t pid)
 	proc_stat_t	*ps = NULL;
 
 
-	mom_get_sample();
+	get_sample(1);
 	for (i=0; i<nproc; i++) {
 		ps = &proc_info[i];
 		if (ps->pid == pid)
@@ -6522,7 +7542,7 @@ sessions(struct rm_attribute *attrib)
 		return NULL;
 	}
 
-	mom_get_sample();
+	get_sample(1);
 
 	/*
 	 ** Search for members of session
@@ -6637,7 +7657,7 @@ pids(struct rm_attribute *attrib)
 		return NULL;
 	}
 
-	mom_get_sample();
+	get_sample(1);
 
 	/*
 	 ** Search for members of session
@@ -6697,7 +7717,7 @@ nusers(struct rm_attribute *attrib)
 		return NULL;
 	}
 
-	mom_get_sample();
+	get_sample(1);
 	for (i=0; i<nproc; i++) {
 		ps = &proc_info[i];
 
@@ -7526,7 +8546,7 @@ walltime(struct rm_attribute *attrib)
 		rm_errno = RM_ERR_SYSTEM;
 		return NULL;
 	}
-	mom_get_sample();
+	get_sample(1);
 
 	start = now;
 	for (i=0; i<nproc; i++) {
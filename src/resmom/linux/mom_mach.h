@@ -54,7 +54,7 @@ extern "C" {
 #define	SET_LIMIT_SET   1
 #define	SET_LIMIT_ALTER 0
 #define	PBS_CHKPT_MIGRATE 0
-#define	PBS_PROC_SID(x)  proc_info[x].session
+#define	PBS_PROC_SID(x)  proc_info[x].tsid
 #define	PBS_PROC_PID(x)  proc_info[x].pid
 #define	PBS_PROC_PPID(x) proc_info[x].ppid
 #define	CLR_SJR(sjr)	memset(&sjr, 0, sizeof(sjr));
@@ -143,6 +143,8 @@ struct startjob_rtn {
 };
 
 extern int mom_set_limits(job *pjob, int);	/* Set job's limits */
+struct ts_request;
+extern int mom_task_limits(job *pjob, struct ts_request *); /* for pbs_task_starter */
 extern int mom_do_poll(job *pjob);		/* Should limits be polled? */
 extern int mom_does_chkpnt;                     /* see if mom does chkpnt */
 extern int mom_open_poll();		/* Initialize poll ability */
@@ -419,6 +421,7 @@ extern struct bgl_job 		*stuck_bgljobs;       /* "hanging" BGL jobs */
 #define	COMSIZE		12
 typedef struct proc_stat {
 	pid_t		session;	/* session id */
+	pid_t		tsid;		/* session id of the owning task */
 	char		state;		/* one of RSDZT: Running, Sleeping,
 						 Sleeping (uninterruptable), Zombie,
 						 Traced or stopped on signal */
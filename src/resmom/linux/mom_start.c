@@ -2446,7 +2446,8 @@ set_shell(job *pjob, struct passwd *pwdp)
 /**
  *
  * @brief
- * 	Checks if a child of the current (mom) process has terminated, and
+ * 	Checks if a child of the current (mom) process, or a task started by
+ *	pbs_task_starter, has terminated, and
  *	matches it with the pid of one of the tasks in the task_list_event,
  *	or matches the pid of a process being monitored for a PBS job.
  *	if matching a task in the task_list_event, then that task is
@@ -2483,7 +2484,8 @@ scan_for_terminated(void)
 
 	/* Now figure out which task(s) have terminated (are zombies) */
 
-	while ((pid = waitpid(-1, &statloc, WNOHANG)) > 0) {
+	while (((pid = waitpid(-1, &statloc, WNOHANG)) > 0) ||
+		((pid = task_starter_reaped(&statloc)) > 0)) {
 		if (WIFEXITED(statloc))
 			exiteval = WEXITSTATUS(statloc);
 		else if (WIFSIGNALED(statloc))
@@ -2504,26 +2506,19 @@ scan_for_terminated(void)
 			wtask = (struct work_task *)GET_NEXT(wtask->wt_linkall);
 		}
 
-		pjob = (job *)GET_NEXT(svr_alljobs);
-		while (pjob) {
-			/*
-			 ** see if process was a child doing a special
-			 ** function for MOM
-			 */
-			if (pid == pjob->ji_momsubt)
-				break;
-			/*
-			 ** look for task
-			 */
-			ptask = (task *)GET_NEXT(pjob->ji_tasks);
-			while (ptask) {
-				if (ptask->ti_qs.ti_sid == pid)
+		/*
+		 ** look for task via the session index, otherwise see if
+		 ** process was a child doing a special function for MOM
+		 */
+		if ((ptask = find_session(pid)) != NULL) {
+			pjob = ptask->ti_job;
+		} else {
+			pjob = (job *)GET_NEXT(svr_alljobs);
+			while (pjob) {
+				if (pid == pjob->ji_momsubt)
 					break;
-				ptask = (task *)GET_NEXT(ptask->ti_jobtask);
+				pjob = (job *)GET_NEXT(pjob->ji_alljobs);
 			}
-			if (ptask != NULL)
-				break;
-			pjob = (job *)GET_NEXT(pjob->ji_alljobs);
 		}
 
 		if (pjob == NULL) {
@@ -2572,7 +2567,7 @@ scan_for_terminated(void)
 		kill_session(ptask->ti_qs.ti_sid, SIGKILL, 0);
 		ptask->ti_qs.ti_status = TI_STATE_EXITED;
 		(void)task_save(ptask);
-		exiting_tasks = 1;
+		mom_exiting_job(pjob);
 	}
 }
 
@@ -94,6 +94,7 @@
 #include	"pbs_internal.h"
 #include	"placementsets.h"
 #include	"pbs_reliable.h"
+#include	"avltree.h"
 
 
 /* Global Data Items */
@@ -119,6 +120,16 @@ extern int
 write_pipe_data(int upfds, void *data, int data_size);
 char	task_fmt[] = "/%8.8X";
 
+/*
+ * Index of live tasks keyed by session id, so find_session() does not
+ * have to walk every task of every job for each reaped child.
+ * Maintained through task_set_sid()/task_unindex_sid(); if the tree
+ * ever fails, sess_idx_off is set and find_session() walks the lists.
+ */
+static AVL_IX_DESC	*sess_idx = NULL;
+static int		sess_idx_off = 0;
+static int		sess_idx_dups = 0;	/* sid collisions seen */
+
 
 /* Function pointers
  **
@@ -495,6 +506,108 @@ task_find(job *pjob, tm_task_id taskid)
 	return ptask;
 }
 
+/**
+ * @brief
+ *	Give up on the session index after a tree failure; find_session()
+ *	falls back to walking the job and task lists.
+ */
+static void
+sess_idx_disable(void)
+{
+	log_event(PBSEVENT_DEBUG4, PBS_EVENTCLASS_SERVER, LOG_DEBUG, __func__,
+		"AVL: session index disabled");
+	if (sess_idx != NULL) {
+		avl_destroy_index(sess_idx);
+		free(sess_idx);
+		sess_idx = NULL;
+	}
+	sess_idx_off = 1;
+}
+
+/**
+ * @brief
+ *	Remove a task from the session index if it is the task indexed
+ *	under its current session id.
+ *
+ * @param[in] ptask - task being removed or whose session id changes
+ *
+ * @return void
+ */
+void
+task_unindex_sid(pbs_task *ptask)
+{
+	pid_t		sid = ptask->ti_qs.ti_sid;
+	job		*pjob;
+	pbs_task	*pt;
+
+	if (sess_idx == NULL || sid <= 0)
+		return;
+	if (find_tree(sess_idx, &sid) != ptask)
+		return;
+	if (tree_add_del(sess_idx, &sid, NULL, TREE_OP_DEL) != 0) {
+		sess_idx_disable();
+		return;
+	}
+	if (sess_idx_dups == 0)
+		return;
+
+	/* another task may have been shadowed by this one, put it back */
+	for (pjob = (job *)GET_NEXT(svr_alljobs);
+		pjob != NULL;
+		pjob = (job *)GET_NEXT(pjob->ji_alljobs)) {
+		for (pt = (pbs_task *)GET_NEXT(pjob->ji_tasks);
+			pt != NULL;
+			pt = (pbs_task *)GET_NEXT(pt->ti_jobtask)) {
+			if (pt != ptask && pt->ti_qs.ti_sid == sid) {
+				if (tree_add_del(sess_idx, &sid, pt,
+					TREE_OP_ADD) != 0)
+					sess_idx_disable();
+				return;
+			}
+		}
+	}
+}
+
+/**
+ * @brief
+ *	Set the session id of a task and keep the session index in step.
+ *	Only positive session ids (live sessions) are indexed.
+ *
+ * @param[in] ptask - task
+ * @param[in] sid   - new session id
+ *
+ * @return void
+ */
+void
+task_set_sid(pbs_task *ptask, pid_t sid)
+{
+	pbs_task	*old;
+
+	task_unindex_sid(ptask);
+	ptask->ti_qs.ti_sid = sid;
+	if (sid <= 0 || sess_idx_off)
+		return;
+
+	if (sess_idx == NULL) {
+		sess_idx = create_tree(AVL_NO_DUP_KEYS, sizeof(pid_t));
+		if (sess_idx == NULL) {
+			sess_idx_disable();
+			return;
+		}
+	}
+	if ((old = find_tree(sess_idx, &sid)) != NULL) {
+		if (old == ptask)
+			return;
+		sess_idx_dups++;
+		if (tree_add_del(sess_idx, &sid, NULL, TREE_OP_DEL) != 0) {
+			sess_idx_disable();
+			return;
+		}
+	}
+	if (tree_add_del(sess_idx, &sid, ptask, TREE_OP_ADD) != 0)
+		sess_idx_disable();
+}
+
 /**
  * @brief
  *	find session  for task
@@ -510,6 +623,12 @@ find_session(pid_t sid)
 	job		*pjob;
 	pbs_task	*ptask;
 
+	if (!sess_idx_off && sid > 0) {
+		if (sess_idx == NULL)
+			return NULL;
+		return (pbs_task *)find_tree(sess_idx, &sid);
+	}
+
 	for (pjob = (job *)GET_NEXT(svr_alljobs);
 		pjob != NULL;
 		pjob = (job *)GET_NEXT(pjob->ji_alljobs)) {
@@ -633,6 +752,8 @@ task_recov(job *pjob)
 			continue;
 		}
 		pt->ti_qs = task_save;
+		pt->ti_qs.ti_sid = 0;
+		task_set_sid(pt, task_save.ti_sid);
 		(void)close(fds);
 
 		if (task_save.ti_sid > 0) {
@@ -674,6 +795,8 @@ task_recov(job *pjob)
 			continue;
 		}
 		pt->ti_qs = task_save;
+		pt->ti_qs.ti_sid = 0;
+		task_set_sid(pt, task_save.ti_sid);
 		(void)close(fds);
 	}
 	if (errno != 0 && errno != ENOENT) {
@@ -1987,7 +2110,7 @@ job_start_error(job *pjob, int code, char *nodename, char *cmd)
 #ifdef WIN32
 	pjob->ji_qs.ji_substate = JOB_SUBSTATE_EXITING;
 	pjob->ji_qs.ji_un.ji_momt.ji_exitstat = JOB_EXEC_RETRY;
-	exiting_tasks = 1;
+	mom_exiting_job(pjob);
 #else
 	if (code == PBSE_HOOK_REJECT_DELETEJOB)
 		exec_bail(pjob, JOB_EXEC_FAILHOOK_DELETE, NULL);
@@ -2215,7 +2338,7 @@ node_bailout(job *pjob, hnodent *np)
 					if (pjob->ji_qs.ji_substate == JOB_SUBSTATE_KILLSIS) {
 						pjob->ji_qs.ji_state    = JOB_STATE_EXITING;
 						pjob->ji_qs.ji_substate = JOB_SUBSTATE_EXITING;
-						exiting_tasks = 1;
+						mom_exiting_job(pjob);
 					}
 				}
 				break;
@@ -2456,7 +2579,7 @@ im_eof(int stream, int ret)
 			log_joberr(-1, __func__, log_buffer, pjob->ji_qs.ji_jobid);
 			kill_job(pjob, SIGKILL);
 			pjob->ji_qs.ji_substate = JOB_SUBSTATE_EXITING;
-			exiting_tasks = 1;
+			mom_exiting_job(pjob);
 		}
 	}
 }
@@ -3453,6 +3576,7 @@ im_request(int stream, int version)
 			if (mom_do_poll(pjob))
 				append_link(&mom_polljobs, &pjob->ji_jobque, pjob);
 			append_link(&svr_alljobs, &pjob->ji_alljobs, pjob);
+			mom_avljob_oper(pjob, 0);
 
 			/*
 			 ** At this point, we have done all the job setup.
@@ -3630,7 +3754,7 @@ join_err:
 			pjob->ji_qs.ji_substate = JOB_SUBSTATE_EXITING;
 			pjob->ji_qs.ji_state    = JOB_STATE_EXITING;
 			pjob->ji_obit = event;
-			exiting_tasks = 1;
+			mom_exiting_job(pjob);
 
 			mom_hook_input_init(&hook_input);
 			hook_input.pjob = pjob;
@@ -4626,7 +4750,7 @@ join_err:
 						if (pjob->ji_qs.ji_substate == JOB_SUBSTATE_KILLSIS) {
 							pjob->ji_qs.ji_state    = JOB_STATE_EXITING;
 							pjob->ji_qs.ji_substate = JOB_SUBSTATE_EXITING;
-							exiting_tasks = 1;
+							mom_exiting_job(pjob);
 						}
 					}
 					break;
@@ -5148,7 +5272,7 @@ join_err:
 					if (i == pjob->ji_numnodes) {	/* all dead */
 						if (pjob->ji_qs.ji_substate == JOB_SUBSTATE_KILLSIS) {
 							pjob->ji_qs.ji_substate = JOB_SUBSTATE_EXITING;
-							exiting_tasks = 1;
+							mom_exiting_job(pjob);
 						}
 					}
 					break;
@@ -5814,7 +5938,7 @@ tm_request(int fd, int version)
 		ptask->ti_qs.ti_parentnode = TM_ERROR_NODE;
 		ptask->ti_qs.ti_myvnode = TM_ERROR_NODE;
 		ptask->ti_qs.ti_parenttask = TM_INIT_TASK;
-		ptask->ti_qs.ti_sid = sid;
+		task_set_sid(ptask, sid);
 #ifdef WIN32
 		ptask->ti_hProc = hProcess;
 		if (pjob->ji_hJob == NULL) {
@@ -6226,6 +6350,7 @@ aterr:
 						} else if (ret == PBSE_SYSTEM) {
 							i = TM_ESYSTEM;
 							ptask->ti_qs.ti_status = TI_STATE_EXITED;
+							mom_exiting_job(pjob);
 						}
 					}
 				}
@@ -160,6 +160,7 @@ int		internal_state        = 0;
 int		internal_state_update = 0;
 int		termin_child = 0;
 int		do_debug_report = 0;
+int		do_tpp_stats = 0;	/* set on SIGUSR1 */
 uid_t		restrict_user_exempt_uids[NUM_RESTRICT_USER_EXEMPT_UIDS] = {0};
 int		svr_delay_entry = 0;
 int     mom_net_up = 0;
@@ -260,6 +261,7 @@ unsigned int	pbs_mom_port;
 unsigned int	pbs_rm_port;
 pbs_list_head	mom_polljobs;	/* jobs that must have resource limits polled */
 pbs_list_head	mom_deadjobs;	/* jobs that need to purged, see chk_del_job */
+pbs_list_head	mom_exitjobs;	/* jobs for scan_for_exiting to look at */
 int		server_stream = -1;
 pbs_list_head	svr_newjobs;	/* jobs being sent to MOM */
 pbs_list_head	svr_alljobs;	/* all jobs under MOM's control */
@@ -287,6 +289,9 @@ static		resource_def *rdcput;
 static		resource_def *rdwall;
 int		restart_background = FALSE;
 int		reject_root_scripts = FALSE;
+int		cgroup_accounting = FALSE;
+int		proc_connector = FALSE;
+int		task_starter = FALSE;
 int		report_hook_checksums = TRUE;
 int		restart_transmogrify = FALSE;
 int		attach_allow = TRUE;
@@ -347,6 +352,7 @@ pbs_list_head	svr_resv_end_hooks;
 pbs_list_head	svr_hook_job_actions;
 pbs_list_head   svr_hook_vnl_actions;
 int		svr_hook_resend_job_attrs = 0;
+int		svr_rused_resync = 1;	/* next update sends all resources_used */
 int		mom_recvd_ip_cluster_addrs = 0;
 
 /* the mom hooks */
@@ -477,6 +483,9 @@ static handler_ret_t	set_vnode_per_numa_node(char *);
 static handler_ret_t	set_alps_confirm_switch_timeout(char *);
 #endif	/* MOM_ALPS */
 static handler_ret_t	set_attach_allow(char *);
+static handler_ret_t	set_cgroup_accounting(char *);
+static handler_ret_t	set_proc_connector(char *);
+static handler_ret_t	set_task_starter(char *);
 static handler_ret_t	set_checkpoint_path(char *);
 static handler_ret_t	set_enforcement(char *);
 static handler_ret_t	set_jobdir_root(char *);
@@ -543,6 +552,7 @@ static struct	specials {
 #if	MOM_BGL
 	{ "bgl_reserve_partitions",	set_bgl_reserve_partitions },
 #endif	/* MOM_BGL */
+	{ "cgroup_accounting",		set_cgroup_accounting },
 	{ "checkpoint_path",		set_checkpoint_path },
 #if	defined(__sgi)
 	{ "checkpoint_upgrade",		set_checkpoint_upgrade },
@@ -568,7 +578,9 @@ static struct	specials {
 #endif
 	{ "port",			set_momport },
 	{ "prologalarm",		prologalarm },
+	{ "proc_connector",		set_proc_connector },
 	{ "sister_join_job_alarm",	set_joinjob_alarm },
+	{ "task_starter",		set_task_starter },
 	{ "job_launch_delay",		set_job_launch_delay },
 	{ "restart_background",		set_restart_background },
 	{ "restart_transmogrify",	set_restart_transmogrify },
@@ -2143,6 +2155,57 @@ set_reject_root_scripts(char *value)
 	return (set_boolean(__func__, value, &reject_root_scripts));
 }
 
+/**
+ * @brief
+ *	Set the configuration flag that tells the mom to take job cpu and
+ *	memory usage from the job's cgroup when it has one.
+ *
+ * @param[in] value - boolean value
+ *
+ * @retval 0 failure
+ * @retval 1 success
+ *
+ */
+static handler_ret_t
+set_cgroup_accounting(char *value)
+{
+	return (set_boolean(__func__, value, &cgroup_accounting));
+}
+
+/**
+ * @brief
+ *	Set the configuration flag that tells the mom to follow the processes
+ *	of its tasks with the Linux process events connector.
+ *
+ * @param[in] value - boolean value
+ *
+ * @retval 0 failure
+ * @retval 1 success
+ *
+ */
+static handler_ret_t
+set_proc_connector(char *value)
+{
+	return (set_boolean(__func__, value, &proc_connector));
+}
+
+/**
+ * @brief
+ *	Set the configuration flag that tells the mom to start the tasks of
+ *	multi-node jobs from pbs_task_starter instead of forking itself.
+ *
+ * @param[in] value - boolean value
+ *
+ * @retval 0 failure
+ * @retval 1 success
+ *
+ */
+static handler_ret_t
+set_task_starter(char *value)
+{
+	return (set_boolean(__func__, value, &task_starter));
+}
+
 /**
  * @brief
  *	Set the configuration flag that tells the mom to send the checksums
@@ -2998,7 +3061,7 @@ do_mom_action_script(int	ae,	/* index into action table */
 		 **	After adding process to job
 		 */
 		ptask->ti_hProc = pi.hProcess;
-		ptask->ti_qs.ti_sid = pi.dwProcessId;
+		task_set_sid(ptask, pi.dwProcessId);
 		ptask->ti_qs.ti_status = TI_STATE_RUNNING;
 		(void)task_save(ptask);
 		/* update the job with the new session id */
@@ -3116,6 +3179,8 @@ do_mom_action_script(int	ae,	/* index into action table */
 		shell = set_shell(pjob, pwdp);	/* machine dependent */
 		vtable.v_ensize = 30;
 		vtable.v_used = 0;
+		vtable.v_index = NULL;
+		vtable.v_isize = 0;
 		vtable.v_envp = (char **)calloc(vtable.v_ensize,
 			sizeof(char *));
 		if (vtable.v_envp == NULL) {
@@ -3221,7 +3286,7 @@ do_mom_action_script(int	ae,	/* index into action table */
 					j = JOB_EXEC_RETRY;
 				starter_return(kid_write, kid_read, j, &sjr);
 			}
-			ptask->ti_qs.ti_sid = sjr.sj_session;
+			task_set_sid(ptask, sjr.sj_session);
 			i = mom_set_limits(pjob, SET_LIMIT_SET);
 			if (i != PBSE_NONE) {
 				sprintf(log_buffer,
@@ -3300,7 +3365,7 @@ do_mom_action_script(int	ae,	/* index into action table */
 				LOG_NOTICE, pjob->ji_qs.ji_jobid, log_buffer);
 			goto done;
 		}
-		ptask->ti_qs.ti_sid = sjr.sj_session;
+		task_set_sid(ptask, sjr.sj_session);
 		ptask->ti_qs.ti_status = TI_STATE_RUNNING;
 		(void)task_save(ptask);
 		/* update the job with the new session id */
@@ -4916,6 +4981,7 @@ read_config(char *file)
 	report_hook_checksums = TRUE;
 	restart_transmogrify = FALSE;
 	attach_allow	     = TRUE;
+	task_starter	     = FALSE;
 	max_check_poll	     = MAX_CHECK_POLL_TIME;
 	min_check_poll	     = MIN_CHECK_POLL_TIME;
 	vnode_additive       = 1;	/* keep vnodes on HUP */
@@ -5715,6 +5781,10 @@ process_hup(void)
 	cleanup();
 	initialize();
 
+	/* its running tasks are still reported, see task_starter_close() */
+	if (!task_starter)
+		task_starter_close();
+
 #if	MOM_CSA || MOM_ALPS /* ALPS needs libjob support */
 	/*
 	 * This needs to be called after the config file is read.
@@ -5736,6 +5806,21 @@ process_hup(void)
 #endif	/* MOM_BGL */
 }
 
+/**
+ * @brief
+ *	signal handler for SIG_USR1, asks the main loop to append the
+ *	TPP statistics to mom_priv/tpp_stats
+ *
+ * @return Void
+ *
+ */
+
+static void
+catch_USR1(int sig)
+{
+	do_tpp_stats = 1;
+}
+
 /**
  * @brief
  *	signal handler for SIG_USR2
@@ -6454,11 +6539,11 @@ kill_job(job *pjob, int sig)
 			log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_JOB,
 				LOG_DEBUG, pjob->ji_qs.ji_jobid, log_buffer);
 			/*
-			 ** If it is the parent task who became orphan by
-			 ** loosing the top shell, then set exiting_tasks.
+			 ** Queue the job so scan_for_exiting() moves the
+			 ** task to DEAD, this also covers the parent task
+			 ** becoming orphan by loosing the top shell.
 			 */
-			if (ptask->ti_qs.ti_parenttask == TM_NULL_TASK)
-				exiting_tasks = 1;
+			mom_exiting_job(pjob);
 		}
 	}
 	DBPRT(("%s: done %s killed %d\n", __func__, pjob->ji_qs.ji_jobid, ct))
@@ -6500,6 +6585,15 @@ finish_loop(time_t waittime)
 #else
 	if (do_debug_report)
 		debug_report();
+	if (do_tpp_stats) {
+		do_tpp_stats = 0;
+		if (pbs_conf.pbs_use_tcp == 1) {
+			char path_stats[MAXPATHLEN + 1];
+
+			snprintf(path_stats, sizeof(path_stats), "%s/tpp_stats", mom_home);
+			(void) tpp_dump_stats(path_stats, "pbs_mom");
+		}
+	}
 	if (termin_child) {
 		scan_for_terminated();
 		waittime = 1;	/* want faster time around to next loop */
@@ -7821,7 +7915,7 @@ dorestrict_user(void)
 			ptask->ti_qs.ti_parentnode = TM_ERROR_NODE;
 			ptask->ti_qs.ti_myvnode = TM_ERROR_NODE;
 			ptask->ti_qs.ti_parenttask = TM_INIT_TASK;
-			ptask->ti_qs.ti_sid = procsid;
+			task_set_sid(ptask, procsid);
 			ptask->ti_qs.ti_status = TI_STATE_RUNNING;
 			ptask->ti_flags |= TI_FLAGS_ORPHAN;
 			(void)task_save(ptask);
@@ -9024,6 +9118,10 @@ main(int argc, char *argv[])
 	(void)write(lockfds, log_buffer, strlen(log_buffer));
 
 	daemon_protect(0, PBS_DAEMON_PROTECT_ON);
+
+	/* write the log from a background thread if PBS_LOG_ASYNC is set */
+	(void)log_async_start();
+
 #ifdef _POSIX_MEMLOCK
 	if (do_mlockall == 1) {
 		if (mlockall(MCL_CURRENT|MCL_FUTURE) == -1) {
@@ -9056,6 +9154,8 @@ main(int argc, char *argv[])
 #endif
 	act.sa_handler = catch_USR2;
 	sigaction(SIGUSR2, &act, NULL);
+	act.sa_handler = catch_USR1;
+	sigaction(SIGUSR1, &act, NULL);
 
 	act.sa_handler = catch_child;	/* set up to catch Death of Child */
 	sigaction(SIGCHLD, &act, NULL);
@@ -9086,7 +9186,6 @@ main(int argc, char *argv[])
 	 **	that is exec'ed will not have SIG_IGN set for anything.
 	 */
 	sigaction(SIGPIPE, &act, NULL);
-	sigaction(SIGUSR1, &act, NULL);
 #ifdef	SIGINFO
 	sigaction(SIGINFO, &act, NULL);
 #endif
@@ -9100,6 +9199,7 @@ main(int argc, char *argv[])
 	CLEAR_HEAD(mom_polljobs);
 	CLEAR_HEAD(svr_requests);
 	CLEAR_HEAD(mom_deadjobs);
+	CLEAR_HEAD(mom_exitjobs);
 
 #ifdef NAS_UNKILL /* localmod 011 */
 	CLEAR_HEAD(killed_procs);
@@ -10527,7 +10627,6 @@ stop_me(int sig)
 
 	switch (sig) {
 		case SIGPIPE:
-		case SIGUSR1:
 #ifdef	SIGINFO
 		case SIGINFO:
 #endif
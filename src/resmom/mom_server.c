@@ -115,6 +115,7 @@ extern	pbs_list_head	svr_hook_job_actions;
 extern	pbs_list_head	svr_hook_vnl_actions;
 extern	pbs_list_head	svr_allhooks;
 extern  int		svr_hook_resend_job_attrs;
+extern  int		svr_rused_resync;
 extern  int 		mom_recvd_ip_cluster_addrs;
 
 extern  int		server_stream;
@@ -815,6 +816,7 @@ is_request(int stream, int version)
 			 * does "vnodes".
 			 */
 			server_stream = stream;		/* save stream to server */
+			svr_rused_resync = 1;		/* new stream, send full status */
 			next_sample_time = min_check_poll;
 			reply_hello4(stream);
 			internal_state_update = UPDATE_MOM_STATE;
@@ -828,6 +830,7 @@ is_request(int stream, int version)
 			DBPRT(("%s: IS_HELLO_NO_INVENTORY, state=0x%x stream=%d\n", __func__,
 				internal_state, stream))
 			server_stream = stream;         /* save stream to server */
+			svr_rused_resync = 1;		/* new stream, send full status */
 			next_sample_time = min_check_poll;
 			reply_hello4(stream);
 			internal_state_update = UPDATE_MOM_STATE;
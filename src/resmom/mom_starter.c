@@ -0,0 +1,378 @@
+/*
+ * Copyright (C) 1994-2018 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * PBS Pro is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * For a copy of the commercial license terms and conditions,
+ * go to: (http://www.pbspro.com/UserArea/agreement.html)
+ * or contact the Altair Legal Department.
+ *
+ * Altair’s dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of PBS Pro and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair’s trademarks, including but not limited to "PBS™",
+ * "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's
+ * trademark licensing policies.
+ *
+ */
+
+/**
+ * @file	mom_starter.c
+ * @brief
+ *	Start the tasks of jobs from pbs_task_starter ($task_starter).
+ *
+ *	Forking MoM gets slower as MoM grows, and every task of a job is
+ *	forked from it.  With $task_starter set, MoM runs the small
+ *	pbs_task_starter once and sends it the tasks to start: MoM builds
+ *	the environment, limits, user and standard files as for a forked
+ *	task and the starter forks itself and applies them, leaving to its
+ *	child what may block, the temporary directory and pbs_demux.  The
+ *	starter reports the exit of its tasks, which are handed to
+ *	scan_for_terminated() as if MoM had reaped them.
+ */
+
+#include <pbs_config.h>   /* the master config generated by configure */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "libpbs.h"
+#include "server_limits.h"
+#include "list_link.h"
+#include "attribute.h"
+#include "resource.h"
+#include "job.h"
+#include "mom_mach.h"
+#include "mom_func.h"
+#include "net_connect.h"
+#include "log.h"
+#include "pbs_internal.h"
+#include "task_starter.h"
+
+#define TS_RETRY_DELAY	60	/* seconds before starting it again */
+
+extern int	termin_child;
+extern int	task_starter;
+extern time_t	time_now;
+
+static int	ts_fd = -1;		/* socket to the starter */
+static time_t	ts_retry = 0;		/* do not start it again before */
+
+/* exits reported by the starter, not yet seen by scan_for_terminated() */
+static ts_reply_t *ts_exits = NULL;
+static int	ts_nexits = 0;
+static int	ts_maxexits = 0;
+
+/**
+ * @brief
+ *	Queue the exit of a task for scan_for_terminated()
+ *
+ * @param[in] rp - TS_EXITED message
+ *
+ * @return	void
+ */
+static void
+ts_queue_exit(ts_reply_t *rp)
+{
+	if (ts_nexits == ts_maxexits) {
+		int		 newmax = ts_maxexits ? ts_maxexits * 2 : 16;
+		ts_reply_t	*tmp;
+
+		tmp = realloc(ts_exits, newmax * sizeof(ts_reply_t));
+		if (tmp == NULL) {
+			log_err(errno, __func__, "no memory, task exit lost");
+			return;
+		}
+		ts_exits = tmp;
+		ts_maxexits = newmax;
+	}
+	ts_exits[ts_nexits++] = *rp;
+	termin_child = 1;
+}
+
+/**
+ * @brief
+ *	Stop using pbs_task_starter for new tasks.  Only MoM's side of the
+ *	socket is shut down: the starter takes no more requests but stays
+ *	until the tasks it started have exited, and ts_read() goes on
+ *	taking their exits until it closes the socket.
+ *
+ * @return	void
+ */
+void
+task_starter_close(void)
+{
+	if (ts_fd >= 0) {
+		(void)shutdown(ts_fd, SHUT_WR);
+		ts_fd = -1;
+	}
+}
+
+/**
+ * @brief
+ *	Read a message from pbs_task_starter that came outside of a
+ *	request, the exit of a task.  Called from wait_request(), also for
+ *	a starter no longer used for new tasks, see task_starter_close().
+ *
+ * @param[in] fd - socket to the starter
+ *
+ * @return	void
+ */
+static void
+ts_read(int fd)
+{
+	ts_reply_t	rp;
+
+	if (readpipe(fd, &rp, sizeof(rp)) != sizeof(rp)) {
+		close_conn(fd);
+		if (fd != ts_fd) {
+			log_event(PBSEVENT_DEBUG, 0, LOG_DEBUG, __func__,
+				"pbs_task_starter done");
+			return;
+		}
+		log_event(PBSEVENT_SYSTEM, 0, LOG_WARNING, __func__,
+			"lost pbs_task_starter");
+		ts_fd = -1;
+		ts_retry = time_now + TS_RETRY_DELAY;
+		return;
+	}
+	if (rp.tp_type == TS_EXITED)
+		ts_queue_exit(&rp);
+}
+
+/**
+ * @brief
+ *	Run pbs_task_starter and wait until it is ready
+ *
+ * @return	int
+ * @retval	0	the starter is running
+ * @retval	-1	it could not be started
+ */
+static int
+ts_open(void)
+{
+	char		path[MAXPATHLEN + 1];
+	char		arg[16];
+	int		sv[2];
+	pid_t		pid;
+	ts_reply_t	rp;
+
+	snprintf(path, sizeof(path), "%s/sbin/pbs_task_starter",
+		pbs_conf.pbs_exec_path);
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1) {
+		log_err(errno, __func__, "socketpair");
+		return -1;
+	}
+
+	if ((pid = fork_me(-1)) == -1) {
+		(void)close(sv[0]);
+		(void)close(sv[1]);
+		return -1;
+	} else if (pid == 0) {
+		(void)close(sv[0]);
+		sprintf(arg, "%d", sv[1]);
+		execl(path, "pbs_task_starter", arg, NULL);
+		exit(1);
+	}
+	(void)close(sv[1]);
+	(void)fcntl(sv[0], F_SETFD, FD_CLOEXEC);
+
+	if ((readpipe(sv[0], &rp, sizeof(rp)) != sizeof(rp)) ||
+		(rp.tp_type != TS_READY)) {
+		sprintf(log_buffer, "could not run %s", path);
+		log_event(PBSEVENT_SYSTEM, 0, LOG_ERR, __func__, log_buffer);
+		(void)close(sv[0]);
+		return -1;
+	}
+	if (add_conn(sv[0], ChildPipe, (pbs_net_t)0, 0, ts_read) == NULL) {
+		log_err(-1, __func__, "add_conn");
+		(void)close(sv[0]);
+		return -1;
+	}
+	ts_fd = sv[0];
+
+	sprintf(log_buffer, "started pbs_task_starter, pid %d", (int)pid);
+	log_event(PBSEVENT_SYSTEM, 0, LOG_INFO, __func__, log_buffer);
+	return 0;
+}
+
+/**
+ * @brief
+ *	Send all of a buffer to the starter
+ *
+ * @param[in] buf - data
+ * @param[in] len - its length
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	error
+ */
+static int
+ts_send(char *buf, size_t len)
+{
+	ssize_t	n;
+
+	while (len > 0) {
+		n = send(ts_fd, buf, len, MSG_NOSIGNAL);
+		if (n == -1 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return -1;
+		buf += n;
+		len -= n;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *	Check that pbs_task_starter is to be used and is running, run it
+ *	if needed.  If it cannot be run, or dies, it is not tried again for
+ *	TS_RETRY_DELAY seconds.
+ *
+ * @return	int
+ * @retval	0	task_starter_run() may be called
+ * @retval	-1	the starter is not available
+ */
+int
+task_starter_ready(void)
+{
+	if (!task_starter) {
+		task_starter_close();
+		return -1;
+	}
+	if (ts_fd == -1) {
+		if (time_now < ts_retry)
+			return -1;
+		if (ts_open() == -1) {
+			ts_retry = time_now + TS_RETRY_DELAY;
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *	Have pbs_task_starter start a task, after task_starter_ready().
+ *	The descriptors are not closed here.
+ *
+ * @param[in]  treq - the request, tr_strlen bytes of strings follow
+ * @param[in]  strs - the strings, see task_starter.h
+ * @param[in]  fds  - standard input, output and error of the task
+ * @param[out] rp   - the reply, TS_STARTED or TS_FAILED
+ *
+ * @return	int
+ * @retval	0	*rp is the reply
+ * @retval	-1	the starter is not available, nothing was started
+ * @retval	-2	the starter was lost before it answered
+ */
+int
+task_starter_run(ts_request_t *treq, char *strs, int *fds, ts_reply_t *rp)
+{
+	struct msghdr	 msg;
+	struct iovec	 iov;
+	struct cmsghdr	*cmsg;
+	union {
+		struct cmsghdr	cm;
+		char		buf[CMSG_SPACE(TS_NFDS * sizeof(int))];
+	} ctl;
+	ssize_t		 n;
+
+	if (ts_fd == -1)
+		return -1;
+
+	treq->tr_version = TS_VERSION;
+	memset(&msg, 0, sizeof(msg));
+	iov.iov_base = treq;
+	iov.iov_len = sizeof(ts_request_t);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = ctl.buf;
+	msg.msg_controllen = sizeof(ctl.buf);
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(TS_NFDS * sizeof(int));
+	memcpy(CMSG_DATA(cmsg), fds, TS_NFDS * sizeof(int));
+
+	/* an incomplete request is never started, the starter stops reading */
+	do {
+		n = sendmsg(ts_fd, &msg, MSG_NOSIGNAL);
+	} while (n == -1 && errno == EINTR);
+	if ((n <= 0) ||
+		(ts_send((char *)treq + n, sizeof(ts_request_t) - n) == -1) ||
+		(ts_send(strs, treq->tr_strlen) == -1)) {
+		log_err(errno, __func__, "send to pbs_task_starter");
+		task_starter_close();
+		ts_retry = time_now + TS_RETRY_DELAY;
+		return -1;
+	}
+
+	for (;;) {
+		if (readpipe(ts_fd, rp, sizeof(ts_reply_t)) != sizeof(ts_reply_t)) {
+			log_err(errno, __func__, "lost pbs_task_starter");
+			close_conn(ts_fd);
+			ts_fd = -1;
+			ts_retry = time_now + TS_RETRY_DELAY;
+			return -2;
+		}
+		if (rp->tp_type != TS_EXITED)
+			return 0;
+		ts_queue_exit(rp);
+	}
+}
+
+/**
+ * @brief
+ *	Return the next task exit reported by pbs_task_starter, for
+ *	scan_for_terminated()
+ *
+ * @param[out] statp - wait status of the task
+ *
+ * @return	pid_t
+ * @retval	>0	pid of the task
+ * @retval	0	no more exits
+ */
+pid_t
+task_starter_reaped(int *statp)
+{
+	pid_t	pid;
+
+	if (ts_nexits == 0)
+		return 0;
+	pid = ts_exits[0].tp_pid;
+	*statp = ts_exits[0].tp_status;
+	if (--ts_nexits > 0)
+		memmove(ts_exits, ts_exits + 1, ts_nexits * sizeof(ts_reply_t));
+	return pid;
+}
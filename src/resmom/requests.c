@@ -1737,7 +1737,7 @@ post_terminate(job *pjob, int err)
 		if (kill_job(pjob, SIGKILL) == 0) {
 			/* no processes around, force into exiting */
 			pjob->ji_qs.ji_substate = JOB_SUBSTATE_EXITING;
-			exiting_tasks = 1;
+			mom_exiting_job(pjob);
 		}
 	}
 	return;
@@ -1800,7 +1800,7 @@ terminate_job(job *pjob, int internal)
 		if (kill_job(pjob, s) == 0) {
 			/* no processes around, force into exiting */
 			pjob->ji_qs.ji_substate = JOB_SUBSTATE_EXITING;
-			exiting_tasks = 1;
+			mom_exiting_job(pjob);
 		}
 		i = -2;
 	}
@@ -2023,7 +2023,7 @@ req_signaljob(struct batch_request *preq)
 			ptask = GET_NEXT(pjob->ji_tasks);
 			if (ptask)
 				ptask->ti_qs.ti_status = TI_STATE_EXITED;
-			exiting_tasks = 1;
+			mom_exiting_job(pjob);
 		}
 	}
 
@@ -3741,7 +3741,7 @@ post_chkpt(job *pjob, int  ev)
 		 **	obit is sent.
 		 */
 		if (abort) {
-			exiting_tasks = 1;
+			mom_exiting_job(pjob);
 			term_job(pjob);
 		} else if (pjob->ji_preq) {
 			/*
@@ -4209,7 +4209,7 @@ post_restart(job *pjob, int ev)
 		 ** If we get here, an error happened.
 		 */
 		pjob->ji_qs.ji_substate = JOB_SUBSTATE_EXITING;
-		exiting_tasks = 1;
+		mom_exiting_job(pjob);
 		return;
 	}
 
@@ -4238,8 +4238,8 @@ post_restart(job *pjob, int ev)
 				 * has not been generated.
 				 */
 				if (ptask->ti_qs.ti_sid < 0) {
-					ptask->ti_qs.ti_sid =
-						-ptask->ti_qs.ti_sid;
+					task_set_sid(ptask,
+						-ptask->ti_qs.ti_sid);
 				}
 				(void)task_save(ptask);
 			}
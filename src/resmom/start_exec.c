@@ -96,6 +96,7 @@
 #include "placementsets.h"
 #include "pbs_internal.h"
 #include "pbs_reliable.h"
+#include "task_starter.h"
 
 #define	PIPE_READ_TIMEOUT	5
 #define EXTRA_ENV_PTRS	       32
@@ -124,6 +125,8 @@ extern	time_t		time_resc_updated;
 extern char		*path_hooks_workdir;
 extern	long		joinjob_alarm_time;
 extern	long		job_launch_delay;
+extern	int		nice_val;
+extern	int		task_starter;
 int              mom_reader_go;		/* see catchinter() & mom_writer() */
 struct var_table vtable;		/* for building up Job's environ */
 
@@ -176,6 +179,9 @@ char *variables_else[] = {	/* variables to add, value computed */
 static	int num_var_else = sizeof(variables_else) / sizeof(char *);
 static	void catchinter(int);
 static int find_env_slot(struct var_table *, char *);
+static void reset_env_variables(struct var_table *);
+static int init_job_env(struct var_table *, job *, int);
+static void job_env_base(job *);
 
 extern int is_direct_write(job *, enum job_file, char *, int *);
 static int direct_write_possible = 1;
@@ -427,7 +433,7 @@ readpipe(int pfd, void *vptr, size_t nbytes)
  *	Logs the message if one is passed in.
  *	Sends IM_ABORT_JOB to the sisters.
  *	sets the job's substate to JOB_SUBSTATE_EXITING, sets the job's
- *	exit code and sets exiting_tasks so an obit is sent for the job.
+ *	exit code and queues it with mom_exiting_job() so an obit is sent.
  *	The job's standard out/err are closed and then resources are released.
  *
  * @param[in]	pjob - pointer to job structure
@@ -460,7 +466,7 @@ exec_bail(job *pjob, int code, char *txt)
 	}
 	pjob->ji_qs.ji_substate = JOB_SUBSTATE_EXITING;
 	pjob->ji_qs.ji_un.ji_momt.ji_exitstat = code;
-	exiting_tasks = 1;
+	mom_exiting_job(pjob);
 	if (pjob->ji_stdout > 0)
 		(void)close(pjob->ji_stdout);
 	if (pjob->ji_stderr > 0)
@@ -1752,7 +1758,7 @@ record_finish_exec(int sd)
 		return;
 	}
 
-	ptask->ti_qs.ti_sid = sjr.sj_session;
+	task_set_sid(ptask, sjr.sj_session);
 	ptask->ti_qs.ti_status = TI_STATE_RUNNING;
 #ifdef	_SX
 	ptask->ti_qs.ti_u.ti_ext.ti_parent = sjr.sj_parent;
@@ -2850,7 +2856,6 @@ finish_exec(job *pjob)
 	struct startjob_rtn     ack;
 #endif
 	pbs_task			*ptask;
-	struct	array_strings	*vstrs;
 	struct	sockaddr_in	saddr;
 	int			nodemux = 0;
 	char			*pbs_jobdir; /* staging and execution directory of this job */
@@ -3186,6 +3191,9 @@ finish_exec(job *pjob)
 	pjob->ji_qs.ji_stime = time_now;
 	pjob->ji_sampletim  = time_now;
 
+	/* the child starts the job's environment from this */
+	job_env_base(pjob);
+
 	/*
 	 ** Fork the child process that will become the job.
 	 */
@@ -3495,27 +3503,11 @@ finish_exec(job *pjob)
 	/*
 	 * set up the Environmental Variables to be given to the job
 	 */
-	vstrs = pjob->ji_wattr[(int)JOB_ATR_variables].at_val.at_arst;
-	vtable.v_ensize = vstrs->as_usedptr + num_var_else + num_var_env +
-		EXTRA_ENV_PTRS;
-	vtable.v_used   = 0;
-	vtable.v_envp = (char **)malloc(vtable.v_ensize * sizeof(char *));
-	if (vtable.v_envp == NULL) {
+	if (init_job_env(&vtable, pjob, 0) == -1) {
 		log_err(ENOMEM, __func__, "out of memory");
 		starter_return(upfds, downfds, JOB_EXEC_FAIL1, &sjr);
 	}
 
-	/*  First variables from the local environment */
-
-	for (j = 0; j < num_var_env; ++j)
-		bld_env_variables(&vtable, environ[j], NULL);
-
-	/* Second, the variables passed with the job.  They may */
-	/* be overwritten with new correct values for this job	*/
-
-	for (j = 0; j < vstrs->as_usedptr; ++j)
-		bld_env_variables(&vtable, vstrs->as_string[j], NULL);
-
 	/* .. Next the critical variables: home, path, logname, ... */
 	/* these may replace some passed in with the job	    */
 
@@ -4360,8 +4352,7 @@ finish_exec(job *pjob)
 			}
 
 			/* clear the env array */
-			vtable.v_used = 0;
-			vtable.v_envp[0] = NULL;
+			reset_env_variables(&vtable);
 
 			/* need to also set vtable as that would */
 			/* get appended to later in the code */
@@ -4615,6 +4606,415 @@ finish_exec(job *pjob)
 	exit(254);	/* should never, ever get here */
 }
 
+/**
+ * @brief
+ *	task_env_variables - add the variables of a task spawned with
+ *	start_process() to its environment, after init_job_env()
+ *
+ * @param[in] ptask      - the task
+ * @param[in] envp       - environment passed with the spawn request
+ * @param[in] vtab       - environment being built
+ * @param[in] pbs_jobdir - staging and execution directory of the job
+ * @param[in] make_tmpdir - make TMPDIR here, else only name it
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	!0	JOB_EXEC_* from mktmpdir()
+ */
+static int
+task_env_variables(task *ptask, char **envp, struct var_table *vtab,
+	char *pbs_jobdir, int make_tmpdir)
+{
+	job	*pjob = ptask->ti_job;
+	char	buf[MAXPATHLEN+2];
+	int	i;
+	int	j;
+
+	/* HOME */
+	bld_env_variables(vtab, variables_else[0],
+		pjob->ji_grpcache->gc_homedir);
+
+	/* PBS_JOBNAME */
+	bld_env_variables(vtab, variables_else[2],
+		pjob->ji_wattr[(int)JOB_ATR_jobname].at_val.at_str);
+
+	/* PBS_JOBID */
+	bld_env_variables(vtab, variables_else[3], pjob->ji_qs.ji_jobid);
+
+	/* PBS_QUEUE */
+	bld_env_variables(vtab, variables_else[4],
+		pjob->ji_wattr[(int)JOB_ATR_in_queue].at_val.at_str);
+
+	/* PBS_JOBCOOKIE */
+	bld_env_variables(vtab, variables_else[7],
+		pjob->ji_wattr[(int)JOB_ATR_Cookie].at_val.at_str);
+
+	/* PBS_NODENUM */
+	sprintf(buf, "%d", pjob->ji_nodeid);
+	bld_env_variables(vtab, variables_else[8], buf);
+
+	/* PBS_TASKNUM */
+	sprintf(buf, "%8.8X", ptask->ti_qs.ti_task);
+	bld_env_variables(vtab, variables_else[9], buf);
+
+	/* PBS_MOMPORT */
+	sprintf(buf, "%d", pbs_rm_port);
+	bld_env_variables(vtab, variables_else[10], buf);
+
+	/* OMP_NUM_THREADS and NCPUS eq to number of cpus */
+	sprintf(buf, "%d", pjob->ji_vnods[ptask->ti_qs.ti_myvnode].vn_threads);
+#ifdef NAS /* localmod 020 */
+	/* Force OMP_NUM_THREADS=1 on Columbia.
+	 * If you've ever seen a 256 process MPI program try to start 256
+	 * threads for each process, you'd know why.
+	 */
+	bld_env_variables(vtab, variables_else[12], "1");
+#else
+	bld_env_variables(vtab, variables_else[12], buf);
+#endif /* localmod 020 */
+	bld_env_variables(vtab, "NCPUS", buf);
+
+	/* PBS_ACCOUNT */
+	if (pjob->ji_wattr[(int)JOB_ATR_account].at_flags & ATR_VFLAG_SET)
+		bld_env_variables(vtab, variables_else[13],
+			pjob->ji_wattr[(int)JOB_ATR_account].at_val.at_str);
+
+	if (set_mach_vars(pjob, vtab) != 0) {
+		/* never reaches here */
+	}
+
+	/* set Environment to reflect batch */
+	bld_env_variables(vtab, "PBS_ENVIRONMENT", "PBS_BATCH");
+	bld_env_variables(vtab, "ENVIRONMENT", "BATCH");
+
+	for (i=0; envp[i]; i++)
+		bld_env_variables(vtab, envp[i], NULL);
+
+	/* Add TMPDIR to environment */
+#ifdef NAS /* localmod 010 */
+	(void) NAS_tmpdirname(pjob);
+#endif /* localmod 010 */
+	if (make_tmpdir) {
+		j = mktmpdir(pjob->ji_qs.ji_jobid,
+			pjob->ji_qs.ji_un.ji_momt.ji_exuid,
+			pjob->ji_qs.ji_un.ji_momt.ji_exgid,
+			vtab);
+		if (j != 0)
+			return (j);
+	} else {
+		bld_env_variables(vtab, "TMPDIR",
+			tmpdirname(pjob->ji_qs.ji_jobid));
+	}
+
+	/* set PBS_JOBDIR */
+	if ((pjob->ji_wattr[(int)JOB_ATR_sandbox].at_flags & ATR_VFLAG_SET) &&
+		(strcasecmp(pjob->ji_wattr[JOB_ATR_sandbox].at_val.at_str, "PRIVATE") == 0)) {
+		bld_env_variables(vtab, "PBS_JOBDIR", pbs_jobdir);
+	} else {
+		bld_env_variables(vtab, "PBS_JOBDIR", pjob->ji_grpcache->gc_homedir);
+	}
+
+	return (0);
+}
+
+/**
+ * @brief
+ *	task_started - record the outcome of starting a task for a spawn
+ *	request in MoM
+ *
+ * @param[in] ptask - the task
+ * @param[in] psjr  - what the child or pbs_task_starter returned
+ * @param[in] prog  - program of the task, for the log
+ *
+ * @return	int
+ * @retval	PBSE_NONE	the task is running
+ * @retval	PBSE_SYSTEM	it was not started
+ */
+static int
+task_started(task *ptask, struct startjob_rtn *psjr, char *prog)
+{
+	job	*pjob = ptask->ti_job;
+
+	/*
+	 ** Set the global id before exiting on error so any
+	 ** information can be put into the job struct first.
+	 */
+	set_globid(pjob, psjr);
+	if (psjr->sj_code < 0) {
+		(void)sprintf(log_buffer, "task not started, %s %s %d",
+			(psjr->sj_code==JOB_EXEC_RETRY)?
+			"Retry" : "Failure",
+			prog,
+			psjr->sj_code);
+		log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_JOB,
+			LOG_NOTICE, pjob->ji_qs.ji_jobid, log_buffer);
+		return PBSE_SYSTEM;
+	}
+
+	task_set_sid(ptask, psjr->sj_session);
+	ptask->ti_qs.ti_status = TI_STATE_RUNNING;
+#ifdef	_SX
+	ptask->ti_qs.ti_u.ti_ext.ti_parent = psjr->sj_parent;
+	ptask->ti_qs.ti_u.ti_ext.ti_jid = psjr->sj_jid;
+#endif
+	(void)task_save(ptask);
+	if (pjob->ji_qs.ji_substate != JOB_SUBSTATE_RUNNING) {
+		pjob->ji_qs.ji_state = JOB_STATE_RUNNING;
+		pjob->ji_qs.ji_substate = JOB_SUBSTATE_RUNNING;
+		job_save(pjob, SAVEJOB_QUICK);
+	}
+	(void)sprintf(log_buffer, "task %8.8X started, %s",
+		ptask->ti_qs.ti_task, prog);
+	log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, LOG_INFO,
+		pjob->ji_qs.ji_jobid, log_buffer);
+
+	return PBSE_NONE;
+}
+
+/**
+ * @brief
+ *	free_env_table - free a var_table and its strings
+ *
+ * @param[in] ptbl - the table
+ *
+ * @return	void
+ */
+static void
+free_env_table(struct var_table *ptbl)
+{
+	int	i;
+
+	for (i = 0; i < ptbl->v_used; ++i)
+		free(ptbl->v_envp[i]);
+	free(ptbl->v_envp);
+	free(ptbl->v_index);
+	ptbl->v_envp = NULL;
+	ptbl->v_index = NULL;
+	ptbl->v_used = 0;
+}
+
+/**
+ * @brief
+ *	copy_job_env - init_job_env() for use in MoM itself, the strings are
+ *	copied rather than shared with the job's common environment
+ *
+ * @param[out] ptbl  - var_table to set up, free with free_env_table()
+ * @param[in]  pjob  - the job
+ * @param[in]  extra - number of variables the caller is going to add
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	out of memory
+ */
+static int
+copy_job_env(struct var_table *ptbl, job *pjob, int extra)
+{
+	int	i;
+
+	if (init_job_env(ptbl, pjob, extra) == -1)
+		return (-1);
+	if (pjob->ji_env == NULL)
+		return (0);
+	for (i = 0; i < ptbl->v_used; ++i) {
+		if ((ptbl->v_envp[i] = strdup(ptbl->v_envp[i])) == NULL) {
+			ptbl->v_used = i;
+			free_env_table(ptbl);
+			return (-1);
+		}
+	}
+	return (0);
+}
+
+#if defined(linux) && !MOM_CPUSET && !MOM_ALPS && !MOM_CSA
+/**
+ * @brief
+ *	start_process_starter - start a task for a spawn request from
+ *	pbs_task_starter instead of forking MoM, see mom_starter.c
+ *
+ * @par
+ *	Used for tasks of multi-node jobs, whose standard output and error
+ *	go to /dev/null or pbs_demux, when the job has no credential and
+ *	there is no execjob_launch hook.  Everything the forked child would
+ *	do is prepared here, except what needs the new process or may block
+ *	MoM: the session, limits, temporary directory, user, working
+ *	directory, the connections to pbs_demux and the exec.  When anything
+ *	here goes wrong the task is left to start_process() to fork, which
+ *	then reports the error as before.
+ *
+ * @param[in] ptask      - the task
+ * @param[in] argv       - argument list
+ * @param[in] envp       - environment passed with the spawn request
+ * @param[in] nodemux    - false if the task process needs demux
+ * @param[in] ipaddr     - address of Mother Superior, for pbs_demux
+ * @param[in] pbs_jobdir - staging and execution directory of the job
+ *
+ * @return	int
+ * @retval	PBSE_NONE	the task was started
+ * @retval	PBSE_SYSTEM	the task could not be started
+ * @retval	-1		start the task by forking
+ */
+static int
+start_process_starter(task *ptask, char **argv, char **envp, bool nodemux,
+	u_long ipaddr, char *pbs_jobdir)
+{
+	job			*pjob = ptask->ti_job;
+	struct var_table	vt;
+	struct startjob_rtn	sjr;
+	ts_request_t		treq;
+	ts_reply_t		rp;
+	attribute		*pattr;
+	char			*user;
+	char			*cwd;
+	char			*tmpdir;
+	char			*cookie;
+	char			*strs;
+	char			*p;
+	char			buf[64];
+	size_t			len;
+	int			fds[TS_NFDS] = {-1, -1, -1};
+	int			nenv;
+	int			i;
+	int			rc;
+
+	if (!task_starter || (pjob->ji_numnodes < 2) ||
+		(pjob->ji_grpcache == NULL) ||
+		(pjob->ji_extended.ji_ext.ji_credtype != PBS_CREDTYPE_NONE) ||
+		(num_eligible_hooks(HOOK_EVENT_EXECJOB_LAUNCH) > 0))
+		return (-1);
+
+	if ((pjob->ji_wattr[(int)JOB_ATR_sandbox].at_flags & ATR_VFLAG_SET) &&
+		(strcasecmp(pjob->ji_wattr[JOB_ATR_sandbox].at_val.at_str, "PRIVATE") == 0))
+		cwd = pbs_jobdir;
+	else
+		cwd = pjob->ji_grpcache->gc_homedir;
+	user = pjob->ji_wattr[(int)JOB_ATR_euser].at_val.at_str;
+	if ((cwd == NULL) || (user == NULL))
+		return (-1);
+
+	memset(&treq, 0, sizeof(treq));
+	if (mom_task_limits(pjob, &treq) != PBSE_NONE)
+		return (-1);
+	treq.tr_uid = pjob->ji_qs.ji_un.ji_momt.ji_exuid;
+	treq.tr_gid = pjob->ji_qs.ji_un.ji_momt.ji_exgid;
+	treq.tr_rgid = pjob->ji_grpcache->gc_rgid;
+	treq.tr_unnice = (nice_val != 0);
+	if (pjob->ji_wattr[(int)JOB_ATR_umask].at_flags & ATR_VFLAG_SET) {
+		sprintf(buf, "%ld", pjob->ji_wattr[(int)JOB_ATR_umask].
+			at_val.at_long);
+		sscanf(buf, "%o", &i);
+		treq.tr_umask = (mode_t)i;
+	} else {
+		treq.tr_umask = 077;
+	}
+
+	/* stdout and stderr go to /dev/null, or the child connects pbs_demux */
+	pattr = &pjob->ji_wattr[(int)JOB_ATR_nodemux];
+	if (!nodemux && (pattr->at_flags & ATR_VFLAG_SET))
+		nodemux = (int)pattr->at_val.at_long;
+	if (nodemux) {
+		cookie = "";
+	} else {
+		cookie = pjob->ji_wattr[(int)JOB_ATR_Cookie].at_val.at_str;
+		treq.tr_demux_addr = (in_addr_t)ipaddr;
+		treq.tr_demux_port[0] = pjob->ji_stdout;
+		treq.tr_demux_port[1] = pjob->ji_stderr;
+	}
+
+	if (task_starter_ready() == -1)
+		return (-1);
+
+	for (nenv = 0; envp[nenv]; nenv++)
+		;
+	job_env_base(pjob);
+	if (copy_job_env(&vt, pjob, nenv) == -1)
+		return (-1);
+	if (task_env_variables(ptask, envp, &vt, pbs_jobdir, 0) != 0) {
+		free_env_table(&vt);
+		return (-1);
+	}
+	tmpdir = tmpdirname(pjob->ji_qs.ji_jobid);
+
+	/* pack the strings, see task_starter.h */
+	len = strlen(user) + strlen(cwd) + strlen(tmpdir) + strlen(cookie) +
+		strlen(argv[0]) + TS_NSTRS;
+	for (i = 0; argv[i]; i++)
+		len += strlen(argv[i]) + 1;
+	treq.tr_argc = i;
+	for (i = 0; i < vt.v_used; i++)
+		len += strlen(vt.v_envp[i]) + 1;
+	treq.tr_envc = vt.v_used;
+	treq.tr_strlen = len;
+	if ((strs = malloc(len)) == NULL) {
+		free_env_table(&vt);
+		return (-1);
+	}
+	p = strs;
+	strcpy(p, user);
+	p += strlen(p) + 1;
+	strcpy(p, cwd);
+	p += strlen(p) + 1;
+	strcpy(p, tmpdir);
+	p += strlen(p) + 1;
+	strcpy(p, cookie);
+	p += strlen(p) + 1;
+	strcpy(p, argv[0]);
+	p += strlen(p) + 1;
+	for (i = 0; argv[i]; i++) {
+		strcpy(p, argv[i]);
+		p += strlen(p) + 1;
+	}
+	for (i = 0; i < vt.v_used; i++) {
+		strcpy(p, vt.v_envp[i]);
+		p += strlen(p) + 1;
+	}
+	free_env_table(&vt);
+
+	memset(&sjr, 0, sizeof(sjr));
+
+	/* the child replaces stdout and stderr if it connects to pbs_demux */
+	fds[0] = open("/dev/null", O_RDONLY);
+	if ((fds[1] = open("/dev/null", O_WRONLY)) != -1)
+		fds[2] = dup(fds[1]);
+	if ((fds[0] == -1) || (fds[1] == -1) || (fds[2] == -1)) {
+		log_err(errno, __func__, "could not open task standard files");
+		sjr.sj_code = JOB_EXEC_FAIL2;
+		rc = 1;
+	} else {
+		rc = task_starter_run(&treq, strs, fds, &rp);
+	}
+	for (i = 0; i < TS_NFDS; i++) {
+		if (fds[i] != -1)
+			(void)close(fds[i]);
+	}
+	free(strs);
+
+	if (rc == -1)
+		return (-1);
+	if (rc == -2) {
+		sjr.sj_code = JOB_EXEC_RETRY;
+	} else if (rc == 0) {
+		if (rp.tp_type == TS_STARTED) {
+			sjr.sj_session = rp.tp_pid;
+		} else {
+			sprintf(log_buffer,
+				"pbs_task_starter could not start task %8.8X, "
+				"stage %d", ptask->ti_qs.ti_task, rp.tp_stage);
+			log_joberr(rp.tp_status, __func__, log_buffer,
+				pjob->ji_qs.ji_jobid);
+			if (rp.tp_stage == TS_STAGE_SETSID)
+				sjr.sj_code = JOB_EXEC_RETRY;
+			else if (rp.tp_stage != TS_STAGE_TMPDIR)
+				sjr.sj_code = JOB_EXEC_FAIL2;
+			else if (rp.tp_status == EEXIST)
+				sjr.sj_code = JOB_EXEC_FAIL_SECURITY;
+			else
+				sjr.sj_code = JOB_EXEC_FAIL1;
+		}
+	}
+	return (task_started(ptask, &sjr, argv[0]));
+}
+#endif	/* linux && !MOM_CPUSET && !MOM_ALPS && !MOM_CSA */
+
 /**
  * @brief
  * 	Start a process for a spawn request.  This will be different from
@@ -4644,7 +5044,6 @@ start_process(task *ptask, char **argv, char **envp, bool nodemux)
 	int	i, j, k;
 	int	fd;
 	u_long	ipaddr;
-	struct	array_strings	*vstrs;
 	struct  startjob_rtn sjr;
 	attribute		*pattr;
 	char	*pbs_jobdir; /* staging and execution directory of this job */
@@ -4663,6 +5062,32 @@ start_process(task *ptask, char **argv, char **envp, bool nodemux)
 	FILE			*temp_stderr = stderr;
 
 	pbs_jobdir = jobdirname(pjob->ji_qs.ji_jobid, pjob->ji_grpcache->gc_homedir);
+	/*
+	 ** Get ipaddr to Mother Superior.
+	 */
+	if (pjob->ji_qs.ji_svrflags & JOB_SVFLG_HERE)	/* I'm MS */
+		ipaddr = htonl(localaddr);
+	else {
+		struct	sockaddr_in	*ap;
+
+		/*
+		 ** We always have a stream open to MS at node 0.
+		 */
+		i = pjob->ji_hosts[0].hn_stream;
+		if ((ap = rpp_getaddr(i)) == NULL) {
+			log_joberr(-1, __func__, "no stream to MS",
+				pjob->ji_qs.ji_jobid);
+			return PBSE_SYSTEM;
+		}
+		ipaddr = ap->sin_addr.s_addr;
+	}
+
+#if defined(linux) && !MOM_CPUSET && !MOM_ALPS && !MOM_CSA
+	if ((i = start_process_starter(ptask, argv, envp, nodemux, ipaddr,
+		pbs_jobdir)) != -1)
+		return i;
+#endif
+
 	memset(&sjr, 0, sizeof(sjr));
 	if (pipe(pipes) == -1)
 		return PBSE_SYSTEM;
@@ -4685,25 +5110,7 @@ start_process(task *ptask, char **argv, char **envp, bool nodemux)
 		kid_read = pipes[0];
 	parent_write = pipes[1];
 
-	/*
-	 ** Get ipaddr to Mother Superior.
-	 */
-	if (pjob->ji_qs.ji_svrflags & JOB_SVFLG_HERE)	/* I'm MS */
-		ipaddr = htonl(localaddr);
-	else {
-		struct	sockaddr_in	*ap;
-
-		/*
-		 ** We always have a stream open to MS at node 0.
-		 */
-		i = pjob->ji_hosts[0].hn_stream;
-		if ((ap = rpp_getaddr(i)) == NULL) {
-			log_joberr(-1, __func__, "no stream to MS",
-				pjob->ji_qs.ji_jobid);
-			return PBSE_SYSTEM;
-		}
-		ipaddr = ap->sin_addr.s_addr;
-	}
+	job_env_base(pjob);
 
 	/*
 	 ** Begin a new process for the fledgling task.
@@ -4731,40 +5138,7 @@ start_process(task *ptask, char **argv, char **envp, bool nodemux)
 		DBPRT(("%s: read start return %d %d\n", __func__,
 			sjr.sj_code, sjr.sj_session))
 
-		/*
-		 ** Set the global id before exiting on error so any
-		 ** information can be put into the job struct first.
-		 */
-		set_globid(pjob, &sjr);
-		if (sjr.sj_code < 0) {
-			(void)sprintf(log_buffer, "task not started, %s %s %d",
-				(sjr.sj_code==JOB_EXEC_RETRY)?
-				"Retry" : "Failure",
-				argv[0],
-				sjr.sj_code);
-			log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_JOB,
-				LOG_NOTICE, pjob->ji_qs.ji_jobid, log_buffer);
-			return PBSE_SYSTEM;
-		}
-
-		ptask->ti_qs.ti_sid = sjr.sj_session;
-		ptask->ti_qs.ti_status = TI_STATE_RUNNING;
-#ifdef	_SX
-		ptask->ti_qs.ti_u.ti_ext.ti_parent = sjr.sj_parent;
-		ptask->ti_qs.ti_u.ti_ext.ti_jid = sjr.sj_jid;
-#endif
-		(void)task_save(ptask);
-		if (pjob->ji_qs.ji_substate != JOB_SUBSTATE_RUNNING) {
-			pjob->ji_qs.ji_state = JOB_STATE_RUNNING;
-			pjob->ji_qs.ji_substate = JOB_SUBSTATE_RUNNING;
-			job_save(pjob, SAVEJOB_QUICK);
-		}
-		(void)sprintf(log_buffer, "task %8.8X started, %s",
-			ptask->ti_qs.ti_task, argv[0]);
-		log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, LOG_INFO,
-			pjob->ji_qs.ji_jobid, log_buffer);
-
-		return PBSE_NONE;
+		return (task_started(ptask, &sjr, argv[0]));
 	}
 
 	/************************************************/
@@ -4782,78 +5156,10 @@ start_process(task *ptask, char **argv, char **envp, bool nodemux)
 
 	for (j=0, ebsize=0; envp[j]; j++)
 		ebsize += strlen(envp[j]);
-	vstrs = pjob->ji_wattr[(int)JOB_ATR_variables].at_val.at_arst;
-	vtable.v_ensize = vstrs->as_usedptr + num_var_else + num_var_env +
-		j + EXTRA_ENV_PTRS;
-	vtable.v_used   = 0;
-	vtable.v_envp = (char **)malloc(vtable.v_ensize * sizeof(char *));
-	if (vtable.v_envp == NULL) {
+	if (init_job_env(&vtable, pjob, j) == -1) {
 		return PBSE_SYSTEM;
 	}
 
-	/* First variables from the local environment */
-	for (j = 0; j < num_var_env; ++j)
-		bld_env_variables(&vtable, environ[j], NULL);
-
-	/* Next, the variables passed with the job.  They may   */
-	/* be overwritten with new correct values for this job	*/
-
-	for (j = 0; j < vstrs->as_usedptr; ++j)
-		bld_env_variables(&vtable, vstrs->as_string[j], NULL);
-
-	/* HOME */
-	bld_env_variables(&vtable, variables_else[0],
-		pjob->ji_grpcache->gc_homedir);
-
-	/* PBS_JOBNAME */
-	bld_env_variables(&vtable, variables_else[2],
-		pjob->ji_wattr[(int)JOB_ATR_jobname].at_val.at_str);
-
-	/* PBS_JOBID */
-	bld_env_variables(&vtable, variables_else[3], pjob->ji_qs.ji_jobid);
-
-	/* PBS_QUEUE */
-	bld_env_variables(&vtable, variables_else[4],
-		pjob->ji_wattr[(int)JOB_ATR_in_queue].at_val.at_str);
-
-	/* PBS_JOBCOOKIE */
-	bld_env_variables(&vtable, variables_else[7],
-		pjob->ji_wattr[(int)JOB_ATR_Cookie].at_val.at_str);
-
-	/* PBS_NODENUM */
-	sprintf(buf, "%d", pjob->ji_nodeid);
-	bld_env_variables(&vtable, variables_else[8], buf);
-
-	/* PBS_TASKNUM */
-	sprintf(buf, "%8.8X", ptask->ti_qs.ti_task);
-	bld_env_variables(&vtable, variables_else[9], buf);
-
-	/* PBS_MOMPORT */
-	sprintf(buf, "%d", pbs_rm_port);
-	bld_env_variables(&vtable, variables_else[10], buf);
-
-	/* OMP_NUM_THREADS and NCPUS eq to number of cpus */
-	sprintf(buf, "%d", pjob->ji_vnods[ptask->ti_qs.ti_myvnode].vn_threads);
-#ifdef NAS /* localmod 020 */
-	/* Force OMP_NUM_THREADS=1 on Columbia.
-	 * If you've ever seen a 256 process MPI program try to start 256
-	 * threads for each process, you'd know why.
-	 */
-	bld_env_variables(&vtable, variables_else[12], "1");
-#else
-	bld_env_variables(&vtable, variables_else[12], buf);
-#endif /* localmod 020 */
-	bld_env_variables(&vtable, "NCPUS", buf);
-
-	/* PBS_ACCOUNT */
-	if (pjob->ji_wattr[(int)JOB_ATR_account].at_flags & ATR_VFLAG_SET)
-		bld_env_variables(&vtable, variables_else[13],
-			pjob->ji_wattr[(int)JOB_ATR_account].at_val.at_str);
-
-	if (set_mach_vars(pjob, &vtable) != 0) {
-		/* never reaches here */
-	}
-
 	if (pjob->ji_wattr[(int)JOB_ATR_umask].at_flags & ATR_VFLAG_SET) {
 		sprintf(buf, "%ld", pjob->ji_wattr[(int)JOB_ATR_umask].
 			at_val.at_long);
@@ -4865,32 +5171,8 @@ start_process(task *ptask, char **argv, char **envp, bool nodemux)
 
 	mom_unnice();
 
-	/* set Environment to reflect batch */
-	bld_env_variables(&vtable, "PBS_ENVIRONMENT", "PBS_BATCH");
-	bld_env_variables(&vtable, "ENVIRONMENT", "BATCH");
-
-	for (i=0; envp[i]; i++)
-		bld_env_variables(&vtable, envp[i], NULL);
-
-	/* Add TMPDIR to environment */
-#ifdef NAS /* localmod 010 */
-	(void) NAS_tmpdirname(pjob);
-#endif /* localmod 010 */
-	j = mktmpdir(pjob->ji_qs.ji_jobid,
-		pjob->ji_qs.ji_un.ji_momt.ji_exuid,
-		pjob->ji_qs.ji_un.ji_momt.ji_exgid,
-		&vtable);
-	if (j != 0) {
+	if ((j = task_env_variables(ptask, envp, &vtable, pbs_jobdir, 1)) != 0)
 		starter_return(kid_write, kid_read, j, &sjr);
-	}
-
-	/* set PBS_JOBDIR */
-	if ((pjob->ji_wattr[(int)JOB_ATR_sandbox].at_flags & ATR_VFLAG_SET) &&
-		(strcasecmp(pjob->ji_wattr[JOB_ATR_sandbox].at_val.at_str, "PRIVATE") == 0)) {
-		bld_env_variables(&vtable, "PBS_JOBDIR", pbs_jobdir);
-	} else {
-		bld_env_variables(&vtable, "PBS_JOBDIR", pjob->ji_grpcache->gc_homedir);
-	}
 
 	j = set_job(pjob, &sjr);
 	if (j < 0) {
@@ -4906,7 +5188,7 @@ start_process(task *ptask, char **argv, char **envp, bool nodemux)
 			j = JOB_EXEC_RETRY;
 		starter_return(kid_write, kid_read, j, &sjr);
 	}
-	ptask->ti_qs.ti_sid = sjr.sj_session;
+	task_set_sid(ptask, sjr.sj_session);
 	if ((i = mom_set_limits(pjob, SET_LIMIT_SET)) != PBSE_NONE) {
 		(void)sprintf(log_buffer, "Unable to set limits, err=%d", i);
 		log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_JOB, LOG_WARNING,
@@ -4978,8 +5260,7 @@ start_process(task *ptask, char **argv, char **envp, bool nodemux)
 			}
 
 			/* clear the env array */
-			vtable.v_used = 0;
-			vtable.v_envp[0] = NULL;
+			reset_env_variables(&vtable);
 
 			/* need to also set vtable as that would */
 			/* get appended to later in the code */
@@ -6733,11 +7014,104 @@ open_std_file(job *pjob, enum job_file which, int mode, gid_t exgid)
 	return (fds);
 }
 
+/*
+ * The names in a var_table are indexed by an open addressing hash table of
+ * v_isize slots, a power of two, each holding the position of a variable in
+ * v_envp plus one, or 0 for an empty slot.  The index is built on the first
+ * lookup and kept at most half full.  If it cannot be allocated the table is
+ * searched linearly.
+ */
+#define ENV_INDEX_MIN	64
+
+/**
+ * @brief
+ *	env_name_hash - hash the name part of a "name=value" string
+ *
+ * @param[in]  pstr - the variable
+ * @param[out] plen - length of the name plus one for the '='
+ *
+ * @return	unsigned int
+ * @retval	the hash of the name
+ */
+static unsigned int
+env_name_hash(char *pstr, int *plen)
+{
+	unsigned int h = 2166136261U;
+	int	 i;
+
+	for (i = 0; (pstr[i] != '=') && (pstr[i] != '\0'); ++i) {
+		h ^= (unsigned char)pstr[i];
+		h *= 16777619U;
+	}
+	*plen = i + 1;
+	return h;
+}
+
+/**
+ * @brief
+ *	env_index_add - add the variable at a position in v_envp to the index
+ *
+ * @param[in] ptbl - var_table with an index that has room
+ * @param[in] slot - position of the variable in v_envp
+ *
+ * @return	void
+ */
+static void
+env_index_add(struct var_table *ptbl, int slot)
+{
+	unsigned int mask = ptbl->v_isize - 1;
+	unsigned int h;
+	int	 len;
+
+	h = env_name_hash(ptbl->v_envp[slot], &len) & mask;
+	while (ptbl->v_index[h] != 0)
+		h = (h + 1) & mask;
+	ptbl->v_index[h] = slot + 1;
+}
+
+/**
+ * @brief
+ *	env_index_build - (re)build the index of a var_table with room for
+ *	at least the given number of variables
+ *
+ * @param[in] ptbl - var_table
+ * @param[in] need - number of variables the index must hold
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	out of memory, the table has no index
+ */
+static int
+env_index_build(struct var_table *ptbl, int need)
+{
+	int	 size = ENV_INDEX_MIN;
+	int	*idx;
+	int	 i;
+
+	while (size < need * 2)
+		size *= 2;
+	idx = (int *)calloc(size, sizeof(int));
+	free(ptbl->v_index);
+	ptbl->v_index = idx;
+	if (idx == NULL) {
+		ptbl->v_isize = 0;
+		return (-1);
+	}
+	ptbl->v_isize = size;
+	for (i = 0; i < ptbl->v_used; ++i)
+		env_index_add(ptbl, i);
+	return (0);
+}
+
 /**
  * @brief
  * 	find_env_slot - find if the environment variable is already in the table,
  *	If so, replace the existing one with the new one.
  *
+ * @par
+ *	Makes sure the index has room for one more variable, which
+ *	bld_env_variables() adds when the variable is not found.
+ *
  * @param[in] ptbl - pointer to var_table which holds environment variable for job
  * @param[in] pstr - new environment variable
  *
@@ -6750,21 +7124,52 @@ open_std_file(job *pjob, enum job_file which, int mode, gid_t exgid)
 static int
 find_env_slot(struct var_table *ptbl, char *pstr)
 {
+	unsigned int mask;
+	unsigned int h;
 	int	 i;
-	int	 len = 1;	/* one extra for '=' */
+	int	 len;
 
 	if (pstr == NULL)
 		return (-1);
-	for (i=0; (*(pstr+i) != '=') && (*(pstr+i) != '\0'); ++i)
-		++len;
+	h = env_name_hash(pstr, &len);
+
+	if ((ptbl->v_index == NULL) || ((ptbl->v_used + 1) * 2 > ptbl->v_isize))
+		(void)env_index_build(ptbl, ptbl->v_used + 1);
+
+	if (ptbl->v_index == NULL) {
+		for (i=0; i<ptbl->v_used; ++i) {
+			if (strncmp(ptbl->v_envp[i], pstr, len) == 0)
+				return (i);
+		}
+		return (-1);
+	}
 
-	for (i=0; i<ptbl->v_used; ++i) {
-		if (strncmp(ptbl->v_envp[i], pstr, len) == 0)
-			return (i);
+	mask = ptbl->v_isize - 1;
+	for (h &= mask; (i = ptbl->v_index[h]) != 0; h = (h + 1) & mask) {
+		if ((i <= ptbl->v_used) &&
+			(strncmp(ptbl->v_envp[i - 1], pstr, len) == 0))
+			return (i - 1);
 	}
 	return (-1);
 }
 
+/**
+ * @brief
+ *	reset_env_variables - empty a var_table, keeping its allocations
+ *
+ * @param[in] vtable - variable table
+ *
+ * @return	void
+ */
+static void
+reset_env_variables(struct var_table *vtable)
+{
+	vtable->v_used = 0;
+	vtable->v_envp[0] = NULL;
+	if (vtable->v_index != NULL)
+		memset(vtable->v_index, 0, vtable->v_isize * sizeof(int));
+}
+
 /**
  * @brief
  *	bld_env_variables - Add an entry to the table that defines the environment variables for a job.
@@ -6836,6 +7241,8 @@ bld_env_variables(struct var_table *vtable, char *name, char *value)
 
 		*(vtable->v_envp + vtable->v_used++) = block;
 		*(vtable->v_envp + vtable->v_used) = NULL;
+		if (vtable->v_index != NULL)
+			env_index_add(vtable, vtable->v_used - 1);
 	} else {
 		/* free old value */
 		free(*(vtable->v_envp + i));
@@ -6843,6 +7250,209 @@ bld_env_variables(struct var_table *vtable, char *name, char *value)
 	}
 }
 
+/*
+ * The part of a job's environment that is the same for all of its tasks,
+ * the variables from the pbs_environment file followed by the job's
+ * Variable_List.  It is built in the MoM before the first fork for the job
+ * and the children copy it rather than adding every variable again.  It is
+ * rebuilt when either part changes.
+ */
+struct job_env {
+	struct var_table je_vtab;
+	int		 je_nenv;	/* num_var_env when built */
+	int		 je_nvars;	/* entries in Variable_List when built */
+	unsigned int	 je_sum;	/* hash of both parts when built */
+};
+
+/**
+ * @brief
+ *	job_env_sum - hash the variables that make up the common part of a
+ *	job's environment
+ *
+ * @param[in] pjob - the job
+ *
+ * @return	unsigned int
+ * @retval	the hash
+ */
+static unsigned int
+job_env_sum(job *pjob)
+{
+	struct array_strings *vstrs;
+	unsigned int h = 2166136261U;
+	char	*p;
+	int	 j;
+
+	for (j = 0; j < num_var_env; ++j) {
+		for (p = environ[j]; *p; ++p) {
+			h ^= (unsigned char)*p;
+			h *= 16777619U;
+		}
+		h *= 16777619U;		/* separator */
+	}
+	vstrs = pjob->ji_wattr[(int)JOB_ATR_variables].at_val.at_arst;
+	if (vstrs != NULL) {
+		for (j = 0; j < vstrs->as_usedptr; ++j) {
+			for (p = vstrs->as_string[j]; *p; ++p) {
+				h ^= (unsigned char)*p;
+				h *= 16777619U;
+			}
+			h *= 16777619U;
+		}
+	}
+	return h;
+}
+
+/**
+ * @brief
+ *	free_job_env - free the common environment of a job
+ *
+ * @param[in] pjob - the job
+ *
+ * @return	void
+ */
+void
+free_job_env(job *pjob)
+{
+	struct job_env *pje = pjob->ji_env;
+	int	 i;
+
+	if (pje == NULL)
+		return;
+	for (i = 0; i < pje->je_vtab.v_used; ++i)
+		free(pje->je_vtab.v_envp[i]);
+	free(pje->je_vtab.v_envp);
+	free(pje->je_vtab.v_index);
+	free(pje);
+	pjob->ji_env = NULL;
+}
+
+/**
+ * @brief
+ *	job_env_base - make sure the common environment of a job is current,
+ *	called in the MoM before forking a child that sets up the environment
+ *	with init_job_env()
+ *
+ * @par
+ *	If it cannot be built the job is left without one and the child
+ *	builds the environment itself.
+ *
+ * @param[in] pjob - the job
+ *
+ * @return	void
+ */
+static void
+job_env_base(job *pjob)
+{
+	struct job_env *pje = pjob->ji_env;
+	struct array_strings *vstrs;
+	unsigned int sum;
+	int	 nvars;
+	int	 j;
+
+	vstrs = pjob->ji_wattr[(int)JOB_ATR_variables].at_val.at_arst;
+	nvars = (vstrs != NULL) ? vstrs->as_usedptr : 0;
+	sum = job_env_sum(pjob);
+	if ((pje != NULL) && (pje->je_nenv == num_var_env) &&
+		(pje->je_nvars == nvars) && (pje->je_sum == sum))
+		return;
+
+	free_job_env(pjob);
+	if ((pje = (struct job_env *)calloc(1, sizeof(struct job_env))) == NULL)
+		return;
+	pje->je_vtab.v_ensize = nvars + num_var_env + 1;
+	pje->je_vtab.v_envp = (char **)malloc(pje->je_vtab.v_ensize *
+		sizeof(char *));
+	if (pje->je_vtab.v_envp == NULL) {
+		free(pje);
+		return;
+	}
+	pje->je_vtab.v_envp[0] = NULL;
+	pjob->ji_env = pje;
+
+	for (j = 0; j < num_var_env; ++j)
+		bld_env_variables(&pje->je_vtab, environ[j], NULL);
+	for (j = 0; j < nvars; ++j)
+		bld_env_variables(&pje->je_vtab, vstrs->as_string[j], NULL);
+
+	pje->je_nenv = num_var_env;
+	pje->je_nvars = nvars;
+	pje->je_sum = sum;
+}
+
+/**
+ * @brief
+ *	init_job_env - start the environment of a job's process with the
+ *	variables from the local environment and the ones passed with the job
+ *
+ * @par
+ *	Called in the child after job_env_base() was called in the MoM.  The
+ *	common environment is copied, the strings are shared with it as the
+ *	child has its own copy of them.  If the job has none the variables
+ *	are added one by one.
+ *
+ * @param[out] ptbl  - var_table to set up
+ * @param[in]  pjob  - the job
+ * @param[in]  extra - number of variables the caller is going to add
+ *		       besides those in variables_else[]
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	out of memory
+ */
+static int
+init_job_env(struct var_table *ptbl, job *pjob, int extra)
+{
+	struct job_env *pje = pjob->ji_env;
+	struct array_strings *vstrs;
+	int	 nvars;
+	int	 j;
+
+	ptbl->v_index = NULL;
+	ptbl->v_isize = 0;
+
+	if (pje != NULL) {
+		ptbl->v_ensize = pje->je_vtab.v_used + num_var_else + extra +
+			EXTRA_ENV_PTRS;
+		ptbl->v_envp = (char **)malloc(ptbl->v_ensize * sizeof(char *));
+		if (ptbl->v_envp == NULL)
+			return (-1);
+		memcpy(ptbl->v_envp, pje->je_vtab.v_envp,
+			(pje->je_vtab.v_used + 1) * sizeof(char *));
+		ptbl->v_used = pje->je_vtab.v_used;
+		if (pje->je_vtab.v_index != NULL) {
+			ptbl->v_index = (int *)malloc(pje->je_vtab.v_isize *
+				sizeof(int));
+			if (ptbl->v_index != NULL) {
+				memcpy(ptbl->v_index, pje->je_vtab.v_index,
+					pje->je_vtab.v_isize * sizeof(int));
+				ptbl->v_isize = pje->je_vtab.v_isize;
+			}
+		}
+		return (0);
+	}
+
+	vstrs = pjob->ji_wattr[(int)JOB_ATR_variables].at_val.at_arst;
+	nvars = (vstrs != NULL) ? vstrs->as_usedptr : 0;
+	ptbl->v_ensize = nvars + num_var_else + num_var_env + extra +
+		EXTRA_ENV_PTRS;
+	ptbl->v_used = 0;
+	ptbl->v_envp = (char **)malloc(ptbl->v_ensize * sizeof(char *));
+	if (ptbl->v_envp == NULL)
+		return (-1);
+	ptbl->v_envp[0] = NULL;
+
+	/* First variables from the local environment */
+	for (j = 0; j < num_var_env; ++j)
+		bld_env_variables(ptbl, environ[j], NULL);
+
+	/* Next, the variables passed with the job.  They may   */
+	/* be overwritten with new correct values for this job	*/
+	for (j = 0; j < nvars; ++j)
+		bld_env_variables(ptbl, vstrs->as_string[j], NULL);
+
+	return (0);
+}
+
 /**
  * @brief
  *	catchinter = catch death of writer child of interactive job
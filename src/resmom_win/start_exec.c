@@ -1277,7 +1277,7 @@ proc_bail(task *ptask)
  *	Logs the message if one is passed in.
  *	Sends IM_ABORT_JOB to the sisters.
  *	sets the job's substate to JOB_SUBSTATE_EXITING, sets the job's
- *	exit code and sets exiting_tasks so an obit is sent for the job.
+ *	exit code and queues it with mom_exiting_job() so an obit is sent.
  *	The job's standard out/err are closed and then resources are released.
  *
  * @param[in]	pjob - pointer to job structure
@@ -1310,7 +1310,7 @@ exec_bail(job *pjob, int code, char *txt)
 
 	pjob->ji_qs.ji_substate = JOB_SUBSTATE_EXITING;
 	pjob->ji_qs.ji_un.ji_momt.ji_exitstat = code;
-	exiting_tasks = 1;
+	mom_exiting_job(pjob);
 	proc_bail(ptask);
 	if (pjob->ji_hJob != NULL) {
 		CloseHandle(pjob->ji_hJob);
@@ -2596,7 +2596,7 @@ finish_exec(job *pjob)
 		return;
 	}
 	ptask->ti_hProc = pi.hProcess;
-	ptask->ti_qs.ti_sid = pi.dwProcessId;
+	task_set_sid(ptask, pi.dwProcessId);
 
 	/*
 	 **	Get the job going.
@@ -3285,7 +3285,7 @@ start_process(task *ptask, char **argv, char **envp, bool nodemux)
 		return PBSE_PERM;
 	}
 	ptask->ti_hProc = pi.hProcess;
-	ptask->ti_qs.ti_sid = pi.dwProcessId;
+	task_set_sid(ptask, pi.dwProcessId);
 #ifndef WIN32
 	if ((pjob->ji_numnodes > 1) && !no_stdio_sockets) {
 #endif
@@ -1464,7 +1464,7 @@ dep_attach_child(job *pjob, char *parentjobid, pid_t ppid)
 	ptask->ti_qs.ti_parentnode = TM_ERROR_NODE;
 	ptask->ti_qs.ti_myvnode = TM_ERROR_NODE;
 	ptask->ti_qs.ti_parenttask = TM_INIT_TASK;
-	ptask->ti_qs.ti_sid = ppid;
+	task_set_sid(ptask, ppid);
 	ptask->ti_hProc = hProcess;
 	ptask->ti_qs.ti_status = TI_STATE_RUNNING;
 	ptask->ti_flags |= TI_FLAGS_ORPHAN;
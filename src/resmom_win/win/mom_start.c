@@ -291,13 +291,13 @@ wait_action(void)
 		ptask->ti_hProc = NULL;
 		ptask->ti_qs.ti_exitstat = ecode;
 		ptask->ti_qs.ti_status = TI_STATE_EXITED;
-		ptask->ti_qs.ti_sid = 0;
+		task_set_sid(ptask, 0);
 		(void)task_save(ptask);
 		sprintf(log_buffer, "task %d terminated", ptask->ti_qs.ti_task);
 		log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_JOB, LOG_DEBUG,
 			pjob->ji_qs.ji_jobid, log_buffer);
 
-		exiting_tasks = 1;
+		mom_exiting_job(pjob);
 	}
 
 	connection_idlecheck();
@@ -745,6 +745,44 @@ node_can_fit_job_time(int node_ind, resource_resv *resresv)
 	return 1;
 }
 
+/**
+ * @brief take a node out of its node bucket.  This is done when a node
+ *	  becomes unusable in the middle of a cycle.  The node is no longer
+ *	  associated with a bucket, so running or ending jobs on it will not
+ *	  touch the bucket pools.
+ * @param[in] ninfo - the node
+ * @return void
+ */
+void
+remove_node_from_bucket(node_info *ninfo)
+{
+	node_bucket *bkt;
+	int ind;
+
+	if (ninfo == NULL || ninfo->node_ind == -1 || ninfo->bucket_ind == -1)
+		return;
+
+	bkt = ninfo->server->buckets[ninfo->bucket_ind];
+	ind = ninfo->node_ind;
+
+	if (pbs_bitmap_get_bit(bkt->free_pool->truth, ind)) {
+		pbs_bitmap_bit_off(bkt->free_pool->truth, ind);
+		bkt->free_pool->truth_ct--;
+	}
+	if (pbs_bitmap_get_bit(bkt->busy_later_pool->truth, ind)) {
+		pbs_bitmap_bit_off(bkt->busy_later_pool->truth, ind);
+		bkt->busy_later_pool->truth_ct--;
+	}
+	if (pbs_bitmap_get_bit(bkt->busy_pool->truth, ind)) {
+		pbs_bitmap_bit_off(bkt->busy_pool->truth, ind);
+		bkt->busy_pool->truth_ct--;
+	}
+	pbs_bitmap_bit_off(bkt->bkt_nodes, ind);
+	bkt->total--;
+
+	ninfo->bucket_ind = -1;
+}
+
 /**
  * @brief convert a chunk into an nspec for a job on a node
  * @param policy - policy info
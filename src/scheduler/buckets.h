@@ -71,6 +71,9 @@ nspec **bucket_to_nspecs(status *policy, chunk_map **cmap, resource_resv *resres
 /* can a job completely fit on a node before it is busy */
 int node_can_fit_job_time(int node_ind, resource_resv *resresv);
 
+/* take a node which can no longer be used out of its bucket */
+void remove_node_from_bucket(node_info *ninfo);
+
 /* bucket version of a = b */
 void set_working_bucket_to_truth(node_bucket *nb);
 void set_chkpt_bucket_to_working(node_bucket *nb);
@@ -103,6 +103,7 @@
 #include "resource.h"
 #include "buckets.h"
 #include "pbs_bitmap.h"
+#include "cycle_prof.h"
 
 
 /**
@@ -726,6 +727,7 @@ is_ok_to_run(status *policy, server_info *sinfo,
 	schd_error	*prev_err = NULL;
 	schd_error	*err;
 	resource_req	*resreq = NULL;
+	double		prof_start;		/* start of the node search */
 
 	if (sinfo == NULL || resresv == NULL || perr == NULL)
 		return NULL;
@@ -1070,10 +1072,12 @@ is_ok_to_run(status *policy, server_info *sinfo,
 	}
 
 
+	prof_start = prof_begin();
 	if (flags & USE_BUCKETS)
 		ns_arr = check_node_buckets(policy, sinfo, qinfo, resresv, err);
 	else 
 		ns_arr = check_nodes(policy, sinfo, qinfo, resresv, flags, err);
+	prof_end(PROF_NODE_SEARCH, prof_start);
 	
 	if (err->error_code != SUCCESS)
 		add_err(&prev_err, err);
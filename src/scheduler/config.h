@@ -56,6 +56,7 @@
 #define HOLIDAYS_FILE "holidays"
 #define RESGROUP_FILE "resource_group"
 #define DEDTIME_FILE "dedicated_time"
+#define CYCLE_STATS_FILE "cycle_stats"
 
 /* usage file "magic number" - needs to be 8 chars */
 #define USAGE_MAGIC "PBS_MAG!"
@@ -143,6 +144,8 @@
 #define PARSE_STRICT_ORDERING "strict_ordering"
 #define PARSE_RES_UNSET_INFINITE "resource_unset_infinite"
 #define PARSE_SELECT_PROVISION "provision_policy"
+#define PARSE_CYCLE_STATS "cycle_stats"
+#define PARSE_CYCLE_SLICE "cycle_slice"
 
 #ifdef NAS
 /* localmod 034 */
@@ -166,6 +169,7 @@
 #define PARSE_RESV_CONFIRM_IGNORE "resv_confirm_ignore"
 #define PARSE_ALLOW_AOE_CALENDAR "allow_aoe_calendar"
 #define PARSE_OPT_BACKFILL_FUZZY_TIME "opt_backfill_fuzzy_time"
+#define PARSE_DUMP_SNAPSHOT "dump_snapshot"
 
 /* deprecated */
 #define PARSE_SORT_BY "sort_by"
@@ -584,6 +584,18 @@ enum bucket_flags {
 	NO_PRINT_BUCKETS
 };
 
+/* phases of a scheduling cycle which are timed (see cycle_prof.c) */
+enum prof_phase {
+	PROF_CYCLE,		/* scheduling_cycle() */
+	PROF_QUERY,		/* query_server() */
+	PROF_SORT,		/* sort_jobs() */
+	PROF_NODE_SEARCH,	/* check_nodes() */
+	PROF_CALENDAR,		/* add_job_to_calendar() */
+	PROF_PREEMPT,		/* find_and_preempt_jobs() */
+	PROF_RUN,		/* run_update_resresv() */
+	PROF_NUM_PHASES
+};
+
 #ifdef	__cplusplus
 }
 #endif
@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 1994-2018 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * PBS Pro is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * For a copy of the commercial license terms and conditions,
+ * go to: (http://www.pbspro.com/UserArea/agreement.html)
+ * or contact the Altair Legal Department.
+ *
+ * Altair’s dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of PBS Pro and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair’s trademarks, including but not limited to "PBS™",
+ * "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's
+ * trademark licensing policies.
+ *
+ */
+
+/**
+ * @file    cycle_prof.c
+ *
+ * @brief
+ * 		Low overhead timers for the phases of a scheduling cycle.
+ *
+ * 		A phase is timed by reading the monotonic clock with prof_begin()
+ * 		before the call and handing the result to prof_end() after it.
+ * 		Phases nest (e.g. check_nodes() is called while adding a job to the
+ * 		calendar), so the time of each phase is inclusive of the phases
+ * 		called from it.
+ *
+ * 		If cycle_stats is set in the sched_config, the totals of every
+ * 		cycle are appended to sched_priv/cycle_stats as one line of JSON:
+ *
+ * 		{"sched":"default","time":1500000000,"iteration":42,
+ * 		 "phases":{"cycle":{"time":0.012345,"calls":1},...}}
+ *
+ * Functions included are:
+ * 	prof_begin()
+ * 	prof_end()
+ * 	prof_cycle_begin()
+ * 	prof_cycle_end()
+ * 	prof_phase_name()
+ * 	prof_write_stats()
+ *
+ */
+#include <pbs_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#ifndef WIN32
+#include <sys/time.h>
+#endif
+#include <log.h>
+#include "data_types.h"
+#include "constant.h"
+#include "globals.h"
+#include "cycle_prof.h"
+#include "pbs_json.h"
+
+phase_prof cycle_prof[PROF_NUM_PHASES];
+
+/* when the current cycle started */
+static double cycle_start;
+
+/* names of the phases - indexed by enum prof_phase */
+static char *prof_phase_names[PROF_NUM_PHASES] = {
+	"cycle",
+	"query",
+	"sort",
+	"node_search",
+	"calendar",
+	"preempt",
+	"run"
+};
+
+/**
+ * @brief
+ *		read the monotonic clock
+ *
+ * @return	double
+ * @retval	seconds since an arbitrary point in the past
+ */
+double
+prof_begin(void)
+{
+#if defined(CLOCK_MONOTONIC) && !defined(WIN32)
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+		return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+#endif
+	{
+		struct timeval tv;
+
+		gettimeofday(&tv, NULL);
+		return tv.tv_sec + tv.tv_usec / 1000000.0;
+	}
+}
+
+/**
+ * @brief
+ *		account the time since start to a phase
+ *
+ * @param[in]	phase	-	phase to account to
+ * @param[in]	start	-	value returned by prof_begin() when the phase started
+ *
+ * @return	nothing
+ */
+void
+prof_end(enum prof_phase phase, double start)
+{
+	double now;
+
+	if ((int) phase < 0 || phase >= PROF_NUM_PHASES)
+		return;
+
+	now = prof_begin();
+	if (now > start)
+		cycle_prof[phase].time += now - start;
+	cycle_prof[phase].calls++;
+}
+
+/**
+ * @brief
+ *		start profiling a new cycle: zero the per-phase totals and note
+ *		when the cycle started
+ *
+ * @return	nothing
+ */
+void
+prof_cycle_begin(void)
+{
+	memset(cycle_prof, 0, sizeof(cycle_prof));
+	cycle_start = prof_begin();
+}
+
+/**
+ * @brief
+ *		account the time since prof_cycle_begin() to the cycle
+ *
+ * @return	nothing
+ */
+void
+prof_cycle_end(void)
+{
+	prof_end(PROF_CYCLE, cycle_start);
+}
+
+/**
+ * @brief
+ *		name of a phase
+ *
+ * @param[in]	phase	-	the phase
+ *
+ * @return	char *
+ * @retval	name of the phase
+ * @retval	"unknown"	: phase is out of range
+ */
+char *
+prof_phase_name(enum prof_phase phase)
+{
+	if ((int) phase < 0 || phase >= PROF_NUM_PHASES)
+		return "unknown";
+
+	return prof_phase_names[phase];
+}
+
+/**
+ * @brief
+ *		append the totals of the cycle to a file as one line of JSON
+ *		The scheduler name is escaped since it comes from the server.
+ *
+ * @param[in]	file	-	file to append to
+ * @param[in]	cycle_time	-	the time of the cycle
+ * @param[in]	iteration	-	the scheduler's iteration count
+ *
+ * @return	int
+ * @retval	1	: success
+ * @retval	0	: failure
+ */
+int
+prof_write_stats(char *file, time_t cycle_time, unsigned long long iteration)
+{
+	FILE *fp;
+	char *name;
+	int i;
+	int rc = 1;
+
+	if (file == NULL)
+		return 0;
+
+	if ((name = strdup_escape(JSON_FULLESCAPE, sc_name == NULL ? "" : sc_name)) == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		return 0;
+	}
+
+	if ((fp = fopen(file, "a")) == NULL) {
+		log_err(errno, __func__, "Can not open cycle stats file");
+		free(name);
+		return 0;
+	}
+
+	fprintf(fp, "{\"sched\":\"%s\",\"time\":%ld,\"iteration\":%llu,\"phases\":{",
+		name, (long) cycle_time, iteration);
+	free(name);
+	for (i = 0; i < PROF_NUM_PHASES; i++)
+		fprintf(fp, "%s\"%s\":{\"time\":%.6f,\"calls\":%lu}", i == 0 ? "" : ",",
+			prof_phase_names[i], cycle_prof[i].time, cycle_prof[i].calls);
+	fprintf(fp, "}}\n");
+
+	if (fclose(fp) != 0) {
+		log_err(errno, __func__, "Can not write cycle stats file");
+		rc = 0;
+	}
+
+	return rc;
+}
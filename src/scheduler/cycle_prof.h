@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 1994-2018 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * PBS Pro is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * For a copy of the commercial license terms and conditions,
+ * go to: (http://www.pbspro.com/UserArea/agreement.html)
+ * or contact the Altair Legal Department.
+ *
+ * Altair’s dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of PBS Pro and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair’s trademarks, including but not limited to "PBS™",
+ * "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's
+ * trademark licensing policies.
+ *
+ */
+
+#ifndef	_CYCLE_PROF_H
+#define	_CYCLE_PROF_H
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "data_types.h"
+#include "constant.h"
+
+/* per-phase totals for the current cycle */
+extern phase_prof cycle_prof[PROF_NUM_PHASES];
+
+/* read the monotonic clock (in seconds) */
+double prof_begin(void);
+
+/* account the time since start to a phase */
+void prof_end(enum prof_phase phase, double start);
+
+/* start profiling a new cycle */
+void prof_cycle_begin(void);
+
+/* account the time since prof_cycle_begin() to the cycle */
+void prof_cycle_end(void);
+
+/* name of a phase */
+char *prof_phase_name(enum prof_phase phase);
+
+/* append the totals of the cycle to a file as a line of JSON */
+int prof_write_stats(char *file, time_t cycle_time, unsigned long long iteration);
+
+#ifdef	__cplusplus
+}
+#endif
+#endif	/* _CYCLE_PROF_H */
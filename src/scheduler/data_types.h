@@ -95,6 +95,10 @@ struct node_bucket;
 struct bucket_bitpool;
 struct chunk_map;
 struct node_bucket_count;
+struct node_bitmaps;
+struct res_bitmap;
+struct topjob_estimate;
+struct phase_prof;
 
 
 typedef struct state_count state_count;
@@ -130,6 +134,10 @@ typedef struct node_bucket node_bucket;
 typedef struct bucket_bitpool bucket_bitpool;
 typedef struct chunk_map chunk_map;
 typedef struct node_bucket_count node_bucket_count;
+typedef struct node_bitmaps node_bitmaps;
+typedef struct res_bitmap res_bitmap;
+typedef struct topjob_estimate topjob_estimate;
+typedef struct phase_prof phase_prof;
 
 #ifdef NAS
 /* localmod 034 */
@@ -368,6 +376,8 @@ struct server_info
 	resresv_set **equiv_classes;
 	node_bucket **buckets;		/* node bucket array */
 	node_info **unordered_nodes;
+	node_bitmaps *node_bits;	/* state and resource bitmaps indexed by node_ind */
+	unsigned long long config_fp;	/* fingerprint of server/queue configuration */
 #ifdef NAS
 	/* localmod 049 */
 	node_info **nodes_by_NASrank;	/* nodes indexed by NASrank */
@@ -1051,6 +1061,8 @@ struct config
 	unsigned resv_conf_ignore:1;  /* if we want to ignore dedicated time when confirming reservations.  Move to enum if ever expanded */
 	unsigned allow_aoe_calendar:1;        /* allow jobs requesting aoe in calendar*/
 	unsigned logstderr:1;               /* log to stderr as well as log file */
+	unsigned dump_snapshot:1;	/* write sched_priv/snapshot every cycle */
+	unsigned cycle_stats:1;		/* append phase timings to sched_priv/cycle_stats */
 #ifdef NAS /* localmod 034 */
 	unsigned prime_sto	:1;	/* shares_track_only--no enforce shares */
 	unsigned non_prime_sto:1;
@@ -1091,6 +1103,7 @@ struct config
 	char **ignore_res;			/* resources - unset implies infinite */
 	int num_res_to_check;			/* the size of res_to_check */
 	time_t max_starve;			/* starving threshold */
+	time_t cycle_slice;			/* refresh node states this often in a cycle */
 	int pprio[NUM_PPRIO][2];		/* premption priority levels */
 	int preempt_low;			/* lowest preemption level */
 	int preempt_normal;			/* preempt priority of normal_jobs */
@@ -1179,6 +1192,37 @@ struct chunk_map {
 	pbs_bitmap *node_bits;		/* assignment of nodes from buckets */
 };
 
+struct res_bitmap {
+	resdef *def;			/* non-consumable resource */
+	char *value;			/* requested value of the resource */
+	pbs_bitmap *nodes;		/* nodes which satisfy def=value */
+};
+
+/* bitmaps over sinfo->unordered_nodes (bit number is node_ind) */
+struct node_bitmaps {
+	int num_nodes;			/* number of nodes the bitmaps cover */
+	pbs_bitmap *free;		/* nodes in the free state */
+	pbs_bitmap *down;		/* nodes in the down state */
+	pbs_bitmap *offline;		/* nodes in the offline state */
+	pbs_bitmap *resv_exclusive;	/* nodes in the resv-exclusive state */
+	res_bitmap **res_bits;		/* per (resource, value) bitmaps, created on demand */
+};
+
+/* a top job's start time estimate kept across cycles */
+struct topjob_estimate {
+	unsigned int used:1;		/* estimate was looked up or stored this cycle */
+	char *name;			/* name of the job */
+	unsigned long long fp;		/* fingerprint of the state the estimate was made in */
+	time_t start;			/* estimated start time */
+	char *execvnode;		/* estimated execvnode */
+};
+
+/* time spent in and number of calls to a phase of the cycle */
+struct phase_prof {
+	double time;			/* seconds spent in the phase */
+	unsigned long calls;		/* number of times the phase was entered */
+};
+
 struct resresv_filter {
 	resource_resv *job;
 	schd_error *err;		/* reason why set can not run*/
@@ -114,6 +114,9 @@
 #include "limits_if.h"
 #include "pbs_version.h"
 #include "buckets.h"
+#include "topjob_cache.h"
+#include "snapshot.h"
+#include "cycle_prof.h"
 
 
 #ifdef NAS
@@ -124,6 +127,11 @@
 static prev_job_info *last_running = NULL;
 static int last_running_size = 0;
 
+/* qrun requests received on the secondary connection which could not be
+ * served inside the cycle that was running when they arrived
+ */
+static char **pending_qruns = NULL;
+
 #ifdef WIN32
 extern void win_toolong(void);
 #endif
@@ -162,6 +170,9 @@ schedinit(void)
 	init_config();
 	parse_config(CONFIG_FILE);
 
+	/* a new configuration can change any top job's start time estimate */
+	clear_topjob_estimates();
+
 	parse_holidays(HOLIDAYS_FILE);
 	time(&(cstat.current_time));
 
@@ -587,6 +598,32 @@ schedule(int cmd, int sd, char *runjobid)
 	return 0;
 }
 
+/**
+ * @brief
+ *		serve_pending_qruns - run a qrun cycle for each qrun request which
+ *		was sent on the secondary connection but could not be served
+ *		in the cycle it arrived in
+ *
+ * @param[in]	sd	-	connection descriptor to the pbs server
+ *
+ * @return	void
+ */
+static void
+serve_pending_qruns(int sd)
+{
+	char **qruns;
+	int i;
+
+	while (pending_qruns != NULL && !got_sigpipe) {
+		/* a qrun cycle may queue up more requests */
+		qruns = pending_qruns;
+		pending_qruns = NULL;
+		for (i = 0; qruns[i] != NULL && !got_sigpipe; i++)
+			scheduling_cycle(sd, qruns[i]);
+		free_string_array(qruns);
+	}
+}
+
 /**
  * @brief
  *		intermediate_schedule - responsible for starting/restarting scheduling
@@ -607,6 +644,9 @@ intermediate_schedule(int sd, char *jobid)
 	do {
 		ret = scheduling_cycle(sd, jobid);
 
+		/* serve the qrun requests which arrived during the cycle */
+		serve_pending_qruns(sd);
+
 		/* don't restart cycle if :- */
 
 		/* 1) qrun request, we don't want to keep trying same job */
@@ -631,6 +671,10 @@ intermediate_schedule(int sd, char *jobid)
 	}
 	while (ret == -1);
 
+	/* qrun requests sent while the last cycle was finishing up */
+	if (!got_sigpipe && check_second_connection(NULL, sd, NULL, NULL))
+		serve_pending_qruns(sd);
+
 	return 0;
 }
 
@@ -656,10 +700,13 @@ scheduling_cycle(int sd, char *jobid)
 	int error = 0;			/* error happened, don't run main loop */
 	status *policy;			/* policy structure used for cycle */
 	schd_error *err = NULL;
+	double prof_start;		/* start of the query */
 
 	schdlog(PBSEVENT_DEBUG, PBS_EVENTCLASS_REQUEST, LOG_DEBUG,
 		"", "Starting Scheduling Cycle");
 
+	prof_cycle_begin();
+
 	update_cycle_status(&cstat, 0);
 
 #ifdef NAS /* localmod 030 */
@@ -667,7 +714,10 @@ scheduling_cycle(int sd, char *jobid)
 	do_hard_cycle_interrupt = 0;
 #endif /* localmod 030 */
 	/* create the server / queue / job / node structures */
-	if ((sinfo = query_server(&cstat, sd)) == NULL) {
+	prof_start = prof_begin();
+	sinfo = query_server(&cstat, sd);
+	prof_end(PROF_QUERY, prof_start);
+	if (sinfo == NULL) {
 		schdlog(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, LOG_NOTICE,
 			"", "Problem with creating server data structure");
 		end_cycle_tasks(sinfo);
@@ -735,47 +785,8 @@ scheduling_cycle(int sd, char *jobid)
 	if (error == 0)
 		rc = main_sched_loop(policy, sd, sinfo, &err);
 
-	if (jobid != NULL) {
-		int def_rc = -1;
-		int i;
-
-		for (i = 0; i < MAX_DEF_REPLY && def_rc != 0; i++) {
-			/* smooth sailing, the job ran */
-			if (rc == SUCCESS)
-				def_rc = pbs_defschreply(sd, SCH_SCHEDULE_AJOB, jobid, 0, NULL, NULL);
-
-			/* we thought the job should run, but the server had other ideas */
-			else {
-				if (err != NULL) {
-					translate_fail_code(err, NULL, log_msg);
-					if (err->error_code < RET_BASE) {
-						error = err->error_code;
-					} else {
-						/* everything else... unfortunately our ret codes don't nicely match up to
-						 * the rest of PBS's PBSE codes, so we return resources unavailable.  This
-						 * doesn't really matter, because we're returning a message
-						 */
-						error = PBSE_RESCUNAV;
-					}
-				} else
-					error = PBSE_RESCUNAV;
-				def_rc = pbs_defschreply(sd, SCH_SCHEDULE_AJOB, jobid, error, log_msg, NULL);
-			}
-			if (def_rc != 0) {
-				char *pbs_errmsg;
-				pbs_errmsg = pbs_geterrmsg(sd);
-
-				snprintf(log_msg, sizeof(log_msg), "Error in deferred reply: %s",
-					pbs_errmsg == NULL ? "" : pbs_errmsg);
-				schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_SCHED, LOG_WARNING,
-					jobid, log_msg);
-			}
-		}
-		if (i == MAX_DEF_REPLY && def_rc != 0) {
-			schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_SCHED, LOG_WARNING,
-				jobid, "Max deferred reply count reached; giving up.");
-		}
-	}
+	if (jobid != NULL)
+		send_qrun_reply(sd, jobid, rc, err, log_msg);
 
 #ifdef NAS
 	/* localmod 064 */
@@ -792,6 +803,210 @@ scheduling_cycle(int sd, char *jobid)
 	return 0;
 }
 
+/**
+ * @brief
+ *		send the deferred reply for a qrun request to the server
+ *
+ * @param[in]	sd	-	connection descriptor to the pbs server
+ * @param[in]	jobid	-	job the qrun request was for
+ * @param[in]	rc	-	SUCCESS if the job was run
+ * @param[in]	err	-	why the job did not run (may be NULL)
+ * @param[in,out] log_msg -	message to send if err is NULL; buffer of
+ *				MAX_LOG_SIZE
+ *
+ * @return	void
+ */
+void
+send_qrun_reply(int sd, char *jobid, int rc, schd_error *err, char *log_msg)
+{
+	int def_rc = -1;
+	int error;
+	int i;
+	char buf[MAX_LOG_SIZE];
+
+	for (i = 0; i < MAX_DEF_REPLY && def_rc != 0; i++) {
+		/* smooth sailing, the job ran */
+		if (rc == SUCCESS)
+			def_rc = pbs_defschreply(sd, SCH_SCHEDULE_AJOB, jobid, 0, NULL, NULL);
+
+		/* we thought the job should run, but the server had other ideas */
+		else {
+			if (err != NULL) {
+				translate_fail_code(err, NULL, log_msg);
+				if (err->error_code < RET_BASE) {
+					error = err->error_code;
+				} else {
+					/* everything else... unfortunately our ret codes don't nicely match up to
+					 * the rest of PBS's PBSE codes, so we return resources unavailable.  This
+					 * doesn't really matter, because we're returning a message
+					 */
+					error = PBSE_RESCUNAV;
+				}
+			} else
+				error = PBSE_RESCUNAV;
+			def_rc = pbs_defschreply(sd, SCH_SCHEDULE_AJOB, jobid, error, log_msg, NULL);
+		}
+		if (def_rc != 0) {
+			char *pbs_errmsg;
+			pbs_errmsg = pbs_geterrmsg(sd);
+
+			snprintf(buf, sizeof(buf), "Error in deferred reply: %s",
+				pbs_errmsg == NULL ? "" : pbs_errmsg);
+			schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_SCHED, LOG_WARNING,
+				jobid, buf);
+		}
+	}
+	if (i == MAX_DEF_REPLY && def_rc != 0) {
+		schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_SCHED, LOG_WARNING,
+			jobid, "Max deferred reply count reached; giving up.");
+	}
+}
+
+/**
+ * @brief
+ *		serve a qrun request inside the running scheduling cycle.  This
+ *		is only done for a queued non-array job which can run right now
+ *		on the universe we already have.  Everything else (subjobs, held
+ *		jobs, jobs which need preemption) is left to a qrun cycle of
+ *		its own.
+ *
+ * @param[in]	policy	-	policy info
+ * @param[in]	sd	-	connection descriptor to the pbs server
+ * @param[in]	sinfo	-	pbs universe of the running cycle
+ * @param[in]	jobid	-	job to run for the qrun request
+ * @param[out]	sort_again -	set if the job list needs to be resorted
+ *
+ * @return	int
+ * @retval	1	: the request was served (a reply was sent)
+ * @retval	0	: the request needs a qrun cycle of its own
+ */
+int
+serve_qrun_request(status *policy, int sd, server_info *sinfo, char *jobid, int *sort_again)
+{
+	resource_resv *qjob;
+	nspec **ns_arr;
+	schd_error *err;
+	unsigned int flags = IGNORE_EQUIV_CLASS;
+	char log_msg[MAX_LOG_SIZE];
+	double prof_start;
+	int can_not_run;
+	int rc;
+
+	if (policy == NULL || sinfo == NULL || jobid == NULL || sort_again == NULL)
+		return 0;
+
+	if (is_job_array(jobid) != 0 || sinfo->qrun_job != NULL)
+		return 0;
+
+	qjob = find_resource_resv(sinfo->jobs, jobid);
+	if (qjob == NULL || qjob->job == NULL || !qjob->job->is_queued)
+		return 0;
+
+	err = new_schd_error();
+	if (err == NULL)
+		return 0;
+
+	schdlog(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, LOG_INFO,
+		jobid, "Received qrun request");
+
+	can_not_run = qjob->can_not_run;
+	qjob->can_not_run = 0;
+	sinfo->qrun_job = qjob;
+
+	if (job_should_use_buckets(qjob))
+		flags |= USE_BUCKETS;
+
+	if (qjob->is_shrink_to_fit)
+		ns_arr = is_ok_to_run_STF(policy, sinfo, qjob->job->queue, qjob, flags, err, shrink_job_algorithm);
+	else
+		ns_arr = is_ok_to_run(policy, sinfo, qjob->job->queue, qjob, flags, err);
+
+	if (ns_arr == NULL) {
+		schdlog(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_DEBUG, jobid,
+			"Job can not run in the current cycle, deferring qrun request");
+		qjob->can_not_run = can_not_run;
+		sinfo->qrun_job = NULL;
+		free_schd_error(err);
+		return 0;
+	}
+
+	prof_start = prof_begin();
+	rc = run_update_resresv(policy, sd, sinfo, qjob->job->queue, qjob, ns_arr, RURR_ADD_END_EVENT, err);
+	prof_end(PROF_RUN, prof_start);
+	sinfo->qrun_job = NULL;
+
+	log_msg[0] = '\0';
+	if (rc > 0) {
+		send_qrun_reply(sd, jobid, SUCCESS, err, log_msg);
+		/* do not downgrade a resort the main loop already requires */
+		if (*sort_again != MUST_RESORT_JOBS)
+			*sort_again = MAY_RESORT_JOBS;
+	} else {
+		qjob->can_not_run = 1;
+		send_qrun_reply(sd, jobid, RUN_FAILURE, err, log_msg);
+	}
+	send_job_updates(sd, qjob);
+
+	free_schd_error(err);
+	return 1;
+}
+
+/**
+ * @brief
+ *		handle the commands the server sent on the secondary connection
+ *		while the cycle was running.  A request to restart the cycle ends
+ *		it.  A qrun request is served right away if the job can run in
+ *		the current universe, otherwise it is queued up and the cycle is
+ *		ended so it can be served as soon as possible.
+ *
+ * @param[in]	policy	-	policy info (NULL if no cycle is running)
+ * @param[in]	sd	-	connection descriptor to the pbs server
+ * @param[in]	sinfo	-	pbs universe of the running cycle (may be NULL)
+ * @param[out]	sort_again -	set if the job list needs to be resorted
+ *
+ * @return	int
+ * @retval	1	: the cycle should end
+ * @retval	0	: carry on
+ */
+int
+check_second_connection(status *policy, int sd, server_info *sinfo, int *sort_again)
+{
+	int cmd;
+	char *jid;
+	int end_cycle = 0;
+
+	if (second_connection == -1)
+		return 0;
+
+	for (;;) {
+		jid = NULL;
+		/* get_sched_cmd_noblk() located in file get_4byte.c */
+		if (get_sched_cmd_noblk(second_connection, &cmd, &jid) != 1)
+			break;
+
+		if (cmd == SCH_SCHEDULE_RESTART_CYCLE) {
+			schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_SCHED, LOG_WARNING,
+				"", "Leaving scheduling cycle as requested by server.");
+			end_cycle = 1;
+		} else if (cmd == SCH_SCHEDULE_AJOB && jid != NULL) {
+			if (!serve_qrun_request(policy, sd, sinfo, jid, sort_again)) {
+				if (add_str_to_array(&pending_qruns, jid) == -1)
+					log_err(errno, __func__, MEM_ERR_MSG);
+				else {
+					if (sinfo != NULL)
+						schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_JOB, LOG_INFO,
+							jid, "Leaving scheduling cycle to serve qrun request");
+					end_cycle = 1;
+				}
+			}
+		}
+		if (jid != NULL)
+			free(jid);
+	}
+
+	return end_cycle;
+}
+
 /**
  * @brief
  * 		the main scheduler loop
@@ -829,10 +1044,13 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 	time_t cur_time;		/* the current time via time() */
 	nspec **ns_arr = NULL;		/* node solution for job */
 	int i;
-	int cmd;
+	time_t slice_end_time;		/* when to refresh the node states next */
 	int sort_again = DONT_SORT_JOBS;
 	schd_error *err;
 	schd_error *chk_lim_err;
+	double prof_start;		/* start of a timed phase */
+	int run_rc;			/* return code of run_update_resresv() */
+	int preempt_rc;			/* return code of find_and_preempt_jobs() */
 	
 
 	if (policy == NULL || sinfo == NULL || rerr == NULL)
@@ -841,6 +1059,7 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 	time(&cycle_start_time);
 	/* calculate the time which we've been in the cycle too long */
 	cycle_end_time = cycle_start_time + sinfo->sched_cycle_len;
+	slice_end_time = cycle_start_time + conf.cycle_slice;
 
 	chk_lim_err = new_schd_error();
 	if(chk_lim_err == NULL)
@@ -906,7 +1125,10 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 				tj = njob;
 
 			if (rc != SCHD_ERROR) {
-				if(run_update_resresv(policy, sd, sinfo, qinfo, tj, ns_arr, RURR_ADD_END_EVENT, err) > 0 ) {
+				prof_start = prof_begin();
+				run_rc = run_update_resresv(policy, sd, sinfo, qinfo, tj, ns_arr, RURR_ADD_END_EVENT, err);
+				prof_end(PROF_RUN, prof_start);
+				if (run_rc > 0) {
 					rc = SUCCESS;
 					sort_again = MAY_RESORT_JOBS;
 				} else {
@@ -920,7 +1142,10 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 				free_nspecs(ns_arr);
 		}
 		else if (policy->preempting && in_runnable_state(njob) && (!njob -> can_never_run)) {
-			if (find_and_preempt_jobs(policy, sd, njob, sinfo, err) > 0) {
+			prof_start = prof_begin();
+			preempt_rc = find_and_preempt_jobs(policy, sd, njob, sinfo, err);
+			prof_end(PROF_PREEMPT, prof_start);
+			if (preempt_rc > 0) {
 				rc = SUCCESS;
 				sort_again = MUST_RESORT_JOBS;
 			}
@@ -954,7 +1179,9 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 			sort_again = SORTED;
 			if (should_backfill_with_job(policy, sinfo, njob, num_topjobs) != 0) {
 #endif
+				prof_start = prof_begin();
 				cal_rc = add_job_to_calendar(sd, policy, sinfo, njob, should_use_buckets);
+				prof_end(PROF_CALENDAR, prof_start);
 
 				if (cal_rc > 0) { /* Success! */
 #ifdef NAS /* localmod 034 */
@@ -1080,20 +1307,18 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 			schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_JOB, LOG_INFO, "", buf);
 		}
 
-		if (!end_cycle) {
-			if (second_connection != -1) {
-				char *jid = NULL;
+		if (!end_cycle && check_second_connection(policy, sd, sinfo, &sort_again)) {
+			end_cycle = 1;
+			/* restart the cycle once the qrun requests have been served */
+			if (pending_qruns != NULL && sinfo->qrun_job == NULL)
+				rc = -1;
+		}
 
-				/* get_sched_cmd_noblk() located in file get_4byte.c */
-				if ((get_sched_cmd_noblk(second_connection, &cmd, &jid) == 1) &&
-					(cmd == SCH_SCHEDULE_RESTART_CYCLE)) {
-					schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_JOB, LOG_WARNING,
-						njob->name, "Leaving scheduling cycle as requested by server.");
-					end_cycle = 1;
-				}
-				if (jid != NULL)
-					free(jid);
-			}
+		if (!end_cycle && conf.cycle_slice > 0 && cur_time >= slice_end_time &&
+			sinfo->qrun_job == NULL) {
+			/* pick up nodes which went away while we were busy */
+			refresh_node_states(sd, sinfo);
+			slice_end_time = cur_time + conf.cycle_slice;
 		}
 
 #ifdef NAS /* localmod 030 */
@@ -1129,10 +1354,20 @@ end_cycle_tasks(server_info *sinfo)
 {
 	int i;
 
+	prof_cycle_end();
+	if (conf.cycle_stats)
+		prof_write_stats(CYCLE_STATS_FILE, cstat.current_time, cstat.iteration);
+
 	/* keep track of update used resources for fairshare */
 	if (sinfo != NULL && sinfo->policy->fair_share)
 		update_last_running(sinfo);
 
+	/* forget the estimates of jobs which are no longer top jobs */
+	prune_topjob_estimates();
+
+	/* finish writing the snapshot of this cycle if we are dumping one */
+	snapshot_end();
+
 	/* we copied in conf.fairshare into sinfo at the start of the cycle,
 	 * we don't want to free it now, or we'd lose all fairshare data
 	 */
@@ -1508,8 +1743,12 @@ run_update_resresv(status *policy, int pbs_sd, server_info *sinfo,
 		else if (ns_arr != NULL)
 			ns = ns_arr;
 		/* 3) calculate where to run the resresv ourselves */
-		else
+		else {
+			double prof_start = prof_begin();
+
 			ns = check_nodes(policy, sinfo, qinfo, rr, eval_flags, err);
+			prof_end(PROF_NODE_SEARCH, prof_start);
+		}
 
 		if (ns != NULL) {
 #ifdef RESC_SPEC /* Hack to make rescspec work with new select code */
@@ -1740,6 +1979,8 @@ sim_run_update_resresv(status *policy, resource_resv *resresv, nspec **ns_arr, u
 	server_info *sinfo = NULL;
 	queue_info *qinfo = NULL;
 	static schd_error *err = NULL;
+	double prof_start;
+	int ret;
 
 	if(err == NULL)
 		err = new_schd_error();
@@ -1756,8 +1997,12 @@ sim_run_update_resresv(status *policy, resource_resv *resresv, nspec **ns_arr, u
 
 	clear_schd_error(err);
 
-	return run_update_resresv(policy, SIMULATE_SD, sinfo, qinfo,
+	prof_start = prof_begin();
+	ret = run_update_resresv(policy, SIMULATE_SD, sinfo, qinfo,
 		resresv, ns_arr, flags | RURR_NOPRINT, err);
+	prof_end(PROF_RUN, prof_start);
+
+	return ret;
 
 }
 
@@ -1881,6 +2126,8 @@ add_job_to_calendar(int pbs_sd, status *policy, server_info *sinfo,
 	timed_event *nexte;
 	char log_buf[MAX_LOG_SIZE];
 	int i;
+	unsigned long long fp;		/* fingerprint of the state the estimate is made in */
+	topjob_estimate *est;		/* estimate from a previous cycle */
 
 	if (policy == NULL || sinfo == NULL ||
 		topjob == NULL || topjob->job == NULL)
@@ -1894,27 +2141,41 @@ add_job_to_calendar(int pbs_sd, status *policy, server_info *sinfo,
 		if (find_timed_event(nexte, topjob->name, TIMED_NOEVENT, 0) != NULL)
 			return 1;
 	}
-	if ((nsinfo = dup_server_info(sinfo)) == NULL)
-		return 0;
 
-	if ((njob = find_resource_resv_by_indrank(nsinfo->jobs, topjob->rank, topjob->resresv_ind)) == NULL) {
-		free_server(nsinfo, 1);
-		return 0;
-	}
+	/* If nothing the estimate depends on has changed since a previous cycle,
+	 * the simulation would come up with the same answer.  Reuse it.
+	 */
+	fp = topjob_fingerprint(sinfo, topjob);
+	est = find_topjob_estimate(topjob->name, fp, sinfo->server_time);
+	if (est != NULL) {
+		nsinfo = NULL;
+		njob = NULL;
+		start_time = est->start;
+		schdlog(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_DEBUG,
+			topjob->name, "Reusing the start time estimate from a previous cycle.");
+	} else {
+		if ((nsinfo = dup_server_info(sinfo)) == NULL)
+			return 0;
+
+		if ((njob = find_resource_resv_by_indrank(nsinfo->jobs, topjob->rank, topjob->resresv_ind)) == NULL) {
+			free_server(nsinfo, 1);
+			return 0;
+		}
+
 
-	
 #ifdef NAS /* localmod 031 */
-	snprintf(log_buf, sizeof(log_buf), "Estimating the start time for a top job (q=%s schedselect=%.1000s).", topjob->job->queue->name, topjob->job->schedsel);
-	schdlog(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_DEBUG,
-		topjob->name, log_buf);
+		snprintf(log_buf, sizeof(log_buf), "Estimating the start time for a top job (q=%s schedselect=%.1000s).", topjob->job->queue->name, topjob->job->schedsel);
+		schdlog(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_DEBUG,
+			topjob->name, log_buf);
 #else
-	schdlog(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_DEBUG,
-		topjob->name, "Estimating the start time for a top job.");
+		schdlog(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_DEBUG,
+			topjob->name, "Estimating the start time for a top job.");
 #endif /* localmod 031 */
-	if(use_buckets)
-		start_time = calc_run_time(njob->name, nsinfo, SIM_RUN_JOB|USE_BUCKETS);
-	else
-		start_time = calc_run_time(njob->name, nsinfo, SIM_RUN_JOB);
+		if(use_buckets)
+			start_time = calc_run_time(njob->name, nsinfo, SIM_RUN_JOB|USE_BUCKETS);
+		else
+			start_time = calc_run_time(njob->name, nsinfo, SIM_RUN_JOB);
+	}
 
 	if (start_time > 0) {
 		/* If our top job is a job array, we don't backfill around the
@@ -1930,8 +2191,9 @@ add_job_to_calendar(int pbs_sd, status *policy, server_info *sinfo,
 			}
 
 			/* Can't search by rank, we just created tjob and it has a new rank*/
-			njob = find_resource_resv(nsinfo->jobs, tjob->name);
-			if (njob == NULL) {
+			if (nsinfo != NULL)
+				njob = find_resource_resv(nsinfo->jobs, tjob->name);
+			if (nsinfo != NULL && njob == NULL) {
 				schdlog(PBSEVENT_DEBUG, PBS_EVENTCLASS_JOB, LOG_DEBUG, __func__,
 					"Can't find new subjob in simulated universe");
 				free_server(nsinfo, 1);
@@ -1945,7 +2207,12 @@ add_job_to_calendar(int pbs_sd, status *policy, server_info *sinfo,
 
 
 
-		exec = create_execvnode(njob->nspec_arr);
+		if (est != NULL)
+			exec = est->execvnode;
+		else {
+			exec = create_execvnode(njob->nspec_arr);
+			store_topjob_estimate(topjob->name, fp, start_time, exec);
+		}
 		if (exec != NULL) {
 #ifdef NAS /* localmod 068 */
 			/* debug dpr - Log vnodes reserved for job */
@@ -1954,7 +2221,7 @@ add_job_to_calendar(int pbs_sd, status *policy, server_info *sinfo,
 			printf("%04d-%02d-%02d %02d:%02d:%02d %s %s %s\n",
 				ptm->tm_year+1900, ptm->tm_mon+1, ptm->tm_mday,
 				ptm->tm_hour, ptm->tm_min, ptm->tm_sec,
-				"Backfill", njob->name, exec);
+				"Backfill", bjob->name, exec);
 #endif /* localmod 068 */
 			if (bjob->nspec_arr != NULL)
 				free_nspecs(bjob->nspec_arr);
@@ -2012,7 +2279,7 @@ add_job_to_calendar(int pbs_sd, status *policy, server_info *sinfo,
 			int ind = bjob->nspec_arr[i]->ninfo->node_ind;
 			add_te_list(&(bjob->nspec_arr[i]->ninfo->node_events), te_start);
 
-			if (ind != -1) {
+			if (ind != -1 && sinfo->unordered_nodes[ind]->bucket_ind != -1) {
 				node_bucket *bkt;
 
 				bkt = sinfo->buckets[sinfo->unordered_nodes[ind]->bucket_ind];
@@ -212,6 +212,27 @@ void update_cycle_status(struct status *policy, time_t current_time);
  */
 int main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr);
 
+/*
+ *	send_qrun_reply - send the deferred reply for a qrun request
+ */
+void send_qrun_reply(int sd, char *jobid, int rc, schd_error *err, char *log_msg);
+
+/*
+ *	serve_qrun_request - try to run a qrun job inside the current
+ *			     scheduling cycle
+ *
+ *	return 1 if the request was served, 0 if a new cycle is needed
+ */
+int serve_qrun_request(status *policy, int sd, server_info *sinfo, char *jobid, int *sort_again);
+
+/*
+ *	check_second_connection - handle commands the server sent on the
+ *				  secondary connection while we were busy
+ *
+ *	return 1 if the cycle should end, 0 otherwise
+ */
+int check_second_connection(status *policy, int sd, server_info *sinfo, int *sort_again);
+
 /*
  *
  *	scheduler_simulation_task - offline simulation task to calculate
@@ -123,6 +123,8 @@
 #include "resource.h"
 #include "server_info.h"
 #include "attribute.h"
+#include "snapshot.h"
+#include "cycle_prof.h"
 
 #ifdef NAS
 #include "site_code.h"
@@ -580,11 +582,14 @@ query_jobs(status *policy, int pbs_sd, queue_info *qinfo, resource_resv **pjobs,
 			errmsg = pbs_geterrmsg(pbs_sd);
 			if (errmsg == NULL)
 				errmsg = "";
-			sprintf(log_buffer, "pbs_selstat failed: %s (%d)", errmsg, pbs_errno);
-			schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_JOB, LOG_NOTICE, "job_info", log_buffer);
+			schdlogf(PBSEVENT_SCHED, PBS_EVENTCLASS_JOB, LOG_NOTICE, "job_info",
+				"pbs_selstat failed: %s (%d)", errmsg, pbs_errno);
 		}
 		return pjobs;
 	}
+	/* jobs from peer servers are not replayable */
+	if (!qinfo->is_peer_queue)
+		snapshot_add(SNAPSHOT_JOBS, jobs);
 
 	/* count the number of new jobs */
 	cur_job = jobs;
@@ -2536,8 +2541,8 @@ create_resresv_sets(status *policy, server_info *sinfo)
 		rsets = tmp_rset_arr;
 
 	if (i > 0) {
-		snprintf(log_buffer, sizeof(log_buffer), "Number of job equivalence classes: %d", i);
-		schdlog(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__, log_buffer);
+		schdlogf(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__,
+			"Number of job equivalence classes: %d", i);
 	}
 
 	return rsets;
@@ -2942,6 +2947,8 @@ find_and_preempt_jobs(status *policy, int pbs_sd, resource_resv *hjob, server_in
 	int *fail_list = NULL;
 	int fail_count=0;
 	int num_tries=0;
+	int rerun_rc;
+	double prof_start;
 
 	/* jobs with AOE cannot preempt (atleast for now) */
 	if (hjob->aoename != NULL)
@@ -2988,7 +2995,9 @@ find_and_preempt_jobs(status *policy, int pbs_sd, resource_resv *hjob, server_in
 
 	if (done) {
 		clear_schd_error(err);
+		prof_start = prof_begin();
 		ret = run_update_resresv(policy, pbs_sd, sinfo, hjob->job->queue, hjob, NULL, RURR_ADD_END_EVENT, err);
+		prof_end(PROF_RUN, prof_start);
 
 		/* oops... we screwed up.. the high priority job didn't run.  Forget about
 		 * running it now and resume preempted work
@@ -3007,7 +3016,10 @@ find_and_preempt_jobs(status *policy, int pbs_sd, resource_resv *hjob, server_in
 				job = find_resource_resv_by_indrank(sinfo->jobs, preempted_list[i], -1);
 				if (job != NULL && !job->job->is_running) {
 					clear_schd_error(serr);
-					if (run_update_resresv(policy, pbs_sd, sinfo, job->job->queue, job, NULL, RURR_NO_FLAGS, serr) == 0) {
+					prof_start = prof_begin();
+					rerun_rc = run_update_resresv(policy, pbs_sd, sinfo, job->job->queue, job, NULL, RURR_NO_FLAGS, serr);
+					prof_end(PROF_RUN, prof_start);
+					if (rerun_rc == 0) {
 						schdlogerr(PBSEVENT_DEBUG, PBS_EVENTCLASS_JOB, LOG_DEBUG, job->name, "Failed to rerun job:", serr);
 					}
 				}
@@ -3228,9 +3240,9 @@ find_jobs_to_preempt(status *policy, resource_resv *hjob, server_info *sinfo, in
 		rjobs = prjobs;
 		rjobs_count = count_array((void **)prjobs);
 		if (rjobs_count > 0) {
-			sprintf(log_buf, "Limited running jobs used for preemption from %d to %d",
+			schdlogf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_DEBUG, nhjob->name,
+				"Limited running jobs used for preemption from %d to %d",
 				nsinfo->sc.running, rjobs_count);
-			schdlog(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_DEBUG, nhjob->name, log_buf);
 		}
 		else {
 			sprintf(log_buf, "Limited running jobs used for preemption from %d to 0: No jobs to preempt",
@@ -4118,7 +4130,6 @@ formula_evaluate(char *formula, resource_resv *resresv, resource_req *resreq)
 	char buf[1024];
 	char *globals;
 	int globals_size = 1024;  /* initial size... will grow if needed */
-	char errbuf[MAX_LOG_SIZE];
 	resource_req *req;
 	sch_resource_t ans = 0;
 	char *str;
@@ -4219,11 +4230,10 @@ formula_evaluate(char *formula, resource_resv *resresv, resource_req *resreq)
 		str = PyString_AsString(obj);
 		if (str != NULL) {
 			if (strlen(str) > 0) { /* exception happened */
-				sprintf(errbuf,
+				schdlogf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_DEBUG,
+					resresv->name,
 					"Formula evaluation for job had an error.  Zero value will be used: %s",
 					str);
-				schdlog(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_DEBUG,
-					resresv->name, errbuf);
 				ans = 0;
 			}
 		}
@@ -50,6 +50,7 @@
  * 		res_to_num()
  * 		skip_line()
  * 		schdlog()
+ * 		schdlogf()
  * 		schdlogerr()
  * 		filter_array()
  * 		dup_string_array()
@@ -88,6 +89,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <time.h>
 #include <ctype.h>
 #include <string.h>
@@ -419,6 +421,36 @@ schdlog(int event, int class, int sev, const char *name, const char *text)
 	}
 }
 
+/**
+ * @brief
+ *		schdlogf - format a log entry and write it with schdlog().
+ *		Nothing is formatted if the event is filtered out.
+ *
+ * @param[in] event	-	the event type
+ * @param[in] class	-	the event class
+ * @param[in] sev   -	the severity of the log message
+ * @param[in] name  -	the name of the object
+ * @param[in] fmt   -	printf style format of the message
+ * @param[in] ...   -	arguments for fmt
+ *
+ * @return nothing
+ */
+
+void
+schdlogf(int event, int class, int sev, const char *name, const char *fmt, ...)
+{
+	va_list args;
+	char logbuf[LOG_BUF_SIZE];
+
+	if (conf.log_filter & event)
+		return;
+
+	va_start(args, fmt);
+	vsnprintf(logbuf, sizeof(logbuf), fmt, args);
+	va_end(args);
+	schdlog(event, class, sev, name, logbuf);
+}
+
 /**
  *	@brief  combination of schdlog and translate_fail_code()
  *		If we're actually going to log a message, translate
@@ -45,6 +45,7 @@ extern "C" {
 #include "server_info.h"
 #include "queue_info.h"
 #include "job_info.h"
+#include "log.h"
 
 /*
  *	string_dup - duplicate a string
@@ -84,6 +85,12 @@ int skip_line(char *line);
 
 void schdlog(int event, int class, int sev, const char *name, const char *text);
 
+/*
+ *      schdlogf - schdlog with a printf style format, the message is only
+ *                 formatted if the event is not filtered out
+ */
+void schdlogf(int event, int class, int sev, const char *name, const char *fmt, ...) LOG_PRINTF_FORMAT(5, 6);
+
 /*
  *      schdlogerr - combination of schdlog and translate_fail_code()
  *                   If we're actually going to log a message, translate
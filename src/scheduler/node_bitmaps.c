@@ -0,0 +1,488 @@
+/*
+ * Copyright (C) 1994-2018 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * PBS Pro is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * For a copy of the commercial license terms and conditions,
+ * go to: (http://www.pbspro.com/UserArea/agreement.html)
+ * or contact the Altair Legal Department.
+ *
+ * Altair’s dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of PBS Pro and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair’s trademarks, including but not limited to "PBS™",
+ * "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's
+ * trademark licensing policies.
+ *
+ */
+
+/**
+ * @file    node_bitmaps.c
+ *
+ * @brief
+ * 		Per-cycle bitmaps over the server's nodes.  Bit N of each bitmap
+ * 		represents sinfo->unordered_nodes[N] (i.e. node_ind N).
+ *
+ * 		The state bitmaps (free, down, offline, resv-exclusive) are kept
+ * 		up to date as node states change during the cycle.  The resource
+ * 		bitmaps hold the nodes which satisfy a non-consumable resource
+ * 		request (e.g. arch=linux).  Since non-consumable resources do not
+ * 		change within a cycle, a resource bitmap is created the first time
+ * 		a (resource, value) pair is requested and reused by every chunk that
+ * 		requests the same pair afterwards.  A chunk's non-consumable
+ * 		request then becomes a few bitwise ANDs instead of a walk of every
+ * 		node's resource list.
+ *
+ * Functions included are:
+ * 	new_node_bitmaps()
+ * 	dup_node_bitmaps()
+ * 	free_node_bitmaps()
+ * 	new_res_bitmap()
+ * 	free_res_bitmap()
+ * 	free_res_bitmap_array()
+ * 	create_node_bitmaps()
+ * 	update_node_state_bits()
+ * 	find_alloc_res_bitmap()
+ * 	create_chunk_candidates()
+ * 	node_in_candidates()
+ *
+ */
+#include <pbs_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <log.h>
+#include "data_types.h"
+#include "pbs_bitmap.h"
+#include "node_bitmaps.h"
+#include "check.h"
+#include "constant.h"
+#include "misc.h"
+#include "resource_resv.h"
+
+
+/* node_bitmaps constructor */
+node_bitmaps *
+new_node_bitmaps(int num_nodes)
+{
+	node_bitmaps *nbm;
+
+	if (num_nodes <= 0)
+		return NULL;
+
+	nbm = calloc(1, sizeof(node_bitmaps));
+	if (nbm == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		return NULL;
+	}
+
+	nbm->num_nodes = num_nodes;
+	nbm->free = pbs_bitmap_alloc(NULL, num_nodes);
+	nbm->down = pbs_bitmap_alloc(NULL, num_nodes);
+	nbm->offline = pbs_bitmap_alloc(NULL, num_nodes);
+	nbm->resv_exclusive = pbs_bitmap_alloc(NULL, num_nodes);
+	if (nbm->free == NULL || nbm->down == NULL ||
+		nbm->offline == NULL || nbm->resv_exclusive == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		free_node_bitmaps(nbm);
+		return NULL;
+	}
+	nbm->res_bits = NULL;
+
+	return nbm;
+}
+
+/* node_bitmaps copy constructor */
+node_bitmaps *
+dup_node_bitmaps(node_bitmaps *onbm)
+{
+	node_bitmaps *nnbm;
+	int ct;
+	int i;
+
+	if (onbm == NULL)
+		return NULL;
+
+	nnbm = new_node_bitmaps(onbm->num_nodes);
+	if (nnbm == NULL)
+		return NULL;
+
+	if (pbs_bitmap_assign(nnbm->free, onbm->free) == 0 ||
+		pbs_bitmap_assign(nnbm->down, onbm->down) == 0 ||
+		pbs_bitmap_assign(nnbm->offline, onbm->offline) == 0 ||
+		pbs_bitmap_assign(nnbm->resv_exclusive, onbm->resv_exclusive) == 0) {
+		free_node_bitmaps(nnbm);
+		return NULL;
+	}
+
+	if (onbm->res_bits != NULL) {
+		ct = count_array((void **) onbm->res_bits);
+		nnbm->res_bits = calloc(ct + 1, sizeof(res_bitmap *));
+		if (nnbm->res_bits == NULL) {
+			log_err(errno, __func__, MEM_ERR_MSG);
+			free_node_bitmaps(nnbm);
+			return NULL;
+		}
+		for (i = 0; onbm->res_bits[i] != NULL; i++) {
+			nnbm->res_bits[i] = new_res_bitmap(onbm->res_bits[i]->def,
+				onbm->res_bits[i]->value, onbm->num_nodes);
+			if (nnbm->res_bits[i] == NULL ||
+				pbs_bitmap_assign(nnbm->res_bits[i]->nodes, onbm->res_bits[i]->nodes) == 0) {
+				free_node_bitmaps(nnbm);
+				return NULL;
+			}
+		}
+	}
+
+	return nnbm;
+}
+
+/* node_bitmaps destructor */
+void
+free_node_bitmaps(node_bitmaps *nbm)
+{
+	if (nbm == NULL)
+		return;
+
+	pbs_bitmap_free(nbm->free);
+	pbs_bitmap_free(nbm->down);
+	pbs_bitmap_free(nbm->offline);
+	pbs_bitmap_free(nbm->resv_exclusive);
+	free_res_bitmap_array(nbm->res_bits);
+	free(nbm);
+}
+
+/* res_bitmap constructor */
+res_bitmap *
+new_res_bitmap(resdef *def, char *value, int num_nodes)
+{
+	res_bitmap *rb;
+
+	rb = calloc(1, sizeof(res_bitmap));
+	if (rb == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		return NULL;
+	}
+
+	rb->def = def;
+	if (value != NULL) {
+		rb->value = string_dup(value);
+		if (rb->value == NULL) {
+			free_res_bitmap(rb);
+			return NULL;
+		}
+	}
+
+	rb->nodes = pbs_bitmap_alloc(NULL, num_nodes);
+	if (rb->nodes == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		free_res_bitmap(rb);
+		return NULL;
+	}
+
+	return rb;
+}
+
+/* res_bitmap destructor */
+void
+free_res_bitmap(res_bitmap *rb)
+{
+	if (rb == NULL)
+		return;
+
+	free(rb->value);
+	pbs_bitmap_free(rb->nodes);
+	free(rb);
+}
+
+/* res_bitmap array destructor */
+void
+free_res_bitmap_array(res_bitmap **rb_arr)
+{
+	int i;
+
+	if (rb_arr == NULL)
+		return;
+
+	for (i = 0; rb_arr[i] != NULL; i++)
+		free_res_bitmap(rb_arr[i]);
+
+	free(rb_arr);
+}
+
+/**
+ * @brief
+ * 		create the node state bitmaps for a server's nodes
+ *
+ * @param[in]	unordered_nodes	-	sinfo->unordered_nodes
+ * @param[in]	num_nodes	-	number of nodes in unordered_nodes
+ *
+ * @return	node_bitmaps *
+ * @retval	the new bitmaps
+ * @retval	NULL	: on error or if there are no nodes
+ */
+node_bitmaps *
+create_node_bitmaps(node_info **unordered_nodes, int num_nodes)
+{
+	node_bitmaps *nbm;
+	int i;
+
+	if (unordered_nodes == NULL)
+		return NULL;
+
+	nbm = new_node_bitmaps(num_nodes);
+	if (nbm == NULL)
+		return NULL;
+
+	for (i = 0; i < num_nodes && unordered_nodes[i] != NULL; i++) {
+		node_info *ninfo = unordered_nodes[i];
+
+		if (ninfo->is_free)
+			pbs_bitmap_bit_on(nbm->free, i);
+		if (ninfo->is_down)
+			pbs_bitmap_bit_on(nbm->down, i);
+		if (ninfo->is_offline)
+			pbs_bitmap_bit_on(nbm->offline, i);
+		if (ninfo->is_resv_exclusive)
+			pbs_bitmap_bit_on(nbm->resv_exclusive, i);
+	}
+
+	return nbm;
+}
+
+/**
+ * @brief
+ * 		set or clear a node's bit in the server's state bitmaps to match the
+ * 		node's current state.
+ *
+ * @par	Only nodes which are in the server's unordered_nodes array are in the
+ * 		bitmaps.  Copies of nodes (e.g. a reservation's nodes) share the
+ * 		node_ind of the server node they were copied from, but have their
+ * 		own state, so they are ignored.
+ *
+ * @param[in]	ninfo	-	the node whose state has changed
+ *
+ * @return	void
+ */
+void
+update_node_state_bits(node_info *ninfo)
+{
+	node_bitmaps *nbm;
+	int ind;
+
+	if (ninfo == NULL || ninfo->server == NULL)
+		return;
+
+	nbm = ninfo->server->node_bits;
+	ind = ninfo->node_ind;
+	if (nbm == NULL || ind < 0 || ind >= nbm->num_nodes)
+		return;
+	if (ninfo->server->unordered_nodes == NULL ||
+		ninfo->server->unordered_nodes[ind] != ninfo)
+		return;
+
+	if (ninfo->is_free)
+		pbs_bitmap_bit_on(nbm->free, ind);
+	else
+		pbs_bitmap_bit_off(nbm->free, ind);
+
+	if (ninfo->is_down)
+		pbs_bitmap_bit_on(nbm->down, ind);
+	else
+		pbs_bitmap_bit_off(nbm->down, ind);
+
+	if (ninfo->is_offline)
+		pbs_bitmap_bit_on(nbm->offline, ind);
+	else
+		pbs_bitmap_bit_off(nbm->offline, ind);
+
+	if (ninfo->is_resv_exclusive)
+		pbs_bitmap_bit_on(nbm->resv_exclusive, ind);
+	else
+		pbs_bitmap_bit_off(nbm->resv_exclusive, ind);
+}
+
+/**
+ * @brief
+ * 		find the bitmap of nodes which satisfy a non-consumable resource
+ * 		request.  If this is the first time the (resource, value) pair has
+ * 		been requested this cycle, the bitmap is created by checking every
+ * 		node once and is cached on the server.
+ *
+ * @param[in]	sinfo	-	server whose nodes to check
+ * @param[in]	req	-	non-consumable resource request
+ *
+ * @return	pbs_bitmap *
+ * @retval	bitmap of nodes which satisfy req (do not free)
+ * @retval	NULL	: on error
+ */
+pbs_bitmap *
+find_alloc_res_bitmap(server_info *sinfo, resource_req *req)
+{
+	node_bitmaps *nbm;
+	res_bitmap *rb;
+	res_bitmap **tmp_arr;
+	resource_req *onereq;
+	int ct;
+	int i;
+
+	if (sinfo == NULL || req == NULL || req->def == NULL || sinfo->node_bits == NULL)
+		return NULL;
+
+	nbm = sinfo->node_bits;
+	ct = 0;
+	if (nbm->res_bits != NULL) {
+		for (; nbm->res_bits[ct] != NULL; ct++) {
+			rb = nbm->res_bits[ct];
+			if (rb->def == req->def) {
+				if (rb->value == NULL && req->res_str == NULL)
+					return rb->nodes;
+				if (rb->value != NULL && req->res_str != NULL &&
+					!strcmp(rb->value, req->res_str))
+					return rb->nodes;
+			}
+		}
+	}
+
+	rb = new_res_bitmap(req->def, req->res_str, nbm->num_nodes);
+	if (rb == NULL)
+		return NULL;
+
+	/* check_avail_resources() checks an entire list; hand it just this one */
+	onereq = dup_resource_req(req);
+	if (onereq == NULL) {
+		free_res_bitmap(rb);
+		return NULL;
+	}
+
+	for (i = 0; i < nbm->num_nodes && sinfo->unordered_nodes[i] != NULL; i++) {
+		if (check_avail_resources(sinfo->unordered_nodes[i]->res, onereq,
+				CHECK_ALL_BOOLS | ONLY_COMP_NONCONS | UNSET_RES_ZERO, NULL,
+				INSUFFICIENT_RESOURCE, NULL) != 0)
+			pbs_bitmap_bit_on(rb->nodes, i);
+	}
+	free_resource_req(onereq);
+
+	tmp_arr = realloc(nbm->res_bits, (ct + 2) * sizeof(res_bitmap *));
+	if (tmp_arr == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		free_res_bitmap(rb);
+		return NULL;
+	}
+	tmp_arr[ct] = rb;
+	tmp_arr[ct + 1] = NULL;
+	nbm->res_bits = tmp_arr;
+
+	return rb->nodes;
+}
+
+/**
+ * @brief
+ * 		create the bitmap of nodes which satisfy all of a chunk's
+ * 		non-consumable resources and are in the free state.
+ *
+ * @param[in]	sinfo	-	server whose nodes to check
+ * @param[in]	specreq_noncons	-	non-consumable resources of the chunk
+ *
+ * @return	pbs_bitmap *
+ * @retval	candidate nodes (caller must free with pbs_bitmap_free())
+ * @retval	NULL	: on error or if there are no bitmaps for the server
+ */
+pbs_bitmap *
+create_chunk_candidates(server_info *sinfo, resource_req *specreq_noncons)
+{
+	pbs_bitmap *cand;
+	pbs_bitmap *rbits;
+	resource_req *req;
+
+	if (sinfo == NULL || sinfo->node_bits == NULL)
+		return NULL;
+
+	cand = pbs_bitmap_alloc(NULL, sinfo->node_bits->num_nodes);
+	if (cand == NULL)
+		return NULL;
+
+	if (pbs_bitmap_assign(cand, sinfo->node_bits->free) == 0) {
+		pbs_bitmap_free(cand);
+		return NULL;
+	}
+
+	for (req = specreq_noncons; req != NULL; req = req->next) {
+		rbits = find_alloc_res_bitmap(sinfo, req);
+		if (rbits == NULL) {
+			pbs_bitmap_free(cand);
+			return NULL;
+		}
+		pbs_bitmap_and(cand, rbits);
+	}
+
+	return cand;
+}
+
+/**
+ * @brief
+ * 		check if a node is in a candidate bitmap from create_chunk_candidates()
+ *
+ * @par	A node which isn't in the server's bitmaps (e.g. a node from another
+ * 		universe) can't be ruled out, so it is considered a candidate.
+ * 		A copy of a server node (e.g. a reservation's node or a node duplicated
+ * 		to break a chunk across vnodes) has the same non-consumable resources
+ * 		as the node it was copied from, but its own state.  Its resource
+ * 		bits are used, but the free state is left for the caller to check.
+ *
+ * @param[in]	sinfo	-	server the candidate bitmap was created from
+ * @param[in]	candidates	-	candidate bitmap
+ * @param[in]	ninfo	-	node to check
+ *
+ * @return	int
+ * @retval	1	: node is a candidate
+ * @retval	0	: node can not satisfy the chunk
+ */
+int
+node_in_candidates(server_info *sinfo, pbs_bitmap *candidates, node_info *ninfo)
+{
+	node_info *snode;
+	int ind;
+
+	if (sinfo == NULL || candidates == NULL || ninfo == NULL || sinfo->node_bits == NULL)
+		return 1;
+
+	ind = ninfo->node_ind;
+	if (ind < 0 || ind >= sinfo->node_bits->num_nodes)
+		return 1;
+
+	snode = sinfo->unordered_nodes[ind];
+	if (snode == NULL || snode->rank != ninfo->rank)
+		return 1;
+
+	if (pbs_bitmap_get_bit(candidates, ind))
+		return 1;
+
+	/* A copy is only ruled out by its resources, not the server node's state */
+	if (snode != ninfo && !pbs_bitmap_get_bit(sinfo->node_bits->free, ind))
+		return 1;
+
+	return 0;
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 1994-2018 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * PBS Pro is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * For a copy of the commercial license terms and conditions,
+ * go to: (http://www.pbspro.com/UserArea/agreement.html)
+ * or contact the Altair Legal Department.
+ *
+ * Altair’s dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of PBS Pro and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair’s trademarks, including but not limited to "PBS™",
+ * "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's
+ * trademark licensing policies.
+ *
+ */
+
+#ifndef	_NODE_BITMAPS_H
+#define	_NODE_BITMAPS_H
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "data_types.h"
+
+/* node_bitmaps constructor, copy constructor, destructor */
+node_bitmaps *new_node_bitmaps(int num_nodes);
+node_bitmaps *dup_node_bitmaps(node_bitmaps *onbm);
+void free_node_bitmaps(node_bitmaps *nbm);
+
+/* res_bitmap constructor, destructor */
+res_bitmap *new_res_bitmap(resdef *def, char *value, int num_nodes);
+void free_res_bitmap(res_bitmap *rb);
+void free_res_bitmap_array(res_bitmap **rb_arr);
+
+/* create the state bitmaps for the nodes in sinfo->unordered_nodes */
+node_bitmaps *create_node_bitmaps(node_info **unordered_nodes, int num_nodes);
+
+/* bring a node's bits in the state bitmaps in line with its state */
+void update_node_state_bits(node_info *ninfo);
+
+/* find (or create) the bitmap of nodes which satisfy a non-consumable request */
+pbs_bitmap *find_alloc_res_bitmap(server_info *sinfo, resource_req *req);
+
+/* AND together the bitmaps for all the non-consumable resources in a chunk */
+pbs_bitmap *create_chunk_candidates(server_info *sinfo, resource_req *specreq_noncons);
+
+/* is a node one of the candidates in a candidate bitmap */
+int node_in_candidates(server_info *sinfo, pbs_bitmap *candidates, node_info *ninfo);
+
+#ifdef	__cplusplus
+}
+#endif
+#endif	/* _NODE_BITMAPS_H */
@@ -149,6 +149,9 @@
 #include "server_info.h"
 #include "pbs_share.h"
 #include "pbs_bitmap.h"
+#include "node_bitmaps.h"
+#include "snapshot.h"
+#include "buckets.h"
 #ifdef NAS
 #include "site_code.h"
 #endif
@@ -174,7 +177,6 @@ query_nodes(int pbs_sd, server_info *sinfo)
 	struct batch_status *cur_node;	/* used to cycle through nodes */
 	node_info **ninfo_arr;		/* array of nodes for scheduler's use */
 	node_info *ninfo;			/* used to set up a node */
-	char errbuf[256];
 	char *err;				/* used with pbs_geterrmsg() */
 	int num_nodes = 0;			/* the number of nodes */
 	int i;
@@ -183,10 +185,11 @@ query_nodes(int pbs_sd, server_info *sinfo)
 	/* get nodes from PBS server */
 	if ((nodes = pbs_statvnode(pbs_sd, NULL, NULL, NULL)) == NULL) {
 		err = pbs_geterrmsg(pbs_sd);
-		sprintf(errbuf, "Error getting nodes: %s", err);
-		schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_NODE, LOG_INFO, "", errbuf);
+		schdlogf(PBSEVENT_SCHED, PBS_EVENTCLASS_NODE, LOG_INFO, "",
+			"Error getting nodes: %s", err);
 		return NULL;
 	}
+	snapshot_add(SNAPSHOT_NODES, nodes);
 
 	cur_node = nodes;
 	while (cur_node != NULL) {
@@ -242,8 +245,8 @@ query_nodes(int pbs_sd, server_info *sinfo)
 	}
 	ninfo_arr[nidx] = NULL;
 	if (nidx == 0) {
-		snprintf(log_buffer, sizeof(log_buffer), "No nodes found in partitions serviced by scheduler");
-		schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_SERVER, LOG_INFO, __func__, log_buffer);
+		schdlogf(PBSEVENT_SCHED, PBS_EVENTCLASS_SERVER, LOG_INFO, __func__,
+			"No nodes found in partitions serviced by scheduler");
 		free(ninfo_arr);
 		return NULL;
 	}
@@ -282,7 +285,6 @@ query_node_info(struct batch_status *node, server_info *sinfo)
 	schd_resource *res;		/* used to set resources in res list */
 	sch_resource_t count;		/* used to convert str->num */
 	char *endp;			/* end pointer for strtol */
-	char logbuf[256];		/* log buffer */
 
 	if ((ninfo = new_node_info()) == NULL)
 		return NULL;
@@ -364,9 +366,9 @@ query_node_info(struct batch_status *node, server_info *sinfo)
 		else if (!strcmp(attrp->name, ATTR_NODE_Sharing)) {
 			ninfo->sharing = str_to_vnode_sharing(attrp->value);
 			if (ninfo->sharing == VNS_UNSET) {
-				sprintf(logbuf, "Unknown sharing type: %s using default shared", attrp->value);
-				schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_NODE, LOG_INFO,
-					ninfo->name, logbuf);
+				schdlogf(PBSEVENT_SCHED, PBS_EVENTCLASS_NODE, LOG_INFO,
+					ninfo->name,
+					"Unknown sharing type: %s using default shared", attrp->value);
 				ninfo->sharing = VNS_DFLT_SHARED;
 			}
 		}
@@ -377,9 +379,9 @@ query_node_info(struct batch_status *node, server_info *sinfo)
 					sinfo->has_nonCPU_licenses = 1;
 					break;
 				default:
-					sprintf(logbuf, "Unknown license type: %c", attrp->value[0]);
-					schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_NODE, LOG_INFO,
-						ninfo->name, logbuf);
+					schdlogf(PBSEVENT_SCHED, PBS_EVENTCLASS_NODE, LOG_INFO,
+						ninfo->name,
+						"Unknown license type: %c", attrp->value[0]);
 			}
 		} else if (!strcmp(attrp->name, ATTR_rescavail)) {
 			res = find_alloc_resource_by_str(ninfo->res, attrp->resource);
@@ -660,15 +662,12 @@ free_node_info(node_info *ninfo)
 int
 set_node_type(node_info *ninfo, char *ntype)
 {
-	char errbuf[256];
-
 	if (ntype != NULL && ninfo != NULL) {
 		if (!strcmp(ntype, ND_pbs))
 			ninfo->is_pbsnode = 1;
 		else {
-			sprintf(errbuf, "Unknown node type: %s", ntype);
-			schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_NODE, LOG_INFO,
-				ninfo->name, errbuf);
+			schdlogf(PBSEVENT_SCHED, PBS_EVENTCLASS_NODE, LOG_INFO,
+				ninfo->name, "Unknown node type: %s", ntype);
 			return 1;
 		}
 		return 0;
@@ -690,7 +689,6 @@ set_node_type(node_info *ninfo, char *ntype)
 int
 set_node_info_state(node_info *ninfo, char *state)
 {
-	char errbuf[256];
 	char statebuf[256];			/* used to strtok() node states */
 	char *tok;				/* used with strtok() */
 
@@ -710,13 +708,13 @@ set_node_info_state(node_info *ninfo, char *state)
 				tok++;
 
 			if (add_node_state(ninfo, tok) == 1) {
-				sprintf(errbuf, "Unknown Node State: %s", tok);
-				schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_NODE, LOG_INFO,
-					ninfo->name, errbuf);
+				schdlogf(PBSEVENT_SCHED, PBS_EVENTCLASS_NODE, LOG_INFO,
+					ninfo->name, "Unknown Node State: %s", tok);
 			}
 
 			tok = strtok(NULL, ",");
 		}
+		update_node_state_bits(ninfo);
 		return 0;
 	}
 
@@ -742,8 +740,6 @@ set_node_info_state(node_info *ninfo, char *state)
 int
 remove_node_state(node_info *ninfo, char *state)
 {
-	char errbuf[256];
-
 	if (ninfo == NULL)
 		return 1;
 
@@ -778,9 +774,8 @@ remove_node_state(node_info *ninfo, char *state)
 	else if (!strcmp(state, ND_wait_prov))
 		ninfo->is_provisioning = 0;
 	else {
-		sprintf(errbuf, "Unknown Node State: %s on remove operation", state);
-		schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_NODE, LOG_INFO,
-			ninfo->name, errbuf);
+		schdlogf(PBSEVENT_SCHED, PBS_EVENTCLASS_NODE, LOG_INFO,
+			ninfo->name, "Unknown Node State: %s on remove operation", state);
 		return 1;
 	}
 
@@ -792,6 +787,8 @@ remove_node_state(node_info *ninfo, char *state)
 		&& !ninfo->is_unknown  && !ninfo->is_down)
 		ninfo->is_free = 1;
 
+	update_node_state_bits(ninfo);
+
 	return 0;
 }
 
@@ -812,7 +809,6 @@ remove_node_state(node_info *ninfo, char *state)
 int
 add_node_state(node_info *ninfo, char *state)
 {
-	char errbuf[256];
 	int set_free = 0;
 
 	if (ninfo == NULL)
@@ -852,9 +848,8 @@ add_node_state(node_info *ninfo, char *state)
 		if(ninfo->server->power_provisioning)
 			ninfo->is_sleeping = 1;
 	} else {
-		sprintf(errbuf, "Unknown Node State: %s on add operation", state);
-		schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_NODE, LOG_INFO,
-			ninfo->name, errbuf);
+		schdlogf(PBSEVENT_SCHED, PBS_EVENTCLASS_NODE, LOG_INFO,
+			ninfo->name, "Unknown Node State: %s on add operation", state);
 		return 1;
 	}
 
@@ -862,6 +857,8 @@ add_node_state(node_info *ninfo, char *state)
 	if (!set_free)
 		ninfo->is_free = 0;
 
+	update_node_state_bits(ninfo);
+
 	return 0;
 }
 
@@ -886,7 +883,6 @@ talk_with_mom(node_info *ninfo)
 	double testd;			/* used to convert string->double */
 	schd_resource *res;                /* used for dynamic resources from mom */
 	int ncpus = 1;		/* used as a default for loads */
-	char errbuf[MAX_LOG_SIZE];
 	int i;
 
 	if (!should_talk_with_mom(ninfo))
@@ -934,9 +930,8 @@ talk_with_mom(node_info *ninfo)
 				ninfo->loadave = -1.0;
 		}
 		else {
-			sprintf(errbuf, "Unknown resource value[%d]: %s", i, mom_ans);
-			schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_NODE, LOG_INFO,
-				ninfo->name, errbuf);
+			schdlogf(PBSEVENT_SCHED, PBS_EVENTCLASS_NODE, LOG_INFO,
+				ninfo->name, "Unknown resource value[%d]: %s", i, mom_ans);
 		}
 		free(mom_ans);
 		mom_ans = NULL;
@@ -966,10 +961,9 @@ talk_with_mom(node_info *ninfo)
 				else if (res->avail == SCHD_INFINITY)
 					res->avail = 0;
 
-				snprintf(errbuf, sizeof(errbuf), "%s = %s (\"%s\")",
+				schdlogf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_NODE, LOG_DEBUG,
+					"mom_resources", "%s = %s (\"%s\")",
 					res->name, res_to_str(res, RF_AVAIL), mom_ans);
-				schdlog(PBSEVENT_DEBUG2, PBS_EVENTCLASS_NODE, LOG_DEBUG,
-					"mom_resources", errbuf);
 			}
 			free(mom_ans);
 			mom_ans = NULL;
@@ -1455,7 +1449,6 @@ collect_jobs_on_nodes(node_info **ninfo_arr, resource_resv **resresv_arr, int si
 	counts *cts;		/* used to update user and group counts */
 	int i, j, k;
 	node_info *node;	/* used to store pointer of node in ninfo_arr */
-	char logbuf[MAX_LOG_SIZE];
 	resource_resv **temp_ninfo_arr = NULL;
 
 	if (ninfo_arr == NULL || ninfo_arr[0] == NULL)
@@ -1515,11 +1508,10 @@ collect_jobs_on_nodes(node_info **ninfo_arr, resource_resv **resresv_arr, int si
 					 * recalculated later.
 					 */
 					ninfo_arr[i]->has_ghost_job = 1;
-					snprintf(logbuf, sizeof(logbuf),
+					schdlogf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_NODE, LOG_DEBUG,
+						ninfo_arr[i]->name,
 						"Job %s reported running on node no longer exists or is not in running state",
 						ninfo_arr[i]->jobs[j]);
-					schdlog(PBSEVENT_DEBUG2, PBS_EVENTCLASS_NODE, LOG_DEBUG,
-						ninfo_arr[i]->name, logbuf);
 				}
 
 			}
@@ -1756,7 +1748,6 @@ update_node_on_end(node_info *ninfo, resource_resv *resresv, char *job_state)
 	schd_resource *res = NULL;
 	counts *cts;
 	nspec *ns;		/* nspec from resresv for this node */
-	char logbuf[MAX_LOG_SIZE];
 	int ind;
 	int i;
 
@@ -1814,10 +1805,9 @@ update_node_on_end(node_info *ninfo, resource_resv *resresv, char *job_state)
 							res = res->indirect_res;
 						res->assigned -= resreq->amount;
 						if (res->assigned < 0) {
-							snprintf(logbuf, MAX_LOG_SIZE,
+							schdlogf(PBSEVENT_DEBUG, PBS_EVENTCLASS_NODE,
+								LOG_DEBUG, ninfo->name,
 								"%s turned negative %.2lf, setting it to 0", res->name, res->assigned);
-							schdlog(PBSEVENT_DEBUG, PBS_EVENTCLASS_NODE,
-								LOG_DEBUG, ninfo->name, logbuf);
 							res->assigned = 0;
 						}
 						if (res->def == getallres(RES_NCPUS)) {
@@ -2186,7 +2176,6 @@ eval_selspec(status *policy, selspec *spec, place *placespec,
 	place				*pl;
 	int				can_fit = 0;
 	int				rc = 0;		/* 1 if resources are available, 0 if not */
-	char				logbuf[MAX_LOG_SIZE] = {0};
 	int				pass_flags = NO_FLAGS;
 	char				reason[MAX_LOG_SIZE] = {0};
 	int				i = 0;
@@ -2267,10 +2256,9 @@ eval_selspec(status *policy, selspec *spec, place *placespec,
 	for (i = 0; nodepart[i] != NULL && rc == 0; i++) {
 		clear_schd_error(err);
 		if (resresv_can_fit_nodepart(policy, nodepart[i], resresv, flags, err)) {
-			snprintf(logbuf, MAX_LOG_SIZE, "Evaluating placement set: %s",
+			schdlogf(PBSEVENT_DEBUG3, PBS_EVENTCLASS_JOB, LOG_DEBUG,
+				resresv->name, "Evaluating placement set: %s",
 				nodepart[i]->name);
-			schdlog(PBSEVENT_DEBUG3, PBS_EVENTCLASS_JOB, LOG_DEBUG,
-				resresv->name, logbuf);
 			if (nodepart[i]->ok_break)
 				pass_flags |= EVAL_OKBREAK;
 
@@ -2383,7 +2371,6 @@ eval_placement(status *policy, selspec *spec, node_info **ninfo_arr, place *pl,
 	int			cur_flt_lic;
 	nspec			**nsa = NULL;
 	nspec			**ns_head = NULL;
-	char			logbuf[MAX_LOG_SIZE] = {0};
 	char			reason[MAX_LOG_SIZE] = {0};
 	char			*msgbuf;
 	resource_req		*req = NULL;
@@ -2479,9 +2466,8 @@ eval_placement(status *policy, selspec *spec, node_info **ninfo_arr, place *pl,
 			}
 
 			rc = any_succ_rc = 0;
-			sprintf(logbuf, "Evaluating host %s", hostsets[i]->res_val);
-			schdlog(PBSEVENT_DEBUG3, PBS_EVENTCLASS_NODE, LOG_DEBUG,
-				resresv->name, logbuf);
+			schdlogf(PBSEVENT_DEBUG3, PBS_EVENTCLASS_NODE, LOG_DEBUG,
+				resresv->name, "Evaluating host %s", hostsets[i]->res_val);
 
 			/* Pack on One Host Placement:
 			 * place all chunks on one host.  This is done with a call to
@@ -2786,9 +2772,9 @@ eval_placement(status *policy, selspec *spec, node_info **ninfo_arr, place *pl,
 				free_nodes(dup_ninfo_arr);
 			}
 			else {
-				snprintf(logbuf, MAX_LOG_SIZE, "Unexpected Placement: not %s, %s, %s, or %s", PLACE_Scatter, PLACE_VScatter, PLACE_Pack, PLACE_Free);
-				schdlog(PBSEVENT_DEBUG, PBS_EVENTCLASS_NODE, LOG_DEBUG,
-					resresv->name, logbuf);
+				schdlogf(PBSEVENT_DEBUG, PBS_EVENTCLASS_NODE, LOG_DEBUG,
+					resresv->name,
+					"Unexpected Placement: not %s, %s, %s, or %s", PLACE_Scatter, PLACE_VScatter, PLACE_Pack, PLACE_Free);
 			}
 		}
 	} else
@@ -3000,7 +2986,6 @@ eval_simple_selspec(status *policy, chunk *chk, node_info **pninfo_arr,
 	resource_req	*req = NULL;		/* used to determine if we're done */
 	resource_req	*prevreq = NULL;	/* used to determine if we're done */
 	resource_req	*tmpreq = NULL;		/* used to unlink and free */
-	char		logbuf[MAX_LOG_SIZE];
 	int		need_new_nspec = 1;	/* need to allocate a new nspec for node solution */
 
 	int		allocated = 0;		/* did we allocate resources to a vnode */
@@ -3012,6 +2997,9 @@ eval_simple_selspec(status *policy, chunk *chk, node_info **pninfo_arr,
 	char		*str_chunk = NULL;	/* ptr to after the number of chunks in the str_chunk */
 
 	node_info	**ninfo_arr = NULL;
+	pbs_bitmap	*candidates = NULL;	/* nodes which pass the chunk's non-consumable resources */
+	node_info	*first_filtered = NULL;	/* first node ruled out by candidates */
+	int		num_evaluated = 0;	/* number of nodes not ruled out by candidates */
 
 	static schd_error *failerr = NULL;
 
@@ -3073,9 +3061,8 @@ eval_simple_selspec(status *policy, chunk *chk, node_info **pninfo_arr,
 
 	str_chunk = &chk->str_chunk[i];
 
-	snprintf(logbuf, MAX_LOG_SIZE, "Evaluating subchunk: %s", str_chunk);
-	schdlog(PBSEVENT_DEBUG3, PBS_EVENTCLASS_NODE, LOG_DEBUG,
-		resresv->name, logbuf);
+	schdlogf(PBSEVENT_DEBUG3, PBS_EVENTCLASS_NODE, LOG_DEBUG,
+		resresv->name, "Evaluating subchunk: %s", str_chunk);
 
 	/* We're duplicating the entire list here.  This list is organized so that
 	 * all non-consumable resources come before the consumable ones.  After
@@ -3115,11 +3102,25 @@ eval_simple_selspec(status *policy, chunk *chk, node_info **pninfo_arr,
 	cur_flt_lic = flt_lic;
 	nsa = *nspec_arr;
 
+	/* Rule out nodes which can't satisfy the chunk's non-consumable
+	 * resources with a few bitmap ANDs rather than checking each node
+	 */
+	if (specreq_noncons != NULL)
+		candidates = create_chunk_candidates(resresv->server, specreq_noncons);
+
 	for (i = 0, j = 0; ninfo_arr[i] != NULL && chunks_found == 0; i++) {
 		if (ninfo_arr[i]->nscr.visited || ninfo_arr[i]->nscr.scattered  ||
 			ninfo_arr[i]->nscr.ineligible)
 			continue;
 
+		if (candidates != NULL &&
+			!node_in_candidates(resresv->server, candidates, ninfo_arr[i])) {
+			if (first_filtered == NULL)
+				first_filtered = ninfo_arr[i];
+			continue;
+		}
+		num_evaluated++;
+
 		allocated = 0;
 		licenses_allocated = 0;
 		clear_schd_error(err);
@@ -3266,6 +3267,15 @@ eval_simple_selspec(status *policy, chunk *chk, node_info **pninfo_arr,
 
 	nsa[j] = NULL;
 
+	/* If every node was ruled out by its non-consumable resources, nothing
+	 * set err.  Evaluate one of them to report why.
+	 */
+	if (!chunks_found && num_evaluated == 0 && first_filtered != NULL) {
+		clear_schd_error(err);
+		is_vnode_eligible_chunk(specreq_noncons, first_filtered, resresv, err);
+	}
+	pbs_bitmap_free(candidates);
+
 	if (specreq_cons != NULL)
 		free_resource_req_list(specreq_cons);
 	if (specreq_noncons != NULL)
@@ -3275,9 +3285,8 @@ eval_simple_selspec(status *policy, chunk *chk, node_info **pninfo_arr,
 		free_nodes(ninfo_arr);
 
 	if (chunks_found) {
-		snprintf(logbuf, MAX_LOG_SIZE, "Allocated one subchunk: %s", str_chunk);
-		schdlog(PBSEVENT_DEBUG3, PBS_EVENTCLASS_NODE, LOG_DEBUG,
-			resresv->name, logbuf);
+		schdlogf(PBSEVENT_DEBUG3, PBS_EVENTCLASS_NODE, LOG_DEBUG,
+			resresv->name, "Allocated one subchunk: %s", str_chunk);
 		clear_schd_error(err);
 		return 1;
 	}
@@ -3292,10 +3301,9 @@ eval_simple_selspec(status *policy, chunk *chk, node_info **pninfo_arr,
 		nsa[i] = NULL;
 	}
 
-	snprintf(logbuf, MAX_LOG_SIZE, "Failed to satisfy subchunk: %s",
+	schdlogf(PBSEVENT_DEBUG3, PBS_EVENTCLASS_NODE, LOG_DEBUG,
+		resresv->name, "Failed to satisfy subchunk: %s",
 		chk->str_chunk);
-	schdlog(PBSEVENT_DEBUG3, PBS_EVENTCLASS_NODE, LOG_DEBUG,
-		resresv->name, logbuf);
 
 	/* If the last node we looked at was fine, err would be empty.
 	 * Actually return an a real error */
@@ -3569,8 +3577,6 @@ resources_avail_on_vnode(resource_req *specreq_cons, node_info *node,
 	long long num_chunks = 0;
 	int is_p;
 
-	char logbuf[MAX_LOG_SIZE];
-
 	if (specreq_cons == NULL || node == NULL ||
 		resresv == NULL || pl == NULL || err == NULL)
 		return 0;
@@ -3613,10 +3619,10 @@ resources_avail_on_vnode(resource_req *specreq_cons, node_info *node,
 						if (resresv->select->total_chunks > 1 && pl->scatter != 1 && pl->vscatter != 1)
 							set_current_aoe(node, resresv->aoename);
 						if (resresv->is_job) {
-							sprintf(logbuf, "Vnode %s selected for provisioning with AOE %s",
+							schdlogf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_NOTICE,
+								resresv->name,
+								"Vnode %s selected for provisioning with AOE %s",
 								node->name, resresv->aoename);
-							schdlog(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_NOTICE,
-								resresv->name, logbuf);
 						}
 					}
 
@@ -3631,11 +3637,10 @@ resources_avail_on_vnode(resource_req *specreq_cons, node_info *node,
 							set_current_eoe(node, resresv->eoename);
 
 						if (resresv->is_job) {
-							snprintf(logbuf, sizeof(logbuf),
+							schdlogf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB,
+								LOG_NOTICE, resresv->name,
 								"Vnode %s selected for power with EOE %s",
 								node->name, resresv->eoename);
-							schdlog(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB,
-								LOG_NOTICE, resresv->name, logbuf);
 						}
 					}
 
@@ -3673,10 +3678,9 @@ resources_avail_on_vnode(resource_req *specreq_cons, node_info *node,
 
 					/* use tmpreq to wrap the amount so we can use res_to_str */
 					tmpreq.amount = amount;
-					sprintf(logbuf, "vnode allocated %s=%s",
+					schdlogf(PBSEVENT_DEBUG3, PBS_EVENTCLASS_NODE, LOG_DEBUG,
+						node->name, "vnode allocated %s=%s",
 						req->name, res_to_str(&tmpreq, RF_REQUEST));
-					schdlog(PBSEVENT_DEBUG3, PBS_EVENTCLASS_NODE, LOG_DEBUG,
-						node->name, logbuf);
 
 					allocated = 1;
 				}
@@ -3806,7 +3810,6 @@ check_resources_for_node(resource_req *resreq, node_info *ninfo,
 	timed_event *event;
 	unsigned int event_mask;
 	int i;
-	char logbuf[MAX_LOG_SIZE];
 
 	if (resreq == NULL || ninfo == NULL || err == NULL || resresv == NULL)
 		return -1;
@@ -3893,11 +3896,10 @@ check_resources_for_node(resource_req *resreq, node_info *ninfo,
 				}
 				else {
 					ns = NULL;
-					snprintf(logbuf, MAX_LOG_SIZE,
+					schdlogf(PBSEVENT_SCHED, PBS_EVENTCLASS_SCHED, LOG_WARNING,
+						resresv->name,
 						"Event %s is a run/end event w/o nspec array, ignoring event",
 						event->name);
-					schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_SCHED, LOG_WARNING,
-						resresv->name, logbuf);
 				}
 
 				is_run_event = (event->event_type == TIMED_RUN_EVENT);
@@ -4427,7 +4429,6 @@ parse_execvnode(char *execvnode, server_info *sinfo)
 
 	int num_chunk;
 	char *p;
-	char logbuf[256];
 
 	if (execvnode == NULL || sinfo == NULL)
 		return NULL;
@@ -4504,9 +4505,8 @@ parse_execvnode(char *execvnode, server_info *sinfo)
 	nspec_arr[i] = NULL;
 
 	if (invalid) {
-		snprintf(logbuf, sizeof(logbuf), "Failed to parse execvnode: %s", execvnode);
-		schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_NODE, LOG_WARNING, __func__,
-			logbuf);
+		schdlogf(PBSEVENT_SCHED, PBS_EVENTCLASS_NODE, LOG_WARNING, __func__,
+			"Failed to parse execvnode: %s", execvnode);
 		free_nspecs(nspec_arr);
 		return NULL;
 	}
@@ -5440,6 +5440,118 @@ node_down_event(node_info *node, void *arg)
 	return 1;
 }
 
+/**
+ * @brief
+ *		does a node state string contain a state which means the node
+ *		can not be used to run jobs
+ *
+ * @param[in]	state	-	comma separated list of node states
+ *
+ * @return	int
+ * @retval	1	: the node can not be used
+ * @retval	0	: the node can be used
+ */
+static int
+state_is_unusable(char *state)
+{
+	char statebuf[256];
+	char *tok;
+
+	snprintf(statebuf, sizeof(statebuf), "%s", state);
+	for (tok = strtok(statebuf, ","); tok != NULL; tok = strtok(NULL, ",")) {
+		while (isspace((int) *tok))
+			tok++;
+		if (!strcmp(tok, ND_down) || !strcmp(tok, ND_offline) ||
+			!strcmp(tok, ND_state_unknown) || !strcmp(tok, ND_Stale) ||
+			!strcmp(tok, ND_sleep))
+			return 1;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *		refresh the state of the nodes in the middle of a scheduling
+ *		cycle.  Nodes which have gone down, offline, or are otherwise
+ *		unusable since the universe was queried are marked as such and
+ *		taken out of the node buckets and placement sets.  Nodes which
+ *		came back up are left alone; the next cycle will pick them up.
+ *		Jobs running on the nodes are left alone as well; the server
+ *		will tell us what became of them.
+ *
+ * @param[in]	pbs_sd	-	connection descriptor to the pbs server
+ * @param[in]	sinfo	-	the universe of the running cycle
+ *
+ * @return	int
+ * @retval	number of nodes which were changed
+ * @retval	-1	: on error
+ */
+int
+refresh_node_states(int pbs_sd, server_info *sinfo)
+{
+	static struct attrl state_attr = {NULL, ATTR_NODE_state, NULL, NULL, SET};
+	struct batch_status *nodes;
+	struct batch_status *cur_node;
+	node_info *ninfo;
+	char *err;
+	int changed = 0;
+	int i;
+
+	if (sinfo == NULL || sinfo->unordered_nodes == NULL)
+		return -1;
+
+	if ((nodes = pbs_statvnode(pbs_sd, NULL, &state_attr, NULL)) == NULL) {
+		err = pbs_geterrmsg(pbs_sd);
+		schdlogf(PBSEVENT_SCHED, PBS_EVENTCLASS_NODE, LOG_INFO, "",
+			"Error refreshing node states: %s",
+			err == NULL ? "" : err);
+		return -1;
+	}
+
+	for (cur_node = nodes, i = 0; cur_node != NULL; cur_node = cur_node->next, i++) {
+		/* the server returns the nodes in the same order as the last query */
+		if (i < sinfo->num_nodes && !strcmp(sinfo->unordered_nodes[i]->name, cur_node->name))
+			ninfo = sinfo->unordered_nodes[i];
+		else
+			ninfo = find_node_info(sinfo->nodes, cur_node->name);
+
+		if (ninfo == NULL || cur_node->attribs == NULL || cur_node->attribs->value == NULL)
+			continue;
+
+		if (ninfo->is_down || ninfo->is_offline || ninfo->is_unknown ||
+			ninfo->is_stale || ninfo->is_sleeping)
+			continue;
+
+		if (!state_is_unusable(cur_node->attribs->value))
+			continue;
+
+		set_node_info_state(ninfo, cur_node->attribs->value);
+		remove_node_from_bucket(ninfo);
+
+		if (sinfo->node_group_enable && sinfo->node_group_key != NULL) {
+			node_info *arr[2];
+			arr[0] = ninfo;
+			arr[1] = NULL;
+			node_partition_update_array(sinfo->policy, sinfo->nodepart, (node_info **) arr);
+		}
+
+		schdlogf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_NODE, LOG_DEBUG, ninfo->name,
+			"Node state changed to %s during the cycle",
+			cur_node->attribs->value);
+		changed++;
+	}
+	pbs_statfree(nodes);
+
+	if (changed > 0) {
+		if (sinfo->node_group_enable && sinfo->node_group_key != NULL)
+			qsort(sinfo->nodepart, sinfo->num_parts,
+				sizeof(node_partition *), cmp_placement_sets);
+		update_all_nodepart(sinfo->policy, sinfo, NULL, NO_ALLPART);
+	}
+
+	return changed;
+}
+
 /**
  * @brief
  * 		filter function to check if node is in a string array of node names
@@ -5481,7 +5593,6 @@ create_node_array_from_str(node_info **nodes, char **strnodes)
 	int i, j;
 	node_info **ninfo_arr;
 	int cnt;
-	char errbuf[MAX_LOG_SIZE];
 
 	if (nodes == NULL || strnodes == NULL)
 		return NULL;
@@ -5502,8 +5613,8 @@ create_node_array_from_str(node_info **nodes, char **strnodes)
 				ninfo_arr[j] = NULL;
 			}
 			else {
-				snprintf(errbuf, MAX_LOG_SIZE, "Node %s not found in list.", strnodes[i]);
-				schdlog(PBSEVENT_DEBUG2, PBS_EVENTCLASS_NODE, LOG_DEBUG, __func__, errbuf);
+				schdlogf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_NODE, LOG_DEBUG, __func__,
+					"Node %s not found in list.", strnodes[i]);
 			}
 		}
 	}
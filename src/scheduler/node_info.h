@@ -612,6 +612,14 @@ int node_up_event(node_info *node, void *arg);
  */
 int node_down_event(node_info *node, void *arg);
 
+/*
+ *	refresh_node_states - mark nodes which became unusable since the
+ *			      universe was queried
+ *
+ *	return number of nodes changed or -1 on error
+ */
+int refresh_node_states(int pbs_sd, server_info *sinfo);
+
 /*
  *	create a node_info array from a list of nodes in a string array
  */
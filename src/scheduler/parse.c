@@ -303,6 +303,15 @@ parse_config(char *fname)
 					conf.enforce_no_shares = num ? 1 : 0;
 				else if (!strcmp(config_name, PARSE_ALLOW_AOE_CALENDAR))
 					conf.allow_aoe_calendar = 1;
+				else if (!strcmp(config_name, PARSE_DUMP_SNAPSHOT))
+					conf.dump_snapshot = num ? 1 : 0;
+				else if (!strcmp(config_name, PARSE_CYCLE_STATS))
+					conf.cycle_stats = num ? 1 : 0;
+				else if (!strcmp(config_name, PARSE_CYCLE_SLICE)) {
+					conf.cycle_slice = res_to_num(config_value, &type);
+					if (!type.is_time || conf.cycle_slice < 0)
+						error = 1;
+				}
 				else if (!strcmp(config_name, PARSE_PRIME_SPILL)) {
 					if (prime == PRIME || prime == ALL)
 						conf.prime_spill = res_to_num(config_value, &type);
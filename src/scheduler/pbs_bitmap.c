@@ -43,6 +43,26 @@
 
 #define BYTES_TO_BITS(x) ((x) * 8)
 
+/**
+ * @brief find the index of the lowest on bit in a non-zero long
+ * @param[in] word - the long to search (must not be 0)
+ * @return int
+ * @retval index of the lowest on bit
+ */
+static int
+lowest_on_bit(unsigned long word)
+{
+#ifdef __GNUC__
+	return __builtin_ctzl(word);
+#else
+	int i;
+
+	for (i = 0; !(word & 1UL); i++)
+		word >>= 1;
+	return i;
+#endif
+}
+
 
 /**
  * @brief allocate space for a pbs_bitmap (and possibly the bitmap itself)
@@ -215,44 +235,32 @@ pbs_bitmap_next_on_bit(pbs_bitmap *pbm, long start_bit)
 {
 	long long_ind;
 	long bit;
-	int i;
-	
+	unsigned long word;
+
 	if (pbm == NULL)
 		return -1;
-	
-	if (start_bit >= pbm->num_bits)
+
+	if (start_bit + 1 >= pbm->num_bits)
 		return -1;
-	
-	long_ind = start_bit / BYTES_TO_BITS(sizeof(unsigned long));
-	bit = start_bit % BYTES_TO_BITS(sizeof(unsigned long));
 
-	/* special case - look at first long that contains start_bit */
-	if (pbm->bits[long_ind] != 0) {
-		for (i = bit + 1; i < BYTES_TO_BITS(sizeof(unsigned long)); i++) {
-			if (pbm->bits[long_ind] & (1UL << i)) {
-				return (long_ind * BYTES_TO_BITS(sizeof(unsigned long)) + i);
-			}
-		}
+	long_ind = (start_bit + 1) / BYTES_TO_BITS(sizeof(unsigned long));
+	bit = (start_bit + 1) % BYTES_TO_BITS(sizeof(unsigned long));
 
-		/* didn't find an on bit after start_bit_index in the long that contained start_bit */
-		if (long_ind < pbm->num_longs) {
-			long_ind++;
-		}
-	}
+	/* mask off the bits up to and including start_bit in the first long */
+	word = pbm->bits[long_ind] & (~0UL << bit);
 
-	for( ; long_ind < pbm->num_longs && pbm->bits[long_ind] == 0; long_ind++)
-		;
+	/* Look at a whole long at a time and skip over the ones with no on bits */
+	while (word == 0) {
+		if (++long_ind >= pbm->num_longs)
+			return -1;
+		word = pbm->bits[long_ind];
+	}
 
-	if (long_ind == pbm->num_longs)
+	bit = long_ind * BYTES_TO_BITS(sizeof(unsigned long)) + lowest_on_bit(word);
+	if (bit >= pbm->num_bits)
 		return -1;
 
-	for (i = 0 ; i < BYTES_TO_BITS(sizeof(unsigned long)) ; i++) {
-		if (pbm->bits[long_ind] & (1UL << i)) {
-			return (long_ind * BYTES_TO_BITS(sizeof(unsigned long)) + i);
-		}
-	}
-
-	return -1;
+	return bit;
 }
 
 /**
@@ -332,3 +340,28 @@ pbs_bitmap_is_equal(pbs_bitmap *L, pbs_bitmap *R)
 	
 	return 1;
 }
+
+/**
+ * @brief pbs_bitmap version of L &= R
+ * @param L - bitmap lvalue
+ * @param R - bitmap rvalue
+ * @return int
+ * @retval 1 success
+ * @retval 0 failure
+ */
+int
+pbs_bitmap_and(pbs_bitmap *L, pbs_bitmap *R)
+{
+	long i;
+
+	if (L == NULL || R == NULL)
+		return 0;
+
+	for (i = 0; i < L->num_longs && i < R->num_longs; i++)
+		L->bits[i] &= R->bits[i];
+	/* bits past the end of R are off in R */
+	for (; i < L->num_longs; i++)
+		L->bits[i] = 0;
+
+	return 1;
+}
@@ -75,6 +75,9 @@ int pbs_bitmap_next_on_bit(pbs_bitmap *pbm, long start_bit);
 /* pbs_bitmap's version of L = R */
 int pbs_bitmap_assign(pbs_bitmap *L, pbs_bitmap *R);
 
+/* pbs_bitmap's version of L &= R */
+int pbs_bitmap_and(pbs_bitmap *L, pbs_bitmap *R);
+
 /* pbs_bitmap's version of L == R */
 int pbs_bitmap_is_equal(pbs_bitmap *L, pbs_bitmap *R);
 
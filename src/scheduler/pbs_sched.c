@@ -1299,6 +1299,9 @@ main(int argc, char *argv[])
 #endif
 	pid = getpid();
 	daemon_protect(0, PBS_DAEMON_PROTECT_ON);
+
+	/* write the log from a background thread if PBS_LOG_ASYNC is set */
+	(void)log_async_start();
 	freopen("/dev/null", "r", stdin);
 
 	/* write schedulers pid into lockfile */
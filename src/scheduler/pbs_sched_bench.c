@@ -0,0 +1,703 @@
+/*
+ * Copyright (C) 1994-2018 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * PBS Pro is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * For a copy of the commercial license terms and conditions,
+ * go to: (http://www.pbspro.com/UserArea/agreement.html)
+ * or contact the Altair Legal Department.
+ *
+ * Altair’s dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of PBS Pro and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair’s trademarks, including but not limited to "PBS™",
+ * "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's
+ * trademark licensing policies.
+ *
+ */
+
+/**
+ * @file    pbs_sched_bench.c
+ *
+ * @brief
+ * 		pbs_sched_bench - replay a scheduling cycle captured with
+ * 		dump_snapshot (see snapshot.c) and report where the time went.
+ *
+ * 		The IFL calls the scheduler makes are answered from the snapshot
+ * 		instead of a server.  Every pbs_* call which ifl_impl.c passes
+ * 		through to the library is defined here so nothing is ever sent over
+ * 		the wire: stat calls return copies of the snapshot, run and preempt
+ * 		requests are recorded and printed and everything else succeeds or
+ * 		fails with PBSE_NOSUP.  The server state is the same every cycle, so
+ * 		each cycle replays the captured cycle.
+ *
+ * Functions included are:
+ * 	main()
+ * 	time()
+ * 	dup_snapshot_list()
+ * 	pbs_*() replacements
+ *
+ */
+#include <pbs_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <libpbs.h>
+#include <pbs_ifl.h>
+#include <pbs_error.h>
+#include <pbs_internal.h>
+#include <pbs_share.h>
+#include <pbs_version.h>
+#include <ifl_internal.h>
+#include <libutil.h>
+#include <log.h>
+#include "data_types.h"
+#include "constant.h"
+#include "config.h"
+#include "globals.h"
+#include "misc.h"
+#include "fifo.h"
+#include "cycle_prof.h"
+#include "snapshot.h"
+
+/*
+ * The connection handed to scheduling_cycle().  SIMULATE_SD would make the
+ * scheduler skip the calls to run and preempt jobs, and those are part of
+ * what is being measured.  The value is never used for I/O because every
+ * call made with it is answered below.
+ */
+#define BENCH_SD	(NCONNECTS - 1)
+
+static char usage[] = "[-I sched_name] [-L logfile] [-n cycles] snapshot_dir";
+
+/* the captured universe */
+static time_t snap_time;
+static struct batch_status *snap_server;
+static struct batch_status *snap_sched;
+static struct batch_status *snap_resources;
+static struct batch_status *snap_nodes;
+static struct batch_status *snap_queues;
+static struct batch_status *snap_jobs;
+static struct batch_status *snap_resvs;
+
+/* jobs held by a checkpoint preemption in the current cycle */
+static char **held_jobs;
+
+/* number of jobs run in the current cycle */
+static int jobs_run;
+
+/* wall clock time the current cycle was started at */
+static struct timeval cycle_start;
+
+/**
+ * @brief
+ *		the scheduler's clock.  Time starts at the time the snapshot was
+ *		taken at the beginning of every cycle and then advances with the
+ *		wall clock so the replayed cycle sees the same calendar.
+ *
+ * @param[out]	tloc	-	if not NULL, the time is also stored here
+ *
+ * @return	time_t
+ */
+time_t
+time(time_t *tloc)
+{
+	struct timeval now;
+	time_t t;
+
+	gettimeofday(&now, NULL);
+	t = snap_time + (now.tv_sec - cycle_start.tv_sec);
+	if (tloc != NULL)
+		*tloc = t;
+
+	return t;
+}
+
+/**
+ * @brief
+ *		is an attribute requested by an attrl list?
+ *
+ * @param[in]	attrib	-	requested attributes (NULL means all)
+ * @param[in]	name	-	attribute name
+ *
+ * @return	int
+ * @retval	1	: requested
+ * @retval	0	: not requested
+ */
+static int
+attr_requested(struct attrl *attrib, char *name)
+{
+	struct attrl *cur;
+
+	if (attrib == NULL)
+		return 1;
+
+	for (cur = attrib; cur != NULL; cur = cur->next)
+		if (!strcmp(cur->name, name))
+			return 1;
+
+	return 0;
+}
+
+/**
+ * @brief
+ *		does an object match a pbs_selstat() selection list?  Only the
+ *		EQ and NE operators the scheduler uses are understood.  Like the
+ *		server, a selection on the destination matches the job's queue.
+ *
+ * @param[in]	bs	-	object to check
+ * @param[in]	sel	-	selection list
+ *
+ * @return	int
+ * @retval	1	: match
+ * @retval	0	: no match
+ */
+static int
+selected(struct batch_status *bs, struct attropl *sel)
+{
+	struct attropl *cur;
+	struct attrl *attrp;
+	char *name;
+	char *value;
+
+	for (cur = sel; cur != NULL; cur = cur->next) {
+		name = strcmp(cur->name, ATTR_q) ? cur->name : ATTR_queue;
+		value = NULL;
+		for (attrp = bs->attribs; attrp != NULL; attrp = attrp->next) {
+			if (!strcmp(attrp->name, name) &&
+				(cur->resource == NULL || (attrp->resource != NULL &&
+				!strcmp(attrp->resource, cur->resource)))) {
+				value = attrp->value;
+				break;
+			}
+		}
+
+		if (cur->op == EQ && (value == NULL || strcmp(value, cur->value)))
+			return 0;
+		if (cur->op == NE && value != NULL && !strcmp(value, cur->value))
+			return 0;
+	}
+
+	return 1;
+}
+
+/**
+ * @brief
+ *		copy (part of) a snapshot list the way the server would return it
+ *
+ * @param[in]	bs	-	snapshot list
+ * @param[in]	id	-	only copy the object with this name (NULL or "" for all)
+ * @param[in]	sel	-	only copy objects matching this selection
+ * @param[in]	attrib	-	only copy these attributes (NULL for all)
+ *
+ * @return	struct batch_status *
+ * @retval	NULL	: nothing matched or on error (pbs_errno is set)
+ */
+static struct batch_status *
+dup_snapshot_list(struct batch_status *bs, char *id, struct attropl *sel,
+	struct attrl *attrib)
+{
+	struct batch_status *head = NULL;
+	struct batch_status *tail = NULL;
+	struct batch_status *nbs;
+	struct attrl *attrp;
+	struct attrl *nattr;
+	struct attrl *attr_tail;
+	char *value;
+
+	pbs_errno = PBSE_NONE;
+
+	for (; bs != NULL; bs = bs->next) {
+		if (id != NULL && *id != '\0' && strcmp(bs->name, id))
+			continue;
+		if (!selected(bs, sel))
+			continue;
+
+		if ((nbs = calloc(1, sizeof(struct batch_status))) == NULL)
+			goto err;
+		if (tail == NULL)
+			head = nbs;
+		else
+			tail->next = nbs;
+		tail = nbs;
+		if ((nbs->name = string_dup(bs->name)) == NULL)
+			goto err;
+
+		attr_tail = NULL;
+		for (attrp = bs->attribs; attrp != NULL; attrp = attrp->next) {
+			if (!attr_requested(attrib, attrp->name))
+				continue;
+
+			value = attrp->value;
+			/* a checkpointed job is held by the server */
+			if (!strcmp(attrp->name, ATTR_state) &&
+				is_string_in_arr(held_jobs, bs->name))
+				value = "H";
+
+			if ((nattr = calloc(1, sizeof(struct attrl))) == NULL)
+				goto err;
+			if (attr_tail == NULL)
+				nbs->attribs = nattr;
+			else
+				attr_tail->next = nattr;
+			attr_tail = nattr;
+			nattr->op = SET;
+			if ((nattr->name = string_dup(attrp->name)) == NULL ||
+				(attrp->resource != NULL &&
+				(nattr->resource = string_dup(attrp->resource)) == NULL) ||
+				(nattr->value = string_dup(value)) == NULL)
+				goto err;
+		}
+	}
+
+	if (head == NULL && id != NULL && *id != '\0')
+		pbs_errno = PBSE_UNKJOBID;
+
+	return head;
+
+err:
+	__pbs_statfree(head);
+	pbs_errno = PBSE_SYSTEM;
+	return NULL;
+}
+
+/*
+ * Replacements for the IFL calls.  See ifl_impl.c for the calls they
+ * stand in for.
+ */
+
+struct batch_status *
+pbs_statserver(int c, struct attrl *attrib, char *extend)
+{
+	return dup_snapshot_list(snap_server, NULL, NULL, attrib);
+}
+
+struct batch_status *
+pbs_statsched(int c, struct attrl *attrib, char *extend)
+{
+	return dup_snapshot_list(snap_sched, NULL, NULL, attrib);
+}
+
+struct batch_status *
+pbs_statrsc(int c, char *id, struct attrl *attrib, char *extend)
+{
+	return dup_snapshot_list(snap_resources, id, NULL, attrib);
+}
+
+struct batch_status *
+pbs_statvnode(int c, char *id, struct attrl *attrib, char *extend)
+{
+	return dup_snapshot_list(snap_nodes, id, NULL, attrib);
+}
+
+struct batch_status *
+pbs_statnode(int c, char *id, struct attrl *attrib, char *extend)
+{
+	return dup_snapshot_list(snap_nodes, id, NULL, attrib);
+}
+
+struct batch_status *
+pbs_stathost(int c, char *id, struct attrl *attrib, char *extend)
+{
+	return dup_snapshot_list(snap_nodes, id, NULL, attrib);
+}
+
+struct batch_status *
+pbs_statque(int c, char *id, struct attrl *attrib, char *extend)
+{
+	return dup_snapshot_list(snap_queues, id, NULL, attrib);
+}
+
+struct batch_status *
+pbs_statjob(int c, char *id, struct attrl *attrib, char *extend)
+{
+	return dup_snapshot_list(snap_jobs, id, NULL, attrib);
+}
+
+struct batch_status *
+pbs_selstat(int c, struct attropl *attrib, struct attrl *rattrib, char *extend)
+{
+	return dup_snapshot_list(snap_jobs, NULL, attrib, rattrib);
+}
+
+struct batch_status *
+pbs_statresv(int c, char *id, struct attrl *attrib, char *extend)
+{
+	return dup_snapshot_list(snap_resvs, id, NULL, attrib);
+}
+
+struct batch_status *
+pbs_stathook(int c, char *id, struct attrl *attrib, char *extend)
+{
+	pbs_errno = PBSE_NONE;
+	return NULL;
+}
+
+void
+pbs_statfree(struct batch_status *bsp)
+{
+	__pbs_statfree(bsp);
+}
+
+int
+pbs_runjob(int c, char *jobid, char *location, char *extend)
+{
+	jobs_run++;
+	printf("\trun %s %s\n", jobid, location == NULL ? "" : location);
+	pbs_errno = PBSE_NONE;
+	return 0;
+}
+
+int
+pbs_asyrunjob(int c, char *jobid, char *location, char *extend)
+{
+	return pbs_runjob(c, jobid, location, extend);
+}
+
+int
+pbs_sigjob(int c, char *jobid, char *signal, char *extend)
+{
+	printf("\tpreempt %s signal %s\n", jobid, signal);
+	pbs_errno = PBSE_NONE;
+	return 0;
+}
+
+int
+pbs_holdjob(int c, char *jobid, char *holdtype, char *extend)
+{
+	printf("\tpreempt %s checkpoint\n", jobid);
+	add_str_to_array(&held_jobs, jobid);
+	pbs_errno = PBSE_NONE;
+	return 0;
+}
+
+int
+pbs_rlsjob(int c, char *jobid, char *holdtype, char *extend)
+{
+	pbs_errno = PBSE_NONE;
+	return 0;
+}
+
+int
+pbs_rerunjob(int c, char *jobid, char *extend)
+{
+	printf("\tpreempt %s requeue\n", jobid);
+	pbs_errno = PBSE_NONE;
+	return 0;
+}
+
+int
+pbs_alterjob(int c, char *jobid, struct attrl *attrib, char *extend)
+{
+	pbs_errno = PBSE_NONE;
+	return 0;
+}
+
+int
+pbs_manager(int c, int command, int objtype, char *objname,
+	struct attropl *attrib, char *extend)
+{
+	pbs_errno = PBSE_NONE;
+	return 0;
+}
+
+int
+pbs_confirmresv(int c, char *resv_id, char *location, unsigned long start,
+	char *extend)
+{
+	printf("\tconfirm %s %s\n", resv_id, location == NULL ? "" : location);
+	pbs_errno = PBSE_NONE;
+	return 0;
+}
+
+int
+pbs_movejob(int c, char *jobid, char *destin, char *extend)
+{
+	pbs_errno = PBSE_NOSUP;
+	return pbs_errno;
+}
+
+int
+pbs_orderjob(int c, char *job1, char *job2, char *extend)
+{
+	pbs_errno = PBSE_NOSUP;
+	return pbs_errno;
+}
+
+int
+pbs_msgjob(int c, char *jobid, int fileopt, char *msg, char *extend)
+{
+	pbs_errno = PBSE_NOSUP;
+	return pbs_errno;
+}
+
+int
+pbs_deljob(int c, char *jobid, char *extend)
+{
+	pbs_errno = PBSE_NOSUP;
+	return pbs_errno;
+}
+
+int
+pbs_delresv(int c, char *resv_id, char *extend)
+{
+	pbs_errno = PBSE_NOSUP;
+	return pbs_errno;
+}
+
+int
+pbs_terminate(int c, int manner, char *extend)
+{
+	pbs_errno = PBSE_NOSUP;
+	return pbs_errno;
+}
+
+char *
+pbs_locjob(int c, char *jobid, char *extend)
+{
+	pbs_errno = PBSE_NOSUP;
+	return NULL;
+}
+
+char **
+pbs_selectjob(int c, struct attropl *attrib, char *extend)
+{
+	pbs_errno = PBSE_NOSUP;
+	return NULL;
+}
+
+char *
+pbs_submit(int c, struct attropl *attrib, char *script, char *destination,
+	char *extend)
+{
+	pbs_errno = PBSE_NOSUP;
+	return NULL;
+}
+
+char *
+pbs_submit_resv(int c, struct attropl *attrib, char *extend)
+{
+	pbs_errno = PBSE_NOSUP;
+	return NULL;
+}
+
+int
+pbs_connect(char *server)
+{
+	pbs_errno = PBSE_NOSUP;
+	return -1;
+}
+
+int
+pbs_connect_extend(char *server, char *extend_data)
+{
+	pbs_errno = PBSE_NOSUP;
+	return -1;
+}
+
+int
+pbs_disconnect(int connect)
+{
+	return 0;
+}
+
+char *
+pbs_default(void)
+{
+	return NULL;
+}
+
+char *
+pbs_geterrmsg(int connect)
+{
+	return NULL;
+}
+
+struct ecl_attribute_errors *
+pbs_get_attributes_in_error(int connect)
+{
+	return NULL;
+}
+
+/**
+ * @brief
+ *		load a snapshot
+ *
+ * @param[in]	dir	-	snapshot directory
+ *
+ * @return	int
+ * @retval	1	: success
+ * @retval	0	: failure
+ */
+static int
+load_snapshot(char *dir)
+{
+	char path[MAXPATHLEN + 1];
+	FILE *fp;
+	long t;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, SNAPSHOT_TIME);
+	if ((fp = fopen(path, "r")) == NULL) {
+		perror(path);
+		return 0;
+	}
+	if (fscanf(fp, "%ld", &t) != 1) {
+		fprintf(stderr, "%s: bad snapshot time\n", path);
+		fclose(fp);
+		return 0;
+	}
+	fclose(fp);
+	snap_time = (time_t) t;
+
+	snap_server = read_snapshot_file(dir, SNAPSHOT_SERVER);
+	snap_sched = read_snapshot_file(dir, SNAPSHOT_SCHED);
+	snap_resources = read_snapshot_file(dir, SNAPSHOT_RESOURCES);
+	snap_nodes = read_snapshot_file(dir, SNAPSHOT_NODES);
+	snap_queues = read_snapshot_file(dir, SNAPSHOT_QUEUES);
+	snap_jobs = read_snapshot_file(dir, SNAPSHOT_JOBS);
+	snap_resvs = read_snapshot_file(dir, SNAPSHOT_RESVS);
+
+	if (snap_server == NULL) {
+		fprintf(stderr, "%s: snapshot has no server\n", dir);
+		return 0;
+	}
+
+	return 1;
+}
+
+/**
+ * @brief
+ *		The entry point of pbs_sched_bench
+ *
+ * @return	int
+ * @retval	0	: success
+ * @retval	1	: failure
+ */
+int
+main(int argc, char *argv[])
+{
+	char dir[MAXPATHLEN + 1];
+	char *endp;
+	char *logfile = NULL;
+	int cycles = 1;
+	int errflg = 0;
+	int c;
+	int i;
+	int j;
+
+	execution_mode(argc, argv);
+	if (set_msgdaemonname("pbs_sched_bench")) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+
+	pbs_client_thread_set_single_threaded_mode();
+	if (pbs_client_thread_init_thread_context() != 0) {
+		fprintf(stderr, "%s: Unable to initialize thread context\n", argv[0]);
+		return 1;
+	}
+
+	if (pbs_loadconf(0) == 0)
+		return 1;
+
+	while ((c = getopt(argc, argv, "I:L:n:")) != EOF) {
+		switch (c) {
+			case 'I':
+				sc_name = optarg;
+				break;
+			case 'L':
+				logfile = optarg;
+				break;
+			case 'n':
+				cycles = strtol(optarg, &endp, 10);
+				if (*endp != '\0' || cycles <= 0)
+					errflg = 1;
+				break;
+			default:
+				errflg = 1;
+				break;
+		}
+	}
+
+	if (errflg || optind != argc - 1) {
+		fprintf(stderr, "usage: %s %s\n", argv[0], usage);
+		fprintf(stderr, "       %s --version\n", argv[0]);
+		return 1;
+	}
+
+	if (sc_name == NULL) {
+		sc_name = PBS_DFLT_SCHED_NAME;
+		dflt_sched = 1;
+	}
+
+	if (!load_snapshot(argv[optind]))
+		return 1;
+
+	/* the snapshot's sched_priv stands in for PBS_HOME/sched_priv */
+	if (realpath(argv[optind], dir) == NULL) {
+		perror(argv[optind]);
+		return 1;
+	}
+	pbs_conf.pbs_home_path = strdup(dir);
+	snprintf(dir, sizeof(dir), "%s/%s", pbs_conf.pbs_home_path, SNAPSHOT_PRIV);
+	if (chdir(dir) == -1) {
+		perror(dir);
+		return 1;
+	}
+
+	if (logfile != NULL && log_open(logfile, pbs_conf.pbs_home_path) == -1) {
+		fprintf(stderr, "%s: logfile could not be opened\n", argv[0]);
+		return 1;
+	}
+
+	gettimeofday(&cycle_start, NULL);
+	if (schedinit() != 0)
+		return 1;
+
+	/* never snapshot the replay and never talk to peer servers */
+	conf.dump_snapshot = 0;
+	for (i = 0; i < NUM_PEERS; i++)
+		conf.peer_queues[i].local_queue = NULL;
+
+	for (i = 1; i <= cycles; i++) {
+		printf("cycle %d\n", i);
+		jobs_run = 0;
+		free_string_array(held_jobs);
+		held_jobs = NULL;
+
+		gettimeofday(&cycle_start, NULL);
+		scheduling_cycle(BENCH_SD, NULL);
+
+		printf("\t%d jobs run\n", jobs_run);
+		for (j = 0; j < PROF_NUM_PHASES; j++)
+			printf("\t%-12s %12.6f s %10lu calls\n", prof_phase_name(j),
+				cycle_prof[j].time, cycle_prof[j].calls);
+	}
+
+	return 0;
+}
@@ -86,6 +86,8 @@
 #include "limits_if.h"
 #include "pbs_internal.h"
 #include "fifo.h"
+#include "topjob_cache.h"
+#include "snapshot.h"
 
 /**
  * @brief
@@ -158,6 +160,9 @@ query_queues(status *policy, int pbs_sd, server_info *sinfo)
 		return NULL;
 	}
 
+	sinfo->config_fp = fingerprint_batch_status(sinfo->config_fp, queues);
+	snapshot_add(SNAPSHOT_QUEUES, queues);
+
 	cur_queue = queues;
 
 	while (cur_queue != NULL) {
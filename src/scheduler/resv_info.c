@@ -85,6 +85,7 @@
 #include "constant.h"
 #include "node_partition.h"
 #include "pbs_internal.h"
+#include "snapshot.h"
 
 
 /**
@@ -114,6 +115,7 @@ stat_resvs(int pbs_sd)
 		}
 		return NULL;
 	}
+	snapshot_add(SNAPSHOT_RESVS, resvs);
 	return resvs;
 }
 
@@ -143,6 +143,9 @@
 #include "pbs_sched.h"
 #include "fifo.h"
 #include "buckets.h"
+#include "node_bitmaps.h"
+#include "topjob_cache.h"
+#include "snapshot.h"
 #ifdef NAS
 #include "site_code.h"
 #endif
@@ -189,6 +192,8 @@ query_server(status *pol, int pbs_sd)
 	if (pol == NULL)
 		return NULL;
 
+	snapshot_begin(pbs_sd, pol->current_time);
+
 	if (update_resource_defs(pbs_sd) == 0) {
 		schdlog(PBSEVENT_SCHED, PBS_EVENTCLASS_SCHED, LOG_WARNING, "resources",
 			"Failed to update global resource definition arrays");
@@ -205,6 +210,7 @@ query_server(status *pol, int pbs_sd)
 			log_buffer);
 		return NULL;
 	}
+	snapshot_add(SNAPSHOT_SERVER, server);
 
 	/* convert batch_status structure into server_info structure */
 	if ((sinfo = query_server_info(pol, server)) == NULL) {
@@ -212,6 +218,8 @@ query_server(status *pol, int pbs_sd)
 		return NULL;
 	}
 
+	sinfo->config_fp = fingerprint_batch_status(TJC_FP_INIT, server);
+
 	/* We dup'd the policy structure for the cycle */
 	policy = sinfo->policy;
 
@@ -226,6 +234,7 @@ query_server(status *pol, int pbs_sd)
 	}
 
 	all_sched = pbs_statsched(pbs_sd, NULL, NULL);
+	snapshot_add(SNAPSHOT_SCHED, all_sched);
 	sched = bs_find(all_sched, sc_name);
 
 	if (sched == NULL) {
@@ -447,6 +456,8 @@ query_server(status *pol, int pbs_sd)
 	}
 	sinfo->unordered_nodes[i] = NULL;
 
+	sinfo->node_bits = create_node_bitmaps(sinfo->unordered_nodes, sinfo->num_nodes);
+
 	adjust_alter_resv_nodes(sinfo->resvs, sinfo->nodes);
 
 	/* Create placement sets  after collecting jobs on nodes because
@@ -1072,6 +1083,8 @@ free_server_info(server_info *sinfo)
 	
 	if(sinfo->unordered_nodes != NULL)
 		free(sinfo->unordered_nodes);
+	if (sinfo->node_bits != NULL)
+		free_node_bitmaps(sinfo->node_bits);
 
 	free_resource_list(sinfo->res);
 #ifdef NAS
@@ -1222,6 +1235,8 @@ new_server_info(int limallocflag)
 	sinfo->equiv_classes = NULL;
 	sinfo->buckets = NULL;
 	sinfo->unordered_nodes = NULL;
+	sinfo->node_bits = NULL;
+	sinfo->config_fp = 0;
 	sinfo->num_queues = 0;
 	sinfo->num_nodes = 0;
 	sinfo->num_resvs = 0;
@@ -2188,6 +2203,7 @@ dup_server_info(server_info *osinfo)
 	nsinfo->preempt_targets_enable = osinfo->preempt_targets_enable;
 	nsinfo->liminfo = lim_dup_liminfo(osinfo->liminfo);
 	nsinfo->server_time = osinfo->server_time;
+	nsinfo->config_fp = osinfo->config_fp;
 	nsinfo->flt_lic = osinfo->flt_lic;
 	nsinfo->res = dup_resource_list(osinfo->res);
 	nsinfo->alljobcounts = dup_counts_list(osinfo->alljobcounts);
@@ -2220,6 +2236,7 @@ dup_server_info(server_info *osinfo)
 		nsinfo->unassoc_nodes = nsinfo->nodes;
 	
 	nsinfo->unordered_nodes = dup_unordered_nodes(osinfo->unordered_nodes, nsinfo->nodes);
+	nsinfo->node_bits = dup_node_bitmaps(osinfo->node_bits);
 
 	/* dup the reservations */
 	nsinfo->resvs = dup_resource_resv_array(osinfo->resvs, nsinfo, NULL);
@@ -0,0 +1,481 @@
+/*
+ * Copyright (C) 1994-2018 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * PBS Pro is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * For a copy of the commercial license terms and conditions,
+ * go to: (http://www.pbspro.com/UserArea/agreement.html)
+ * or contact the Altair Legal Department.
+ *
+ * Altair’s dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of PBS Pro and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair’s trademarks, including but not limited to "PBS™",
+ * "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's
+ * trademark licensing policies.
+ *
+ */
+
+/**
+ * @file    snapshot.c
+ *
+ * @brief
+ * 		Capture the universe a scheduling cycle saw so it can be replayed
+ * 		offline (see pbs_sched_bench).
+ *
+ * 		When dump_snapshot is set in the sched_config, every batch_status
+ * 		list the scheduler receives from the server during a cycle is
+ * 		written to sched_priv/snapshot.new.  At the end of the cycle the
+ * 		sched_priv files which drive the cycle (sched_config, usage,
+ * 		holidays, resource_group, dedicated_time and the job sort formula)
+ * 		are copied alongside and the directory is renamed to
+ * 		sched_priv/snapshot, replacing the previous cycle's snapshot.
+ *
+ * 		Each batch_status file is plain text.  A line starting in the first
+ * 		column is the name of an object.  The object's attributes follow,
+ * 		one per line, as tab separated name, resource and value.  Tabs,
+ * 		newlines and backslashes in values are escaped with a backslash.
+ *
+ * Functions included are:
+ * 	snapshot_begin()
+ * 	snapshot_add()
+ * 	snapshot_end()
+ * 	read_snapshot_file()
+ *
+ */
+#include <pbs_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <pbs_ifl.h>
+#include <pbs_share.h>
+#include <pbs_internal.h>
+#include <libutil.h>
+#include <log.h>
+#include "constant.h"
+#include "config.h"
+#include "globals.h"
+#include "misc.h"
+#include "snapshot.h"
+
+#define SNAPSHOT_FORMULA	"sched_formula"
+
+/* batch_status files in a snapshot */
+static char *snapshot_files[] = {
+	SNAPSHOT_TIME,
+	SNAPSHOT_SERVER,
+	SNAPSHOT_SCHED,
+	SNAPSHOT_RESOURCES,
+	SNAPSHOT_NODES,
+	SNAPSHOT_QUEUES,
+	SNAPSHOT_JOBS,
+	SNAPSHOT_RESVS,
+	NULL
+};
+
+/* sched_priv files copied into a snapshot */
+static char *snapshot_priv_files[] = {
+	CONFIG_FILE,
+	USAGE_FILE,
+	HOLIDAYS_FILE,
+	RESGROUP_FILE,
+	DEDTIME_FILE,
+	SNAPSHOT_FORMULA,
+	NULL
+};
+
+/* are we capturing the current cycle? */
+static int snapshot_active = 0;
+
+/**
+ * @brief
+ *		remove a snapshot directory and everything we put in it
+ *
+ * @param[in]	dir	-	snapshot directory
+ *
+ * @return	nothing
+ */
+static void
+remove_snapshot_dir(char *dir)
+{
+	char path[MAXPATHLEN + 1];
+	int i;
+
+	for (i = 0; snapshot_files[i] != NULL; i++) {
+		snprintf(path, sizeof(path), "%s/%s", dir, snapshot_files[i]);
+		(void) unlink(path);
+	}
+	for (i = 0; snapshot_priv_files[i] != NULL; i++) {
+		snprintf(path, sizeof(path), "%s/%s/%s", dir, SNAPSHOT_PRIV,
+			snapshot_priv_files[i]);
+		(void) unlink(path);
+	}
+	snprintf(path, sizeof(path), "%s/%s", dir, SNAPSHOT_PRIV);
+	(void) rmdir(path);
+	(void) rmdir(dir);
+}
+
+/**
+ * @brief
+ *		copy a file byte for byte (the usage file is binary)
+ *
+ * @param[in]	src	-	file to copy
+ * @param[in]	dst	-	file to create
+ *
+ * @return	int
+ * @retval	1	: success or src does not exist
+ * @retval	0	: failure
+ */
+static int
+copy_snapshot_file(char *src, char *dst)
+{
+	FILE *in;
+	FILE *out;
+	char buf[BUFSIZ];
+	size_t len;
+	int rc = 1;
+
+	if ((in = fopen(src, "rb")) == NULL)
+		return 1;
+
+	if ((out = fopen(dst, "wb")) == NULL) {
+		fclose(in);
+		return 0;
+	}
+
+	while ((len = fread(buf, 1, sizeof(buf), in)) > 0) {
+		if (fwrite(buf, 1, len, out) != len) {
+			rc = 0;
+			break;
+		}
+	}
+
+	fclose(in);
+	if (fclose(out) != 0)
+		rc = 0;
+
+	return rc;
+}
+
+/**
+ * @brief
+ *		write a string escaping tabs, newlines and backslashes
+ *
+ * @param[in]	fp	-	file to write to
+ * @param[in]	str	-	string to write (NULL is written as empty)
+ *
+ * @return	nothing
+ */
+static void
+write_escaped(FILE *fp, char *str)
+{
+	char *p;
+
+	if (str == NULL)
+		return;
+
+	for (p = str; *p != '\0'; p++) {
+		switch (*p) {
+			case '\\':
+				fputs("\\\\", fp);
+				break;
+			case '\t':
+				fputs("\\t", fp);
+				break;
+			case '\n':
+				fputs("\\n", fp);
+				break;
+			default:
+				fputc(*p, fp);
+		}
+	}
+}
+
+/**
+ * @brief
+ *		undo write_escaped() in place
+ *
+ * @param[in,out]	str	-	string to unescape
+ *
+ * @return	nothing
+ */
+static void
+unescape(char *str)
+{
+	char *p;
+	char *q;
+
+	for (p = q = str; *p != '\0'; p++) {
+		if (*p == '\\' && p[1] != '\0') {
+			p++;
+			if (*p == 't')
+				*q++ = '\t';
+			else if (*p == 'n')
+				*q++ = '\n';
+			else
+				*q++ = *p;
+		} else
+			*q++ = *p;
+	}
+	*q = '\0';
+}
+
+/**
+ * @brief
+ *		start capturing the current cycle.  Nothing is done unless
+ *		dump_snapshot is set in the sched_config.  The resource definitions
+ *		are always queried here because the scheduler only queries them
+ *		when they change.
+ *
+ * @param[in]	pbs_sd	-	connection to the server
+ * @param[in]	now	-	the time of the cycle
+ *
+ * @return	int
+ * @retval	1	: capturing this cycle
+ * @retval	0	: not capturing this cycle
+ */
+int
+snapshot_begin(int pbs_sd, time_t now)
+{
+	char path[MAXPATHLEN + 1];
+	struct batch_status *bs;
+	FILE *fp;
+
+	snapshot_active = 0;
+
+	if (!conf.dump_snapshot)
+		return 0;
+
+	remove_snapshot_dir(SNAPSHOT_TMP_DIR);
+	snprintf(path, sizeof(path), "%s/%s", SNAPSHOT_TMP_DIR, SNAPSHOT_PRIV);
+	if (mkdir(SNAPSHOT_TMP_DIR, 0750) == -1 || mkdir(path, 0750) == -1) {
+		log_err(errno, __func__, "Can not create snapshot directory");
+		return 0;
+	}
+
+	snprintf(path, sizeof(path), "%s/%s", SNAPSHOT_TMP_DIR, SNAPSHOT_TIME);
+	if ((fp = fopen(path, "w")) == NULL) {
+		log_err(errno, __func__, "Can not create snapshot");
+		return 0;
+	}
+	fprintf(fp, "%ld\n", (long) now);
+	fclose(fp);
+
+	snapshot_active = 1;
+
+	if ((bs = pbs_statrsc(pbs_sd, NULL, NULL, "p")) != NULL) {
+		snapshot_add(SNAPSHOT_RESOURCES, bs);
+		pbs_statfree(bs);
+	}
+
+	return snapshot_active;
+}
+
+/**
+ * @brief
+ *		add the result of a server query to the snapshot of the cycle.
+ *		Lists added to the same file are appended (e.g. the jobs of each
+ *		queue).
+ *
+ * @param[in]	file	-	snapshot file (e.g. SNAPSHOT_NODES)
+ * @param[in]	bs	-	batch_status list to add
+ *
+ * @return	nothing
+ */
+void
+snapshot_add(char *file, struct batch_status *bs)
+{
+	char path[MAXPATHLEN + 1];
+	struct batch_status *cur;
+	struct attrl *attrp;
+	FILE *fp;
+
+	if (!snapshot_active || file == NULL)
+		return;
+
+	snprintf(path, sizeof(path), "%s/%s", SNAPSHOT_TMP_DIR, file);
+	if ((fp = fopen(path, "a")) == NULL) {
+		log_err(errno, __func__, "Can not write snapshot");
+		snapshot_active = 0;
+		return;
+	}
+
+	for (cur = bs; cur != NULL; cur = cur->next) {
+		fprintf(fp, "%s\n", cur->name);
+		for (attrp = cur->attribs; attrp != NULL; attrp = attrp->next) {
+			fprintf(fp, "\t%s\t%s\t", attrp->name,
+				attrp->resource == NULL ? "" : attrp->resource);
+			write_escaped(fp, attrp->value);
+			fputc('\n', fp);
+		}
+	}
+
+	if (fclose(fp) != 0) {
+		log_err(errno, __func__, "Can not write snapshot");
+		snapshot_active = 0;
+	}
+}
+
+/**
+ * @brief
+ *		finish the snapshot of the cycle: copy the sched_priv files and
+ *		replace the previous snapshot with this one.
+ *
+ * @return	nothing
+ */
+void
+snapshot_end(void)
+{
+	char src[MAXPATHLEN + 1];
+	char dst[MAXPATHLEN + 1];
+	int i;
+
+	if (!snapshot_active)
+		return;
+	snapshot_active = 0;
+
+	for (i = 0; snapshot_priv_files[i] != NULL; i++) {
+		if (!strcmp(snapshot_priv_files[i], SNAPSHOT_FORMULA))
+			snprintf(src, sizeof(src), "%s/%s", pbs_conf.pbs_home_path,
+				FORMULA_ATTR_PATH_SCHED);
+		else
+			snprintf(src, sizeof(src), "%s", snapshot_priv_files[i]);
+		snprintf(dst, sizeof(dst), "%s/%s/%s", SNAPSHOT_TMP_DIR, SNAPSHOT_PRIV,
+			snapshot_priv_files[i]);
+		if (!copy_snapshot_file(src, dst)) {
+			log_err(errno, __func__, "Can not copy file into snapshot");
+			remove_snapshot_dir(SNAPSHOT_TMP_DIR);
+			return;
+		}
+	}
+
+	remove_snapshot_dir(SNAPSHOT_DIR);
+	if (rename(SNAPSHOT_TMP_DIR, SNAPSHOT_DIR) == -1) {
+		log_err(errno, __func__, "Can not rename snapshot directory");
+		remove_snapshot_dir(SNAPSHOT_TMP_DIR);
+		return;
+	}
+
+	schdlog(PBSEVENT_DEBUG, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__,
+		"Snapshot of the cycle written to " SNAPSHOT_DIR);
+}
+
+/**
+ * @brief
+ *		read a batch_status list back from a snapshot file
+ *
+ * @param[in]	dir	-	snapshot directory
+ * @param[in]	file	-	snapshot file (e.g. SNAPSHOT_NODES)
+ *
+ * @return	struct batch_status *
+ * @retval	NULL	: file is empty, missing or on error
+ */
+struct batch_status *
+read_snapshot_file(char *dir, char *file)
+{
+	char path[MAXPATHLEN + 1];
+	struct batch_status *head = NULL;
+	struct batch_status *bs = NULL;
+	struct batch_status *bs_tail = NULL;
+	struct attrl *attrp;
+	struct attrl *attr_tail = NULL;
+	char *buf = NULL;
+	int buf_size = 0;
+	char *name;
+	char *resource;
+	char *value;
+	char *p;
+	FILE *fp;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, file);
+	if ((fp = fopen(path, "r")) == NULL)
+		return NULL;
+
+	while (pbs_fgets(&buf, &buf_size, fp) != NULL) {
+		p = buf + strlen(buf);
+		if (p > buf && *(p - 1) == '\n')
+			*(p - 1) = '\0';
+
+		if (buf[0] != '\t') {
+			if ((bs = calloc(1, sizeof(struct batch_status))) == NULL ||
+				(bs->name = string_dup(buf)) == NULL) {
+				log_err(errno, __func__, MEM_ERR_MSG);
+				free(bs);
+				goto err;
+			}
+			if (bs_tail == NULL)
+				head = bs;
+			else
+				bs_tail->next = bs;
+			bs_tail = bs;
+			attr_tail = NULL;
+			continue;
+		}
+
+		/* an attribute line before any object name */
+		if (bs == NULL)
+			continue;
+
+		name = buf + 1;
+		if ((resource = strchr(name, '\t')) == NULL)
+			continue;
+		*resource++ = '\0';
+		if ((value = strchr(resource, '\t')) == NULL)
+			continue;
+		*value++ = '\0';
+		unescape(value);
+
+		if ((attrp = calloc(1, sizeof(struct attrl))) == NULL) {
+			log_err(errno, __func__, MEM_ERR_MSG);
+			goto err;
+		}
+		if (attr_tail == NULL)
+			bs->attribs = attrp;
+		else
+			attr_tail->next = attrp;
+		attr_tail = attrp;
+		attrp->op = SET;
+
+		if ((attrp->name = string_dup(name)) == NULL ||
+			(*resource != '\0' && (attrp->resource = string_dup(resource)) == NULL) ||
+			(attrp->value = string_dup(value)) == NULL) {
+			log_err(errno, __func__, MEM_ERR_MSG);
+			goto err;
+		}
+	}
+
+	free(buf);
+	fclose(fp);
+	return head;
+
+err:
+	free(buf);
+	fclose(fp);
+	pbs_statfree(head);
+	return NULL;
+}
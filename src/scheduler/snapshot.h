@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 1994-2018 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * PBS Pro is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * For a copy of the commercial license terms and conditions,
+ * go to: (http://www.pbspro.com/UserArea/agreement.html)
+ * or contact the Altair Legal Department.
+ *
+ * Altair’s dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of PBS Pro and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair’s trademarks, including but not limited to "PBS™",
+ * "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's
+ * trademark licensing policies.
+ *
+ */
+
+#ifndef	_SNAPSHOT_H
+#define	_SNAPSHOT_H
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <time.h>
+#include "pbs_ifl.h"
+
+/* directory (in sched_priv) the snapshot of the last cycle is written to */
+#define SNAPSHOT_DIR		"snapshot"
+#define SNAPSHOT_TMP_DIR	"snapshot.new"
+
+/* files in a snapshot directory */
+#define SNAPSHOT_TIME		"time"
+#define SNAPSHOT_SERVER		"server"
+#define SNAPSHOT_SCHED		"sched"
+#define SNAPSHOT_RESOURCES	"resources"
+#define SNAPSHOT_NODES		"nodes"
+#define SNAPSHOT_QUEUES		"queues"
+#define SNAPSHOT_JOBS		"jobs"
+#define SNAPSHOT_RESVS		"resvs"
+
+/* subdirectory of a snapshot holding copies of the sched_priv files */
+#define SNAPSHOT_PRIV		"sched_priv"
+
+/* start capturing a cycle (if dump_snapshot is set in the sched_config) */
+int snapshot_begin(int pbs_sd, time_t now);
+
+/* add the result of a server query to the snapshot */
+void snapshot_add(char *file, struct batch_status *bs);
+
+/* finish the snapshot of the cycle */
+void snapshot_end(void);
+
+/* read a batch_status list back from a snapshot file */
+struct batch_status *read_snapshot_file(char *dir, char *file);
+
+#ifdef	__cplusplus
+}
+#endif
+#endif	/* _SNAPSHOT_H */
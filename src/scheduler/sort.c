@@ -94,6 +94,7 @@
 #include "server_info.h"
 #include "resource.h"
 #include "constant.h"
+#include "cycle_prof.h"
 
 #ifdef NAS
 #include "site_code.h"
@@ -1283,6 +1284,9 @@ sort_jobs(status *policy, server_info *sinfo)
 	int job_index = 0;
 	int index = 0;
 	int count = 0;
+	double prof_start;
+
+	prof_start = prof_begin();
 
 	/** sort jobs in such a way that Higher Priority jobs come on top
 	 * followed by preempted jobs and then starving jobs and normal jobs
@@ -1340,4 +1344,6 @@ sort_jobs(status *policy, server_info *sinfo)
 	}
 	else
 		qsort(sinfo->jobs, count_array((void **)sinfo->jobs), sizeof(resource_resv*), cmp_sort);
+
+	prof_end(PROF_SORT, prof_start);
 }
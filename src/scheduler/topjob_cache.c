@@ -0,0 +1,468 @@
+/*
+ * Copyright (C) 1994-2018 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * PBS Pro is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * For a copy of the commercial license terms and conditions,
+ * go to: (http://www.pbspro.com/UserArea/agreement.html)
+ * or contact the Altair Legal Department.
+ *
+ * Altair’s dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of PBS Pro and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair’s trademarks, including but not limited to "PBS™",
+ * "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's
+ * trademark licensing policies.
+ *
+ */
+
+/**
+ * @file    topjob_cache.c
+ *
+ * @brief
+ * 		Memoized start time estimates for top jobs.
+ *
+ * 		Estimating a top job's start time requires duplicating the whole
+ * 		server and simulating the calendar forward.  On a busy system the
+ * 		same top jobs are estimated every cycle and nothing that affects
+ * 		their estimates has changed.  Each estimate is stored with a
+ * 		fingerprint of the state it was made in: the server and queue
+ * 		configuration, the server and node resources and states, the
+ * 		future events in the calendar and the job's own request.  If the
+ * 		fingerprint matches in a later cycle, the previous estimate is
+ * 		reused instead of running the simulation again.
+ *
+ * 		Computing a fingerprint walks the nodes and calendar once, which
+ * 		is considerably cheaper than duplicating them and simulating.
+ *
+ * Functions included are:
+ * 	fingerprint_batch_status()
+ * 	topjob_fingerprint()
+ * 	find_topjob_estimate()
+ * 	store_topjob_estimate()
+ * 	prune_topjob_estimates()
+ * 	clear_topjob_estimates()
+ *
+ */
+#include <pbs_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pbs_ifl.h>
+#include <log.h>
+#include "data_types.h"
+#include "constant.h"
+#include "misc.h"
+#include "simulate.h"
+#include "topjob_cache.h"
+
+#define TJC_FP_PRIME	1099511628211ULL
+
+/* attributes which change from cycle to cycle without affecting estimates */
+static char *volatile_attrs[] = {
+	ATTR_count,
+	ATTR_total,
+	ATTR_rescassn,
+	ATTR_license_count,
+	ATTR_FLicenses,
+	ATTR_status,
+	NULL
+};
+
+/* estimates kept across cycles - NULL terminated */
+static topjob_estimate **estimates = NULL;
+
+/**
+ * @brief
+ *		fold bytes into a fingerprint (64 bit FNV-1a)
+ *
+ * @param[in]	fp	-	fingerprint so far
+ * @param[in]	data	-	bytes to fold in
+ * @param[in]	len	-	number of bytes
+ *
+ * @return	new fingerprint
+ */
+static unsigned long long
+fp_bytes(unsigned long long fp, const void *data, size_t len)
+{
+	const unsigned char *p = data;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		fp ^= p[i];
+		fp *= TJC_FP_PRIME;
+	}
+
+	return fp;
+}
+
+/**
+ * @brief
+ *		fold a string into a fingerprint.  The terminating NUL is folded in
+ *		so ("ab", "c") and ("a", "bc") differ.
+ *
+ * @param[in]	fp	-	fingerprint so far
+ * @param[in]	str	-	string to fold in (may be NULL)
+ *
+ * @return	new fingerprint
+ */
+static unsigned long long
+fp_str(unsigned long long fp, const char *str)
+{
+	static const unsigned char null_str = 0xff;
+
+	if (str == NULL)
+		return fp_bytes(fp, &null_str, 1);
+
+	return fp_bytes(fp, str, strlen(str) + 1);
+}
+
+#define FP_VAL(fp, v)	fp_bytes((fp), &(v), sizeof(v))
+
+/**
+ * @brief
+ *		fold a resource list into a fingerprint
+ *
+ * @param[in]	fp	-	fingerprint so far
+ * @param[in]	res	-	resource list
+ *
+ * @return	new fingerprint
+ */
+static unsigned long long
+fp_resources(unsigned long long fp, schd_resource *res)
+{
+	schd_resource *r;
+
+	for (r = res; r != NULL; r = r->next) {
+		fp = fp_str(fp, r->name);
+		fp = fp_str(fp, r->orig_str_avail);
+		fp = FP_VAL(fp, r->avail);
+		fp = FP_VAL(fp, r->assigned);
+	}
+
+	return fp;
+}
+
+/**
+ * @brief
+ *		fold a batch_status list into a fingerprint.  Attributes which
+ *		change every cycle without affecting a start time estimate
+ *		(e.g. state_count) are skipped.
+ *
+ * @param[in]	fp	-	fingerprint so far
+ * @param[in]	bs	-	batch_status list
+ *
+ * @return	new fingerprint
+ */
+unsigned long long
+fingerprint_batch_status(unsigned long long fp, struct batch_status *bs)
+{
+	struct batch_status *cur;
+	struct attrl *attrp;
+	int i;
+
+	for (cur = bs; cur != NULL; cur = cur->next) {
+		fp = fp_str(fp, cur->name);
+		for (attrp = cur->attribs; attrp != NULL; attrp = attrp->next) {
+			for (i = 0; volatile_attrs[i] != NULL; i++)
+				if (!strcmp(attrp->name, volatile_attrs[i]))
+					break;
+			if (volatile_attrs[i] != NULL)
+				continue;
+
+			fp = fp_str(fp, attrp->name);
+			fp = fp_str(fp, attrp->resource);
+			fp = fp_str(fp, attrp->value);
+		}
+	}
+
+	return fp;
+}
+
+/**
+ * @brief
+ *		fingerprint everything a top job's start time estimate depends on
+ *
+ * @param[in]	sinfo	-	server the estimate will be made in
+ * @param[in]	resresv	-	the top job
+ *
+ * @return	fingerprint
+ */
+unsigned long long
+topjob_fingerprint(server_info *sinfo, resource_resv *resresv)
+{
+	unsigned long long fp;
+	node_info *ninfo;
+	timed_event *te;
+	resource_req *req;
+	unsigned int state;
+	unsigned int bits;
+	int i;
+
+	if (sinfo == NULL || resresv == NULL)
+		return 0;
+
+	fp = sinfo->config_fp;
+
+	bits = sinfo->policy->is_prime | (sinfo->policy->is_ded_time << 1);
+	fp = FP_VAL(fp, bits);
+
+	fp = fp_resources(fp, sinfo->res);
+
+	for (i = 0; i < sinfo->num_nodes; i++) {
+		ninfo = sinfo->nodes[i];
+		state = ninfo->is_down | (ninfo->is_free << 1) |
+			(ninfo->is_offline << 2) | (ninfo->is_unknown << 3) |
+			(ninfo->is_exclusive << 4) | (ninfo->is_job_exclusive << 5) |
+			(ninfo->is_resv_exclusive << 6) | (ninfo->is_sharing << 7) |
+			(ninfo->is_busy << 8) | (ninfo->is_job_busy << 9) |
+			(ninfo->is_stale << 10) | (ninfo->is_provisioning << 11) |
+			(ninfo->is_sleeping << 12);
+		fp = fp_str(fp, ninfo->name);
+		fp = FP_VAL(fp, state);
+		fp = FP_VAL(fp, ninfo->sharing);
+		fp = FP_VAL(fp, ninfo->num_jobs);
+		fp = FP_VAL(fp, ninfo->num_run_resv);
+		fp = FP_VAL(fp, ninfo->num_susp_jobs);
+		fp = fp_str(fp, ninfo->current_aoe);
+		fp = fp_str(fp, ninfo->current_eoe);
+		fp = fp_resources(fp, ninfo->res);
+	}
+
+	/* We only ever look from now into the future */
+	for (te = get_next_event(sinfo->calendar); te != NULL; te = te->next) {
+		bits = te->disabled;
+		fp = fp_str(fp, te->name);
+		fp = FP_VAL(fp, te->event_type);
+		fp = FP_VAL(fp, te->event_time);
+		fp = FP_VAL(fp, bits);
+	}
+
+	fp = fp_str(fp, resresv->name);
+	fp = fp_str(fp, resresv->user);
+	fp = fp_str(fp, resresv->group);
+	fp = fp_str(fp, resresv->project);
+	fp = fp_str(fp, resresv->aoename);
+	fp = fp_str(fp, resresv->eoename);
+	fp = FP_VAL(fp, resresv->duration);
+	fp = FP_VAL(fp, resresv->hard_duration);
+	fp = FP_VAL(fp, resresv->min_duration);
+	if (resresv->is_job && resresv->job != NULL && resresv->job->queue != NULL)
+		fp = fp_str(fp, resresv->job->queue->name);
+
+	for (req = resresv->resreq; req != NULL; req = req->next) {
+		fp = fp_str(fp, req->name);
+		fp = fp_str(fp, req->res_str);
+		fp = FP_VAL(fp, req->amount);
+	}
+
+	if (resresv->select != NULL && resresv->select->chunks != NULL) {
+		for (i = 0; resresv->select->chunks[i] != NULL; i++) {
+			fp = fp_str(fp, resresv->select->chunks[i]->str_chunk);
+			fp = FP_VAL(fp, resresv->select->chunks[i]->num_chunks);
+		}
+	}
+
+	if (resresv->place_spec != NULL) {
+		place *pl = resresv->place_spec;
+
+		bits = pl->free | (pl->pack << 1) | (pl->scatter << 2) |
+			(pl->vscatter << 3) | (pl->excl << 4) |
+			(pl->exclhost << 5) | (pl->share << 6);
+		fp = FP_VAL(fp, bits);
+		fp = fp_str(fp, pl->group);
+	}
+
+	if (resresv->node_set_str != NULL)
+		for (i = 0; resresv->node_set_str[i] != NULL; i++)
+			fp = fp_str(fp, resresv->node_set_str[i]);
+
+	return fp;
+}
+
+/**
+ * @brief
+ *		free a topjob_estimate
+ *
+ * @param[in]	est	-	estimate to free
+ *
+ * @return	nothing
+ */
+static void
+free_topjob_estimate(topjob_estimate *est)
+{
+	if (est == NULL)
+		return;
+
+	if (est->name != NULL)
+		free(est->name);
+	if (est->execvnode != NULL)
+		free(est->execvnode);
+	free(est);
+}
+
+/**
+ * @brief
+ *		find the previous estimate for a job.  The estimate is only returned
+ *		if it was made in the same state (fingerprint) and it is still in the
+ *		future.  A found estimate is marked as used so it survives pruning.
+ *
+ * @param[in]	name	-	name of the job
+ * @param[in]	fp	-	fingerprint of the current state
+ * @param[in]	server_time -	current time in the server
+ *
+ * @return	topjob_estimate *
+ * @retval	NULL	: no valid estimate
+ */
+topjob_estimate *
+find_topjob_estimate(char *name, unsigned long long fp, time_t server_time)
+{
+	int i;
+
+	if (name == NULL || estimates == NULL)
+		return NULL;
+
+	for (i = 0; estimates[i] != NULL; i++) {
+		if (!strcmp(estimates[i]->name, name)) {
+			if (estimates[i]->fp != fp || estimates[i]->start <= server_time)
+				return NULL;
+			estimates[i]->used = 1;
+			return estimates[i];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief
+ *		remember the estimate for a job.  Replaces any previous estimate.
+ *		Failure to store an estimate is not an error, the estimate will
+ *		simply be recalculated next cycle.
+ *
+ * @param[in]	name	-	name of the job
+ * @param[in]	fp	-	fingerprint of the state the estimate was made in
+ * @param[in]	start	-	estimated start time
+ * @param[in]	execvnode -	estimated execvnode
+ *
+ * @return	nothing
+ */
+void
+store_topjob_estimate(char *name, unsigned long long fp, time_t start, char *execvnode)
+{
+	topjob_estimate *est = NULL;
+	topjob_estimate **tmp;
+	char *exec_copy;
+	int i;
+
+	if (name == NULL || execvnode == NULL)
+		return;
+
+	if ((exec_copy = string_dup(execvnode)) == NULL)
+		return;
+
+	for (i = 0; estimates != NULL && estimates[i] != NULL; i++) {
+		if (!strcmp(estimates[i]->name, name)) {
+			est = estimates[i];
+			break;
+		}
+	}
+
+	if (est == NULL) {
+		if ((est = calloc(1, sizeof(topjob_estimate))) == NULL) {
+			log_err(errno, __func__, MEM_ERR_MSG);
+			free(exec_copy);
+			return;
+		}
+		if ((est->name = string_dup(name)) == NULL) {
+			free(est);
+			free(exec_copy);
+			return;
+		}
+		tmp = realloc(estimates, (i + 2) * sizeof(topjob_estimate *));
+		if (tmp == NULL) {
+			log_err(errno, __func__, MEM_ERR_MSG);
+			free_topjob_estimate(est);
+			free(exec_copy);
+			return;
+		}
+		estimates = tmp;
+		estimates[i] = est;
+		estimates[i + 1] = NULL;
+	}
+
+	if (est->execvnode != NULL)
+		free(est->execvnode);
+	est->execvnode = exec_copy;
+	est->fp = fp;
+	est->start = start;
+	est->used = 1;
+}
+
+/**
+ * @brief
+ *		drop the estimates of jobs which were not top jobs this cycle
+ *		(e.g. they ran or were deleted) and reset the used flag on the rest.
+ *		Called at the end of every cycle.
+ *
+ * @return	nothing
+ */
+void
+prune_topjob_estimates(void)
+{
+	int i, j;
+
+	if (estimates == NULL)
+		return;
+
+	for (i = 0, j = 0; estimates[i] != NULL; i++) {
+		if (estimates[i]->used) {
+			estimates[i]->used = 0;
+			estimates[j++] = estimates[i];
+		} else
+			free_topjob_estimate(estimates[i]);
+	}
+	estimates[j] = NULL;
+}
+
+/**
+ * @brief
+ *		drop every estimate.  Called when the scheduler is reconfigured.
+ *
+ * @return	nothing
+ */
+void
+clear_topjob_estimates(void)
+{
+	int i;
+
+	if (estimates == NULL)
+		return;
+
+	for (i = 0; estimates[i] != NULL; i++)
+		free_topjob_estimate(estimates[i]);
+	free(estimates);
+	estimates = NULL;
+}
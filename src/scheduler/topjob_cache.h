@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 1994-2018 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * PBS Pro is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * For a copy of the commercial license terms and conditions,
+ * go to: (http://www.pbspro.com/UserArea/agreement.html)
+ * or contact the Altair Legal Department.
+ *
+ * Altair’s dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of PBS Pro and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair’s trademarks, including but not limited to "PBS™",
+ * "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's
+ * trademark licensing policies.
+ *
+ */
+
+#ifndef	_TOPJOB_CACHE_H
+#define	_TOPJOB_CACHE_H
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "data_types.h"
+
+/* starting value for a fingerprint */
+#define TJC_FP_INIT	14695981039346656037ULL
+
+/* fold a batch_status list (minus the volatile attributes) into a fingerprint */
+unsigned long long fingerprint_batch_status(unsigned long long fp, struct batch_status *bs);
+
+/* fingerprint of everything a top job's start time estimate depends on */
+unsigned long long topjob_fingerprint(server_info *sinfo, resource_resv *resresv);
+
+/* find a previous estimate for a job which is still valid */
+topjob_estimate *find_topjob_estimate(char *name, unsigned long long fp, time_t server_time);
+
+/* remember the estimate for a job */
+void store_topjob_estimate(char *name, unsigned long long fp, time_t start, char *execvnode);
+
+/* drop the estimates of jobs which were not top jobs this cycle */
+void prune_topjob_estimates(void);
+
+/* drop every estimate */
+void clear_topjob_estimates(void);
+
+#ifdef	__cplusplus
+}
+#endif
+#endif	/* _TOPJOB_CACHE_H */
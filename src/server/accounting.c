@@ -45,6 +45,7 @@
  * Functions included are:
  *	acct_open()
  *	acct_record()
+ *	acct_flush()
  *	acct_close()
  */
 
@@ -56,12 +57,19 @@
 #include <sys/param.h>
 #endif
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <string.h>
 #include <errno.h>
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
+#include <stdint.h>
 #include <time.h>
+#ifndef WIN32
+#include <pthread.h>
+#include <arpa/inet.h>
+#endif
 #include "list_link.h"
 #include "attribute.h"
 #include "resource.h"
@@ -85,6 +93,10 @@ static int	     acct_opened_day;
 static int	     acct_auto_switch = 0;
 static char	    *acct_buf = 0;
 static int	     acct_bufsize = PBS_ACCT_MAX_RCD;
+static int	     acct_buf_len;	/* length of record built in acct_buf */
+static FILE	    *acct_binfile = NULL; /* binary accounting file, or NULL */
+static char	    *acct_binbuf = NULL;	/* binary record being built */
+static size_t	     acct_binbufsize = 0;
 
 /* Global Data */
 
@@ -102,6 +114,11 @@ extern char *msg_job_end_stat;
  * @brief
  * grow_acct_buf - called when need to grow the account buffer
  *
+ * @par
+ *	Used by the reservation and job update records, which size each item
+ *	before copying it.  The job start and end records are built with
+ *	acct_buf_cat() and acct_buf_printf() instead.
+ *
  * @param[out]	pb - New address in the account buffer after the reallocation
  * @param[out]	avail - Remaining size in the returned variable
  * @param[in]	need - Required extra size for reallocation
@@ -135,6 +152,136 @@ grow_acct_buf(char **pb, int *avail, int need)
 	return 0;
 }
 
+/**
+ * @brief
+ * acct_buf_need - make room for 'need' more characters at the end of the
+ *	record being built in acct_buf
+ *
+ * @par
+ *	The buffer is doubled as needed, so a record is built in a single
+ *	pass over its data, without sizing each item ahead of time.
+ *
+ * @param[in]	need - number of characters to be appended
+ *
+ * @return      Error code
+ * @retval	 0  - Success
+ * @retval	-1  - Failure
+ *
+ * @par MT-safe: No
+ */
+static int
+acct_buf_need(int need)
+{
+	int ln;
+	char *new;
+
+	if (acct_buf_len + need <= acct_bufsize)
+		return 0;
+
+	for (ln = acct_bufsize * 2; ln < acct_buf_len + need; ln *= 2)
+		;
+	new = realloc(acct_buf, (size_t)(ln+1));
+	if (new == NULL) {
+		log_err(errno, __func__, "realloc failure");
+		return (-1);
+	}
+	acct_buf = new;
+	acct_bufsize = ln;
+	return 0;
+}
+
+/**
+ * @brief
+ * acct_buf_cat - append a string to the record being built in acct_buf
+ *
+ * @param[in]	str - string to append
+ * @param[in]	len - number of characters of str to append, -1 for all
+ *
+ * @return	void
+ *
+ * @par MT-safe: No
+ */
+static void
+acct_buf_cat(const char *str, int len)
+{
+	if (len < 0)
+		len = strlen(str);
+	if (acct_buf_need(len) == -1)
+		return;
+	memcpy(acct_buf + acct_buf_len, str, len);
+	acct_buf_len += len;
+	acct_buf[acct_buf_len] = '\0';
+}
+
+/**
+ * @brief
+ * acct_buf_printf - append formatted data to the record being built in
+ *	acct_buf
+ *
+ * @param[in]	fmt - printf style format
+ * @param[in]	... - arguments for fmt
+ *
+ * @return	void
+ *
+ * @par MT-safe: No
+ */
+static void
+acct_buf_printf(const char *fmt, ...)
+{
+	va_list args;
+	int n;
+
+	va_start(args, fmt);
+	n = vsnprintf(acct_buf + acct_buf_len, acct_bufsize - acct_buf_len + 1, fmt, args);
+	va_end(args);
+	if (n < 0) {
+		acct_buf[acct_buf_len] = '\0';
+		return;
+	}
+	if (n > acct_bufsize - acct_buf_len) {
+		if (acct_buf_need(n) == -1) {
+			acct_buf[acct_buf_len] = '\0';
+			return;
+		}
+		va_start(args, fmt);
+		(void)vsnprintf(acct_buf + acct_buf_len, acct_bufsize - acct_buf_len + 1, fmt, args);
+		va_end(args);
+	}
+	acct_buf_len += n;
+}
+
+/**
+ * @brief
+ * acct_buf_cat_resc - append ".resource=value " for an encoded resource,
+ *	the attribute name having been appended by the caller.  The value is
+ *	quoted as by cpy_quote_value().
+ *
+ * @param[in]	pal - encoded resource
+ *
+ * @return	void
+ *
+ * @par MT-safe: No
+ */
+static void
+acct_buf_cat_resc(svrattrl *pal)
+{
+	char *quotechar = NULL;
+
+	if (pal->al_resc) {
+		acct_buf_cat(".", 1);
+		acct_buf_cat(pal->al_resc, -1);
+	}
+	acct_buf_cat("=", 1);
+	if (strchr(pal->al_value, (int)' ') != NULL)
+		quotechar = (strchr(pal->al_value, (int)'"') != NULL) ? "'" : "\"";
+	if (quotechar)
+		acct_buf_cat(quotechar, 1);
+	acct_buf_cat(pal->al_value, -1);
+	if (quotechar)
+		acct_buf_cat(quotechar, 1);
+	acct_buf_cat(" ", 1);
+}
+
 /**
  * @brief
  * sum_resc_alloc() - sums up the consumable resources listed in
@@ -352,101 +499,62 @@ get_walltime(job *jp, int res)
  *
  * @par	Functionality:
  *	Used by account_jobstr() and account_jobend()
- *
+ *	Appends the data to the record being built in acct_buf.
  *
  * @param[in]	pjob	- pointer to job structure
  * @param[in]	type	- account record type
- * @param[in]	buf	- buffer holding the data that will be stored in
- *			  accounting logs.
- * @param[in]	len	- number of characters in 'buf' still available to
- *			  store data.
- * @return	char *
- * @retval	pointer to 'buf' containing new data.
+ *
+ * @return	void
  *
  */
-static char *
-acct_job(job *pjob, int type, char *buf, int len)
+static void
+acct_job(job *pjob, int type)
 {
 	pbs_list_head attrlist;
-	int	  i, k;
-	int       nd;
+	int	  k;
 	svrattrl *pal;
-	char *pb;
 	int	att_index;
 	int	len_orig;
-	char	save_char;
 	int	old_perm;
 
-	pb = buf;
 	CLEAR_HEAD(attrlist);
 
 	/* gridname */
-	if (pjob->ji_wattr[(int)JOB_ATR_gridname].at_flags & ATR_VFLAG_SET) {
-		nd = strlen(pjob->ji_wattr[(int)JOB_ATR_gridname].at_val.at_str)
-			+ sizeof(GRIDNAME_FMT);
-		if (nd > len)
-			if (grow_acct_buf(&pb, &len, nd) == -1)
-				return (pb);
-
-		(void)snprintf(pb, len, GRIDNAME_FMT,
+	if (pjob->ji_wattr[(int)JOB_ATR_gridname].at_flags & ATR_VFLAG_SET)
+		acct_buf_printf(GRIDNAME_FMT,
 			pjob->ji_wattr[(int)JOB_ATR_gridname].at_val.at_str);
-		i = strlen(pb);
-		pb  += i;
-		len -= i;
-	}
 
 	/* user */
-	nd = sizeof(USER_FMT) + strlen(pjob->ji_wattr[(int)JOB_ATR_euser].at_val.at_str);
-	if (nd > len)
-		if (grow_acct_buf(&pb, &len, nd) == -1)
-			return (pb);
 #ifdef WIN32
-	(void)snprintf(pb, len, USER_FMT,
+	acct_buf_printf(USER_FMT,
 		replace_space(pjob->ji_wattr[(int)JOB_ATR_euser].at_val.at_str,
 		acctlog_spacechar));
 #else
-	(void)snprintf(pb, len, USER_FMT,
+	acct_buf_printf(USER_FMT,
 		pjob->ji_wattr[(int)JOB_ATR_euser].at_val.at_str);
 #endif
-	i = strlen(pb);
-	pb  += i;
-	len -= i;
 
 	/* group */
-	nd = sizeof(GROUP_FMT) + strlen(pjob->ji_wattr[(int)JOB_ATR_egroup].at_val.at_str);
-	if (nd > len)
-		if (grow_acct_buf(&pb, &len, nd) == -1)
-			return (pb);
 #ifdef WIN32
-	(void)snprintf(pb, len, GROUP_FMT,
+	acct_buf_printf(GROUP_FMT,
 		replace_space(pjob->ji_wattr[(int)JOB_ATR_egroup].at_val.at_str,
 		acctlog_spacechar));
 #else
-	(void)snprintf(pb, len, GROUP_FMT,
+	acct_buf_printf(GROUP_FMT,
 		pjob->ji_wattr[(int)JOB_ATR_egroup].at_val.at_str);
 #endif
-	i = strlen(pb);
-	pb  += i;
-	len -= i;
 
 	/* account */
 	if (pjob->ji_wattr[(int)JOB_ATR_account].at_flags & ATR_VFLAG_SET) {
-		nd = sizeof(ACCOUNT_FMT) + strlen(pjob->ji_wattr[(int)JOB_ATR_account].at_val.at_str);
-		if (nd > len)
-			if (grow_acct_buf(&pb, &len, nd) == -1)
-				return (pb);
 #ifdef WIN32
-		(void)snprintf(pb, len, ACCOUNT_FMT,
+		acct_buf_printf(ACCOUNT_FMT,
 			replace_space(
 			pjob->ji_wattr[(int)JOB_ATR_account].at_val.at_str,
 			acctlog_spacechar));
 #else
-		(void)snprintf(pb, len, ACCOUNT_FMT,
+		acct_buf_printf(ACCOUNT_FMT,
 			pjob->ji_wattr[(int)JOB_ATR_account].at_val.at_str);
 #endif
-		i = strlen(pb);
-		pb  += i;
-		len -= i;
 	}
 
 	/* project */
@@ -455,139 +563,55 @@ acct_job(job *pjob, int type, char *buf, int len)
 
 		projstr =  pjob->ji_wattr[(int)JOB_ATR_project].at_val.at_str;
 		/* using PROJECT_FMT1 if projstr needs to be quoted; otherwise, PROJECT_FMT2 */
-		nd = sizeof(PROJECT_FMT1) + strlen(projstr);
-		if (nd > len)
-			if (grow_acct_buf(&pb, &len, nd) == -1)
-				return (pb);
-		if (strchr(projstr, ' ') != NULL) {
-			(void)snprintf(pb, len, PROJECT_FMT1, projstr);
-		} else {
-			(void)snprintf(pb, len, PROJECT_FMT2, projstr);
-		}
-		i = strlen(pb);
-		pb  += i;
-		len -= i;
+		if (strchr(projstr, ' ') != NULL)
+			acct_buf_printf(PROJECT_FMT1, projstr);
+		else
+			acct_buf_printf(PROJECT_FMT2, projstr);
 	}
 
 	/* accounting_id */
-	if (pjob->ji_wattr[(int)JOB_ATR_acct_id].at_flags & ATR_VFLAG_SET) {
-		nd = sizeof(ACCOUNTING_ID_FMT) + strlen(pjob->ji_wattr[(int)JOB_ATR_acct_id].at_val.at_str);
-		if (nd > len)
-			if (grow_acct_buf(&pb, &len, nd) == -1)
-				return (pb);
-		(void)snprintf(pb, len, ACCOUNTING_ID_FMT,
+	if (pjob->ji_wattr[(int)JOB_ATR_acct_id].at_flags & ATR_VFLAG_SET)
+		acct_buf_printf(ACCOUNTING_ID_FMT,
 			pjob->ji_wattr[(int)JOB_ATR_acct_id].at_val.at_str);
-		i = strlen(pb);
-		pb  += i;
-		len -= i;
-	}
 
 	/* job name */
-	nd = sizeof(JOBNAME_FMT) + strlen(pjob->ji_wattr[(int)JOB_ATR_jobname].at_val.at_str);
-	if (nd > len)
-		if (grow_acct_buf(&pb, &len, nd) == -1)
-			return (pb);
-	(void)snprintf(pb, len, JOBNAME_FMT,
+	acct_buf_printf(JOBNAME_FMT,
 		pjob->ji_wattr[(int)JOB_ATR_jobname].at_val.at_str);
-	i = strlen(pb);
-	pb  += i;
-	len -= i;
 
 	/* queue name */
-	nd = sizeof(QUEUE_FMT) + strlen(pjob->ji_qhdr->qu_qs.qu_name);
-	if (nd > len)
-		if (grow_acct_buf(&pb, &len, nd) == -1)
-			return (pb);
-	(void)snprintf(pb, len, QUEUE_FMT, pjob->ji_qhdr->qu_qs.qu_name);
-	i = strlen(pb);
-	pb  += i;
-	len -= i;
+	acct_buf_printf(QUEUE_FMT, pjob->ji_qhdr->qu_qs.qu_name);
 
 	if (pjob->ji_myResv) {
-		nd = sizeof(RESVID_FMT) + strlen(pjob->ji_myResv->ri_qs.ri_resvID);
-		if (pjob->ji_myResv->ri_wattr[(int)RESV_ATR_resv_name].at_flags
-			& ATR_VFLAG_SET)
-			nd += sizeof(RESVNAME_FMT) + strlen(pjob->ji_myResv->ri_wattr[(int)RESV_ATR_resv_name].at_val.at_str);
-		if (nd > len)
-			if (grow_acct_buf(&pb, &len, nd) == -1)
-				return (pb);
 		/* reservation name */
 		if (pjob->ji_myResv->ri_wattr[(int)RESV_ATR_resv_name].at_flags
-			& ATR_VFLAG_SET) {
-			(void)snprintf(pb, len, RESVNAME_FMT,
+			& ATR_VFLAG_SET)
+			acct_buf_printf(RESVNAME_FMT,
 				pjob->ji_myResv->ri_wattr[(int)
 				RESV_ATR_resv_name].
 				at_val.at_str);
-			i = strlen(pb);
-			pb  += i;
-			len -= i;
-		}
 
 		/* reservation ID */
-		(void)snprintf(pb, len, RESVID_FMT,
+		acct_buf_printf(RESVID_FMT,
 			pjob->ji_myResv->ri_qs.ri_resvID);
-		i = strlen(pb);
-		pb  += i;
-		len -= i;
 	}
 
 	/* resvjob ID */
-	if (pjob->ji_resvp) {
-		nd = sizeof(RESVJOBID_FMT) + strlen(pjob->ji_resvp->ri_qs.ri_resvID);
-		if (nd > len)
-			if (grow_acct_buf(&pb, &len, nd) == -1)
-				return (pb);
-		(void)snprintf(pb, len, RESVJOBID_FMT,
+	if (pjob->ji_resvp)
+		acct_buf_printf(RESVJOBID_FMT,
 			pjob->ji_resvp->ri_qs.ri_resvID);
-		i = strlen(pb);
-		pb  += i;
-		len -= i;
-	}
-
-	/* insure space for all *times */
-	nd = ACCTBUF_TIMES_NEED;
-	if (nd > len)
-		if (grow_acct_buf(&pb, &len, nd) == -1)
-			return (pb);
-
-	/* create time */
-	(void)sprintf(pb, "ctime=%ld ",
-		pjob->ji_wattr[(int)JOB_ATR_ctime].at_val.at_long);
-	i = strlen(pb);
-	pb  += i;
-	len -= i;
-
-	/* queued time */
-	(void)sprintf(pb, "qtime=%ld ",
-		pjob->ji_wattr[(int)JOB_ATR_qtime].at_val.at_long);
-	i = strlen(pb);
-	pb  += i;
-	len -= i;
-
-	/* eligible time, how long ready to run */
-	(void)sprintf(pb, "etime=%ld ", pjob->ji_wattr[(int)JOB_ATR_etime].at_val.at_long);
-	i = strlen(pb);
-	pb  += i;
-	len -= i;
 
-	/* start time */
-	(void)sprintf(pb, "start=%ld ", (long)pjob->ji_qs.ji_stime);
-	i = strlen(pb);
-	pb  += i;
-	len -= i;
+	/* create time, queued time, eligible time (how long ready to run), start time */
+	acct_buf_printf("ctime=%ld qtime=%ld etime=%ld start=%ld ",
+		pjob->ji_wattr[(int)JOB_ATR_ctime].at_val.at_long,
+		pjob->ji_wattr[(int)JOB_ATR_qtime].at_val.at_long,
+		pjob->ji_wattr[(int)JOB_ATR_etime].at_val.at_long,
+		(long)pjob->ji_qs.ji_stime);
 
 	if (pjob->ji_wattr[(int)JOB_ATR_array_indices_submitted].at_flags & ATR_VFLAG_SET && (pjob->ji_qs.ji_state == JOB_STATE_BEGUN)) {
 
 		/* for an Array Job in Begun state,  record index range */
 
-		nd = sizeof(ARRAY_INDICES_FMT) + strlen(pjob->ji_wattr[(int)JOB_ATR_array_indices_submitted].at_val.at_str);
-		if (nd > len)
-			if (grow_acct_buf(&pb, &len, nd) == -1)
-				return (pb);
-		(void)snprintf(pb, len, ARRAY_INDICES_FMT, pjob->ji_wattr[(int)JOB_ATR_array_indices_submitted].at_val.at_str);
-		i = strlen(pb);
-		pb  += i;
-		len -= i;
+		acct_buf_printf(ARRAY_INDICES_FMT, pjob->ji_wattr[(int)JOB_ATR_array_indices_submitted].at_val.at_str);
 
 	} else {
 
@@ -598,36 +622,21 @@ acct_job(job *pjob, int type, char *buf, int len)
 		else
 			att_index = JOB_ATR_exec_host;
 
-		if (pjob->ji_wattr[att_index].at_flags & ATR_VFLAG_SET) {
-			/* execution host list, may be loooong */
-			nd = sizeof(EXEC_HOST_FMT) + strlen(pjob->ji_wattr[att_index].at_val.at_str);
-			if (nd > len)
-				if (grow_acct_buf(&pb, &len, nd) == -1)
-					return (pb);
-			(void)snprintf(pb, len, EXEC_HOST_FMT,
+		/* execution host list, may be loooong */
+		if (pjob->ji_wattr[att_index].at_flags & ATR_VFLAG_SET)
+			acct_buf_printf(EXEC_HOST_FMT,
 				pjob->ji_wattr[att_index].at_val.at_str);
-			i = strlen(pb);
-			pb  += i;
-			len -= i;
-		}
+
 		if ((type == PBS_ACCT_END) &&
 		    (pjob->ji_wattr[(int)JOB_ATR_exec_vnode_orig].at_flags & ATR_VFLAG_SET))
 			att_index = JOB_ATR_exec_vnode_orig;
 		else
 			att_index = JOB_ATR_exec_vnode;
 
-		if (pjob->ji_wattr[att_index].at_flags & ATR_VFLAG_SET) {
-			/* execution vnode list, will be even longer */
-			nd = sizeof(EXEC_VNODE_FMT) + strlen(pjob->ji_wattr[att_index].at_val.at_str);
-			if (nd > len)
-				if (grow_acct_buf(&pb, &len, nd) == -1)
-					return (pb);
-			(void)snprintf(pb, len, EXEC_VNODE_FMT,
+		/* execution vnode list, will be even longer */
+		if (pjob->ji_wattr[att_index].at_flags & ATR_VFLAG_SET)
+			acct_buf_printf(EXEC_VNODE_FMT,
 				pjob->ji_wattr[att_index].at_val.at_str);
-			i = strlen(pb);
-			pb  += i;
-			len -= i;
-		}
 	}
 
 	/* now encode the job's resource_list attribute */
@@ -650,46 +659,16 @@ acct_job(job *pjob, int type, char *buf, int len)
 		ATR_ENCODE_CLIENT, NULL);
 	resc_access_perm = old_perm;
 
-	nd = 0;	/* compute total size needed in buf */
-	pal = GET_NEXT(attrlist);
-	while (pal != NULL) {
-		/* +5 in count is for '=', ' ', start and end quotes, and \0 */
-		nd += strlen(pal->al_name) + strlen(pal->al_value) + 5;
-		if (pal->al_resc)
-			nd += 1 + strlen(pal->al_resc);
-		pal = GET_NEXT(pal->al_link);
-	}
-	if (nd > len)
-		if (grow_acct_buf(&pb, &len, nd) == -1)
-			return (pb);
-
 	while ((pal = GET_NEXT(attrlist)) != NULL) {
 		/* strip off the '_orig' suffix */
-		if (len_orig > 0) {
-			k = strlen(pal->al_name);
-			if (k  > len_orig) {
-				save_char = pal->al_name[k-len_orig];
-				pal->al_name[k-len_orig] = '\0';
-			}
-		}
-		(void)strcat(pb, pal->al_name);
-		if (len_orig > 0) {
-			if (k  > len_orig) {
-				pal->al_name[k-len_orig] = save_char;
-			}
-		}
-		if (pal->al_resc) {
-			(void)strcat(pb, ".");
-			(void)strcat(pb, pal->al_resc);
-		}
-		(void)strcat(pb, "=");
-		cpy_quote_value(pb, pal->al_value);
-		(void)strcat(pb, " ");
+		k = strlen(pal->al_name);
+		if (len_orig > 0 && k > len_orig)
+			k -= len_orig;
+		acct_buf_cat(pal->al_name, k);
+		acct_buf_cat_resc(pal);
 		delete_link(&pal->al_link);
 		(void)free(pal);
-		pb += strlen(pb);
 	}
-	return (pb);
 }
 
 /**
@@ -896,11 +875,213 @@ acct_resv(resc_resv *presv, char *buf, int len)
 
 /**
  * @brief
- * acct_open() - open the acct file for append.
+ * acct_bin_put - append 'len' bytes of 'data' to the binary record being
+ *	built in acct_binbuf, growing it as needed
+ *
+ * @param[in,out]	off - offset in acct_binbuf to append at, advanced
+ * @param[in]	data - bytes to append
+ * @param[in]	len - number of bytes
+ *
+ * @return      Error code
+ * @retval	 0  - Success
+ * @retval	-1  - Failure
+ */
+static int
+acct_bin_put(size_t *off, const void *data, size_t len)
+{
+	size_t ln;
+	char *new;
+
+	if (*off + len > acct_binbufsize) {
+		for (ln = acct_binbufsize ? acct_binbufsize * 2 : PBS_ACCT_MAX_RCD; ln < *off + len; ln *= 2)
+			;
+		new = realloc(acct_binbuf, ln);
+		if (new == NULL) {
+			log_err(errno, __func__, "realloc failure");
+			return (-1);
+		}
+		acct_binbuf = new;
+		acct_binbufsize = ln;
+	}
+	memcpy(acct_binbuf + *off, data, len);
+	*off += len;
+	return 0;
+}
+
+/**
+ * @brief
+ * acct_bin_put_str - append a length prefixed string to the binary record
+ *
+ * @param[in,out]	off - offset in acct_binbuf to append at, advanced
+ * @param[in]	str - string, need not be null terminated
+ * @param[in]	len - length of str
+ * @param[in]	wide - length is written as 4 bytes if set, else as 2 bytes
+ *
+ * @return      Error code
+ * @retval	 0  - Success
+ * @retval	-1  - Failure
+ */
+static int
+acct_bin_put_str(size_t *off, const char *str, size_t len, int wide)
+{
+	uint32_t l4 = htonl((uint32_t)len);
+	uint16_t l2 = htons((uint16_t)len);
+
+	if (wide) {
+		if (acct_bin_put(off, &l4, 4) == -1)
+			return (-1);
+	} else {
+		if (len > 0xffff)
+			len = 0xffff;
+		if (acct_bin_put(off, &l2, 2) == -1)
+			return (-1);
+	}
+	return acct_bin_put(off, str, len);
+}
+
+/**
+ * @brief
+ * acct_bin_write - write a record to the binary accounting file
+ *
+ * @par Functionality:
+ *	The text of the record is split into its keyword=value fields as a
+ *	reader of the text file would: a value that starts with a quote runs
+ *	to the matching quote, which is dropped, anything else runs to the
+ *	next space.  A word without '=' is stored with an empty keyword.
+ *	See acct.h for the layout of the record.
+ *
+ * @param[in]	acctype - accounting record type
+ * @param[in]	id - accounting record id
+ * @param[in]	text - text of the record
+ *
+ * @return	void
+ */
+static void
+acct_bin_write(int acctype, char *id, char *text)
+{
+	size_t off = 0;
+	uint32_t u32;
+	uint16_t nfields = 0;
+	unsigned char hdr[8] = {0};
+	char *p = text;
+	char *key;
+	char *val;
+	size_t keylen;
+	size_t vallen;
+	char quote;
+
+	/* length, type and field count are filled in at the end */
+	if (acct_bin_put(&off, hdr, sizeof(hdr)) == -1)
+		return;
+	u32 = htonl((uint32_t)(((uint64_t)time_now) >> 32));
+	if (acct_bin_put(&off, &u32, 4) == -1)
+		return;
+	u32 = htonl((uint32_t)time_now);
+	if (acct_bin_put(&off, &u32, 4) == -1)
+		return;
+	if (acct_bin_put_str(&off, id, strlen(id), 0) == -1)
+		return;
+
+	while (*p != '\0') {
+		while (*p == ' ')
+			p++;
+		if (*p == '\0')
+			break;
+		key = p;
+		while (*p != '\0' && *p != ' ' && *p != '=')
+			p++;
+		if (*p == '=') {
+			keylen = p - key;
+			p++;
+			if (*p == '"' || *p == '\'') {
+				quote = *p++;
+				val = p;
+				while (*p != '\0' && *p != quote)
+					p++;
+				vallen = p - val;
+				if (*p != '\0')
+					p++;
+			} else {
+				val = p;
+				while (*p != '\0' && *p != ' ')
+					p++;
+				vallen = p - val;
+			}
+		} else {
+			val = key;
+			vallen = p - key;
+			keylen = 0;
+		}
+		if (acct_bin_put_str(&off, key, keylen, 0) == -1 ||
+			acct_bin_put_str(&off, val, vallen, 1) == -1)
+			return;
+		nfields++;
+	}
+
+	u32 = htonl((uint32_t)(off - 4));
+	memcpy(acct_binbuf, &u32, 4);
+	acct_binbuf[4] = (char)acctype;
+	acct_binbuf[5] = 0;
+	nfields = htons(nfields);
+	memcpy(acct_binbuf + 6, &nfields, 2);
+	if (fwrite(acct_binbuf, off, 1, acct_binfile) != 1) {
+		log_err(errno, __func__, "write failed, binary accounting stopped");
+		(void)fclose(acct_binfile);
+		acct_binfile = NULL;
+	}
+}
+
+/**
+ * @brief
+ * acct_open_bin - open the binary accounting file that goes with the text
+ *	accounting file 'filename', if PBS_ACCOUNTING_BINARY is set
+ *
+ * @param[in]	filename - abs pathname of the text accounting file
+ *
+ * @return	FILE *
+ * @retval	open stream, NULL if not configured or on error
+ */
+static FILE *
+acct_open_bin(char *filename)
+{
+	char *binname;
+	FILE *newbin;
+	struct stat sb;
+
+	if (pbs_conf.pbs_acct_binary == 0)
+		return NULL;
+
+	pbs_asprintf(&binname, "%s%s", filename, PBS_ACCT_BIN_SUFFIX);
+	if (binname == NULL)
+		return NULL;
+	if ((newbin = fopen(binname, "ab")) == NULL) {
+		log_err(errno, __func__, binname);
+		free(binname);
+		return NULL;
+	}
+#ifdef WIN32
+	secure_file(binname, "Administrators", READS_MASK|WRITES_MASK|STANDARD_RIGHTS_REQUIRED);
+#else
+	(void)setvbuf(newbin, NULL, _IOFBF, PBS_ACCT_WRITE_BUFSIZE);
+#endif
+	free(binname);
+
+	/* a new file starts with the magic and format version */
+	if (fstat(fileno(newbin), &sb) == 0 && sb.st_size == 0)
+		(void)fwrite(PBS_ACCT_BIN_MAGIC, PBS_ACCT_BIN_MAGIC_LEN, 1, newbin);
+	return newbin;
+}
+
+/**
+ * @brief
  * Opens a (new) acct file.
  * If a acct file is already open, and the new file is successfully opened,
  * the old file is closed.  Otherwise the old file is left open.
  *
+ * @par
+ *	The file is fully buffered; records reach the file at the flush
+ *	points, see acct_flush().
+ *
  * @param[in]	filename - abs pathname or NULL
  *
  * @return      Error code
@@ -917,6 +1098,7 @@ acct_open(char *filename)
 #else
 	char  filen[_POSIX_PATH_MAX];
 	char  logmsg[_POSIX_PATH_MAX+80];
+	static int atfork_set = 0;
 #endif
 	FILE *newacct;
 	time_t now;
@@ -952,13 +1134,20 @@ acct_open(char *filename)
 	(void)setvbuf(newacct, NULL, _IONBF, 0); /* no buffering to get instant
 						  log*/
 #else
-	(void)setvbuf(newacct, NULL, _IOLBF, 0); /* set line buffering */
+	(void)setvbuf(newacct, NULL, _IOFBF, PBS_ACCT_WRITE_BUFSIZE);
+
+	/* flush before fork so children do not inherit buffered records */
+	if (!atfork_set) {
+		if (pthread_atfork(acct_flush, NULL, NULL) == 0)
+			atfork_set = 1;
+	}
 #endif
 
 	if (acct_opened > 0) 		/* if acct was open, close it */
-		(void)fclose(acctfile);
+		acct_close();
 
 	acctfile = newacct;
+	acct_binfile = acct_open_bin(filename);
 	acct_opened = 1;			/* note that file is open */
 	(void)sprintf(logmsg, "Account file %s opened", filename);
 	log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, LOG_INFO,
@@ -967,6 +1156,25 @@ acct_open(char *filename)
 	return (0);
 }
 
+/**
+ * @brief
+ * acct_flush - write out the buffered accounting records
+ *
+ * @par
+ *	Called once per pass of the server main loop, before fork, and when
+ *	the file is closed.
+ *
+ * @return	void
+ */
+void
+acct_flush(void)
+{
+	if (acct_opened == 1)
+		(void)fflush(acctfile);
+	if (acct_binfile != NULL)
+		(void)fflush(acct_binfile);
+}
+
 /**
  * @brief
  * acct_close - close the current open log file
@@ -980,12 +1188,19 @@ acct_close()
 		(void)fclose(acctfile);
 		acct_opened = 0;
 	}
+	if (acct_binfile != NULL) {
+		(void)fclose(acct_binfile);
+		acct_binfile = NULL;
+	}
 }
 
 /**
  * @brief
  * write_account_record - write basic accounting record
  *
+ * @par
+ *	The date and time prefix is formatted once per second.
+ *
  * @param[in]	acctype - accounting record type
  * @param[in]	id - accounting record id
  * @param[in,out]	text - text to log, may be null
@@ -995,27 +1210,39 @@ acct_close()
 void
 write_account_record(int acctype, char *id, char *text)
 {
+	static time_t prefix_time = -1;
+	static int prefix_yday;
+	static char prefix[80];	/* sized for any int fields */
 	struct tm *ptm;
 
 	if (acct_opened == 0)
 		return;		/* file not open, don't bother */
 
-	ptm = localtime(&time_now);
+	if (time_now != prefix_time) {
+		ptm = localtime(&time_now);
+		(void)snprintf(prefix, sizeof(prefix),
+			"%02d/%02d/%04d %02d:%02d:%02d",
+			ptm->tm_mon+1, ptm->tm_mday, ptm->tm_year+1900,
+			ptm->tm_hour, ptm->tm_min, ptm->tm_sec);
+		prefix_yday = ptm->tm_yday;
+		prefix_time = time_now;
+	}
 
 	/* Do we need to switch files */
 
-	if (acct_auto_switch && (acct_opened_day != ptm->tm_yday)) {
+	if (acct_auto_switch && (acct_opened_day != prefix_yday)) {
 		acct_close();
 		acct_open(NULL);
+		if (acct_opened == 0)
+			return;
 	}
 	if (text == NULL)
 		text = "";
 
-	(void)fprintf(acctfile,
-		"%02d/%02d/%04d %02d:%02d:%02d;%c;%s;%s\n",
-		ptm->tm_mon+1, ptm->tm_mday, ptm->tm_year+1900,
-		ptm->tm_hour, ptm->tm_min, ptm->tm_sec,
-		(char)acctype, id, text);
+	(void)fprintf(acctfile, "%s;%c;%s;%s\n", prefix, (char)acctype, id, text);
+
+	if (acct_binfile != NULL)
+		acct_bin_write(acctype, id, text);
 }
 
 /**
@@ -1102,51 +1329,24 @@ void
 account_jobstr2(job *pjob, int type)
 {
 	pbs_list_head attrlist;
-	int	  nd;
-	int 	  len;
 	svrattrl *pal;
-	char	 *pb;
 
 	CLEAR_HEAD(attrlist);
 
 	/* pack in general information about the job */
 
-	(void)acct_job(pjob, type, acct_buf, acct_bufsize);
-	acct_buf[acct_bufsize] = '\0';
+	acct_buf_len = 0;
+	acct_job(pjob, type);
 
-	nd  = strlen(acct_buf);
-	pb  = acct_buf + nd;
-	len = acct_bufsize - nd;
+	/* copy in resources_assigned */
 
 	sum_resc_alloc(pjob, &attrlist);
 
-	nd = 0;	/* compute total size needed in buf */
-	pal = GET_NEXT(attrlist);
-	while (pal != NULL) {
-		/* +5 in count is for '=', ' ', start and end quotes, and \0 */
-		nd += strlen(pal->al_name) + strlen(pal->al_value) + 5;
-		if (pal->al_resc)
-			nd += 1 + strlen(pal->al_resc);
-		pal = GET_NEXT(pal->al_link);
-	}
-	if ((nd <= len) ||
-		(grow_acct_buf(&pb, &len, nd) == 0)) {
-
-		/* have room in buffer, so copy in resources_assigned */
-
-		while ((pal = GET_NEXT(attrlist)) != NULL) {
-			(void)strcat(pb, pal->al_name);
-			if (pal->al_resc) {
-				(void)strcat(pb, ".");
-				(void)strcat(pb, pal->al_resc);
-			}
-			(void)strcat(pb, "=");
-			cpy_quote_value(pb, pal->al_value);
-			(void)strcat(pb, " ");
-			delete_link(&pal->al_link);
-			(void)free(pal);
-			pb += strlen(pb);
-		}
+	while ((pal = GET_NEXT(attrlist)) != NULL) {
+		acct_buf_cat(pal->al_name, -1);
+		acct_buf_cat_resc(pal);
+		delete_link(&pal->al_link);
+		(void)free(pal);
 	}
 	account_record(type, pjob, acct_buf);
 }
@@ -1169,6 +1369,67 @@ account_resvstart(resc_resv *presv)
 	account_recordResv(PBS_ACCT_BR, presv, acct_buf);
 }
 
+/**
+ * @brief
+ *	acct_rescused_from_attr - rebuild the "Exit_status=n resources_used..."
+ *	text of a job end record from the job's resources_used attribute.
+ *
+ * @par
+ *	If pbs_server is restarted during the end of job processing, the
+ *	text sent by MoM is lost.  The text built here is the same as the
+ *	one built by job_obit(), except that the encoded resources are
+ *	linked through al_sister instead of al_link.
+ *
+ * @param[in]	pjob	- pointer to job structure
+ *
+ * @return	char *
+ * @retval	the text, to be freed by the caller
+ * @retval	NULL	out of memory
+ */
+static char *
+acct_rescused_from_attr(job *pjob)
+{
+	struct svrattrl *patlist = NULL;
+	pbs_list_head temp_head;
+	char *resc_used;
+	int resc_used_size;
+
+	CLEAR_HEAD(temp_head);
+	if (pjob->ji_wattr[(int) JOB_ATR_resc_used].at_user_encoded != NULL)
+		patlist = pjob->ji_wattr[(int) JOB_ATR_resc_used].at_user_encoded;
+	else if (pjob->ji_wattr[(int) JOB_ATR_resc_used].at_priv_encoded != NULL)
+		patlist = pjob->ji_wattr[(int) JOB_ATR_resc_used].at_priv_encoded;
+	else
+		encode_resc(&pjob->ji_wattr[(int) JOB_ATR_resc_used],
+			&temp_head, job_attr_def[(int) JOB_ATR_resc_used].at_name,
+			NULL, ATR_ENCODE_CLIENT, &patlist);
+
+	/* Allocate initial space for resc_used.  Future space will be allocated by pbs_strcat(). */
+	if ((resc_used = malloc(RESC_USED_BUF_SIZE)) == NULL) {
+		free_attrlist(&temp_head);
+		return NULL;
+	}
+	resc_used_size = RESC_USED_BUF_SIZE;
+
+	/* strlen(msg_job_end_stat) == 12 characters plus a number.  This should be plenty big */
+	(void) snprintf(resc_used, resc_used_size, msg_job_end_stat,
+		pjob->ji_qs.ji_un.ji_exect.ji_exitstat);
+
+	for (; patlist; patlist = patlist->al_sister) {
+		/* log to accounting_logs only if there's a value */
+		if (strlen(patlist->al_value) == 0)
+			continue;
+		if (concat_rescused_to_buffer(&resc_used, &resc_used_size, patlist, " ", NULL) != 0) {
+			free(resc_used);
+			resc_used = NULL;
+			break;
+		}
+	}
+
+	free_attrlist(&temp_head);
+	return resc_used;
+}
+
 /**
  * @brief
  *	Form and write a job termination/rerun record with resource usage.
@@ -1197,176 +1458,73 @@ account_resvstart(resc_resv *presv)
 void
 account_jobend(job *pjob, char *used, int type)
 {
-	int i = 0;
-	int len = 0;
-	char *pb = NULL;
-	struct svrattrl *patlist = NULL;
 	char *resc_used;
-	int resc_used_size = 0;
-	pbs_list_head temp_head;
 
-	CLEAR_HEAD(temp_head);
 	/* pack in general information about the job */
 
-	pb = acct_job(pjob, type, acct_buf, acct_bufsize);
-	len = acct_bufsize - (pb - acct_buf);
+	acct_buf_len = 0;
+	acct_job(pjob, type);
 
 	/*
-	 * for each keyword=value pair added, the following steps should be
-	 * followed:
-	 * a. calculate (or over-estimate) the size of the date to be added
-	 * b. check that there is sufficient room in the buffer, "len" is the
-	 *    current unused amount.
-	 * c. If necessary, grow the buffer by calling grow_acct_buf().
-	 *    If this function fails,  just write out what we already have.
-	 * d. Append the new datum to the buffer at "pb".  Each new item should
-	 *    have a single leading space.  The variable "pb" is maintained
-	 *    to point to the end to save "strcat" time.
-	 * e. Advance "pb" by the length of the datum added and decrement
-	 *    "len" by the same amount.
+	 * each keyword=value pair is appended with acct_buf_cat() or
+	 * acct_buf_printf(), which grow acct_buf as needed.  If the buffer
+	 * cannot be grown, the item is left out.  Each new item should have
+	 * a single leading space.
 	 */
 
 	/* session */
-	i = 30;
-	if (i > len)
-		if (grow_acct_buf(&pb, &len, i) == -1)
-			goto writeit;
-	(void)sprintf(pb, "session=%ld",
+	acct_buf_printf("session=%ld",
 		pjob->ji_wattr[(int)JOB_ATR_session_id].at_val.at_long);
-	i = strlen(pb);
-	pb  += i;
-	len -= i;
 
 	/* Alternate id if present */
 
 	if (pjob->ji_wattr[(int)JOB_ATR_altid].at_flags & ATR_VFLAG_SET) {
-		i = 9 + strlen(pjob->ji_wattr[(int)JOB_ATR_altid].at_val.at_str);
-		if (i > len)
-			if (grow_acct_buf(&pb, &len, i) == -1)
-				goto writeit;
 #ifdef WIN32
-		(void)sprintf(pb, " alt_id=%s",
+		acct_buf_printf(" alt_id=%s",
 			replace_space(
 			pjob->ji_wattr[(int)JOB_ATR_altid].at_val.at_str,
 			acctlog_spacechar));
 #else
-		(void)sprintf(pb, " alt_id=%s",
+		acct_buf_printf(" alt_id=%s",
 			pjob->ji_wattr[(int)JOB_ATR_altid].at_val.at_str);
 #endif
-		i = strlen(pb);
-		pb  += i;
-		len -= i;
 	}
 
 	/* add the execution ended time */
-	i = 18;
-	if (i > len)
-		if (grow_acct_buf(&pb, &len, i) == -1)
-			goto writeit;
-	(void)sprintf(pb, " end=%ld", (long)time_now);
-	i = strlen(pb);
-	pb  += i;
-	len -= i;
+	acct_buf_printf(" end=%ld", (long)time_now);
 
 	/* finally add on resources used from req_jobobit() */
 	if (type == PBS_ACCT_END || type == PBS_ACCT_RERUN) {
 		if ((used == NULL && pjob->ji_acctrec == NULL) || (used != NULL && strstr(used, "resources_used") == NULL)) {
-			/* If pbs_server is restarted during the end of job processing then used maybe NULL.
-			 * So we try to derive the resource usage information from resources_used attribute of
-			 * the job and then reconstruct the resources usage information into resc_used buffer.
-			 */
-			if (pjob->ji_wattr[(int) JOB_ATR_resc_used].at_user_encoded != NULL)
-				patlist = pjob->ji_wattr[(int) JOB_ATR_resc_used].at_user_encoded;
-			else if (pjob->ji_wattr[(int) JOB_ATR_resc_used].at_priv_encoded != NULL)
-				patlist = pjob->ji_wattr[(int) JOB_ATR_resc_used].at_priv_encoded;
-			else
-				encode_resc(&pjob->ji_wattr[(int) JOB_ATR_resc_used],
-					    &temp_head, job_attr_def[(int) JOB_ATR_resc_used].at_name,
-					    NULL, ATR_ENCODE_CLIENT, &patlist);
-
-			/* Allocate initial space for resc_used.  Future space will be allocated by pbs_strcat(). */
-			resc_used = malloc(RESC_USED_BUF_SIZE);
-			if (resc_used == NULL)
-				goto writeit;
-			resc_used_size = RESC_USED_BUF_SIZE;
-
-
-			/* strlen(msg_job_end_stat) == 12 characters plus a number.  This should be plenty big */
-			(void) snprintf(resc_used, resc_used_size, msg_job_end_stat,
-					pjob->ji_qs.ji_un.ji_exect.ji_exitstat);
-
-			/*
-			 * NOTE:
-			 * Following code for constructing resources used information is same as job_obit()
-			 * with minor different that to traverse patlist in this code
-			 * we have to use patlist->al_sister since it is encoded information in job struct
-			 * where in job_obit() we are using GET_NEXT(patlist->al_link) which is part of batch
-			 * request.
-			 * ji_acctrec is lost on server restart.  Recreate it here if needed.
-			 */
-
-			while(patlist) {
-				/* log to accounting_logs only if there's a value */
-				if (strlen(patlist->al_value) > 0) {
-					if (concat_rescused_to_buffer(&resc_used, &resc_used_size, patlist, " ", NULL) != 0) {
-						free(resc_used);
-						goto writeit;
-					}
-
-				}
-
-				patlist = patlist->al_sister;
+			/* ji_acctrec is lost on server restart, recreate it */
+			if ((resc_used = acct_rescused_from_attr(pjob)) != NULL) {
+				used = resc_used;
+				free(pjob->ji_acctrec);
+				pjob->ji_acctrec = used;
 			}
-
-			used = resc_used;
-			free(pjob->ji_acctrec);
-			pjob->ji_acctrec = used;
-			free_attrlist(&temp_head);
 		}
 	}
 
 	if (used != NULL) {
-		i = strlen(used) + 1;
-		if (i > len)
-			if (grow_acct_buf(&pb, &len, i) == -1)
-				goto writeit;
-		(void)strcat(pb, " ");
-		(void)strcat(pb, used);
-		i = strlen(pb);
-		pb  += i;
-		len -= i;
+		acct_buf_cat(" ", 1);
+		acct_buf_cat(used, -1);
 	}
 
 	/* Add eligible_time */
 	if (server.sv_attr[(int)SRV_ATR_EligibleTimeEnable].at_val.at_long == 1) {
 		char timebuf[TIMEBUF_SIZE] = {0};
-		i = 26;	/* max size for " eligible_time=<value>" */
-		if (i > len)
-			if (grow_acct_buf(&pb, &len, i) == -1)
-				goto writeit;
 
 		convert_duration_to_str(pjob->ji_wattr[(int)JOB_ATR_eligible_time].at_val.at_long, timebuf, TIMEBUF_SIZE);
-		(void)sprintf(pb, " eligible_time=%s", timebuf);
-		i = strlen(pb);
-		pb  += i;
-		len -= i;
+		acct_buf_printf(" eligible_time=%s", timebuf);
 	}
 
 	/* Add in run count */
 
-	i = 34;		/* sort of max size for "run_count=<value>" */
-	if (i > len)
-		if (grow_acct_buf(&pb, &len, i) == -1)
-			goto writeit;
-	sprintf(pb, " run_count=%ld",
+	acct_buf_printf(" run_count=%ld",
 		pjob->ji_wattr[(int)JOB_ATR_runcount].at_val.at_long);
-	/* if any more is added after this point, */
-	/* don't forget to reset pb and len first */
 
 	/* done creating record,  now write it out */
 
-writeit:
-	acct_buf[acct_bufsize-1] = '\0';
 	account_record(type, pjob, acct_buf);
 }
 /**
@@ -793,6 +793,143 @@ fixup_arrayindicies(attribute *pattr, void *pobj, int mode)
 
 	return (PBSE_NONE);
 }
+/**
+ * @brief
+ * 		subjob_attr_shareable - can the value of a job attribute be
+ * 		borrowed by a subjob from its parent instead of being copied?
+ * 		Only plain string and string array values qualify; their set,
+ * 		decode and free routines copy the value before changing it.
+ * @param[in]	j - index of the job attribute
+ * @return	int
+ * @retval  1	- the value can be shared
+ * @retval  0	- the value must be copied
+ */
+static int
+subjob_attr_shareable(int j)
+{
+	attribute_def *pdef = &job_attr_def[j];
+
+	return (((pdef->at_set == set_str) && (pdef->at_free == free_str)) ||
+		((pdef->at_set == set_arst) && (pdef->at_free == free_arst)));
+}
+
+/**
+ * @brief
+ * 		same_attr_value - compare a string or string array attribute
+ * 		value with its copy.
+ * @param[in]	pa - attribute
+ * @param[in]	pb - copy of the attribute
+ * @return	int
+ * @retval  1	- the values are the same
+ * @retval  0	- the values differ
+ */
+static int
+same_attr_value(attribute *pa, attribute *pb)
+{
+	struct array_strings *pas;
+	struct array_strings *pbs;
+	int i;
+
+	if ((pa->at_flags & ATR_VFLAG_SET) != (pb->at_flags & ATR_VFLAG_SET))
+		return 0;
+	if ((pa->at_flags & ATR_VFLAG_SET) == 0)
+		return 1;
+	if ((pa->at_flags & ATR_VFLAG_DEFLT) != (pb->at_flags & ATR_VFLAG_DEFLT))
+		return 0;
+	if (pa->at_type == ATR_TYPE_STR) {
+		if ((pa->at_val.at_str == NULL) || (pb->at_val.at_str == NULL))
+			return (pa->at_val.at_str == pb->at_val.at_str);
+		return (strcmp(pa->at_val.at_str, pb->at_val.at_str) == 0);
+	}
+	pas = pa->at_val.at_arst;
+	pbs = pb->at_val.at_arst;
+	if ((pas == NULL) || (pbs == NULL))
+		return (pas == pbs);
+	if (pas->as_usedptr != pbs->as_usedptr)
+		return 0;
+	for (i = 0; i < pas->as_usedptr; i++) {
+		if (strcmp(pas->as_string[i], pbs->as_string[i]) != 0)
+			return 0;
+	}
+	return 1;
+}
+
+/**
+ * @brief
+ * 		release_subjob_attrs - drop a job's reference to the attribute
+ * 		values shared between an Array Job and its subjobs, freeing
+ * 		them with the last reference.  The job's own attributes that
+ * 		borrowed the values must have been freed or replaced already.
+ * @param[in]	pjob - Array Job or subjob
+ */
+void
+release_subjob_attrs(job *pjob)
+{
+	struct ajattrs *paja = pjob->ji_ajattrs;
+	int i;
+
+	if (paja == NULL)
+		return;
+	pjob->ji_ajattrs = NULL;
+	if (--paja->aja_refct > 0)
+		return;
+	for (i = 0; i < (int)JOB_ATR_LAST; i++)
+		job_attr_def[i].at_free(&paja->aja_attr[i]);
+	free(paja);
+}
+
+/**
+ * @brief
+ * 		get_subjob_attrs - return the shared copy of the parent's
+ * 		string and string array attributes to be borrowed by a new
+ * 		subjob.  The copy is made once and reused for each subjob until
+ * 		one of those attributes of the parent is changed.
+ * @param[in]	parent - pointer to parent Array Job
+ * @return	pointer to the shared values
+ * @retval  NULL	- could not allocate, copy the values instead
+ */
+static struct ajattrs *
+get_subjob_attrs(job *parent)
+{
+	struct ajattrs *paja = parent->ji_ajattrs;
+	attribute *ppar;
+	int i;
+	int j;
+
+	if (paja != NULL) {
+		for (i = 0; attrs_to_copy[i] != JOB_ATR_LAST; i++) {
+			j = (int)attrs_to_copy[i];
+			if (subjob_attr_shareable(j) &&
+				!same_attr_value(&parent->ji_wattr[j], &paja->aja_attr[j]))
+				break;
+		}
+		if (attrs_to_copy[i] == JOB_ATR_LAST)
+			return (paja);
+		release_subjob_attrs(parent);	/* parent changed, make a new one */
+	}
+
+	if ((paja = malloc(sizeof(struct ajattrs))) == NULL)
+		return NULL;
+	paja->aja_refct = 1;			/* the parent's reference */
+	for (j = 0; j < (int)JOB_ATR_LAST; j++)
+		clear_attr(&paja->aja_attr[j], &job_attr_def[j]);
+	for (i = 0; attrs_to_copy[i] != JOB_ATR_LAST; i++) {
+		j = (int)attrs_to_copy[i];
+		ppar = &parent->ji_wattr[j];
+		if (!subjob_attr_shareable(j) || !(ppar->at_flags & ATR_VFLAG_SET))
+			continue;
+		if (job_attr_def[j].at_set(&paja->aja_attr[j], ppar, SET) != 0) {
+			parent->ji_ajattrs = paja;
+			release_subjob_attrs(parent);
+			return NULL;
+		}
+		paja->aja_attr[j].at_flags = ATR_VFLAG_SET |
+			(ppar->at_flags & ATR_VFLAG_DEFLT);
+	}
+	parent->ji_ajattrs = paja;
+	return (paja);
+}
+
 /**
  * @brief
  * 		create_subjob - create a Subjob from the parent Array Job
@@ -816,6 +953,7 @@ create_subjob(job *parent, char *newjid, int *rc)
 	attribute *psub;
 	svrattrl  *psatl;
 	job 	  *subj;
+	struct ajattrs *paja;
 	long	   eligibletime;
 	long	    time_msec;
 #ifdef	WIN32
@@ -868,18 +1006,35 @@ create_subjob(job *parent, char *newjid, int *rc)
 
 	/*
 	 * now that is all done, copy the required attributes by
-	 * encoding and then decoding into the new array.  Then add the
-	 * subjob specific attributes.
+	 * encoding and then decoding into the new array.  String and
+	 * string array values are not copied, the subjob borrows them
+	 * read-only from a shared copy of the parent's; they are copied
+	 * on write by the attribute's set and decode routines.  Then add
+	 * the subjob specific attributes.
 	 */
 
 	resc_access_perm = ATR_DFLAG_ACCESS;
 	CLEAR_HEAD(attrl);
+	if ((paja = get_subjob_attrs(parent)) != NULL) {
+		paja->aja_refct++;
+		subj->ji_ajattrs = paja;
+	}
 	for (i = 0; attrs_to_copy[i] != JOB_ATR_LAST; i++) {
 		j    = (int)attrs_to_copy[i];
 		ppar = &parent->ji_wattr[j];
 		psub = &subj->ji_wattr[j];
 		pdef = &job_attr_def[j];
 
+		if ((paja != NULL) && subjob_attr_shareable(j)) {
+			if (paja->aja_attr[j].at_flags & ATR_VFLAG_SET) {
+				psub->at_val = paja->aja_attr[j].at_val;
+				psub->at_flags |= paja->aja_attr[j].at_flags |
+					ATR_VFLAG_SHARED | ATR_VFLAG_MODIFY |
+					ATR_VFLAG_MODCACHE;
+			}
+			continue;
+		}
+
 		if (pdef->at_encode(ppar, &attrl, pdef->at_name, NULL,
 			ATR_ENCODE_MOM, &psatl) > 0) {
 			for (psatl = (svrattrl *)GET_NEXT(attrl); psatl;
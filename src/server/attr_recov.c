@@ -458,7 +458,8 @@ recov_attr_fs(int fd, void *parent, struct attribute_def *padef,
 				(void)(padef+index)->at_free(&tmpa);
 			}
 		}
-		(pattr+index)->at_flags = pal->al_flags & ~ATR_VFLAG_MODIFY;
+		(pattr+index)->at_flags = pal->al_flags &
+			~(ATR_VFLAG_MODIFY | ATR_VFLAG_SHARED);
 	}
 
 	(void)free(pal);
@@ -50,6 +50,10 @@
  *	make_attr		create a svrattrl structure from the attr_name, and values
  *	recov_attr_db_raw	Recover the list of attributes from the database without triggering
  *				the action routines
+ *	decode_attr_db		Decode the attributes read from the database
+ *	decode_attr_db_prep	Decode the reentrant attributes, may run on a thread
+ *	decode_attr_db_finish	Decode the rest and run the action routines
+ *	decode_attr_db_free	Free the attributes from decode_attr_db_prep unused
  */
 
 #include <pbs_config.h>   /* the master config generated by configure */
@@ -223,52 +227,87 @@ encode_attr_db(struct attribute_def *padef, struct attribute *pattr, int numattr
 	return 0;
 }
 
+/*
+ * The attributes of one object read from the database, grouped by the
+ * index of their definition.  ad_done[index] is set once the values at
+ * that index have been decoded by decode_attr_db_prep().
+ */
+struct attr_db_decode {
+	int		  ad_limit;
+	svrattrl	**ad_pal;
+	char		 *ad_done;
+};
+
 /**
  * @brief
- *	Decode the list of attributes from the database to the regular attribute structure
+ *	Free the attributes left in an attr_db_decode structure and the
+ *	structure itself, without decoding them or calling any action routine
  *
- * @param[in]	  parent - pointer to parent object
- * @param[in]	  attr_list - Information about the database attributes
- * @param[in]	  padef - Address of parent's attribute definition array
- * @param[in/out] pattr - Address of the parent objects attribute array
- * @param[in]	  limit - Number of attributes in the list
- * @param[in]	  unknown	- The index of the unknown attribute if any
+ * @param[in]	handle - from sort_attr_db() or decode_attr_db_prep()
+ */
+void
+decode_attr_db_free(void *handle)
+{
+	int index;
+	svrattrl *pal;
+	svrattrl *tmp_pal;
+	struct attr_db_decode *pad = handle;
+
+	if (pad == NULL)
+		return;
+	if (pad->ad_pal) {
+		for (index = 0; index < pad->ad_limit; index++) {
+			for (pal = pad->ad_pal[index]; pal; pal = tmp_pal) {
+				tmp_pal = pal->al_sister;
+				free(pal);
+			}
+		}
+		free(pad->ad_pal);
+	}
+	free(pad->ad_done);
+	free(pad);
+}
+
+/**
+ * @brief
+ *	Convert the list of attributes from the database into svrattrl entries
+ *	and sort them by the index of their attribute definition.
  *
- * @return      Error code
- * @retval	 0  - Success
- * @retval	-1  - Failure
+ *	Uses only local buffers, so may be called from the recovery threads.
  *
+ * @param[in]	attr_list - Information about the database attributes
+ * @param[in]	padef - Address of parent's attribute definition array
+ * @param[in]	limit - Number of attributes in the list
+ * @param[in]	unknown	- The index of the unknown attribute if any
  *
+ * @return	struct attr_db_decode *
+ * @retval	NULL	- Failure, out of memory
+ * @retval	!NULL	- the sorted attributes
  */
-int
-decode_attr_db(
-	void *parent,
-	pbs_db_attr_list_t *attr_list,
-	struct attribute_def *padef,
-	struct attribute *pattr,
-	int limit,
-	int unknown)
+static struct attr_db_decode *
+sort_attr_db(pbs_db_attr_list_t *attr_list, struct attribute_def *padef,
+	int limit, int unknown)
 {
 	int amt;
 	int index;
-	svrattrl *pal = (svrattrl *)0;
-	svrattrl *tmp_pal = (svrattrl *)0;
-	int ret = 0;
 	int i;
+	svrattrl *pal;
+	svrattrl *tmp_pal;
+	struct attr_db_decode *pad;
 	pbs_db_attr_info_t *attrs = attr_list->attributes;
-	void **palarray = NULL;
+	char msg[LOG_BUF_SIZE];
 
-	if ((palarray = calloc(limit, sizeof(void *))) == NULL) {
+	if (((pad = malloc(sizeof(struct attr_db_decode))) == NULL) ||
+		((pad->ad_pal = calloc(limit, sizeof(svrattrl *))) == NULL) ||
+		((pad->ad_done = calloc(limit, sizeof(char))) == NULL)) {
 		log_err(-1, __func__, "Out of memory");
-		ret = -1;
-		goto out;
+		if (pad) {
+			free(pad->ad_pal);
+			free(pad);
+		}
+		return NULL;
 	}
-
-	/* set all privileges (read and write) for decoding resources	*/
-	/* This is a special (kludge) flag for the recovery case, see	*/
-	/* decode_resc() in lib/Libattr/attr_fn_resc.c			*/
-
-	resc_access_perm = ATR_DFLAG_ACCESS;
+	pad->ad_limit = limit;
 
 	for (i = 0; i < attr_list->attr_count; i++) {
 		/* Below ensures that a server or queue resource is not set */
@@ -281,12 +320,12 @@ decode_attr_db(
 			prdef = find_resc_def(svr_resc_def,
 			                      attrs[i].attr_resc, svr_resc_size);
 			if (prdef == (resource_def *)0) {
-				snprintf(log_buffer, sizeof(log_buffer),
+				snprintf(msg, sizeof(msg),
 					"%s's unknown resource \"%s.%s\" ignored",
 					((padef == svr_attr_def)?"server":"queue"),
 					attrs[i].attr_name,
 					attrs[i].attr_resc);
-				log_err(-1, __func__, log_buffer);
+				log_err(-1, __func__, msg);
 				continue;
 			}
 		}
@@ -299,16 +338,23 @@ decode_attr_db(
 		/* Return when make_attr fails to create a svrattrl structure */
 		if (pal == NULL) {
 			log_err(-1, __func__, "Out of memory");
-			free(palarray);
-			ret = -1;
-			goto out;
+			decode_attr_db_free(pad);
+			return NULL;
 		}
 
 		amt = pal->al_tsize - sizeof(svrattrl);
 		if (amt < 1) {
-			snprintf(log_buffer,LOG_BUF_SIZE, "Invalid attr list size in DB");
-			log_err(-1, __func__, log_buffer);
-			goto out;
+			/* nothing is decoded from a bad list */
+			log_err(-1, __func__, "Invalid attr list size in DB");
+			free(pal);
+			for (index = 0; index < limit; index++) {
+				for (pal = pad->ad_pal[index]; pal; pal = tmp_pal) {
+					tmp_pal = pal->al_sister;
+					free(pal);
+				}
+				pad->ad_pal[index] = NULL;
+			}
+			return pad;
 		}
 		CLEAR_LINK(pal->al_link);
 
@@ -329,18 +375,18 @@ decode_attr_db(
 			if (unknown > 0) {
 				index = unknown;
 			} else {
-				snprintf(log_buffer,LOG_BUF_SIZE,
+				snprintf(msg, sizeof(msg),
 					"unknown attribute \"%s\" discarded",
 					pal->al_name);
-				log_err(-1, __func__, log_buffer);
+				log_err(-1, __func__, msg);
 				(void)free(pal);
 				continue;
 			}
 		}
-		if (palarray[index] == NULL)
-			palarray[index] = pal;
+		if (pad->ad_pal[index] == NULL)
+			pad->ad_pal[index] = pal;
 		else {
-			tmp_pal = palarray[index];
+			tmp_pal = pad->ad_pal[index];
 			while (tmp_pal->al_sister)
 				tmp_pal = tmp_pal->al_sister;
 
@@ -349,85 +395,227 @@ decode_attr_db(
 		}
 	}
 
-	if (ret == -1) {
-		/*
-		 * some error happened above
-		 * Error has already been logged
-		 * so just free palarray indexes and return
-		 */
-		if (palarray) {
-			for (index = 0; index < limit; index++)
-				if (palarray[index])
-					free(palarray[index]);
-			free(palarray);
-		}
-		goto out;
+	return pad;
+}
+
+/**
+ * @brief
+ *	Decode one value of an attribute read from the database
+ *
+ *	In the normal case we just decode the attribute directly into the real
+ *	attribute since there will be one entry only for that attribute.
+ *
+ *	However, "entity limits" are special and may have multiple, the first
+ *	of which is "SET" and the following are "INCR".  For the SET case, we
+ *	do it directly as for the normal attrs.  For the INCR, we have to
+ *	decode into a temp attr and then call set_entity to do the INCR.
+ *
+ *	We don't store the op value into the database, so we need to determine
+ *	(in case of an ENTITY) whether it is the first value, or was decoded
+ *	before.  We decide this based on whether the flag has ATR_VFLAG_SET.
+ *
+ * @param[in]	  pdef - attribute definition
+ * @param[in/out] pattr - attribute to decode into
+ * @param[in]	  pal - value to decode
+ *
+ * @return	int
+ * @retval	1 - decoded directly, the action routine should follow
+ * @retval	0 - incremented an entity limit or no decode routine
+ */
+static int
+decode_attr_db_value(struct attribute_def *pdef, struct attribute *pattr,
+	svrattrl *pal)
+{
+	if (pdef->at_decode == NULL)
+		return 0;
+
+	if ((pdef->at_type == ATR_TYPE_ENTITY) &&
+		(pattr->at_flags & ATR_VFLAG_SET)) {
+		attribute tmpa;
+
+		/* for INCR case of entity limit, decode locally */
+		memset(&tmpa, 0, sizeof(attribute));
+		(void)pdef->at_decode(&tmpa, pal->al_name, pal->al_resc,
+			pal->al_value);
+		(void)pdef->at_set(pattr, &tmpa, INCR);
+		(void)pdef->at_free(&tmpa);
+		return 0;
 	}
 
-	/* now do the decoding */
+	(void)pdef->at_decode(pattr, pal->al_name, pal->al_resc, pal->al_value);
+	return 1;
+}
+
+/**
+ * @brief
+ *	Can this attribute be decoded away from the main thread?
+ *
+ *	These decode routines keep no state in statics and read no globals
+ *	other than the resource definitions and resc_access_perm, neither of
+ *	which changes while the recovery threads run.  Anything else, for
+ *	example decode_depend() which resolves server host names, and the
+ *	entity limits which are built up with at_set(), is left to
+ *	decode_attr_db_finish().
+ *
+ * @param[in]	pdef - attribute definition
+ *
+ * @return	int
+ * @retval	1 - yes
+ * @retval	0 - no
+ */
+static int
+decode_attr_db_reentrant(struct attribute_def *pdef)
+{
+	int (*decode)(attribute *, char *, char *, char *) = pdef->at_decode;
+
+	if ((decode == NULL) || (pdef->at_type == ATR_TYPE_ENTITY))
+		return 0;
+
+	return ((decode == decode_str) || (decode == decode_l) ||
+		(decode == decode_ll) || (decode == decode_b) ||
+		(decode == decode_c) || (decode == decode_f) ||
+		(decode == decode_size) || (decode == decode_time) ||
+		(decode == decode_arst) || (decode == decode_arst_bs) ||
+		(decode == decode_resc) || (decode == decode_unkn) ||
+		(decode == decode_hold) || (decode == decode_jobname) ||
+		(decode == decode_sandbox) || (decode == decode_project));
+}
+
+/**
+ * @brief
+ *	First half of decode_attr_db(), which may run on a recovery thread.
+ *
+ *	Sorts the database attributes and decodes those whose decode routine
+ *	is reentrant, see decode_attr_db_reentrant().  No action routines are
+ *	called; decode_attr_db_finish() must be called on the main thread to
+ *	decode the rest, run the actions and free the returned structure.
+ *
+ *	The caller sets resc_access_perm to ATR_DFLAG_ACCESS before starting
+ *	the threads, see decode_attr_db().
+ *
+ * @param[in]	  attr_list - Information about the database attributes
+ * @param[in]	  padef - Address of parent's attribute definition array
+ * @param[in/out] pattr - Address of the parent objects attribute array
+ * @param[in]	  limit - Number of attributes in the list
+ * @param[in]	  unknown - The index of the unknown attribute if any
+ *
+ * @return	void *
+ * @retval	NULL	- Failure
+ * @retval	!NULL	- handle to pass to decode_attr_db_finish()
+ */
+void *
+decode_attr_db_prep(pbs_db_attr_list_t *attr_list,
+	struct attribute_def *padef, struct attribute *pattr,
+	int limit, int unknown)
+{
+	int index;
+	svrattrl *pal;
+	struct attr_db_decode *pad;
+
+	if ((pad = sort_attr_db(attr_list, padef, limit, unknown)) == NULL)
+		return NULL;
+
 	for (index = 0; index < limit; index++) {
-		/*
-		 * In the normal case we just decode the attribute directly
-		 * into the real attribute since there will be one entry only
-		 * for that attribute.
-		 *
-		 * However, "entity limits" are special and may have multiple,
-		 * the first of which is "SET" and the following are "INCR".
-		 * For the SET case, we do it directly as for the normal attrs.
-		 * For the INCR,  we have to decode into a temp attr and then
-		 * call set_entity to do the INCR.
-		 */
-		/*
-		 * we don't store the op value into the database, so we need to
-		 * determine (in case of an ENTITY) whether it is the first
-		 * value, or was decoded before. We decide this based on whether
-		 * the flag has ATR_VFLAG_SET
-		 *
-		 */
-		pal = palarray[index];
+		if ((pad->ad_pal[index] == NULL) ||
+			!decode_attr_db_reentrant(padef + index))
+			continue;
+		for (pal = pad->ad_pal[index]; pal; pal = pal->al_sister)
+			(void)decode_attr_db_value(padef + index,
+				pattr + index, pal);
+		pad->ad_done[index] = 1;
+	}
+
+	return pad;
+}
+
+/**
+ * @brief
+ *	Second half of decode_attr_db(), run on the main thread.
+ *
+ *	In index order, decodes the attributes not already decoded by
+ *	decode_attr_db_prep(), calls the action routines with
+ *	ATR_ACTION_RECOV and restores the saved flags.
+ *
+ * @param[in]	  parent - pointer to parent object
+ * @param[in]	  handle - from decode_attr_db_prep(), freed here
+ * @param[in]	  padef - Address of parent's attribute definition array
+ * @param[in/out] pattr - Address of the parent objects attribute array
+ */
+void
+decode_attr_db_finish(void *parent, void *handle,
+	struct attribute_def *padef, struct attribute *pattr)
+{
+	int index;
+	int act;
+	svrattrl *pal;
+	svrattrl *tmp_pal;
+	struct attr_db_decode *pad = handle;
+
+	if (pad == NULL)
+		return;
+
+	/* set all privileges (read and write) for decoding resources	*/
+	/* This is a special (kludge) flag for the recovery case, see	*/
+	/* decode_resc() in lib/Libattr/attr_fn_resc.c			*/
+
+	resc_access_perm = ATR_DFLAG_ACCESS;
+
+	for (index = 0; index < pad->ad_limit; index++) {
+		pal = pad->ad_pal[index];
 		while (pal) {
-			if (((padef + index)->at_type == ATR_TYPE_ENTITY) &&
-				((pattr + index)->at_flags & ATR_VFLAG_SET)) {
-				attribute tmpa;
-				memset(&tmpa, 0, sizeof(attribute));
-				/* for INCR case of entity limit, decode locally */
-				if ((padef+index)->at_decode) {
-					(void)(padef+index)->at_decode(&tmpa,
-						pal->al_name,
-						pal->al_resc,
-						pal->al_value);
-					(void)(padef+index)->at_set(pattr+index,
-						&tmpa,
-						INCR);
-					(void)(padef+index)->at_free(&tmpa);
-				}
-			} else {
-				if ((padef+index)->at_decode) {
-					(void)(padef+index)->at_decode(pattr+index,
-						pal->al_name,
-						pal->al_resc,
-						pal->al_value);
-					if ((padef+index)->at_action)
-						(void)(padef+index)->at_action(
-							pattr+index, parent,
-							ATR_ACTION_RECOV);
-				}
-			}
-			(pattr+index)->at_flags = pal->al_flags & ~ATR_VFLAG_MODIFY;
+			if (pad->ad_done[index])
+				act = 1;
+			else
+				act = decode_attr_db_value(padef + index,
+					pattr + index, pal);
+			if (act && (padef+index)->at_action)
+				(void)(padef+index)->at_action(pattr+index,
+					parent, ATR_ACTION_RECOV);
+			(pattr+index)->at_flags = pal->al_flags &
+				~(ATR_VFLAG_MODIFY | ATR_VFLAG_SHARED);
 
 			tmp_pal = pal->al_sister;
 			(void)free(pal);
 			pal = tmp_pal;
 		}
+		pad->ad_pal[index] = NULL;
 	}
-	(void)free(palarray);
-	ret = 0;
+	decode_attr_db_free(pad);
+}
 
-	/* fall through to free attribute array stuff */
+/**
+ * @brief
+ *	Decode the list of attributes from the database to the regular attribute structure
+ *
+ * @param[in]	  parent - pointer to parent object
+ * @param[in]	  attr_list - Information about the database attributes
+ * @param[in]	  padef - Address of parent's attribute definition array
+ * @param[in/out] pattr - Address of the parent objects attribute array
+ * @param[in]	  limit - Number of attributes in the list
+ * @param[in]	  unknown	- The index of the unknown attribute if any
+ *
+ * @return      Error code
+ * @retval	 0  - Success
+ * @retval	-1  - Failure
+ *
+ *
+ */
+int
+decode_attr_db(
+	void *parent,
+	pbs_db_attr_list_t *attr_list,
+	struct attribute_def *padef,
+	struct attribute *pattr,
+	int limit,
+	int unknown)
+{
+	struct attr_db_decode *pad;
 
-out:
+	if ((pad = sort_attr_db(attr_list, padef, limit, unknown)) == NULL)
+		return -1;
 
-	return ret;
+	decode_attr_db_finish(parent, pad, padef, pattr);
+	return 0;
 }
 
 /**
@@ -124,10 +124,7 @@
 #include "pbs_error.h"
 #include "batch_request.h"
 #include "pbs_entlim.h"
-
-#ifndef PBS_MOM
 #include "avltree.h"
-#endif
 
 #include "svrfunc.h"
 #include "acct.h"
@@ -171,6 +168,14 @@ extern int is_called_by_job_purge;
 #ifdef PBS_MOM
 #include "mom_func.h"
 
+/*
+ * Index of the jobs on svr_alljobs by job id, lower cased as job ids are
+ * compared without case.  If it cannot be maintained it is discarded and
+ * find_job() goes back to walking svr_alljobs.
+ */
+static AVL_IX_DESC *mom_jobidx = NULL;
+static int mom_jobidx_off = 0;
+
 extern void  rmtmpdir(char *);
 void nodes_free(job *);
 extern char* std_file_name(job *pjob, enum job_file which, int *keeping);
@@ -212,6 +217,7 @@ tasks_free(job *pj)
 				close_conn(tp->ti_tmfd[i]);
 			free(tp->ti_tmfd);
 		}
+		task_unindex_sid(tp);
 		delete_link(&tp->ti_jobtask);
 		free(tp);
 		tp = (pbs_task *)GET_NEXT(pj->ji_tasks);
@@ -362,6 +368,9 @@ job_alloc(void)
 	pj->ji_parent2child_job_update_status_pipe = -1;
 	pj->ji_parent2child_moms_status_pipe = -1;
 	pj->ji_updated = 0;
+	CLEAR_HEAD(pj->ji_rused_sent);
+	pj->ji_rused_hop = -1;
+	CLEAR_LINK(pj->ji_exitlink);
 #ifdef WIN32
 	pj->ji_hJob = NULL;
 	pj->ji_user = NULL;
@@ -452,6 +461,12 @@ job_free(job *pj)
 	}
 #endif
 
+	free_attrlist(&pj->ji_rused_sent);
+	if (pj->ji_cgacct != NULL)
+		free(pj->ji_cgacct);
+#ifndef WIN32
+	free_job_env(pj);
+#endif
 #endif
 
 	/* remove any malloc working attribute space */
@@ -524,6 +539,7 @@ job_free(job *pj)
 		pj->ji_ajtrk = NULL;
 	}
 	pj->ji_parentaj = NULL;
+	release_subjob_attrs(pj);
 	if (pj->ji_discard)
 		free(pj->ji_discard);
 	if (pj->ji_acctrec)
@@ -707,9 +723,11 @@ job_purge(job *pjob)
 		pjob->ji_rerun_preq = NULL;
 	}
 #ifdef	PBS_MOM
+	mom_avljob_oper(pjob, 1);
 	delete_link(&pjob->ji_jobque);
 	delete_link(&pjob->ji_alljobs);
 	delete_link(&pjob->ji_unlicjobs);
+	delete_link(&pjob->ji_exitlink);
 
 	if (pjob->ji_preq != NULL) {
 		log_joberr(PBSE_INTERNAL, __func__, "request outstanding",
@@ -987,6 +1005,77 @@ job_purge(job *pjob)
 	return;
 }
 
+#ifdef PBS_MOM
+/**
+ * @brief
+ * 		mom_jobidx_key - make the job index key for a job id
+ *
+ * @param[in]	jobid - job id
+ * @param[out]	key - buffer of PBS_MAXSVRJOBID+1 bytes for the key
+ *
+ * @return	void
+ */
+static void
+mom_jobidx_key(const char *jobid, char *key)
+{
+	int i;
+
+	for (i = 0; i < PBS_MAXSVRJOBID && jobid[i] != '\0'; i++)
+		key[i] = tolower((unsigned char)jobid[i]);
+	key[i] = '\0';
+}
+
+/**
+ * @brief
+ * 		mom_avljob_oper - add a job to or delete it from the job index
+ *
+ * @par
+ *		Called whenever a job is put on or taken off svr_alljobs.  A
+ *		delete only removes the entry if it is for this job.  On failure
+ *		the index is destroyed and find_job() walks svr_alljobs.
+ *
+ * @param[in]	pjob - job structure
+ * @param[in]	delkey - 0 to add the job, 1 to delete it
+ *
+ * @return	void
+ */
+void
+mom_avljob_oper(job *pjob, int delkey)
+{
+	char key[PBS_MAXSVRJOBID+1];
+
+	if (mom_jobidx_off || (pjob == NULL))
+		return;
+	if (mom_jobidx == NULL) {
+		if (delkey)
+			return;
+		if ((mom_jobidx = create_tree(AVL_NO_DUP_KEYS, 0)) == NULL)
+			goto idx_fail;
+	}
+
+	mom_jobidx_key(pjob->ji_qs.ji_jobid, key);
+	if (delkey) {
+		if (find_tree(mom_jobidx, key) == pjob)
+			(void)tree_add_del(mom_jobidx, key, NULL, TREE_OP_DEL);
+		return;
+	}
+	if (find_tree(mom_jobidx, key) != NULL)
+		(void)tree_add_del(mom_jobidx, key, NULL, TREE_OP_DEL);
+	if (tree_add_del(mom_jobidx, key, pjob, TREE_OP_ADD) == 0)
+		return;
+
+idx_fail:
+	log_eventf(PBSEVENT_DEBUG4, PBS_EVENTCLASS_JOB, LOG_DEBUG,
+		pjob->ji_qs.ji_jobid, "AVL: job index disabled");
+	if (mom_jobidx != NULL) {
+		avl_destroy_index(mom_jobidx);
+		free(mom_jobidx);
+		mom_jobidx = NULL;
+	}
+	mom_jobidx_off = 1;
+}
+#endif	/* PBS_MOM */
+
 /**
  * @brief
  * 		find_job() - find job by jobid
@@ -1000,7 +1089,8 @@ job_purge(job *pjob)
  *		hostname. For example, "foo" will match "foo.bar.com", but
  *		"foo.bar" will not match "foo.bar.com".
  *
- *		If server, then search in AVL tree otherwise Linked list.
+ *		Both server and Mom search an AVL tree when they have one,
+ *		otherwise the linked list.
  *
  * @param[in]	jobid - job ID string.
  *
@@ -1017,6 +1107,8 @@ find_job(char *jobid)
 	char *host_dot;
 	char *serv_dot;
 	char *host;
+#else
+	char key[PBS_MAXSVRJOBID+1];
 #endif
 	char *at;
 	job  *pj = NULL;
@@ -1101,6 +1193,13 @@ find_job(char *jobid)
 		free(pkey);
 		return (pj);
 	}
+#else
+	if (!mom_jobidx_off) {
+		if (mom_jobidx == NULL)
+			return NULL;	/* no job added yet */
+		mom_jobidx_key(buf, key);
+		return ((job *)find_tree(mom_jobidx, key));
+	}
 #endif
 	pj = (job *)GET_NEXT(svr_alljobs);
 	while (pj != NULL) {
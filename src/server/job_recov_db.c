@@ -51,6 +51,12 @@
  *	job_or_resv_save_db() -	save to database (job/reservation)
  *	job_recov_db()        - recover(read) job from database
  *	job_or_resv_recov_db() -	recover(read) job/reservation from database
+ *	job_recov_db_open()   - start recovering the jobs of a database cursor
+ *	job_recov_db_next()   - next job recovered from the cursor
+ *	job_recov_db_close()  - end recovering jobs from a cursor
+ *	job_snapshot_save()   - write a snapshot of the jobs
+ *	job_snapshot_open()   - open the job snapshot for job_recov_db_open()
+ *	job_snapshot_close()  - close the job snapshot
  *	svr_to_db_job		  -	Load a server job object to a database job object
  *	db_to_svr_job		  - Load data from database job object to a server job object
  *	svr_to_db_resv		  -	Load data from server resv object to a database resv object
@@ -68,6 +74,10 @@
 
 #ifndef WIN32
 #include <sys/param.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <signal.h>
 #endif
 
 #include "pbs_ifl.h"
@@ -76,6 +86,8 @@
 #include <string.h>
 #include <stdlib.h>
 #include <time.h>
+#include <stdint.h>
+#include <pthread.h>
 
 #include <unistd.h>
 #include "server_limits.h"
@@ -98,6 +110,8 @@
 #include <memory.h>
 #include "libutil.h"
 #include "pbs_db.h"
+#include "pbs_internal.h"
+#include "work_task.h"
 
 
 #define MAX_SAVE_TRIES 3
@@ -122,6 +136,8 @@ extern int recov_attr_db(pbs_db_conn_t *conn,
 
 /* global data items */
 extern time_t time_now;
+extern int resc_access_perm;
+extern pbs_list_head svr_alljobs;
 
 #ifndef PBS_MOM
 
@@ -187,19 +203,17 @@ svr_to_db_job(job *pjob, pbs_db_job_info_t *dbjob, int updatetype)
 
 /**
  * @brief
- *		Load data from database job object to a server job object
+ *		Load the fixed (non attribute) data from a database job object
+ *		to a server job object
  *
  * @see
- * 		job_recov_db
+ * 		db_to_svr_job, job_recov_db_next
  *
  * @param[out]	pjob - Address of the job in the server
  * @param[in]	dbjob - Address of the database job object
- *
- * @retval   !=0  Failure
- * @retval   0    Success
  */
-static int
-db_to_svr_job(job *pjob,  pbs_db_job_info_t *dbjob)
+static void
+db_to_svr_job_qs(job *pjob,  pbs_db_job_info_t *dbjob)
 {
 	/* Variables assigned constant values are not stored in the DB */
 	pjob->ji_qs.ji_jsversion = JSVERSION;
@@ -243,6 +257,25 @@ db_to_svr_job(job *pjob,  pbs_db_job_info_t *dbjob)
 	strcpy(pjob->ji_extended.ji_ext.ji_4ash, dbjob->ji_4ash);
 #endif
 	pjob->ji_extended.ji_ext.ji_credtype = dbjob->ji_credtype;
+}
+
+/**
+ * @brief
+ *		Load data from database job object to a server job object
+ *
+ * @see
+ * 		job_recov_db
+ *
+ * @param[out]	pjob - Address of the job in the server
+ * @param[in]	dbjob - Address of the database job object
+ *
+ * @retval   !=0  Failure
+ * @retval   0    Success
+ */
+static int
+db_to_svr_job(job *pjob,  pbs_db_job_info_t *dbjob)
+{
+	db_to_svr_job_qs(pjob, dbjob);
 
 	if ((decode_attr_db(pjob, &dbjob->attr_list, job_attr_def,
 				pjob->ji_wattr,
@@ -550,6 +583,1032 @@ db_err:
 	return (NULL);
 }
 
+/*
+ * Job snapshot, see PBS_SERVER_SNAPSHOT in pbs.conf(8B).
+ *
+ * The server can write the jobs it holds in memory to a file in server_priv,
+ * periodically from a child process and synchronously at shutdown.  At a
+ * warm or hot start, the jobs whose database row was last saved before the
+ * snapshot was taken are recovered from the snapshot, and only the others
+ * have their attributes read and decoded from the database.  "Before" is
+ * decided by the job save sequence of the database (ji_saveseq), not by a
+ * clock.  Only the attributes are taken from the snapshot, the fixed part
+ * of the job always comes from the database row.
+ *
+ * The file is meant to be read through mmap().  Numbers are in the byte
+ * order of the host and every part starts on an 8 byte boundary:
+ *
+ *	job_snap_hdr_t
+ *	per job: job_snap_rec_t, then sr_nattr times a job_snap_attr_t
+ *		followed by the resource name and the value, each with its NUL
+ *
+ * sh_sum covers everything after the header.  sh_defsum is the sum of the
+ * job attribute names, so a snapshot written by a server with other
+ * attribute definitions is not used.
+ */
+#define JOB_SNAP_MAGIC		"PBSSNAP\001"
+#define JOB_SNAP_MAGIC_LEN	8
+#define JOB_SNAP_VERSION	2
+#define JOB_SNAP_ALIGN(n)	(((n) + 7) & ~((size_t)7))
+#define JOB_SNAP_SUM_INIT	0xcbf29ce484222325ULL
+#define JOB_SNAP_BUFSIZE	(1024 * 1024)
+
+typedef struct job_snap_hdr {
+	char		sh_magic[JOB_SNAP_MAGIC_LEN];
+	uint32_t	sh_version;
+	uint32_t	sh_hdrsize;	/* sizeof(job_snap_hdr_t) */
+	uint32_t	sh_recsize;	/* sizeof(job_snap_rec_t) */
+	uint32_t	sh_nattr;	/* JOB_ATR_LAST */
+	uint64_t	sh_defsum;	/* sum of the job attribute names */
+	int64_t		sh_seq;		/* job save sequence when taken */
+	uint64_t	sh_njobs;
+	uint64_t	sh_size;	/* size of the file */
+	uint64_t	sh_sum;		/* sum of the rest of the file */
+} job_snap_hdr_t;
+
+typedef struct job_snap_rec {
+	uint32_t	sr_size;	/* size of the record with its attributes */
+	uint32_t	sr_nattr;	/* number of job_snap_attr_t */
+	char		sr_jobid[JOB_SNAP_ALIGN(PBS_MAXSVRJOBID + 1)];
+} job_snap_rec_t;
+
+typedef struct job_snap_attr {
+	uint16_t	sa_index;	/* index in job_attr_def */
+	uint16_t	sa_resclen;	/* length of the resource name + NUL */
+	uint32_t	sa_vallen;	/* length of the value + NUL */
+	int32_t		sa_flags;	/* attribute value flags */
+	int32_t		sa_unused;
+} job_snap_attr_t;
+
+typedef struct job_snap {
+	char		*js_addr;	/* the mapped file */
+	size_t		js_size;
+	BIGINT		js_seq;
+	long		js_njobs;
+	job_snap_rec_t	**js_index;	/* the records sorted by job id */
+} job_snap_t;
+
+typedef struct job_snap_out {
+	FILE		*so_fp;
+	uint64_t	so_sum;
+	uint64_t	so_size;
+	int		so_err;		/* errno of the first failed write */
+} job_snap_out_t;
+
+extern char *path_job_snapshot;
+
+#ifndef WIN32
+static pid_t job_snapshot_pid;	/* child writing the periodic snapshot */
+#endif
+
+/**
+ * @brief
+ *		Add data to a FNV-1a sum
+ *
+ * @param[in]	sum - the sum so far, JOB_SNAP_SUM_INIT to start
+ * @param[in]	buf - the data
+ * @param[in]	len - length of the data
+ *
+ * @return	uint64_t - the new sum
+ */
+static uint64_t
+job_snap_sum(uint64_t sum, const void *buf, size_t len)
+{
+	const unsigned char *p = buf;
+
+	while (len-- > 0) {
+		sum ^= *p++;
+		sum *= 0x100000001b3ULL;
+	}
+	return sum;
+}
+
+/**
+ * @brief
+ *		Sum of the names of the job attributes, see sh_defsum
+ *
+ * @return	uint64_t
+ */
+static uint64_t
+job_snap_defsum(void)
+{
+	uint64_t sum = JOB_SNAP_SUM_INIT;
+	int i;
+
+	for (i = 0; i < (int)JOB_ATR_LAST; i++)
+		sum = job_snap_sum(sum, job_attr_def[i].at_name,
+			strlen(job_attr_def[i].at_name) + 1);
+	return sum;
+}
+
+/**
+ * @brief
+ *		Write data to the snapshot file
+ *
+ * @param[in,out]	po - the output file
+ * @param[in]	buf - the data
+ * @param[in]	len - length of the data
+ */
+static void
+job_snap_write(job_snap_out_t *po, const void *buf, size_t len)
+{
+	if (po->so_err != 0)
+		return;
+	if (fwrite(buf, 1, len, po->so_fp) != len) {
+		po->so_err = (errno != 0) ? errno : EIO;
+		return;
+	}
+	po->so_sum = job_snap_sum(po->so_sum, buf, len);
+	po->so_size += len;
+}
+
+/**
+ * @brief
+ *		Pad the snapshot file to the next 8 byte boundary
+ *
+ * @param[in,out]	po - the output file
+ */
+static void
+job_snap_pad(job_snap_out_t *po)
+{
+	static const char pad[8];
+
+	job_snap_write(po, pad, JOB_SNAP_ALIGN(po->so_size) - po->so_size);
+}
+
+/**
+ * @brief
+ *		Write the record of a job to the snapshot file
+ *
+ * @param[in,out]	po - the output file
+ * @param[in]	pjob - the job
+ *
+ * @return	int
+ * @retval	0	- written
+ * @retval	-1	- the job could not be encoded
+ */
+static int
+job_snap_put_job(job_snap_out_t *po, job *pjob)
+{
+	pbs_list_head lhead;
+	svrattrl *pal;
+	svrattrl *ptail;
+	job_snap_rec_t rec;
+	job_snap_attr_t sa;
+	int nent[(int)JOB_ATR_LAST];
+	int i;
+	int n;
+	char *resc;
+
+	memset(&rec, 0, sizeof(rec));
+	strncpy(rec.sr_jobid, pjob->ji_qs.ji_jobid, sizeof(rec.sr_jobid) - 1);
+
+	/* encode all the attributes first, the record starts with its size */
+	CLEAR_HEAD(lhead);
+	rec.sr_size = sizeof(rec);
+	rec.sr_nattr = 0;
+	ptail = NULL;
+	for (i = 0; i < (int)JOB_ATR_LAST; i++) {
+		if (job_attr_def[i].at_encode(&pjob->ji_wattr[i], &lhead,
+			job_attr_def[i].at_name, NULL, ATR_ENCODE_DB, NULL) < 0) {
+			free_attrlist(&lhead);
+			return -1;
+		}
+		/* count the entries added, the return value is not a count */
+		nent[i] = 0;
+		pal = (ptail != NULL) ? (svrattrl *)GET_NEXT(ptail->al_link) :
+			(svrattrl *)GET_NEXT(lhead);
+		for (; pal != NULL; pal = (svrattrl *)GET_NEXT(pal->al_link)) {
+			resc = (pal->al_resc != NULL) ? pal->al_resc : "";
+			rec.sr_size += sizeof(sa) + JOB_SNAP_ALIGN(strlen(resc) +
+				strlen(pal->al_value) + 2);
+			rec.sr_nattr++;
+			nent[i]++;
+			ptail = pal;
+		}
+	}
+
+	job_snap_write(po, &rec, sizeof(rec));
+	pal = (svrattrl *)GET_NEXT(lhead);
+	for (i = 0; i < (int)JOB_ATR_LAST; i++) {
+		for (n = 0; n < nent[i]; n++) {
+			resc = (pal->al_resc != NULL) ? pal->al_resc : "";
+			memset(&sa, 0, sizeof(sa));
+			sa.sa_index = i;
+			sa.sa_resclen = strlen(resc) + 1;
+			sa.sa_vallen = strlen(pal->al_value) + 1;
+			sa.sa_flags = pal->al_flags;
+			job_snap_write(po, &sa, sizeof(sa));
+			job_snap_write(po, resc, sa.sa_resclen);
+			job_snap_write(po, pal->al_value, sa.sa_vallen);
+			job_snap_pad(po);
+			pal = (svrattrl *)GET_NEXT(pal->al_link);
+		}
+	}
+	free_attrlist(&lhead);
+	return 0;
+}
+
+/**
+ * @brief
+ *		Check whether a job has changes not yet saved to the database,
+ *		either flagged for the whole job or on one of its attributes
+ *
+ * @param[in]	pjob - the job
+ *
+ * @return	int
+ * @retval	1	- the job has unsaved changes
+ * @retval	0	- the job is as saved
+ */
+static int
+job_snap_unsaved(job *pjob)
+{
+	int i;
+
+	if (pjob->ji_newjob || pjob->ji_modified)
+		return 1;
+	for (i = 0; i < (int)JOB_ATR_LAST; i++) {
+		if (pjob->ji_wattr[i].at_flags & ATR_VFLAG_MODIFY)
+			return 1;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *		Write a snapshot of the jobs of the server
+ *
+ *		The snapshot is written to a temporary file that is renamed to
+ *		path_job_snapshot once complete.  Jobs with changes not yet
+ *		saved to the database are left out, they are recovered from
+ *		the database.  Nothing is logged, this runs in a child process.
+ *
+ * @param[in]	seq - job save sequence taken before the jobs are written
+ *
+ * @return	int
+ * @retval	0	- Success
+ * @retval	!0	- Failure, an errno value
+ */
+static int
+job_snapshot_write(BIGINT seq)
+{
+	char tmpname[MAXPATHLEN + 1];
+	job_snap_hdr_t hdr;
+	job_snap_out_t out;
+	job *pjob;
+	int fd;
+	int rc;
+
+	snprintf(tmpname, sizeof(tmpname), "%s.%d", path_job_snapshot,
+		(int)getpid());
+	if ((fd = open(tmpname, O_WRONLY | O_CREAT | O_TRUNC, 0600)) == -1)
+		return errno;
+	if ((out.so_fp = fdopen(fd, "w")) == NULL) {
+		rc = errno;
+		(void)close(fd);
+		(void)unlink(tmpname);
+		return rc;
+	}
+	(void)setvbuf(out.so_fp, NULL, _IOFBF, JOB_SNAP_BUFSIZE);
+
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.sh_magic, JOB_SNAP_MAGIC, JOB_SNAP_MAGIC_LEN);
+	hdr.sh_version = JOB_SNAP_VERSION;
+	hdr.sh_hdrsize = sizeof(hdr);
+	hdr.sh_recsize = sizeof(job_snap_rec_t);
+	hdr.sh_nattr = (uint32_t)JOB_ATR_LAST;
+	hdr.sh_defsum = job_snap_defsum();
+	hdr.sh_seq = seq;
+
+	/* the header is written again at the end, with the sum and sizes */
+	out.so_err = 0;
+	if (fwrite(&hdr, sizeof(hdr), 1, out.so_fp) != 1)
+		out.so_err = (errno != 0) ? errno : EIO;
+	out.so_sum = JOB_SNAP_SUM_INIT;
+	out.so_size = sizeof(hdr);
+
+	for (pjob = (job *)GET_NEXT(svr_alljobs); pjob != NULL;
+		pjob = (job *)GET_NEXT(pjob->ji_alljobs)) {
+		if (job_snap_unsaved(pjob))
+			continue;
+		if (job_snap_put_job(&out, pjob) == 0)
+			hdr.sh_njobs++;
+	}
+
+	hdr.sh_size = out.so_size;
+	hdr.sh_sum = out.so_sum;
+	if ((out.so_err == 0) && ((fflush(out.so_fp) != 0) ||
+		(fseek(out.so_fp, 0L, SEEK_SET) != 0) ||
+		(fwrite(&hdr, sizeof(hdr), 1, out.so_fp) != 1) ||
+		(fflush(out.so_fp) != 0) ||
+		(fsync(fileno(out.so_fp)) != 0)))
+		out.so_err = (errno != 0) ? errno : EIO;
+	if ((fclose(out.so_fp) != 0) && (out.so_err == 0))
+		out.so_err = (errno != 0) ? errno : EIO;
+
+	if ((out.so_err == 0) && (rename(tmpname, path_job_snapshot) == -1))
+		out.so_err = errno;
+	if (out.so_err != 0)
+		(void)unlink(tmpname);
+	return out.so_err;
+}
+
+#ifndef WIN32
+/**
+ * @brief
+ *		Work task run when the child writing a periodic snapshot exits
+ *
+ * @param[in]	pwt - work task, wt_aux is the exit status of the child
+ */
+static void
+post_job_snapshot(struct work_task *pwt)
+{
+	int stat = pwt->wt_aux;
+
+	job_snapshot_pid = 0;
+	if (WIFEXITED(stat) && (WEXITSTATUS(stat) == 0)) {
+		log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SERVER, LOG_DEBUG,
+			"job_snapshot_save", "job snapshot written");
+	} else {
+		log_err(WIFEXITED(stat) ? WEXITSTATUS(stat) : -1,
+			"job_snapshot_save", "failed to write job snapshot");
+	}
+}
+#endif
+
+/**
+ * @brief
+ *		Write a snapshot of the jobs, see PBS_SERVER_SNAPSHOT
+ * @par
+ *		Invoked periodically by a timed work task, the first one is
+ *		created at server initialization and then recreated on each
+ *		entry.  The periodic snapshot is written by a child process so
+ *		the server is not held up.
+ * @par
+ *		On server shutdown, after the jobs are saved, job_snapshot_save
+ *		is called with a null work task pointer and the snapshot is
+ *		written synchronously.
+ *
+ * @param[in]	pwt - work task, NULL at shutdown
+ */
+void
+job_snapshot_save(struct work_task *pwt)
+{
+	BIGINT seq;
+	int rc;
+#ifndef WIN32
+	pid_t pid;
+	char tmpname[MAXPATHLEN + 1];
+#endif
+
+	if (pbs_conf.pbs_server_snapshot == 0)
+		return;
+
+	if (pwt) {	/* set up another work task for next time period */
+		if (!set_task(WORK_Timed,
+			(long)time_now + pbs_conf.pbs_server_snapshot,
+			job_snapshot_save, NULL))
+			log_err(errno, __func__, "Unable to set task for save");
+#ifndef WIN32
+		if (job_snapshot_pid != 0)
+			return;	/* the previous one is still being written */
+#endif
+	}
+#ifndef WIN32
+	else if (job_snapshot_pid != 0) {
+		/* an older periodic snapshot must not replace this one */
+		(void)kill(job_snapshot_pid, SIGKILL);
+		(void)waitpid(job_snapshot_pid, NULL, 0);
+		snprintf(tmpname, sizeof(tmpname), "%s.%d", path_job_snapshot,
+			(int)job_snapshot_pid);
+		(void)unlink(tmpname);
+		job_snapshot_pid = 0;
+	}
+#endif
+
+	/* rows saved from now on are newer than the snapshot */
+	if ((svr_db_conn == NULL) ||
+		(pbs_db_get_job_saveseq(svr_db_conn, &seq) != 0)) {
+		log_err(-1, __func__, "failed to get the job save sequence");
+		return;
+	}
+
+#ifndef WIN32
+	if (pwt) {
+		pid = fork();
+		if (pid == -1) {
+			log_err(errno, __func__, "fork failed");
+			return;
+		}
+		if (pid == 0)
+			_exit(job_snapshot_write(seq));
+
+		job_snapshot_pid = pid;
+		if (set_task(WORK_Deferred_Child, (long)pid, post_job_snapshot,
+			NULL) == NULL)
+			log_err(errno, __func__, "Unable to set task for save");
+		return;
+	}
+#endif
+
+	if ((rc = job_snapshot_write(seq)) != 0)
+		log_err(rc, __func__, "failed to write job snapshot");
+	else
+		log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SERVER, LOG_DEBUG,
+			__func__, "job snapshot written");
+}
+
+/**
+ * @brief
+ *		Compare two snapshot records by job id, for qsort()
+ */
+static int
+job_snap_cmp(const void *a, const void *b)
+{
+	return strcmp((*(job_snap_rec_t * const *)a)->sr_jobid,
+		(*(job_snap_rec_t * const *)b)->sr_jobid);
+}
+
+/**
+ * @brief
+ *		Compare a job id with a snapshot record, for bsearch()
+ */
+static int
+job_snap_find_cmp(const void *key, const void *b)
+{
+	return strcmp((const char *)key,
+		(*(job_snap_rec_t * const *)b)->sr_jobid);
+}
+
+/**
+ * @brief
+ *		Check the records of a mapped snapshot and index them by job id
+ *
+ * @param[in,out]	pjs - the snapshot, js_index is set
+ * @param[in]	phdr - its header, already checked
+ *
+ * @return	char *
+ * @retval	NULL	- Success
+ * @retval	!NULL	- what is wrong with the snapshot
+ */
+static char *
+job_snap_index(job_snap_t *pjs, job_snap_hdr_t *phdr)
+{
+	job_snap_rec_t *prec;
+	job_snap_attr_t *psa;
+	size_t off;
+	size_t end;
+	size_t aoff;
+	uint32_t j;
+	long i;
+
+	if (phdr->sh_njobs > (phdr->sh_size - phdr->sh_hdrsize) /
+		sizeof(job_snap_rec_t))
+		return "bad job count";
+	pjs->js_njobs = (long)phdr->sh_njobs;
+	pjs->js_index = malloc((pjs->js_njobs + 1) * sizeof(job_snap_rec_t *));
+	if (pjs->js_index == NULL)
+		return "no memory";
+
+	off = phdr->sh_hdrsize;
+	for (i = 0; i < pjs->js_njobs; i++) {
+		prec = (job_snap_rec_t *)(pjs->js_addr + off);
+		if ((pjs->js_size - off < sizeof(job_snap_rec_t)) ||
+			(prec->sr_size < sizeof(job_snap_rec_t)) ||
+			(prec->sr_size > pjs->js_size - off) ||
+			(prec->sr_size != JOB_SNAP_ALIGN(prec->sr_size)) ||
+			(memchr(prec->sr_jobid, '\0',
+			sizeof(prec->sr_jobid)) == NULL))
+			return "bad job record";
+		end = off + prec->sr_size;
+
+		/* the attributes must fill the record exactly */
+		aoff = off + sizeof(job_snap_rec_t);
+		for (j = 0; j < prec->sr_nattr; j++) {
+			psa = (job_snap_attr_t *)(pjs->js_addr + aoff);
+			if ((end - aoff < sizeof(job_snap_attr_t)) ||
+				(psa->sa_index >= (uint32_t)JOB_ATR_LAST) ||
+				(psa->sa_resclen == 0) || (psa->sa_vallen == 0) ||
+				(psa->sa_resclen > PBS_MAXATTRRESC + 1) ||
+				(end - aoff - sizeof(job_snap_attr_t) <
+				JOB_SNAP_ALIGN((size_t)psa->sa_resclen + psa->sa_vallen)))
+				return "bad attribute record";
+			aoff += sizeof(job_snap_attr_t);
+			if ((pjs->js_addr[aoff + psa->sa_resclen - 1] != '\0') ||
+				(pjs->js_addr[aoff + psa->sa_resclen +
+				psa->sa_vallen - 1] != '\0'))
+				return "bad attribute record";
+			aoff += JOB_SNAP_ALIGN((size_t)psa->sa_resclen +
+				psa->sa_vallen);
+		}
+		if (aoff != end)
+			return "bad job record";
+
+		pjs->js_index[i] = prec;
+		off = end;
+	}
+	if (off != pjs->js_size)
+		return "bad size";
+
+	qsort(pjs->js_index, pjs->js_njobs, sizeof(job_snap_rec_t *),
+		job_snap_cmp);
+	return NULL;
+}
+
+/**
+ * @brief
+ *		Free a snapshot from job_snapshot_open()
+ *
+ * @param[in]	handle - the snapshot, may be NULL
+ */
+void
+job_snapshot_close(void *handle)
+{
+	job_snap_t *pjs = handle;
+
+	if (pjs == NULL)
+		return;
+#ifndef WIN32
+	if (pjs->js_addr != NULL)
+		(void)munmap(pjs->js_addr, pjs->js_size);
+#endif
+	free(pjs->js_index);
+	free(pjs);
+}
+
+/**
+ * @brief
+ *		Open and check the job snapshot for job recovery
+ *
+ *		If snapshots are not enabled any old snapshot is removed, it is
+ *		not kept up to date any more.
+ *
+ * @see
+ * 		job_recov_db_open
+ *
+ * @param[out]	pseq - job save sequence when the snapshot was taken, jobs
+ *			saved to the database since then are not taken from it
+ *
+ * @return	void *
+ * @retval	NULL	- no usable snapshot
+ * @retval	!NULL	- handle to pass to job_recov_db_open()
+ */
+void *
+job_snapshot_open(BIGINT *pseq)
+{
+#ifndef WIN32
+	job_snap_t *pjs;
+	job_snap_hdr_t *phdr;
+	struct stat sb;
+	char *msg = NULL;
+	int fd;
+
+	if (pbs_conf.pbs_server_snapshot == 0) {
+		(void)unlink(path_job_snapshot);
+		return NULL;
+	}
+
+	if ((fd = open(path_job_snapshot, O_RDONLY)) == -1) {
+		if (errno != ENOENT)
+			log_err(errno, __func__, path_job_snapshot);
+		return NULL;
+	}
+	if ((pjs = calloc(1, sizeof(job_snap_t))) == NULL) {
+		log_err(errno, __func__, "no memory");
+		(void)close(fd);
+		return NULL;
+	}
+	if ((fstat(fd, &sb) == -1) || (sb.st_size < (off_t)sizeof(job_snap_hdr_t))) {
+		msg = "too short";
+	} else {
+		pjs->js_size = (size_t)sb.st_size;
+		pjs->js_addr = mmap(NULL, pjs->js_size, PROT_READ, MAP_PRIVATE,
+			fd, 0);
+		if (pjs->js_addr == MAP_FAILED) {
+			pjs->js_addr = NULL;
+			msg = strerror(errno);
+		}
+	}
+	(void)close(fd);
+
+	if (msg == NULL) {
+		phdr = (job_snap_hdr_t *)pjs->js_addr;
+		if (memcmp(phdr->sh_magic, JOB_SNAP_MAGIC, JOB_SNAP_MAGIC_LEN) != 0)
+			msg = "not a job snapshot";
+		else if ((phdr->sh_version != JOB_SNAP_VERSION) ||
+			(phdr->sh_hdrsize != sizeof(job_snap_hdr_t)) ||
+			(phdr->sh_recsize != sizeof(job_snap_rec_t)))
+			msg = "unsupported version";
+		else if ((phdr->sh_nattr != (uint32_t)JOB_ATR_LAST) ||
+			(phdr->sh_defsum != job_snap_defsum()))
+			msg = "job attributes changed";
+		else if (phdr->sh_size != pjs->js_size)
+			msg = "bad size";
+		else if (job_snap_sum(JOB_SNAP_SUM_INIT,
+			pjs->js_addr + sizeof(job_snap_hdr_t),
+			pjs->js_size - sizeof(job_snap_hdr_t)) != phdr->sh_sum)
+			msg = "bad checksum";
+		else
+			msg = job_snap_index(pjs, phdr);
+	}
+	if (msg != NULL) {
+		snprintf(log_buffer, LOG_BUF_SIZE, "Ignoring job snapshot %s: %s",
+			path_job_snapshot, msg);
+		log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, LOG_NOTICE,
+			__func__, log_buffer);
+		job_snapshot_close(pjs);
+		return NULL;
+	}
+
+	pjs->js_seq = (BIGINT)phdr->sh_seq;
+	*pseq = pjs->js_seq;
+	return pjs;
+#else
+	return NULL;
+#endif
+}
+
+/**
+ * @brief
+ *		Fill a database job row left without attributes by the
+ *		FIND_JOBS_ATTRS_SINCE query
+ *
+ *		The attributes are taken from the snapshot, the fixed part of
+ *		the job stays as read from the row.  A job not in the snapshot
+ *		is read from the database.
+ *
+ * @param[in]	pjs - the snapshot
+ * @param[in]	conn - connection to the database
+ * @param[in,out]	pdbjob - the row
+ *
+ * @return	int
+ * @retval	0	- the row was filled from the snapshot
+ * @retval	1	- the row was read from the database
+ * @retval	-1	- Failure
+ */
+static int
+job_snap_fill(job_snap_t *pjs, pbs_db_conn_t *conn, pbs_db_job_info_t *pdbjob)
+{
+	job_snap_rec_t **pprec;
+	job_snap_attr_t *psa;
+	pbs_db_attr_info_t *attrs;
+	pbs_db_obj_info_t obj;
+	char *p;
+	uint32_t j;
+
+	pprec = bsearch(pdbjob->ji_jobid, pjs->js_index, pjs->js_njobs,
+		sizeof(job_snap_rec_t *), job_snap_find_cmp);
+	if (pprec == NULL) {
+		obj.pbs_db_obj_type = PBS_DB_JOB;
+		obj.pbs_db_un.pbs_db_job = pdbjob;
+		return (pbs_db_load_obj(conn, &obj) == 0) ? 1 : -1;
+	}
+
+	pdbjob->attr_list.attr_count = 0;
+	pdbjob->attr_list.attributes = NULL;
+
+	/* freed with the row, see free_db_attr_list() */
+	attrs = calloc((*pprec)->sr_nattr + 1, sizeof(pbs_db_attr_info_t));
+	if (attrs == NULL)
+		return -1;
+	pdbjob->attr_list.attributes = attrs;
+
+	p = (char *)(*pprec + 1);
+	for (j = 0; j < (*pprec)->sr_nattr; j++) {
+		psa = (job_snap_attr_t *)p;
+		p += sizeof(job_snap_attr_t);
+		strncpy(attrs[j].attr_name, job_attr_def[psa->sa_index].at_name,
+			sizeof(attrs[j].attr_name) - 1);
+		strcpy(attrs[j].attr_resc, p);
+		if ((attrs[j].attr_value = strdup(p + psa->sa_resclen)) == NULL)
+			return -1;
+		attrs[j].attr_flags = psa->sa_flags;
+		pdbjob->attr_list.attr_count++;
+		p += JOB_SNAP_ALIGN((size_t)psa->sa_resclen + psa->sa_vallen);
+	}
+	return 0;
+}
+
+/*
+ * At server start the jobs are recovered in batches.  While the main thread
+ * reads one batch of rows from the database cursor, the attributes of the
+ * jobs in the previous batch are decoded by up to JOB_RECOV_MAX_THREADS
+ * threads.  The rest of the recovery, decode routines that are not
+ * reentrant, the action routines and everything done by the caller with
+ * the job, stays on the main thread and in database order.
+ */
+#define JOB_RECOV_BATCH		512
+#define JOB_RECOV_MAX_THREADS	8
+
+typedef struct job_recov_batch {
+	int			jb_count;	/* rows read into the batch */
+	int			jb_next;	/* next row to hand out */
+	pbs_db_job_info_t	jb_dbjob[JOB_RECOV_BATCH];
+	job			*jb_job[JOB_RECOV_BATCH];
+	void			*jb_pend[JOB_RECOV_BATCH]; /* from decode_attr_db_prep */
+} job_recov_batch_t;
+
+typedef struct job_recov {
+	pbs_db_conn_t		*jr_conn;
+	void			*jr_state;	/* the database cursor */
+	int			jr_eof;		/* no more rows in the cursor */
+	int			jr_nthreads;	/* threads decoding a batch */
+	int			jr_cur;		/* batch being handed out */
+	job_snap_t		*jr_snap;	/* job snapshot, may be NULL */
+	long			jr_nsnap;	/* jobs taken from the snapshot */
+	long			jr_ndb;		/* jobs read again from the database */
+	job_recov_batch_t	jr_batch[2];
+} job_recov_t;
+
+typedef struct job_recov_thread {
+	pthread_t		jt_tid;
+	int			jt_started;
+	int			jt_first;	/* first row decoded by the thread */
+	int			jt_step;	/* then every jt_step'th row */
+	job_recov_batch_t	*jt_batch;
+} job_recov_thread_t;
+
+/**
+ * @brief
+ *		Thread start routine, decode the attributes of a share of the jobs
+ *		in a batch
+ *
+ * @param[in]	arg - the job_recov_thread_t of the thread
+ *
+ * @return	NULL
+ */
+static void *
+job_recov_decode(void *arg)
+{
+	job_recov_thread_t *jt = arg;
+	job_recov_batch_t *pb = jt->jt_batch;
+	int i;
+
+	for (i = jt->jt_first; i < pb->jb_count; i += jt->jt_step) {
+		if (pb->jb_job[i] == NULL)
+			continue;
+		pb->jb_pend[i] = decode_attr_db_prep(&pb->jb_dbjob[i].attr_list,
+			job_attr_def, pb->jb_job[i]->ji_wattr,
+			(int)JOB_ATR_LAST, (int)JOB_ATR_UNKN);
+	}
+	return NULL;
+}
+
+/**
+ * @brief
+ *		Read the next batch of job rows from the database cursor
+ *
+ * @param[in]	pjr - recovery state from job_recov_db_open()
+ * @param[out]	pb - batch to fill
+ */
+static void
+job_recov_read(job_recov_t *pjr, job_recov_batch_t *pb)
+{
+	pbs_db_obj_info_t obj;
+
+	pb->jb_count = 0;
+	pb->jb_next = 0;
+	obj.pbs_db_obj_type = PBS_DB_JOB;
+	while (!pjr->jr_eof && (pb->jb_count < JOB_RECOV_BATCH)) {
+		memset(&pb->jb_dbjob[pb->jb_count], 0, sizeof(pbs_db_job_info_t));
+		obj.pbs_db_un.pbs_db_job = &pb->jb_dbjob[pb->jb_count];
+		if (pbs_db_cursor_next(pjr->jr_conn, pjr->jr_state, &obj) != 0)
+			pjr->jr_eof = 1;
+		else
+			pb->jb_count++;
+	}
+}
+
+/**
+ * @brief
+ *		Free what is left of the rows and jobs in a batch
+ *
+ * @param[in]	pb - the batch
+ */
+static void
+job_recov_clear(job_recov_batch_t *pb)
+{
+	pbs_db_obj_info_t obj;
+	int i;
+
+	obj.pbs_db_obj_type = PBS_DB_JOB;
+	for (i = 0; i < pb->jb_count; i++) {
+		if (pb->jb_job[i])
+			job_free(pb->jb_job[i]);
+		decode_attr_db_free(pb->jb_pend[i]);
+		pb->jb_job[i] = NULL;
+		pb->jb_pend[i] = NULL;
+		obj.pbs_db_un.pbs_db_job = &pb->jb_dbjob[i];
+		pbs_db_reset_obj(&obj);
+	}
+	pb->jb_count = 0;
+	pb->jb_next = 0;
+}
+
+/**
+ * @brief
+ *		Start recovering the jobs returned by a database cursor
+ *
+ * @see
+ * 		job_recov_db_next, job_recov_db_close
+ *
+ * @param[in]	conn - connection to the database
+ * @param[in]	state - cursor from pbs_db_cursor_init() on PBS_DB_JOB
+ * @param[in]	snap - job snapshot from job_snapshot_open() if the cursor
+ *			was opened with FIND_JOBS_ATTRS_SINCE, else NULL
+ *
+ * @return	void *
+ * @retval	NULL	- Failure, out of memory
+ * @retval	!NULL	- handle to pass to job_recov_db_next()
+ */
+void *
+job_recov_db_open(pbs_db_conn_t *conn, void *state, void *snap)
+{
+	job_recov_t *pjr;
+	long ncpus = 1;
+
+	if ((pjr = calloc(1, sizeof(job_recov_t))) == NULL) {
+		log_err(errno, __func__, "no memory");
+		return NULL;
+	}
+	pjr->jr_conn = conn;
+	pjr->jr_state = state;
+	pjr->jr_snap = snap;
+
+#ifdef _SC_NPROCESSORS_ONLN
+	ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	if (ncpus < 1)
+		ncpus = 1;
+	else if (ncpus > JOB_RECOV_MAX_THREADS)
+		ncpus = JOB_RECOV_MAX_THREADS;
+	pjr->jr_nthreads = (int)ncpus;
+
+	/* read ahead, the first job_recov_db_next() switches to this batch */
+	pjr->jr_cur = 0;
+	job_recov_read(pjr, &pjr->jr_batch[1]);
+
+	return pjr;
+}
+
+/**
+ * @brief
+ *		Switch to the batch already read, decode its jobs on the
+ *		recovery threads and meanwhile read the following batch
+ *
+ * @param[in]	pjr - recovery state
+ *
+ * @return	job_recov_batch_t *
+ * @retval	NULL	- no more rows
+ * @retval	!NULL	- the batch to hand out
+ */
+static job_recov_batch_t *
+job_recov_switch(job_recov_t *pjr)
+{
+	job_recov_batch_t *pb;
+	job_recov_thread_t jt[JOB_RECOV_MAX_THREADS];
+	int i;
+	int rc;
+
+	job_recov_clear(&pjr->jr_batch[pjr->jr_cur]);
+	pjr->jr_cur ^= 1;
+	pb = &pjr->jr_batch[pjr->jr_cur];
+	if (pb->jb_count == 0)
+		return NULL;
+
+	for (i = 0; i < pb->jb_count; i++) {
+		pb->jb_pend[i] = NULL;
+		pb->jb_job[i] = NULL;
+		/* no attributes in the row, the job was saved before the snapshot */
+		if ((pjr->jr_snap != NULL) &&
+			(pb->jb_dbjob[i].attr_list.attributes == NULL)) {
+			rc = job_snap_fill(pjr->jr_snap, pjr->jr_conn,
+				&pb->jb_dbjob[i]);
+			if (rc == -1)
+				continue;
+			if (rc == 0)
+				pjr->jr_nsnap++;
+			else
+				pjr->jr_ndb++;
+		}
+		if ((pb->jb_job[i] = job_alloc()) != NULL)
+			db_to_svr_job_qs(pb->jb_job[i], &pb->jb_dbjob[i]);
+	}
+
+	/* see decode_attr_db_prep(), set before the threads are started */
+	resc_access_perm = ATR_DFLAG_ACCESS;
+
+	for (i = 0; i < pjr->jr_nthreads; i++) {
+		jt[i].jt_first = i;
+		jt[i].jt_step = pjr->jr_nthreads;
+		jt[i].jt_batch = pb;
+		jt[i].jt_started = 0;
+		if ((pjr->jr_nthreads > 1) &&
+			(pthread_create(&jt[i].jt_tid, NULL, job_recov_decode,
+			&jt[i]) == 0))
+			jt[i].jt_started = 1;
+	}
+
+	/* read the next batch while this one is decoded */
+	job_recov_read(pjr, &pjr->jr_batch[pjr->jr_cur ^ 1]);
+
+	for (i = 0; i < pjr->jr_nthreads; i++) {
+		if (jt[i].jt_started)
+			(void)pthread_join(jt[i].jt_tid, NULL);
+		else
+			(void)job_recov_decode(&jt[i]);
+	}
+
+	return pb;
+}
+
+/**
+ * @brief
+ *		Return the next job recovered from the database, in cursor order
+ *
+ *		The database row is valid until the next call, so the caller may
+ *		use it to log or delete a job that could not be recovered.  The
+ *		row's attribute list is freed here and must not be reset by the
+ *		caller.
+ *
+ * @param[in]	handle - from job_recov_db_open()
+ * @param[out]	ppjob - the recovered job, NULL if the row could not be
+ *			recovered
+ * @param[out]	ppdbjob - the database row of the job
+ *
+ * @return	int
+ * @retval	0	- *ppjob and *ppdbjob are set
+ * @retval	1	- no more jobs
+ */
+int
+job_recov_db_next(void *handle, job **ppjob, pbs_db_job_info_t **ppdbjob)
+{
+	job_recov_t *pjr = handle;
+	job_recov_batch_t *pb;
+	job *pj;
+	int i;
+
+	pb = &pjr->jr_batch[pjr->jr_cur];
+	if (pb->jb_next >= pb->jb_count) {
+		if ((pb = job_recov_switch(pjr)) == NULL)
+			return 1;
+	}
+
+	i = pb->jb_next++;
+	pj = pb->jb_job[i];
+	pb->jb_job[i] = NULL;
+	if (pj != NULL) {
+		if (pb->jb_pend[i] == NULL) {
+			job_free(pj);
+			pj = NULL;
+		} else {
+			decode_attr_db_finish(pj, pb->jb_pend[i], job_attr_def,
+				pj->ji_wattr);
+			pb->jb_pend[i] = NULL;
+			if (pbs_db_end_trx(pjr->jr_conn, PBS_DB_COMMIT) != 0) {
+				job_free(pj);
+				pj = NULL;
+			}
+		}
+	}
+	if (pj == NULL) {
+		snprintf(log_buffer, LOG_BUF_SIZE, "Failed to recover job %s",
+			pb->jb_dbjob[i].ji_jobid);
+		log_err(-1, "job_recov", log_buffer);
+	}
+
+	*ppjob = pj;
+	*ppdbjob = &pb->jb_dbjob[i];
+	return 0;
+}
+
+/**
+ * @brief
+ *		Free the recovery state from job_recov_db_open() and any rows
+ *		and jobs not handed out.  The cursor is not closed.
+ *
+ * @param[in]	handle - from job_recov_db_open()
+ */
+void
+job_recov_db_close(void *handle)
+{
+	job_recov_t *pjr = handle;
+
+	if (pjr == NULL)
+		return;
+	job_recov_clear(&pjr->jr_batch[0]);
+	job_recov_clear(&pjr->jr_batch[1]);
+	if (pjr->jr_snap != NULL) {
+		snprintf(log_buffer, LOG_BUF_SIZE,
+			"%ld jobs recovered from the job snapshot, "
+			"%ld missing from it read from the database",
+			pjr->jr_nsnap, pjr->jr_ndb);
+		log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, LOG_INFO,
+			__func__, log_buffer);
+	}
+	free(pjr);
+}
+
 /**
  * @brief
  *	Save resv to database
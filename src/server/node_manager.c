@@ -631,23 +631,20 @@ node_down_requeue(struct work_task *pwt)
 
 	DBPRT(("node_down_requeue invoked\n"))
 	if (!pwt) {
-		sprintf(log_buffer, "Illegal value passed to %s", __func__);
-		log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_SERVER, LOG_ERR,
-			msg_daemonname, log_buffer);
+		log_eventf(PBSEVENT_ERROR, PBS_EVENTCLASS_SERVER, LOG_ERR,
+			msg_daemonname, "Illegal value passed to %s", __func__);
 		return;
 	}
 	mp = (mominfo_t *)pwt->wt_parm1;
 	if (!mp) {
-		sprintf(log_buffer, "Illegal mominfo value in %s", __func__);
-		log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_SERVER, LOG_ERR,
-			msg_daemonname, log_buffer);
+		log_eventf(PBSEVENT_ERROR, PBS_EVENTCLASS_SERVER, LOG_ERR,
+			msg_daemonname, "Illegal mominfo value in %s", __func__);
 		return;
 	}
 	svmp = (mom_svrinfo_t *)(mp->mi_data);
 	if (!svmp) {
-		sprintf(log_buffer, "Illegal srvinfo value in %s", __func__);
-		log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_SERVER, LOG_ERR,
-			msg_daemonname, log_buffer);
+		log_eventf(PBSEVENT_ERROR, PBS_EVENTCLASS_SERVER, LOG_ERR,
+			msg_daemonname, "Illegal srvinfo value in %s", __func__);
 		return;
 	}
 
@@ -824,9 +821,8 @@ post_discard_job(job *pjob, mominfo_t *pmom, int newstate)
 		 * There was no start record for this job, so no need
 		 * to call account_jobend().
 		 */
-		sprintf(log_buffer, nddown, downmom);
-		log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, LOG_INFO,
-			pjob->ji_qs.ji_jobid, log_buffer);
+		log_eventf(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, LOG_INFO,
+			pjob->ji_qs.ji_jobid, nddown, downmom);
 		return;
 	}
 
@@ -839,9 +835,8 @@ post_discard_job(job *pjob, mominfo_t *pmom, int newstate)
 		 * tried to run the job and it failed before it ever went
 		 * into execution and sent the server JOB_EXEC_RETRY
 		 */
-		sprintf(log_buffer, ndreque, downmom);
-		log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, LOG_INFO,
-			pjob->ji_qs.ji_jobid, log_buffer);
+		log_eventf(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, LOG_INFO,
+			pjob->ji_qs.ji_jobid, ndreque, downmom);
 		account_jobend(pjob, pjob->ji_acctrec, PBS_ACCT_RERUN);
 		if (pjob->ji_acctrec) {
 			free(pjob->ji_acctrec);	/* logged, so clear it */
@@ -1616,16 +1611,14 @@ vnode_available(struct pbsnode *np)
 			/* If a standing reservation we print the execvnodes sequence
 			 * string for debugging purposes */
 			if (rsv_attr[RESV_ATR_resv_standing].at_val.at_long) {
-				snprintf(log_buffer, sizeof(log_buffer), " execvnodes sequence %s",
+				log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_RESV, LOG_DEBUG,
+					presv->ri_qs.ri_resvID, " execvnodes sequence %s",
 					rsv_attr[RESV_ATR_resv_execvnodes].at_val.at_str);
-				log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_RESV, LOG_DEBUG,
-					presv->ri_qs.ri_resvID, log_buffer);
 
 			}
-			snprintf(log_buffer, sizeof(log_buffer), "vnodes in occurrence: %d; ",
+			log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_RESV, LOG_DEBUG,
+				presv->ri_qs.ri_resvID, "vnodes in occurrence: %d; ",
 				presv->ri_vnodect);
-			log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_RESV, LOG_DEBUG,
-				presv->ri_qs.ri_resvID, log_buffer);
 		}
 	}
 
@@ -1745,11 +1738,10 @@ vnode_unavailable(struct pbsnode *np, int account_vnode)
 			str_time = ctime(&presv->ri_resv_retry);
 			if (str_time != NULL) {
 				str_time[strlen(str_time) - 1] = '\0';
-				(void) snprintf(log_buffer, sizeof(log_buffer),
+				log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_RESV, LOG_NOTICE,
+					presv->ri_qs.ri_resvID,
 					"An attempt to reconfirm reservation will be made on %s",
 					str_time);
-				log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_RESV, LOG_NOTICE,
-					presv->ri_qs.ri_resvID, log_buffer);
 			}
 		}
 
@@ -1785,17 +1777,15 @@ vnode_unavailable(struct pbsnode *np, int account_vnode)
 				/* If a standing reservation we print the execvnodes sequence
 				 * string for debugging purposes */
 				if (rsv_attr[RESV_ATR_resv_standing].at_val.at_long) {
-					snprintf(log_buffer, sizeof(log_buffer), " execvnodes sequence %s",
+					log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_RESV, LOG_DEBUG,
+						presv->ri_qs.ri_resvID, " execvnodes sequence %s",
 						rsv_attr[RESV_ATR_resv_execvnodes].at_val.at_str);
-					log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_RESV, LOG_DEBUG,
-						presv->ri_qs.ri_resvID, log_buffer);
 
 				}
-				snprintf(log_buffer, sizeof(log_buffer), "vnodes in occurrence: %d; "
+				log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_RESV, LOG_DEBUG,
+					presv->ri_qs.ri_resvID, "vnodes in occurrence: %d; "
 					" unavailable vnodes in reservation: %d",
 					presv->ri_vnodect, presv->ri_vnodes_down);
-				log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_RESV, LOG_DEBUG,
-					presv->ri_qs.ri_resvID, log_buffer);
 			}
 			presv->ri_vnodes_down++;
 		}
@@ -2437,9 +2427,9 @@ stat_update(int stream)
 					if ((mp = tfind2((u_long)stream, 0, &streams)) != NULL) {
 						for (num=1; num<bad; num++)
 							sattrl = (struct svrattrl *)GET_NEXT(sattrl->al_link);
-						sprintf(log_buffer,"unable to update attribute %s.%s in stat_update",sattrl->al_name,sattrl->al_resc);
-						log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE,
-							LOG_NOTICE, mp->mi_host,log_buffer);
+						log_eventf(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE,
+							LOG_NOTICE, mp->mi_host,
+							"unable to update attribute %s.%s in stat_update",sattrl->al_name,sattrl->al_resc);
 					}
 				}
 			}
@@ -2485,10 +2475,14 @@ stat_update(int stream)
 				/* session id was set to same old value   */
 				/* so only need to save things to disk    */
 				/* if something other than the session id */
-				/* or resources_used was modified         */
+				/* or resources_used was modified; those  */
+				/* are ATR_DFLAG_NOSAVM and Mom resends    */
+				/* them in full after a reconnect          */
 
 				pjob->ji_wattr[(int)JOB_ATR_session_id].at_flags &= ~ATR_VFLAG_MODIFY;
 				for (i=0; i<JOB_ATR_LAST; ++i) {
+					if (job_attr_def[i].at_flags & ATR_DFLAG_NOSAVM)
+						continue;
 					if (pjob->ji_wattr[i].at_flags & ATR_VFLAG_MODIFY) {
 						job_save(pjob, SAVEJOB_FULL);
 						break;
@@ -2660,9 +2654,8 @@ send_discard_job(int stream, char *jobid, int runver, char *txt)
 			if (mp)
 				momptr_down(mp, log_buffer);
 		} else if (txt) {
-			snprintf(log_buffer, sizeof(log_buffer), sdjfmt, txt, "");
-			log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, LOG_INFO, jobid,
-				log_buffer);
+			log_eventf(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, LOG_INFO, jobid,
+				sdjfmt, txt, "");
 		}
 	}
 	DBPRT(("send_discard_job for %s, stream %d \n", jobid, stream))
@@ -3137,10 +3130,9 @@ deallocate_job(mominfo_t *pmom, job *pjob)
 			totcpus0 = totcpus;
 			totcpus += deallocate_job_from_node(pjob, pnode);
 			if (totcpus > totcpus0) {
-				snprintf(log_buffer, sizeof(log_buffer),
+				log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_NODE, LOG_DEBUG,
+					pmom->mi_host,
 					"clearing job %s from node %s", jobid, pnode->nd_name);
-				log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_NODE, LOG_DEBUG,
-								pmom->mi_host, log_buffer);
 			}
 			if (i != 0) {
 				if (pbs_strcat(&freed_vnode_list, &freed_sz, "+") == NULL) {
@@ -3158,9 +3150,9 @@ deallocate_job(mominfo_t *pmom, job *pjob)
 	}
 	deallocate_cpu_licenses2(pjob, totcpus);
 	if (totcpus > 0) {
-		snprintf(log_buffer, sizeof(log_buffer),  "deallocating %d cpu(s) from job %s", totcpus, jobid);
-		log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_NODE, LOG_DEBUG,
-						pmom->mi_host, log_buffer);
+		log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_NODE, LOG_DEBUG,
+			pmom->mi_host,
+			"deallocating %d cpu(s) from job %s", totcpus, jobid);
 	}
 
 	deallocated_attr = pjob->ji_wattr[(int)JOB_ATR_exec_vnode_deallocated];
@@ -3681,19 +3673,17 @@ update2_to_vnode(vnal_t *pvnal, int new, mominfo_t *pmom, int *madenew, int from
 			&bad, &pnode, FALSE);
 		free_attrlist(&atrlist);
 		if (bad != 0) {
-			snprintf(log_buffer, sizeof(log_buffer),
+			log_eventf(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE,
+				LOG_NOTICE, pmom->mi_host,
 				"could not autocreate vnode \"%s\", error = %d",
 				pvnal->vnal_id, bad);
-			log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE,
-				LOG_NOTICE, pmom->mi_host, log_buffer);
 			return bad;
 		}
 		*madenew = 1;
 		localmadenew = 1;
-		snprintf(log_buffer, sizeof(log_buffer),
+		log_eventf(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE,
+			LOG_INFO, pmom->mi_host,
 			"autocreated vnode %s", pvnal->vnal_id);
-		log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE,
-			LOG_INFO, pmom->mi_host, log_buffer);
 	}
 
 
@@ -3720,10 +3710,9 @@ update2_to_vnode(vnal_t *pvnal, int new, mominfo_t *pmom, int *madenew, int from
 		}
 
 		if (!pnode_has_mom) {
-			snprintf(log_buffer, sizeof(log_buffer),
+			log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_NODE,
+				LOG_INFO, pmom->mi_host,
 				"Not allowed to update vnode '%s', as it is owned by a different mom", pvnal->vnal_id);
-			log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_NODE,
-				LOG_INFO, pmom->mi_host, log_buffer);
 			return (PBSE_BADHOST);
 		}
 	}
@@ -3828,12 +3817,11 @@ update2_to_vnode(vnal_t *pvnal, int new, mominfo_t *pmom, int *madenew, int from
 			*dot = '\0';
 			if ((strcasecmp(buf, ATTR_rescavail) != 0) &&
 				(from_hook && (strcasecmp(buf, ATTR_rescassn) != 0))) {
-				snprintf(log_buffer, sizeof(log_buffer),
+				log_eventf(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE,
+					LOG_ERR, pmom->mi_host,
 					"error: not legal to set resource in attribute %s, in %s for vnode %s",
 					psrp->vna_name,  from_hook?UPDATE_FROM_MOM_HOOK:UPDATE,
-										pnode->nd_name);
-				log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE,
-					LOG_ERR, pmom->mi_host, log_buffer);
+					pnode->nd_name);
 				continue;
 			}
 
@@ -3850,17 +3838,16 @@ update2_to_vnode(vnal_t *pvnal, int new, mominfo_t *pmom, int *madenew, int from
 
 				err = add_resource_def(resc, psrp->vna_type, psrp->vna_flag);
 				if (err < 0) {
-					snprintf(log_buffer, sizeof(log_buffer), cannot_def_resc,
+					log_eventf(PBSEVENT_ADMIN, PBS_EVENTCLASS_NODE,
+						LOG_ERR, pmom->mi_host,
+						cannot_def_resc,
 						resc, pvnal->vnal_id);
-					log_event(PBSEVENT_ADMIN, PBS_EVENTCLASS_NODE,
-						LOG_ERR, pmom->mi_host, log_buffer);
 					continue; /* skip this attribute, go to next */
 				} else {
 
-					snprintf(log_buffer, sizeof(log_buffer),
+					log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_NODE,
+						LOG_INFO, pmom->mi_host,
 						"adding resource %s, type %d, in update for vnode %s", resc, psrp->vna_type,  pnode->nd_name);
-					log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_NODE,
-						LOG_INFO, pmom->mi_host, log_buffer);
 					vn_resc_added++;
 				}
 				/* now find the new resource definition */
@@ -3869,10 +3856,10 @@ update2_to_vnode(vnal_t *pvnal, int new, mominfo_t *pmom, int *madenew, int from
 					continue; /* skip this attribute, go to next */
 			} else if ((psrp->vna_type != 0) &&
 				(psrp->vna_type != prdef->rs_type)) {
-				snprintf(log_buffer, sizeof(log_buffer), cannot_def_resc,
+				log_eventf(PBSEVENT_ADMIN, PBS_EVENTCLASS_NODE,
+					LOG_ERR, pmom->mi_host,
+					cannot_def_resc,
 					resc, pvnal->vnal_id);
-				log_event(PBSEVENT_ADMIN, PBS_EVENTCLASS_NODE,
-					LOG_ERR, pmom->mi_host, log_buffer);
 				continue; /* skip this attribute/resource, go to next */
 			}
 
@@ -3937,23 +3924,19 @@ update2_to_vnode(vnal_t *pvnal, int new, mominfo_t *pmom, int *madenew, int from
 						}
 					}
 					if (bad != 0) {
-						snprintf(log_buffer, sizeof(log_buffer),
+						log_eventf(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE,
+							LOG_WARNING, pmom->mi_host,
 							"Error %d decoding resource %s in update for vnode %s", bad, resc, pnode->nd_name);
-						log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE,
-							LOG_WARNING, pmom->mi_host, log_buffer);
 					} else if (from_hook) {
-						snprintf(log_buffer,
-							sizeof(log_buffer),
+						log_eventf(PBSEVENT_DEBUG2,
+							PBS_EVENTCLASS_NODE,
+							LOG_INFO, pmom->mi_host,
 							"Updated vnode %s's "
 							"resource %s=%s per "
 							"mom hook request",
 							pnode->nd_name,
 							psrp->vna_name,
 							psrp->vna_val);
-						log_event(PBSEVENT_DEBUG2,
-							PBS_EVENTCLASS_NODE,
-							LOG_INFO, pmom->mi_host,
-							log_buffer);
 					}
 				}
 			}
@@ -3962,10 +3945,10 @@ update2_to_vnode(vnal_t *pvnal, int new, mominfo_t *pmom, int *madenew, int from
 
 			/* special case pnames because it is set at the Server */
 
-			snprintf(log_buffer, sizeof(log_buffer), "pnames %s",
+			log_eventf(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE,
+				LOG_INFO, pmom->mi_host,
+				"pnames %s",
 				psrp->vna_val);
-			log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE,
-				LOG_INFO, pmom->mi_host, log_buffer);
 
 			setup_pnames(psrp->vna_val);
 
@@ -3979,10 +3962,9 @@ update2_to_vnode(vnal_t *pvnal, int new, mominfo_t *pmom, int *madenew, int from
 				if ((*psrp->vna_val != '\0') &&
 					((svr_get_privilege(psrp->vna_val, pmom->mi_host) &
 					(ATR_DFLAG_MGWR | ATR_DFLAG_OPWR)) == 0)) {
-					snprintf(log_buffer, sizeof(log_buffer),
+					log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_NODE,
+						LOG_INFO, pmom->mi_host,
 						hook_privilege, psrp->vna_val, pmom->mi_host);
-					log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_NODE,
-						LOG_INFO, pmom->mi_host, log_buffer);
 					return (PBSE_PERM);
 				}
 			}
@@ -4022,15 +4004,12 @@ update2_to_vnode(vnal_t *pvnal, int new, mominfo_t *pmom, int *madenew, int from
 				if (strcmp(psrp->vna_val, "1") == 0) {
 
 					set_scheduler_flag(SCH_SCHEDULE_RESTART_CYCLE, dflt_scheduler);
-					snprintf(log_buffer,
-					   sizeof(log_buffer),
-					   "hook '%s' requested for "
-					   "scheduler to restart cycle",
-						hook_name);
-					log_event(PBSEVENT_DEBUG2,
+					log_eventf(PBSEVENT_DEBUG2,
 						PBS_EVENTCLASS_NODE,
 						LOG_INFO, pmom->mi_host,
-							log_buffer);
+						"hook '%s' requested for "
+						"scheduler to restart cycle",
+						hook_name);
 				}
 				if (p != NULL)
 					*p = ','; /* restore psrp->vna_val */
@@ -4043,13 +4022,12 @@ update2_to_vnode(vnal_t *pvnal, int new, mominfo_t *pmom, int *madenew, int from
 			j = find_attr(node_attr_def, psrp->vna_name,
 				ND_ATR_LAST);
 			if (j == -1) {
-				snprintf(log_buffer, sizeof(log_buffer),
+				log_eventf(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE,
+					LOG_WARNING, pmom->mi_host,
 					"unknown attribute %s in %s for vnode %s",
 					psrp->vna_name,
 					from_hook?UPDATE_FROM_MOM_HOOK:UPDATE,
 					pnode->nd_name);
-				log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE,
-					LOG_WARNING, pmom->mi_host, log_buffer);
 				continue;
 			}
 			pattr = &pnode->nd_attr[j];
@@ -4065,15 +4043,13 @@ update2_to_vnode(vnal_t *pvnal, int new, mominfo_t *pmom, int *madenew, int from
 				bad = node_attr_def[j].at_decode(pattr,
 					psrp->vna_name, NULL, psrp->vna_val);
 				if (bad != 0) {
-					snprintf(log_buffer, sizeof(log_buffer),
-						"Error %d decoding attribute %s "
+					log_eventf(PBSEVENT_SYSTEM,
+						PBS_EVENTCLASS_NODE, LOG_WARNING,
+						pmom->mi_host, "Error %d decoding attribute %s "
 						"in %s for vnode %s",
 						bad, psrp->vna_name,
 						from_hook?UPDATE_FROM_MOM_HOOK:UPDATE,
 						pnode->nd_name);
-					log_event(PBSEVENT_SYSTEM,
-						PBS_EVENTCLASS_NODE, LOG_WARNING,
-						pmom->mi_host, log_buffer);
 					continue;
 				}
 				if (from_hook) {
@@ -4087,17 +4063,14 @@ update2_to_vnode(vnal_t *pvnal, int new, mominfo_t *pmom, int *madenew, int from
 						pattr->at_flags |= \
 					       (ATR_VFLAG_SET|ATR_VFLAG_MODIFY);
 					}
-					snprintf(log_buffer,
-						sizeof(log_buffer),
-						"Updated vnode %s's "
+					log_eventf(PBSEVENT_DEBUG2,
+						PBS_EVENTCLASS_NODE, LOG_INFO,
+						pmom->mi_host, "Updated vnode %s's "
 						"attribute %s=%s per "
 						"mom hook request",
 						pnode->nd_name,
 						psrp->vna_name,
 						psrp->vna_val);
-					log_event(PBSEVENT_DEBUG2,
-						PBS_EVENTCLASS_NODE, LOG_INFO,
-						pmom->mi_host, log_buffer);
 
 				} else {
 					pattr->at_flags |= ATR_VFLAG_DEFLT;
@@ -4107,12 +4080,11 @@ update2_to_vnode(vnal_t *pvnal, int new, mominfo_t *pmom, int *madenew, int from
 					     pnode, ATR_ACTION_ALTER)) == 0) {
 						pattr->at_flags |= ATR_VFLAG_DEFLT;
 					} else {
-						snprintf(log_buffer, sizeof(log_buffer),
+						log_eventf(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE,
+							LOG_WARNING, pmom->mi_host,
 							"Error %d setting attribute %s "
 							"in update for vnode %s", bad,
 							psrp->vna_name, pnode->nd_name);
-						log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE,
-							LOG_WARNING, pmom->mi_host, log_buffer);
 					}
 				}
 			}
@@ -4123,17 +4095,14 @@ update2_to_vnode(vnal_t *pvnal, int new, mominfo_t *pmom, int *madenew, int from
 				bad = node_attr_def[j].at_action(pattr,
 					pnode, ATR_ACTION_ALTER);
 				if (bad != 0) {
-					snprintf(log_buffer, sizeof(log_buffer),
-						"Error %d setting attribute %s "
+					log_eventf(PBSEVENT_SYSTEM,
+						PBS_EVENTCLASS_NODE,
+						LOG_WARNING,
+						pmom->mi_host, "Error %d setting attribute %s "
 						"in %s for vnode %s", bad,
 						psrp->vna_name,
 						from_hook?UPDATE_FROM_MOM_HOOK:UPDATE,
 						pnode->nd_name);
-					log_event(PBSEVENT_SYSTEM,
-						PBS_EVENTCLASS_NODE,
-						LOG_WARNING,
-						pmom->mi_host,
-						log_buffer);
 				}
 				if (strcasecmp(psrp->vna_name,
 					ATTR_NODE_state) == 0) {
@@ -4401,8 +4370,8 @@ mom_running_jobs(int stream)
 				if (!strcmp(exec_host_name,mom_name)) {
 					/* natural vnode of MOM at end of stream matches exec_host first entry */
 
-					snprintf(log_buffer, sizeof(log_buffer), "run_version %ld for job recovered from MOM with vnode %s; exec_host %s", runver, mom_name, exec_host_name);
-					log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_JOB, LOG_ALERT, pjob->ji_qs.ji_jobid, log_buffer);
+					log_eventf(PBSEVENT_ERROR, PBS_EVENTCLASS_JOB, LOG_ALERT, pjob->ji_qs.ji_jobid,
+						"run_version %ld for job recovered from MOM with vnode %s; exec_host %s", runver, mom_name, exec_host_name);
 
 					pjob->ji_wattr[(int)JOB_ATR_run_version].at_val.at_long = runver;
 					pjob->ji_wattr[(int)JOB_ATR_run_version].at_flags |= (ATR_VFLAG_SET | ATR_VFLAG_MODCACHE);
@@ -4415,8 +4384,8 @@ mom_running_jobs(int stream)
 				} else {
 					/* wrong MOM, exec_host either empty or non-matching, discard job on MOM (and hope the correct MOM will come along) */
 
-					snprintf(log_buffer, sizeof(log_buffer), "run_version recovery: exec_host %s != MOM name %s, discarding job on that MOM", exec_host_name, mom_name);
-					log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_JOB, LOG_ALERT, pjob->ji_qs.ji_jobid, log_buffer);
+					log_eventf(PBSEVENT_ERROR, PBS_EVENTCLASS_JOB, LOG_ALERT, pjob->ji_qs.ji_jobid,
+						"run_version recovery: exec_host %s != MOM name %s, discarding job on that MOM", exec_host_name, mom_name);
 
 					send_discard_job(stream, jobid, -1, "MOM fails to match exec_host");
 					discarded=1;
@@ -4594,12 +4563,11 @@ is_request(int stream, int version)
 			if (ppool != NULL) {
 				if (ppool->vnpm_inventory_mom == NULL) {
 					ppool->vnpm_inventory_mom = pmom;
-					sprintf(log_buffer,
+					log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_SERVER,
+						LOG_DEBUG, msg_daemonname,
 						msg_new_inventory_mom,
 						ppool->vnpm_vnode_pool,
 						pmom->mi_host);
-					log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_SERVER,
-						LOG_DEBUG, msg_daemonname, log_buffer);
 				}
 			}
 		}
@@ -4738,10 +4706,10 @@ found:
 		case IS_UPDATE:
 		case IS_UPDATE2:
 			if (psvrmom->msr_vnode_pool != 0) {
-				sprintf(log_buffer, "POOL: IS_UPDATE%c received",
+				log_eventf(PBSEVENT_DEBUG4, PBS_EVENTCLASS_NODE,
+					LOG_INFO, pmom->mi_host,
+					"POOL: IS_UPDATE%c received",
 					(command == IS_UPDATE)?' ':'2');
-				log_event(PBSEVENT_DEBUG4, PBS_EVENTCLASS_NODE,
-					LOG_INFO, pmom->mi_host, log_buffer);
 			}
 
 			cr_node = 0;
@@ -4815,11 +4783,11 @@ found:
 				goto err;
 
 			if ((psvrmom->msr_state & INUSE_MARKEDDOWN) == 0) {
-				sprintf(log_buffer, "update%c state:%d ncpus:%ld",
+				log_eventf(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE,
+					LOG_INFO, pmom->mi_host,
+					"update%c state:%d ncpus:%ld",
 					command==IS_UPDATE ? ' ' : '2',
 					s, psvrmom->msr_pcpus);
-				log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE,
-					LOG_INFO, pmom->mi_host, log_buffer);
 			}
 
 			if (command == IS_UPDATE) {
@@ -4945,13 +4913,11 @@ found:
 							psrp = VNAL_NODENUM(vnrlp, j);
 							if (strcasecmp(psrp->vna_name,
 								VNATTR_PNAMES) == 0) {
-								snprintf(log_buffer,
-									sizeof(log_buffer),
-									"pnames %s", psrp->vna_val);
-								log_event(PBSEVENT_SYSTEM,
+								log_eventf(PBSEVENT_SYSTEM,
 									PBS_EVENTCLASS_NODE,
 									LOG_INFO,
-									pmom->mi_host, log_buffer);
+									pmom->mi_host,
+									"pnames %s", psrp->vna_val);
 
 								setup_pnames(psrp->vna_val);
 							}
@@ -5010,10 +4976,9 @@ found:
 
 				if (np->nd_state & INUSE_STALE) {
 					/* vnode is stale */
-					snprintf(log_buffer, sizeof(log_buffer),
+					log_eventf(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE,
+						LOG_INFO, pmom->mi_host,
 						"vnode %s is stale", np->nd_name);
-					log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE,
-						LOG_INFO, pmom->mi_host, log_buffer);
 				}
 
 				pala = &np->nd_attr[(int)ND_ATR_ResourceAvail];
@@ -5251,18 +5216,16 @@ found:
 						pjob->ji_wattr[(int)JOB_ATR_exit_status].\
 						at_val.at_long = JOB_EXEC_HOOK_RERUN;
 						pjob->ji_wattr[(int)JOB_ATR_exit_status].at_flags |= (ATR_VFLAG_SET | ATR_VFLAG_MODCACHE);
-						snprintf(log_buffer, sizeof(log_buffer),
+						log_eventf(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE,
+							LOG_INFO, pmom->mi_host,
 							"hook request rerun %s", jid);
-						log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE,
-								LOG_INFO, pmom->mi_host, log_buffer);
 					} else if (hact == JOB_ACT_REQ_DELETE) {
 						pjob->ji_wattr[(int)JOB_ATR_exit_status].\
 						at_val.at_long = JOB_EXEC_HOOK_DELETE;
 						pjob->ji_wattr[(int)JOB_ATR_exit_status].at_flags |= (ATR_VFLAG_SET | ATR_VFLAG_MODCACHE);
-						snprintf(log_buffer, sizeof(log_buffer),
+						log_eventf(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE,
+							LOG_INFO, pmom->mi_host,
 							"hook request delete %s", jid);
-						log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE,
-								LOG_INFO, pmom->mi_host, log_buffer);
 					} else if (hact == JOB_ACT_REQ_DEALLOCATE) {
 
 						/* decrement everything found in exec_vnode/exec_vnode_deallocated  */
@@ -5314,11 +5277,10 @@ found:
 			if (*hook_euser != '\0') {
 				if ((svr_get_privilege(hook_euser, pmom->mi_host) &
 					(ATR_DFLAG_MGWR | ATR_DFLAG_OPWR)) == 0) {
-					snprintf(log_buffer, sizeof(log_buffer),
+					log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_NODE,
+						LOG_INFO, pmom->mi_host,
 						hook_privilege, hook_euser,
 						pmom->mi_host);
-					log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_NODE,
-						LOG_INFO, pmom->mi_host, log_buffer);
 					free(hook_euser);
 					hook_euser = NULL;
 					break;
@@ -5438,16 +5400,13 @@ found:
 					/* mom has a hook that the server */
 					/* does not  know about. tell mom */
 					/* to delete that hook */
-					snprintf(log_buffer,
-					       sizeof(log_buffer),
-					       "encountered a mom (%s) hook %s "
-					       "that the server does not know "
-					       "about! Telling mom to delete",
-						pmom->mi_host, hname);
-					log_event(PBSEVENT_DEBUG3,
+					log_eventf(PBSEVENT_DEBUG3,
 						PBS_EVENTCLASS_HOOK,
 						LOG_ERR, hname,
-						log_buffer);
+						"encountered a mom (%s) hook %s "
+						"that the server does not know "
+						"about! Telling mom to delete",
+						pmom->mi_host, hname);
 					add_pending_mom_hook_action(pmom,
 						hname, MOM_HOOK_ACTION_DELETE);
 					free(hname);
@@ -5458,51 +5417,42 @@ found:
 				if ((phook->hook_control_checksum > 0) &&
 				    (phook->hook_control_checksum != chksum_hk)) {
 
-					snprintf(log_buffer,
-						sizeof(log_buffer),
+					log_eventf(PBSEVENT_DEBUG3,
+						PBS_EVENTCLASS_HOOK,
+						LOG_ERR, phook->hook_name,
 						"hook control file "
-					     	"mismatched checksums: server: "
+						"mismatched checksums: server: "
 						"%lu mom (%s): %lu...resending",
 						phook->hook_control_checksum,
 						pmom->mi_host, chksum_hk);
-					log_event(PBSEVENT_DEBUG3,
-						PBS_EVENTCLASS_HOOK,
-						LOG_ERR, phook->hook_name,
-						log_buffer);
 					haction |= MOM_HOOK_ACTION_SEND_ATTRS;
 				}
 
 				if ((phook->hook_script_checksum > 0) &&
 				     (phook->hook_script_checksum != chksum_py)) {
 
-					snprintf(log_buffer,
-						sizeof(log_buffer),
+					log_eventf(PBSEVENT_DEBUG3,
+						PBS_EVENTCLASS_HOOK,
+						LOG_ERR, phook->hook_name,
 						"hook script "
-					     	"mismatched checksums: server: "
+						"mismatched checksums: server: "
 						"%lu mom (%s): %lu...resending",
 						phook->hook_script_checksum,
-							pmom->mi_host, chksum_py);
-					log_event(PBSEVENT_DEBUG3,
-						PBS_EVENTCLASS_HOOK,
-						LOG_ERR, phook->hook_name,
-						log_buffer);
+						pmom->mi_host, chksum_py);
 					haction |= MOM_HOOK_ACTION_SEND_SCRIPT;
 				}
 
 				if ((phook->hook_config_checksum > 0) &&
 				     (phook->hook_config_checksum != chksum_cf)) {
 
-					snprintf(log_buffer,
-						sizeof(log_buffer),
+					log_eventf(PBSEVENT_DEBUG3,
+						PBS_EVENTCLASS_HOOK,
+						LOG_ERR, phook->hook_name,
 						"hook config file "
-					     	"mismatched checksums: server: "
+						"mismatched checksums: server: "
 						"%lu mom (%s): %lu...resending",
 						phook->hook_config_checksum,
-							pmom->mi_host, chksum_cf);
-					log_event(PBSEVENT_DEBUG3,
-						PBS_EVENTCLASS_HOOK,
-						LOG_ERR, phook->hook_name,
-						log_buffer);
+						pmom->mi_host, chksum_cf);
 					haction |= MOM_HOOK_ACTION_SEND_CONFIG;
 				}
 
@@ -5533,17 +5483,14 @@ found:
 			if ((hook_rescdef_checksum > 0) &&
 				(hook_rescdef_checksum != chksum_rescdef)) {
 
-				snprintf(log_buffer,
-					sizeof(log_buffer),
+				log_eventf(PBSEVENT_DEBUG3,
+					PBS_EVENTCLASS_HOOK,
+					LOG_ERR, PBS_RESCDEF,
 					"hook resourcedef file "
-					    "mismatched checksums: server: "
+					"mismatched checksums: server: "
 					"%lu mom %s: %lu...resending",
 					hook_rescdef_checksum, pmom->mi_host,
-							chksum_rescdef);
-					log_event(PBSEVENT_DEBUG3,
-						PBS_EVENTCLASS_HOOK,
-						LOG_ERR, PBS_RESCDEF,
-						log_buffer);
+					chksum_rescdef);
 					add_pending_mom_hook_action(pmom,
 						PBS_RESCDEF,
 						MOM_HOOK_ACTION_SEND_RESCDEF);
@@ -7118,11 +7065,10 @@ set_nodes(void *pobj, int objtype, char *execvnod_in, char **execvnod_out, char
 
 					if ((pnode->nd_moms[i] != NULL) &&
 						(sync_mom_hookfiles_count(pnode->nd_moms[i]) > 0)) {
-						snprintf(log_buffer, sizeof(log_buffer),
+						log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_NODE,
+							LOG_WARNING, pjob->ji_qs.ji_jobid,
 							"vnode %s's parent mom %s:%d has a pending copy hook or delete hook request", pnode->nd_name,  pnode->nd_moms[i]->mi_host,
 							pnode->nd_moms[i]->mi_port);
-						log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_NODE,
-							LOG_WARNING, pjob->ji_qs.ji_jobid, log_buffer);
 						break;
 					}
 				}
@@ -7620,20 +7566,20 @@ free_nodes(job *pjob)
 		}
 
 		if (special_case) {
-			snprintf(log_buffer, LOG_BUF_SIZE, "\n================================================================"
+			log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_JOB, LOG_INFO, pjob->ji_qs.ji_jobid,
+				"\n================================================================"
 				"======================================================\nPBSPro diagnostic information."
 				" Share this log with PBSPro Team.\n=========================================="
 				"============================================================================\n"
 				"Mom's state:%lu, number of jobs on this node: %d, number of vnodes: %d.\n"
 				"Other jobs present in the node follows:",
 				psvrmom->msr_state, psvrmom->msr_numjobs, psvrmom->msr_numvnds);
-			log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_JOB, LOG_INFO, pjob->ji_qs.ji_jobid, log_buffer);
 			for (j=0; j<psvrmom->msr_jbinxsz; j++)
 				if (psvrmom->msr_jobindx[j] != NULL)
 					log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_JOB, LOG_INFO, pjob->ji_qs.ji_jobid, psvrmom->msr_jobindx[j]->ji_qs.ji_jobid);
-			sprintf(log_buffer, "===================================================================="
+			log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_JOB, LOG_INFO, pjob->ji_qs.ji_jobid,
+				"===================================================================="
 				"==================================================");
-			log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_JOB, LOG_INFO, pjob->ji_qs.ji_jobid, log_buffer);
 		}
 
 		for (ivnd = 0; ivnd < psvrmom->msr_numvnds; ++ivnd) {
@@ -7864,11 +7810,10 @@ adj_resc_on_node(char *noden, int aflag, enum batch_op op, resource_def *prdef,
 	/* resource->resource->resource */
 
 	if (hop > 1) {
-		snprintf(log_buffer, sizeof(log_buffer),
+		log_eventf(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE,
+			LOG_ALERT, noden,
 			"multiple level of indirectness for resource %s",
 			prdef->rs_name);
-		log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE,
-			LOG_ALERT, noden, log_buffer);
 		return (PBSE_INDIRECTHOP);
 	}
 
@@ -8383,20 +8328,18 @@ set_old_subUniverse(resc_resv	*presv)
 	 * for those resources
 	 */
 	if ((rc=set_resc_deflt((void *)presv, RESC_RESV_OBJECT, NULL)) != 0) {
-		sprintf(log_buffer, "problem assigning default resource "
+		log_eventf(PBSEVENT_ERROR, PBS_EVENTCLASS_RESV, LOG_NOTICE,
+			presv->ri_qs.ri_resvID, "problem assigning default resource "
 			"to reservation %d", rc);
-		log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_RESV, LOG_NOTICE,
-			presv->ri_qs.ri_resvID, log_buffer);
 		free(sp);
 		return;
 	}
 	/* set the nodes on the reservation */
 	rc = assign_resv_resc(presv, sp);
 	if (rc != PBSE_NONE) {
-		sprintf(log_buffer,
+		log_eventf(PBSEVENT_ERROR, PBS_EVENTCLASS_RESV,
+			LOG_NOTICE, presv->ri_qs.ri_resvID,
 			"problem assigning resource to reservation %d", rc);
-		log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_RESV,
-			LOG_NOTICE, presv->ri_qs.ri_resvID, log_buffer);
 		free(sp);
 		return;
 	}
@@ -104,6 +104,7 @@ char	        primary_host[PBS_MAXHOSTNAME+1];   /* host_name of primary */
 static int stalone = 0;	/* is program running not as a service ? */
 static int get_out = 0;
 static int hupped = 0;
+static int dump_stats = 0;
 
 /*
  * Server failover role
@@ -474,6 +475,25 @@ hup_me(int sig)
 	log_err(-1, __func__, buf);
 }
 
+#ifndef WIN32
+/**
+ * @brief
+ * 		USR1 handler for the pbs_comm daemon
+ *
+ * 		Sets a global variable so that the main loop appends the TPP
+ * 		statistics to $PBS_HOME/server_priv/comm_stats
+ *
+ * @param[in]	sig	- name of signal caught
+ *
+ * @return	void
+ */
+static void
+usr1_me(int sig)
+{
+	dump_stats = 1;
+}
+#endif
+
 /**
  * @brief
  * 		lock out the lockfile for this daemon
@@ -1122,15 +1142,17 @@ main(int argc, char **argv)
 	}
 #endif	/* SIGSHUTDN */
 
+	act.sa_handler = usr1_me;
+	if (sigaction(SIGUSR1, &act, &oact) != 0) {
+		log_err(errno, __func__, "sigaction for USR1");
+		return (2);
+	}
+
 	act.sa_handler = SIG_IGN;
 	if (sigaction(SIGPIPE, &act, &oact) != 0) {
 		log_err(errno, __func__, "sigaction for PIPE");
 		return (2);
 	}
-	if (sigaction(SIGUSR1, &act, &oact) != 0) {
-		log_err(errno, __func__, "sigaction for USR1");
-		return (2);
-	}
 	if (sigaction(SIGUSR2, &act, &oact) != 0) {
 		log_err(errno, __func__, "sigaction for USR2");
 		return (2);
@@ -1148,6 +1170,9 @@ main(int argc, char **argv)
 	/* Protect from being killed by kernel */
 	daemon_protect(0, PBS_DAEMON_PROTECT_ON);
 
+	/* write the log from a background thread if PBS_LOG_ASYNC is set */
+	(void)log_async_start();
+
 	/* go in a while loop */
 	while (get_out == 0) {
 
@@ -1173,6 +1198,16 @@ main(int argc, char **argv)
 			}
 		}
 
+		if (dump_stats == 1) {
+			char path_stats[MAXPATHLEN + 1];
+
+			dump_stats = 0; /* reset back */
+			snprintf(path_stats, sizeof(path_stats), "%s/%s/comm_stats",
+				pbs_conf.pbs_home_path, PBS_SVR_PRIVATE);
+			if (tpp_dump_stats(path_stats, "pbs_comm") == 0)
+				log_tppmsg(LOG_INFO, NULL, "Appended TPP statistics to comm_stats");
+		}
+
 		sleep(3);
 	}
 
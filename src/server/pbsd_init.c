@@ -48,6 +48,7 @@
  *	pbsd_init_job()
  *	pbsd_init_reque()
  *	catch_child()
+ *	catch_usr1()
  *	change_logs()
  *	stop_me()
  *	chk_save_file()
@@ -174,6 +175,7 @@ extern char	*path_svrdb_new;
 extern char	*path_scheddb;
 extern char	*path_scheddb_new;
 extern char	*path_track;
+extern char	*path_job_snapshot;
 extern char	*path_prov_track;
 extern char	*path_nodes;
 extern char	*path_nodes_new;
@@ -215,10 +217,16 @@ extern void   on_job_rerun(struct work_task *);
 extern int resize_prov_table(int newsize);
 extern void offline_all_provisioning_vnodes(void);
 extern void stop_db();
-extern job * job_recov_db_spl(pbs_db_job_info_t *dbjob);
+extern void *job_recov_db_open(pbs_db_conn_t *conn, void *state, void *snap);
+extern int job_recov_db_next(void *handle, job **ppjob, pbs_db_job_info_t **ppdbjob);
+extern void job_recov_db_close(void *handle);
+extern void *job_snapshot_open(BIGINT *pseq);
+extern void job_snapshot_close(void *handle);
+extern void job_snapshot_save(struct work_task *pwt);
 /* Private functions in this file */
 
 static void  catch_child(int);
+static void  catch_usr1(int);
 static void  init_abt_job(job *);
 static void  change_logs(int);
 int   chk_save_file(char *filename);
@@ -230,6 +238,7 @@ static void  stop_me(int);
 static int   Rmv_if_resv_not_possible(job *);
 static int   attach_queue_to_reservation(resc_resv *);
 static void  call_log_license(struct work_task *);
+static void  log_recov_phase(char *phase, int count, struct timeval *ptv);
 extern int create_resreleased(job *pjob);
 
 extern pbs_sched *sched_alloc(char *sched_name);
@@ -378,13 +387,19 @@ pbsd_init(int type)
 	struct sigaction oact;
 #endif
 	struct tm	*ptm;
-	pbs_db_job_info_t	dbjob;
+	pbs_db_job_info_t	*pdbjob;
 	pbs_db_resv_info_t	dbresv;
 	pbs_db_que_info_t	dbque;
 	pbs_db_sched_info_t	dbsched;
 	pbs_db_obj_info_t	obj;
 	void		*state = NULL;
+	void		*jrecov;
+	void		*jsnap = NULL;
+	pbs_db_query_options_t	opts;
 	pbs_db_conn_t	*conn = (pbs_db_conn_t *) svr_db_conn;
+	struct timeval	recov_start;
+	struct timeval	phase_start;
+	int		count;
 	char *buf = NULL;
 	int buf_len = 0;
 	pbs_sched *psched;
@@ -572,15 +587,17 @@ pbsd_init(int type)
 		return (2);
 	}
 
+	act.sa_handler = catch_usr1;
+	if (sigaction(SIGUSR1, &act, &oact) != 0) {
+		log_err(errno, __func__, "sigaction for USR1");
+		return (2);
+	}
+
 	act.sa_handler = SIG_IGN;
 	if (sigaction(SIGPIPE, &act, &oact) != 0) {
 		log_err(errno, __func__, "sigaction for PIPE");
 		return (2);
 	}
-	if (sigaction(SIGUSR1, &act, &oact) != 0) {
-		log_err(errno, __func__, "sigaction for USR1");
-		return (2);
-	}
 	if (sigaction(SIGUSR2, &act, &oact) != 0) {
 		log_err(errno, __func__, "sigaction for USR2");
 		return (2);
@@ -645,6 +662,8 @@ pbsd_init(int type)
 
 	/* 5. If not a "create" initialization, recover server db */
 	/*    and sched db					  */
+	gettimeofday(&recov_start, NULL);
+	phase_start = recov_start;
 	rc =svr_recov_db();
 	if ((rc != 0) && (type != RECOV_CREATE)) {
 #ifdef WIN32
@@ -654,7 +673,6 @@ pbsd_init(int type)
 		type = RECOV_CREATE;
 	}
 	if (type != RECOV_CREATE) {
-		int count;
 		/* Server read success full ?*/
 
 		if (rc != 0) {
@@ -766,6 +784,7 @@ pbsd_init(int type)
 		set_sched_default(dflt_scheduler, 0);
 		(void)sched_save_db(dflt_scheduler, SVR_SAVE_NEW);
 	}
+	log_recov_phase("server and schedulers", -1, &phase_start);
 
 	/* 4. Check License information */
 
@@ -848,6 +867,7 @@ pbsd_init(int type)
 
 	had = server.sv_qs.sv_numque;
 	server.sv_qs.sv_numque = 0;
+	gettimeofday(&phase_start, NULL);
 
 	/* start a transaction */
 	if (pbs_db_begin_trx(conn, 0, 0) != 0)
@@ -896,6 +916,7 @@ pbsd_init(int type)
 	sprintf(log_buffer, msg_init_expctq, had, server.sv_qs.sv_numque);
 	log_event(logtype, PBS_EVENTCLASS_SERVER, LOG_INFO,
 		msg_daemonname, log_buffer);
+	log_recov_phase("queues", server.sv_qs.sv_numque, &phase_start);
 
 
 	/* Open and read in node list if one exists */
@@ -904,6 +925,7 @@ pbsd_init(int type)
 		log_err(-1, __func__, log_buffer);
 		return (-1);
 	}
+	log_recov_phase("nodes", svr_totnodes, &phase_start);
 	mark_which_queues_have_nodes();
 	(void) license_sanity_check();
 
@@ -924,6 +946,8 @@ pbsd_init(int type)
 		return (-1);
 
 	/* load reservations */
+	gettimeofday(&phase_start, NULL);
+	count = 0;
 	obj.pbs_db_obj_type = PBS_DB_RESV;
 	obj.pbs_db_un.pbs_db_resv = &dbresv;
 	state = pbs_db_cursor_init(conn, &obj, NULL);
@@ -939,6 +963,7 @@ pbsd_init(int type)
 		presv = (resc_resv *) job_or_resv_recov(dbresv.ri_resvid,
 			RESC_RESV_OBJECT);
 		if (presv != NULL) {
+			count++;
 
 			is_resv_window_in_future(presv);
 			set_old_subUniverse(presv);
@@ -964,6 +989,7 @@ pbsd_init(int type)
 		pbs_db_reset_obj(&obj);
 	}
 	pbs_db_cursor_close(conn, state);
+	log_recov_phase("reservations", count, &phase_start);
 
 	/*
 	 * 9. If not "create" or "clean" recovery, recover the jobs.
@@ -978,15 +1004,25 @@ pbsd_init(int type)
 	avl_create_index(AVL_jctx, AVL_NO_DUP_KEYS, 0);
 
 	server.sv_qs.sv_numjobs = 0;
+	gettimeofday(&phase_start, NULL);
 
-	/* get jobs from DB */
+	/*
+	 * get jobs from DB, with a job snapshot only the attributes of the
+	 * jobs saved since the snapshot was taken
+	 */
+	if ((type == RECOV_COLD) || (type == RECOV_CREATE))
+		(void)unlink(path_job_snapshot);
+	else
+		jsnap = job_snapshot_open(&opts.saveseq);
 	obj.pbs_db_obj_type = PBS_DB_JOB;
-	obj.pbs_db_un.pbs_db_job = &dbjob;
-	state = pbs_db_cursor_init(conn, &obj, NULL);
+	obj.pbs_db_un.pbs_db_job = NULL;
+	opts.flags = FIND_JOBS_ATTRS_SINCE;
+	state = pbs_db_cursor_init(conn, &obj, (jsnap != NULL) ? &opts : NULL);
 	if (state == NULL) {
 		sprintf(log_buffer, "%s", (char *) conn->conn_db_err);
 		log_err(-1, __func__, log_buffer);
 		pbs_db_cursor_close(conn, state);
+		job_snapshot_close(jsnap);
 		(void) pbs_db_end_trx(conn, PBS_DB_ROLLBACK);
 		return (-1);
 	}
@@ -998,24 +1034,31 @@ pbsd_init(int type)
 		}
 	} else {
 		/* Now, for each job found ... */
+		/* the attributes are decoded in batches on several threads */
+		if ((jrecov = job_recov_db_open(conn, state, jsnap)) == NULL) {
+			pbs_db_cursor_close(conn, state);
+			job_snapshot_close(jsnap);
+			(void) pbs_db_end_trx(conn, PBS_DB_ROLLBACK);
+			return (-1);
+		}
 		numjobs = 0;
-		while ((rc = pbs_db_cursor_next(conn, state, &obj)) == 0) {
-			if ((pjob = job_recov_db_spl(&dbjob)) == NULL) {
+		while ((rc = job_recov_db_next(jrecov, &pjob, &pdbjob)) == 0) {
+			if (pjob == NULL) {
 				if ((type == RECOV_COLD) || (type == RECOV_CREATE)) {
 					/* remove the loaded job from db */
+					obj.pbs_db_un.pbs_db_job = pdbjob;
 					if (pbs_db_delete_obj(conn, &obj) != 0) {
-						sprintf(log_buffer, "job %s not purged", dbjob.ji_jobid);
+						sprintf(log_buffer, "job %s not purged", pdbjob->ji_jobid);
 						log_err(-1, __func__, log_buffer);
 					}
 				} else {
-					sprintf(log_buffer, "Failed to recover job %s", dbjob.ji_jobid);
+					sprintf(log_buffer, "Failed to recover job %s", pdbjob->ji_jobid);
 					log_event(PBSEVENT_SYSTEM,
 						PBS_EVENTCLASS_SERVER, LOG_NOTICE,
 						msg_daemonname, log_buffer);
 				}
 				continue;
 			}
-			pbs_db_reset_obj(&obj);
 
 			/*chk if job belongs to a reservation or
 			 *is a reservation job.  If this is true
@@ -1045,6 +1088,8 @@ pbsd_init(int type)
 			}
 		}
 
+		job_recov_db_close(jrecov);
+
 		sprintf(log_buffer, msg_init_exptjobs,
 			server.sv_qs.sv_numjobs);
 		log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, LOG_NOTICE,
@@ -1052,9 +1097,11 @@ pbsd_init(int type)
 	}
 
 	pbs_db_cursor_close(conn, state);
+	job_snapshot_close(jsnap);
 	/* close transaction */
 	if (pbs_db_end_trx(conn, PBS_DB_COMMIT) != 0)
 		return (-1);
+	log_recov_phase("jobs", server.sv_qs.sv_numjobs, &phase_start);
 
 	/* If we have trial licenses, we would need to immediately   */
 	/* license the jobs under svr_unlicensedjobs list.           */
@@ -1093,6 +1140,9 @@ pbsd_init(int type)
 	 *
 	 */
 
+	gettimeofday(&phase_start, NULL);
+	count = 0;
+
 	if (chdir(path_hooks) != 0) {
 		(void)sprintf(log_buffer, msg_init_chdir, path_hooks);
 		log_err(errno, __func__, log_buffer);
@@ -1142,6 +1192,7 @@ pbsd_init(int type)
 					LOG_INFO, msg_daemonname, log_buffer);
 				if (phook->event & MOM_EVENTS)
 					mark_mom_hooks_seen();
+				count++;
 			}
 		}
 
@@ -1166,6 +1217,8 @@ pbsd_init(int type)
 	 */
 
 	cleanup_hooks_workdir(0);
+	log_recov_phase("hooks", count, &phase_start);
+	log_recov_phase("server state", -1, &recov_start);
 
 	/* Put us back in the Server's Private directory */
 
@@ -1249,6 +1302,13 @@ pbsd_init(int type)
 	(void)set_task(WORK_Timed, (long)(time_now + PBS_SAVE_TRACK_TM),
 		track_save, 0);
 
+	/* and to periodically write the job snapshot */
+
+	if (pbs_conf.pbs_server_snapshot > 0)
+		(void)set_task(WORK_Timed,
+			(long)(time_now + pbs_conf.pbs_server_snapshot),
+			job_snapshot_save, NULL);
+
 	fd = open(path_prov_track, O_RDONLY | O_CREAT, 0600);
 	if (fd < 0) {
 		log_err(errno, __func__, "unable to open prov_tracking file");
@@ -1962,6 +2022,24 @@ catch_child(int sig)
 	reap_child_flag = 1;
 }
 
+/**
+ * @brief
+ * 		catch_usr1 - signal handler for SIGUSR1
+ *		Set a flag for the main loop to append the TPP statistics
+ *		to server_priv/tpp_stats.
+ *
+ * @param[in]	sig	- not used in fun.
+ *
+ * @return	void
+ */
+static void
+catch_usr1(int sig)
+{
+	extern int dump_tpp_stats_flag;
+
+	dump_tpp_stats_flag = 1;
+}
+
 /**
  * @brief
  * 		change_logs - signal handler for SIGHUP
@@ -2215,6 +2293,39 @@ attach_queue_to_reservation(resc_resv *presv)
 }
 
 
+/**
+ * @brief
+ * 		log_recov_phase - log how long a phase of the server recovery took
+ *		and start timing the next one
+ *
+ * @param[in]	phase	- what was recovered
+ * @param[in]	count	- number of objects recovered, or -1 if not counted
+ * @param[in,out] ptv	- time the phase started, reset to now
+ *
+ * @return	void
+ */
+static void
+log_recov_phase(char *phase, int count, struct timeval *ptv)
+{
+	struct timeval now;
+	long ms;
+
+	gettimeofday(&now, NULL);
+	ms = (now.tv_sec - ptv->tv_sec) * 1000 +
+		(now.tv_usec - ptv->tv_usec) / 1000;
+	if (count >= 0)
+		snprintf(log_buffer, LOG_BUF_SIZE,
+			"Recovered %d %s in %ld.%03ld seconds",
+			count, phase, ms / 1000, ms % 1000);
+	else
+		snprintf(log_buffer, LOG_BUF_SIZE,
+			"Recovered %s in %ld.%03ld seconds",
+			phase, ms / 1000, ms % 1000);
+	log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, LOG_INFO,
+		msg_daemonname, log_buffer);
+	*ptv = now;
+}
+
 /**
  * @brief
  * 		call_log_license - call the routine to long the floating license info
@@ -145,6 +145,7 @@
 
 extern int  pbsd_init(int);
 extern void shutdown_ack();
+extern void job_snapshot_save(struct work_task *pwt);
 extern int takeover_from_secondary(void);
 extern int  be_secondary(time_t sec);
 extern void set_srv_prov_attributes();
@@ -213,6 +214,7 @@ char	       *path_hooks_rescdef;
 char	       *path_spool;
 char 	       *path_track;
 char	       *path_svrlive;
+char	       *path_job_snapshot;
 extern char    *path_prov_track;
 char	       *path_secondaryact;
 attribute      *pbs_float_lic;
@@ -263,6 +265,7 @@ char	       *pbs_server_name;
 char		server_name[PBS_MAXSERVERNAME+1]; /* host_name[:service|port] */
 char		server_host[PBS_MAXHOSTNAME+1];	  /* host_name of this svr */
 int		reap_child_flag = 0;
+int		dump_tpp_stats_flag = 0; /* set on SIGUSR1 */
 time_t		secondary_delay = 30;
 struct server	server;		/* the server structure */
 pbs_sched	*dflt_scheduler = NULL; /* the default scheduler */
@@ -1308,6 +1311,7 @@ main(int argc, char **argv)
 		HOOK_TRACKING_SUFFIX);
 	path_hooks_rescdef = build_path(path_hooks, PBS_RESCDEF, NULL);
 	path_svrlive = build_path(path_priv, PBS_SVRLIVE, NULL);
+	path_job_snapshot = build_path(path_priv, PBS_JOB_SNAPSHOT, NULL);
 
 	/* initialize the pointers in the resource_def array */
 
@@ -1743,6 +1747,9 @@ try_db_again:
 	/* Protect from being killed by kernel */
 	daemon_protect(0, PBS_DAEMON_PROTECT_ON);
 
+	/* write the log from a background thread if PBS_LOG_ASYNC is set */
+	(void)log_async_start();
+
 #ifdef _POSIX_MEMLOCK
 	if (do_mlockall == 1) {
 		if (mlockall(MCL_CURRENT|MCL_FUTURE) == -1) {
@@ -2129,6 +2136,9 @@ try_db_again:
 			reap_child();
 #endif	/* WIN32 */
 
+		/* write out accounting records buffered during this pass */
+		acct_flush();
+
 		/* wait for a request and process it */
 		if (wait_request(waittime, priority_context) != 0) {
 			log_err(-1, msg_daemonname, "wait_requst failed");
@@ -2139,6 +2149,16 @@ try_db_again:
 
 		if (reap_child_flag)	/* check again incase signal arrived */
 			reap_child();	/* before they were blocked          */
+
+		if (dump_tpp_stats_flag) {
+			dump_tpp_stats_flag = 0;
+			if (pbs_conf.pbs_use_tcp == 1) {
+				char path_stats[MAXPATHLEN + 1];
+
+				snprintf(path_stats, sizeof(path_stats), "%s/tpp_stats", path_priv);
+				(void) tpp_dump_stats(path_stats, "pbs_server");
+			}
+		}
 #endif /* WIN32 */
 
 		if (*state == SV_STATE_SHUTSIG)
@@ -2169,6 +2189,10 @@ try_db_again:
 			(void)job_save(pjob, SAVEJOB_FULLFORCE);
 	}
 
+	/* and snapshot them for a faster restart */
+	if (*state != SV_STATE_SECIDLE)
+		job_snapshot_save(NULL);
+
 	/* save any reservations that need saving */
 	for (presv = (resc_resv *)GET_NEXT(svr_allresvs);
 		presv;
@@ -552,6 +552,7 @@ req_quejob(struct batch_request *preq)
 			pj->ji_qs.ji_substate = JOB_SUBSTATE_TRANSIN;
 			if (reply_jobid(preq, pj->ji_qs.ji_jobid,
 				BATCH_REPLY_CHOICE_Queue) == 0) {
+				mom_avljob_oper(pj, 1);
 				delete_link(&pj->ji_alljobs);
 				append_link(&svr_newjobs, &pj->ji_alljobs, pj);
 				pj->ji_qs.ji_un_type = JOB_UNION_TYPE_NEW;
@@ -570,6 +571,7 @@ req_quejob(struct batch_request *preq)
 			return;
 		}
 		/* unlink job from svr_alljobs since will be place on newjobs */
+		mom_avljob_oper(pj, 1);
 		delete_link(&pj->ji_alljobs);
 	} else {
 		char basename[MAXPATHLEN + 1];
@@ -1779,6 +1781,7 @@ req_commit(struct batch_request *preq)
 
 	delete_link(&pj->ji_alljobs);
 	append_link(&svr_alljobs, &pj->ji_alljobs, pj);
+	mom_avljob_oper(pj, 0);
 	/*
 	 ** Set JOB_SVFLG_HERE to indicate that this is Mother Superior.
 	 */
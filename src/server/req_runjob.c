@@ -463,6 +463,7 @@ req_runjob(struct batch_request *preq)
 		pdefr->dr_id[PBS_MAXSVRJOBID] ='\0';
 		pdefr->dr_preq = preq;
 		pdefr->dr_sent = 0;
+		pdefr->dr_sent_busy = 0;
 		append_link(&svr_deferred_req, &pdefr->dr_link, pdefr);
 		/* ensure that request is removed if client connect is closed */
 		net_add_close_func(preq->rq_conn, clear_from_defr);
@@ -375,6 +375,48 @@ schedule_high(pbs_sched *psched)
 	return 1;
 }
 
+/**
+ * @brief
+ * 		send_qrun_to_busy_sched - send the unsent qrun requests for a busy
+ *		scheduler on its secondary connection.  The scheduler checks that
+ *		connection between jobs, so a qrun does not have to wait for the
+ *		end of a long scheduling cycle.
+ *
+ * @param[in]	psched	-	the busy scheduler
+ *
+ * @return	void
+ */
+static void
+send_qrun_to_busy_sched(pbs_sched *psched)
+{
+	struct deferred_request *pdefr;
+	pbs_sched *target_sched;
+
+	if (psched->scheduler_sock2 == -1)
+		return;
+
+	for (pdefr = (struct deferred_request *)GET_NEXT(svr_deferred_req);
+		pdefr;
+		pdefr = (struct deferred_request *)GET_NEXT(pdefr->dr_link)) {
+		if (pdefr->dr_sent != 0)
+			continue;
+		if (!find_assoc_sched_jid(pdefr->dr_id, &target_sched) ||
+			target_sched != psched)
+			continue;
+
+		if (put_sched_cmd(psched->scheduler_sock2, SCH_SCHEDULE_AJOB,
+			pdefr->dr_id) != 0)
+			break;
+
+		pdefr->dr_sent = 1;
+		pdefr->dr_sent_busy = 1;
+		sprintf(log_buffer, "sent qrun request to busy scheduler %s",
+			psched->sc_name);
+		log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_DEBUG,
+			pdefr->dr_id, log_buffer);
+	}
+}
+
 /**
  * @brief
  * 		Contact scheduler and direct it to run a scheduling cycle
@@ -465,8 +507,10 @@ schedule_jobs(pbs_sched *psched)
 		}
 
 		return (0);
-	} else
+	} else {
+		send_qrun_to_busy_sched(psched);
 		return (1);	/* scheduler was busy */
+	}
 
 }
 
@@ -518,11 +562,18 @@ scheduler_close(int sock)
 	 *	is still there.
 	 *      If any qrun request is pending in the deffered list, set svr_unsent_qrun_req so
 	 * 	they are sent when the Scheduler completes this cycle 
+	 *	A request sent on the secondary connection may have arrived after
+	 *	the Scheduler last looked, so it is made pending again.
 	 */
 	pdefr = (struct deferred_request *)GET_NEXT(svr_deferred_req);
 	while (pdefr) {
 		struct deferred_request *next_pdefr = (struct deferred_request *)GET_NEXT(pdefr->dr_link);
-		if (pdefr->dr_sent != 0) {
+		if (pdefr->dr_sent_busy != 0) {
+			pdefr->dr_sent = 0;
+			pdefr->dr_sent_busy = 0;
+			svr_unsent_qrun_req = 1;
+		}
+		else if (pdefr->dr_sent != 0) {
 			log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_JOB,
 				LOG_NOTICE, pdefr->dr_id,
 				"deferred qrun request to scheduler failed");
@@ -307,11 +307,10 @@ svr_enquejob(job *pjob)
 	/* add job to server's all job list and update server counts */
 
 #ifndef NDEBUG
-	(void)sprintf(log_buffer, "enqueuing into %s, state %x hop %ld",
+	log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_DEBUG,
+		pjob->ji_qs.ji_jobid, "enqueuing into %s, state %x hop %ld",
 		pque->qu_qs.qu_name, pjob->ji_qs.ji_state,
 		pjob->ji_wattr[(int)JOB_ATR_hopcount].at_val.at_long);
-	log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_DEBUG,
-		pjob->ji_qs.ji_jobid, log_buffer);
 #endif	/* NDEBUG */
 
 	pjcur = (job *)GET_PRIOR(svr_alljobs);
@@ -393,10 +392,9 @@ svr_enquejob(job *pjob)
 	pdef->at_decode(pattrjb, NULL, NULL, pque->qu_qs.qu_name);
 
 	if (pque->qu_attr[(int)QA_ATR_QType].at_val.at_str == NULL) {
-		sprintf(log_buffer, "queue type must be set for queue `%s`",
+		log_eventf(PBSEVENT_ADMIN, PBS_EVENTCLASS_QUEUE, LOG_ERR,
+			pjob->ji_qs.ji_jobid, "queue type must be set for queue `%s`",
 			pque->qu_qs.qu_name);
-		log_event(PBSEVENT_ADMIN, PBS_EVENTCLASS_QUEUE, LOG_ERR,
-			pjob->ji_qs.ji_jobid, log_buffer);
 		return PBSE_NEEDQUET;
 	}
 	pjob->ji_wattr[(int)JOB_ATR_queuetype].at_val.at_char =
@@ -570,10 +568,9 @@ svr_dequejob(job *pjob)
 	}
 
 #ifndef NDEBUG
-	(void)sprintf(log_buffer, "dequeuing from %s, state %x",
+	log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_DEBUG,
+		pjob->ji_qs.ji_jobid, "dequeuing from %s, state %x",
 		pque ? pque->qu_qs.qu_name : "", pjob->ji_qs.ji_state);
-	log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_DEBUG,
-		pjob->ji_qs.ji_jobid, log_buffer);
 	if (bad_ct) 		/* state counts are all messed up */
 		correct_ct(pque);
 #endif	/* NDEBUG */
@@ -855,9 +852,8 @@ svr_evaljobstate(job *pjob, int *newstate, int *newsub, int forceeval)
 					*newsub   = JOB_SUBSTATE_QUEUED;
 				}
 			} else {
-				sprintf(log_buffer, "Array job has no tracking table!");
-				log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, LOG_ERR,
-					pjob->ji_qs.ji_jobid, log_buffer);
+				log_eventf(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, LOG_ERR,
+					pjob->ji_qs.ji_jobid, "Array job has no tracking table!");
 				*newstate = JOB_STATE_HELD;
 				*newsub = JOB_SUBSTATE_HELD;
 			}
@@ -1519,23 +1515,20 @@ check_block(job *pjob, char *message)
 
 	phost = get_hostPart(pjob->ji_wattr[(int)JOB_ATR_job_owner].at_val.at_str);
 	if (port == 0 || phost == NULL) {
-		sprintf(log_buffer, "%s: cannot reply %s:%d", __func__,
+		log_eventf(PBSEVENT_ERROR, PBS_EVENTCLASS_JOB, LOG_NOTICE,
+			jobid, "%s: cannot reply %s:%d", __func__,
 			phost == NULL ? "<no host>" : phost, port);
-		log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_JOB, LOG_NOTICE,
-			jobid, log_buffer);
 		return;
 	}
 	if ((hp = gethostbyname(phost)) == NULL) {
-		sprintf(log_buffer, "%s: host %s not found", __func__, phost);
-		log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_JOB, LOG_NOTICE,
-			jobid, log_buffer);
+		log_eventf(PBSEVENT_ERROR, PBS_EVENTCLASS_JOB, LOG_NOTICE,
+			jobid, "%s: host %s not found", __func__, phost);
 		return;
 	}
 	remote_sin_family = hp->h_addrtype;
 	if ((sock = socket(AF_INET, SOCK_STREAM, 0)) == -1) {
-		sprintf(log_buffer, "%s: socket %s", __func__, strerror(errno));
-		log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_JOB, LOG_NOTICE,
-			jobid, log_buffer);
+		log_eventf(PBSEVENT_ERROR, PBS_EVENTCLASS_JOB, LOG_NOTICE,
+			jobid, "%s: socket %s", __func__, strerror(errno));
 		return;
 	}
 	memset(&remote, 0, sizeof(remote));
@@ -1544,10 +1537,9 @@ check_block(job *pjob, char *message)
 	remote.sin_port = htons((unsigned short)port);
 	remote.sin_family = remote_sin_family;
 	if (connect(sock, (struct sockaddr *)&remote, sizeof(remote)) == -1) {
-		sprintf(log_buffer, "%s: connect %s(%s:%d) %s", __func__, phost,
+		log_eventf(PBSEVENT_ERROR, PBS_EVENTCLASS_JOB, LOG_NOTICE,
+			jobid, "%s: connect %s(%s:%d) %s", __func__, phost,
 			inet_ntoa(remote.sin_addr), port, strerror(errno));
-		log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_JOB, LOG_NOTICE,
-			jobid, log_buffer);
 #ifdef WIN32
 		closesocket(sock);
 #else
@@ -1589,10 +1581,9 @@ check_block(job *pjob, char *message)
 	goto done;
 
 err:
-	sprintf(log_buffer, "%s: write %s(%s:%d) %s", __func__, phost,
+	log_eventf(PBSEVENT_ERROR, PBS_EVENTCLASS_JOB, LOG_NOTICE,
+		jobid, "%s: write %s(%s:%d) %s", __func__, phost,
 		inet_ntoa(remote.sin_addr), port, dis_emsg[ret]);
-	log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_JOB, LOG_NOTICE,
-		jobid, log_buffer);
 
 done:
 	if ((ret = CS_close_socket(sock)) != CS_SUCCESS) {
@@ -3295,22 +3286,22 @@ Time4occurrenceFinish(resc_resv *presv)
 	free(newxc);
 
 	if (rc != PBSE_NONE) {
-		sprintf(log_buffer, "problem assigning resource to reservation occurrence (%d)", rc);
-		log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_RESV, LOG_NOTICE, presv->ri_qs.ri_resvID, log_buffer);
+		log_eventf(PBSEVENT_ERROR, PBS_EVENTCLASS_RESV, LOG_NOTICE, presv->ri_qs.ri_resvID,
+			"problem assigning resource to reservation occurrence (%d)", rc);
 		return;
 	}
 
 	/*place "Time4resv" task on "task_list_timed"*/
 	if ((rc = gen_task_Time4resv(presv)) != 0) {
-		sprintf(log_buffer, "problem generating task Time for occurrence (%d)", rc);
-		log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_RESV, LOG_NOTICE, presv->ri_qs.ri_resvID, log_buffer);
+		log_eventf(PBSEVENT_ERROR, PBS_EVENTCLASS_RESV, LOG_NOTICE, presv->ri_qs.ri_resvID,
+			"problem generating task Time for occurrence (%d)", rc);
 		return;
 	}
 	/* add task to handle the end of the next occurrence */
 	if ((rc = gen_task_EndResvWindow(presv)) != 0) {
 		(void)resv_purge(presv);
-		sprintf(log_buffer, " problem generating reservation end task for occurrence (%d)", rc);
-		log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_RESV, LOG_NOTICE, presv->ri_qs.ri_resvID, log_buffer);
+		log_eventf(PBSEVENT_ERROR, PBS_EVENTCLASS_RESV, LOG_NOTICE, presv->ri_qs.ri_resvID,
+			" problem generating reservation end task for occurrence (%d)", rc);
 		return;
 	}
 
@@ -4039,9 +4030,8 @@ change_enableORstart(resc_resv *presv, int which, char *value)
 
 	newreq = alloc_br(PBS_BATCH_Manager);
 	if (newreq == NULL) {
-		(void)sprintf(log_buffer, "batch request allocation failed");
-		log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_RESV, LOG_NOTICE,
-			presv->ri_qs.ri_resvID, log_buffer);
+		log_eventf(PBSEVENT_SYSTEM, PBS_EVENTCLASS_RESV, LOG_NOTICE,
+			presv->ri_qs.ri_resvID, "batch request allocation failed");
 		return  (PBSE_SYSTEM);
 	}
 
@@ -4080,9 +4070,8 @@ change_enableORstart(resc_resv *presv, int which, char *value)
 		handle_qmgr_reply_to_startORenable, &pwt, 0) == -1) {
 		free_br(newreq);
 
-		(void)sprintf(log_buffer, "%s", msg_internalReqFail);
-		log_event(PBSEVENT_RESV, PBS_EVENTCLASS_RESV, LOG_NOTICE,
-			presv->ri_qs.ri_resvID, log_buffer);
+		log_eventf(PBSEVENT_RESV, PBS_EVENTCLASS_RESV, LOG_NOTICE,
+			presv->ri_qs.ri_resvID, "%s", msg_internalReqFail);
 
 		return (PBSE_mgrBatchReq);
 	}
@@ -4124,9 +4113,8 @@ handle_qmgr_reply_to_startORenable(struct work_task *pwt)
 
 	if (preq->rq_reply.brp_code) {
 
-		(void)sprintf(log_buffer, "%s", msg_qEnabStartFail);
-		log_event(PBSEVENT_RESV, PBS_EVENTCLASS_RESV, LOG_NOTICE,
-			presv->ri_qs.ri_resvID, log_buffer);
+		log_eventf(PBSEVENT_RESV, PBS_EVENTCLASS_RESV, LOG_NOTICE,
+			presv->ri_qs.ri_resvID, "%s", msg_qEnabStartFail);
 	}
 
 	free_br((struct batch_request *)pwt->wt_parm1);
@@ -4785,7 +4773,6 @@ update_eligible_time(long newaccruetype, job *pjob)
 	static char *msg[] = { "initial_time", "ineligible_time", "eligible_time", "run_time", "exiting" };
 	char *strtime;
 	static char errtime[] = "00:00:00";
-	char str[256];
 	long accrued_time;			/* accrued time */
 	long oldaccruetype = pjob->ji_wattr[(int)JOB_ATR_accrue_type].at_val.at_long;
 	long timestamp = (long)time_now; 	/* time since accrual begins */
@@ -4838,9 +4825,9 @@ update_eligible_time(long newaccruetype, job *pjob)
 	if (strtime == NULL)
 		strtime = errtime;
 
-	sprintf(str, "Accrue type has changed to %s, previous accrue type was %s for %ld secs, total eligible_time=%s",
+	log_eventf(PBSEVENT_DEBUG3, PBS_EVENTCLASS_JOB, LOG_DEBUG, pjob->ji_qs.ji_jobid,
+		"Accrue type has changed to %s, previous accrue type was %s for %ld secs, total eligible_time=%s",
 		msg[newaccruetype], msg[oldaccruetype], accrued_time, strtime);
-	log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_JOB, LOG_DEBUG, pjob->ji_qs.ji_jobid, str);
 
 	if (strtime != NULL && strtime != errtime)
 		free(strtime);
@@ -4882,7 +4869,6 @@ alter_eligibletime(attribute *pattr, void *pobject, int actmode)
 		} else {
 			long accrued_time;
 			char *strtime;
-			char logstr[256];
 			static char *msg[] = {
 				"initial_time",
 				"ineligible_time",
@@ -4904,10 +4890,10 @@ alter_eligibletime(attribute *pattr, void *pobject, int actmode)
 			if (strtime == NULL)
 				strtime = errtime;
 
-			sprintf(logstr, "Accrue type is %s, previous accrue type was %s for %ld secs, due to qalter total eligible_time=%s",
+			log_eventf(PBSEVENT_DEBUG3, PBS_EVENTCLASS_JOB, LOG_DEBUG,
+				pjob->ji_qs.ji_jobid,
+				"Accrue type is %s, previous accrue type was %s for %ld secs, due to qalter total eligible_time=%s",
 				msg[newaccruetype], msg[oldaccruetype], accrued_time, strtime);
-			log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_JOB, LOG_DEBUG,
-				pjob->ji_qs.ji_jobid, logstr);
 
 			return PBSE_NONE;
 		}
@@ -5271,10 +5257,8 @@ svr_setjob_histinfo(job *pjob, histjob_type type)
 			*tmpstr = '\0';
 		}
 
-		sprintf(log_buffer,
-			"Job Moved to destination: \"%s\"", destination);
-		log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, LOG_INFO,
-			pjob->ji_qs.ji_jobid, log_buffer);
+		log_eventf(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, LOG_INFO,
+			pjob->ji_qs.ji_jobid, "Job Moved to destination: \"%s\"", destination);
 
 		/* put the accounting log for MOVED job */
 		sprintf(log_buffer, "destination=%s", destination);
@@ -5544,9 +5528,8 @@ svr_avljob_oper(job *pjob, int delkey)
 	/** create the avl key using jobid */
 	pkey = svr_avlkey_create(pjob->ji_qs.ji_jobid);
 	if (pkey == NULL) { /** key creation failed */
-		(void) sprintf(log_buffer, "AVL: failed to create job key.");
-		log_event(PBSEVENT_DEBUG4, PBS_EVENTCLASS_JOB, LOG_DEBUG,
-			pjob->ji_qs.ji_jobid, log_buffer);
+		log_eventf(PBSEVENT_DEBUG4, PBS_EVENTCLASS_JOB, LOG_DEBUG,
+			pjob->ji_qs.ji_jobid, "AVL: failed to create job key.");
 		goto AVL_OP_FAIL;
 	}
 
@@ -5574,11 +5557,9 @@ AVL_OP_FAIL:
 	 * for job lookup.
 	 */
 	if (AVL_jctx != NULL) {
-		(void) sprintf(log_buffer,
-			"AVL: %s failed, using LinkedList.",
+		log_eventf(PBSEVENT_DEBUG4, PBS_EVENTCLASS_SERVER, LOG_DEBUG,
+			msg_daemonname, "AVL: %s failed, using LinkedList.",
 			delkey ? "delete" : "insert");
-		log_event(PBSEVENT_DEBUG4, PBS_EVENTCLASS_SERVER, LOG_DEBUG,
-			msg_daemonname, log_buffer);
 		avl_destroy_index(AVL_jctx);
 		free(AVL_jctx);
 		AVL_jctx = NULL;
@@ -5780,8 +5761,8 @@ send_job_exec_update_to_mom(job *pjob, char *err_msg, int err_msg_sz,
 				      psvrl->al_value, 0, NULL) == -1) {
 					free_attrlist(&collectresc);
 					if ((err_msg != NULL) && (err_msg_sz > 0)) {
-						snprintf(err_msg, err_msg_sz, "failed to add_to_svrattrl_list(%s,%s,%s)", objatrdef->at_name, psvrl->al_resc, psvrl->al_value);
-        					log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_DEBUG, pjob->ji_qs.ji_jobid, err_msg);
+						log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_DEBUG, pjob->ji_qs.ji_jobid,
+							"failed to add_to_svrattrl_list(%s,%s,%s)", objatrdef->at_name, psvrl->al_resc, psvrl->al_value);
 					}
 					goto send_job_exec_update_exit;
 				}
@@ -5929,8 +5910,8 @@ recreate_exec_vnode(job *pjob, char *vnodelist, char *err_msg,
 			/* no change */
 
 			if ((err_msg != NULL) && (err_msg_sz > 0)) {
-				snprintf(err_msg, err_msg_sz, "node(s) requested to be released not part of the job: %s", vnodelist?vnodelist:"");
-        			log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_DEBUG, pjob->ji_qs.ji_jobid, err_msg);
+				log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_DEBUG, pjob->ji_qs.ji_jobid,
+					"node(s) requested to be released not part of the job: %s", vnodelist?vnodelist:"");
 			}
 			goto recreate_exec_vnode_exit;
 		}
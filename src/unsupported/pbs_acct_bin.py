@@ -0,0 +1,102 @@
+# coding: utf-8
+#!/usr/bin/env python
+"""
+/*
+# Copyright (C) 1994-2018 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# PBS Pro is free software. You can redistribute it and/or modify it under the
+# terms of the GNU Affero General Public License as published by the Free
+# Software Foundation, either version 3 of the License, or (at your option) any
+# later version.
+#
+# PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY
+# WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE.
+# See the GNU Affero General Public License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# For a copy of the commercial license terms and conditions,
+# go to: (http://www.pbspro.com/UserArea/agreement.html)
+# or contact the Altair Legal Department.
+#
+# Altair’s dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of PBS Pro and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair’s trademarks, including but not limited to "PBS™",
+# "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's
+# trademark licensing policies.
+ *
+ */
+"""
+__doc__ = """
+Print the records of a binary accounting file, written by the server when
+PBS_ACCOUNTING_BINARY is set, one JSON object per line.
+
+usage: pbs_acct_bin.py <accounting file>.bin ...
+"""
+
+import json
+import struct
+import sys
+
+MAGIC = b"PBSACCT\x01"
+
+
+def read_records(f):
+    """
+    Yield (type, time, id, fields) for each record in the open file f
+    """
+    if f.read(len(MAGIC)) != MAGIC:
+        raise ValueError("not a binary accounting file")
+    while True:
+        hdr = f.read(4)
+        if len(hdr) < 4:
+            return
+        (length,) = struct.unpack("!I", hdr)
+        rec = f.read(length)
+        if len(rec) < length:
+            raise ValueError("truncated record")
+        rtype, _, nfields, thi, tlo, idlen = struct.unpack("!BBHIIH", rec[:14])
+        off = 14
+        rid = rec[off:off + idlen].decode("utf-8", "replace")
+        off += idlen
+        fields = []
+        for _ in range(nfields):
+            (klen,) = struct.unpack("!H", rec[off:off + 2])
+            off += 2
+            key = rec[off:off + klen].decode("utf-8", "replace")
+            off += klen
+            (vlen,) = struct.unpack("!I", rec[off:off + 4])
+            off += 4
+            val = rec[off:off + vlen].decode("utf-8", "replace")
+            off += vlen
+            fields.append((key, val))
+        yield chr(rtype), (thi << 32) | tlo, rid, fields
+
+
+def main(args):
+    if not args:
+        sys.stderr.write("usage: pbs_acct_bin.py file ...\n")
+        return 1
+    for name in args:
+        with open(name, "rb") as f:
+            for rtype, rtime, rid, fields in read_records(f):
+                rec = {"type": rtype, "time": rtime, "id": rid}
+                rec["fields"] = [[k, v] for k, v in fields]
+                sys.stdout.write(json.dumps(rec) + "\n")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,701 @@
+/*
+ * Copyright (C) 1994-2018 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * PBS Pro is free software. You can redistribute it and/or modify it under the
+ * terms of the GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * For a copy of the commercial license terms and conditions,
+ * go to: (http://www.pbspro.com/UserArea/agreement.html)
+ * or contact the Altair Legal Department.
+ *
+ * Altair’s dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of PBS Pro and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair’s trademarks, including but not limited to "PBS™",
+ * "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's
+ * trademark licensing policies.
+ *
+ */
+
+/**
+ * @file	tpp_loadgen.c
+ *
+ * @brief
+ *	Synthetic load generator for TPP and pbs_comm.
+ *
+ * @par Functionality
+ *	Forks a number of TPP leaves that connect to the routers named in
+ *	pbs.conf (or given with -r) and exchange traffic patterned after PBS:
+ *
+ *	is    - every leaf periodically sends a status message to a collector
+ *		leaf, the way MoMs send IS messages to the server
+ *	mcast - the collector periodically multicasts a message to all the
+ *		leaves it has heard from, the way the server pings MoMs
+ *	p2p   - every leaf periodically sends a message to another, randomly
+ *		chosen, leaf
+ *
+ *	Each message carries the time it was sent, so the receivers measure
+ *	the latency of the messages (all leaves run on this host and share
+ *	its clock). At the end the throughput and the latency percentiles of
+ *	each kind of traffic are printed, along with the CPU used by the
+ *	router if its pid was given with -c.
+ *
+ *	Each leaf is a separate process, since a process can only host a
+ *	single TPP leaf. With reserved port authentication every leaf binds
+ *	a port below 1024 to connect, which limits a host to some hundreds of
+ *	leaves; run the tool on several hosts, or use external (munge)
+ *	authentication, to simulate more.
+ */
+#include <pbs_config.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sys/select.h>
+#include <pbs_ifl.h>
+#include "pbs_internal.h"
+#include "libutil.h"
+#include "dis.h"
+#include "rpp.h"
+#include "log.h"
+
+#define LG_PROTOCOL	77	/* first item of every message */
+
+/* kinds of traffic */
+#define LG_IS		0
+#define LG_MCAST	1
+#define LG_P2P		2
+#define LG_NKINDS	3
+
+#define LG_MAX_SAMPLES	2048	/* latency samples kept per kind, per leaf */
+#define LG_DRAIN	3	/* seconds to wait for messages after the run */
+
+static char *kind_names[LG_NKINDS] = {"is", "mcast", "p2p"};
+
+/*
+ * Counters of one leaf for one kind of traffic. Only messages sent inside
+ * the measurement window are counted. The latencies are a reservoir
+ * sample of the messages received.
+ */
+typedef struct {
+	unsigned long long sent;
+	unsigned long long sent_bytes;
+	unsigned long long recvd;
+	unsigned long long recvd_bytes;
+	unsigned long long max_lat;
+	unsigned int nsamples;
+	unsigned int samples[LG_MAX_SAMPLES];	/* latency, usec */
+} lg_stats_t;
+
+/* command line settings */
+static int num_leaves = 100;
+static int duration = 30;		/* seconds of measured traffic */
+static int settle = -1;			/* seconds given to the leaves to connect */
+static char *leaf_host = NULL;
+static int base_port = 18000;		/* leaf i is leaf_host:base_port+i */
+static char *routers = NULL;
+static int interval[LG_NKINDS] = {1000, 0, 0};	/* msec, 0 is off */
+static int msg_size[LG_NKINDS] = {256, 1024, 256};
+static pid_t router_pid = -1;
+
+static long long start_us;	/* measurement window */
+static long long end_us;
+static lg_stats_t *all_stats;	/* LG_NKINDS entries per leaf, shared */
+static char *payload;
+static int log_errors = 0;	/* set once the leaves are connected */
+
+/**
+ * @brief
+ *	Log function handed to TPP, prints errors to stderr, but not the
+ *	chatter of the leaves connecting and disconnecting
+ *
+ * @param[in] level   - log level
+ * @param[in] objname - object the message is about
+ * @param[in] mess    - the message
+ *
+ * @return void
+ */
+static void
+log_tppmsg(int level, const char *objname, char *mess)
+{
+	if (log_errors && level <= LOG_ERR)
+		fprintf(stderr, "tpp_loadgen[%d]: %s\n", (int) getpid(), mess);
+}
+
+/**
+ * @brief
+ *	Current time in microseconds
+ *
+ * @return microseconds since the epoch
+ */
+static long long
+now_us(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return ((long long) tv.tv_sec * 1000000 + tv.tv_usec);
+}
+
+/**
+ * @brief
+ *	Compose and send one message on a stream (or mcast channel)
+ *
+ * @param[in] sd     - stream or mcast channel to send on
+ * @param[in] kind   - kind of traffic
+ * @param[in] sender - index of this leaf
+ *
+ * @return DIS error code
+ * @retval DIS_SUCCESS - success
+ */
+static int
+send_msg(int sd, int kind, int sender)
+{
+	int rc;
+
+	DIS_rpp_reset();
+	if ((rc = diswsi(sd, LG_PROTOCOL)) != DIS_SUCCESS)
+		return rc;
+	if ((rc = diswsi(sd, kind)) != DIS_SUCCESS)
+		return rc;
+	if ((rc = diswsi(sd, sender)) != DIS_SUCCESS)
+		return rc;
+	if ((rc = diswull(sd, (u_Long) now_us())) != DIS_SUCCESS)
+		return rc;
+	if ((rc = diswcs(sd, payload, msg_size[kind])) != DIS_SUCCESS)
+		return rc;
+	if (rpp_flush(sd) != 0)
+		return DIS_PROTO;
+	return DIS_SUCCESS;
+}
+
+/**
+ * @brief
+ *	Read one message from a stream and account for it
+ *
+ * @param[in] sd      - stream with data
+ * @param[in] stats   - the LG_NKINDS counters of this leaf
+ * @param[in] strms   - if not NULL, remember the stream to each sender
+ *
+ * @return void
+ */
+static void
+recv_msg(int sd, lg_stats_t *stats, int *strms)
+{
+	int rc;
+	int kind;
+	int sender = 0;
+	long long sent = 0;
+	long long lat;
+	size_t len = 0;
+	char *data = NULL;
+	lg_stats_t *st;
+
+	DIS_rpp_reset();
+	if (disrsi(sd, &rc) != LG_PROTOCOL || rc != DIS_SUCCESS) {
+		rpp_close(sd);
+		return;
+	}
+	kind = disrsi(sd, &rc);
+	if (rc == DIS_SUCCESS)
+		sender = disrsi(sd, &rc);
+	if (rc == DIS_SUCCESS)
+		sent = (long long) disrull(sd, &rc);
+	if (rc == DIS_SUCCESS)
+		data = disrcs(sd, &len, &rc);
+	if (rc != DIS_SUCCESS || kind < 0 || kind >= LG_NKINDS) {
+		rpp_close(sd);
+		return;
+	}
+	free(data);
+	rpp_eom(sd);
+
+	if (strms && sender > 0 && sender < num_leaves)
+		strms[sender] = sd;
+
+	if (sent < start_us || sent >= end_us)
+		return;
+
+	lat = now_us() - sent;
+	if (lat < 0)
+		lat = 0;
+
+	st = &stats[kind];
+	st->recvd++;
+	st->recvd_bytes += len;
+	if ((unsigned long long) lat > st->max_lat)
+		st->max_lat = lat;
+	if (st->nsamples < LG_MAX_SAMPLES)
+		st->samples[st->nsamples++] = (unsigned int) lat;
+	else if ((rc = random() % st->recvd) < LG_MAX_SAMPLES)
+		st->samples[rc] = (unsigned int) lat;
+}
+
+/**
+ * @brief
+ *	Body of the process of leaf number idx. Leaf 0 is the collector.
+ *
+ * @param[in] idx - index of this leaf
+ *
+ * @return exit code of the process
+ */
+static int
+run_leaf(int idx)
+{
+	struct tpp_config tpp_conf;
+	lg_stats_t *stats = &all_stats[idx * LG_NKINDS];
+	int *strms = NULL;
+	int collector = -1;
+	int peer = -1;
+	long long next[LG_NKINDS];
+	long long now;
+	long long wake;
+	char *names;
+	int fd;
+	int sd;
+	int rc;
+	int i;
+
+	srandom(getpid());
+
+	if ((names = strdup(leaf_host)) == NULL)
+		return 1;
+
+	set_tpp_funcs(log_tppmsg);
+#ifndef WIN32
+	if (pbs_conf.auth_method == AUTH_MUNGE)
+		rc = set_tpp_config(&pbs_conf, &tpp_conf, names, base_port + idx, routers,
+			pbs_conf.pbs_use_compression, TPP_AUTH_EXTERNAL,
+			get_ext_auth_data, validate_ext_auth_data);
+	else
+#endif
+		rc = set_tpp_config(&pbs_conf, &tpp_conf, names, base_port + idx, routers,
+			pbs_conf.pbs_use_compression, TPP_AUTH_RESV_PORT, NULL, NULL);
+	if (rc == -1) {
+		fprintf(stderr, "Error setting TPP config\n");
+		return 1;
+	}
+	if ((fd = tpp_init(&tpp_conf)) == -1) {
+		fprintf(stderr, "tpp_init failed for leaf %d\n", idx);
+		return 1;
+	}
+
+	/* spread the first message of each leaf over the interval */
+	for (i = 0; i < LG_NKINDS; i++) {
+		next[i] = -1;
+		if (interval[i] > 0)
+			next[i] = start_us + (random() % interval[i]) * 1000LL;
+	}
+
+	if (idx == 0) {
+		/* the collector sends only the mcasts, and learns the streams from the is messages */
+		if ((strms = calloc(num_leaves, sizeof(int))) == NULL)
+			return 1;
+		for (i = 0; i < num_leaves; i++)
+			strms[i] = -1;
+		next[LG_IS] = next[LG_P2P] = -1;
+	} else
+		next[LG_MCAST] = -1;
+
+	while ((now = now_us()) < end_us + LG_DRAIN * 1000000LL) {
+		fd_set selset;
+		struct timeval tv;
+
+		if (now >= start_us && now < end_us)
+			log_errors = 1;
+		else
+			log_errors = 0;
+
+		/* open the streams once the leaves had time to connect */
+		if (idx > 0 && now >= start_us && collector == -1) {
+			collector = rpp_open(leaf_host, base_port);
+			if (interval[LG_P2P] > 0 && num_leaves > 2) {
+				do {
+					i = 1 + random() % (num_leaves - 1);
+				} while (i == idx);
+				peer = rpp_open(leaf_host, base_port + i);
+			}
+		}
+
+		for (i = 0; i < LG_NKINDS; i++) {
+			if (next[i] == -1 || now < next[i])
+				continue;
+			next[i] += interval[i] * 1000LL;
+			if (next[i] >= end_us)
+				next[i] = -1;
+
+			if (i == LG_IS)
+				sd = collector;
+			else if (i == LG_P2P)
+				sd = peer;
+			else {
+				int j;
+				int n = 0;
+
+				sd = tpp_mcast_open();
+				for (j = 1; sd != -1 && j < num_leaves; j++) {
+					if (strms[j] != -1 && tpp_mcast_add_strm(sd, strms[j]) == 0)
+						n++;
+				}
+				if (n == 0) {
+					if (sd != -1)
+						tpp_mcast_close(sd);
+					continue;
+				}
+				if (send_msg(sd, i, idx) == DIS_SUCCESS) {
+					stats[i].sent += n;
+					stats[i].sent_bytes += (unsigned long long) n * msg_size[i];
+				}
+				tpp_mcast_close(sd);
+				continue;
+			}
+			if (sd < 0)
+				continue;
+			if (send_msg(sd, i, idx) == DIS_SUCCESS) {
+				stats[i].sent++;
+				stats[i].sent_bytes += msg_size[i];
+			}
+		}
+
+		/* sleep till the next message is due, or data arrives */
+		wake = end_us + LG_DRAIN * 1000000LL;
+		if (now < start_us)
+			wake = start_us;
+		for (i = 0; i < LG_NKINDS; i++) {
+			if (next[i] != -1 && next[i] < wake)
+				wake = next[i];
+		}
+		wake -= now_us();
+		if (wake < 0)
+			wake = 0;
+		tv.tv_sec = wake / 1000000;
+		tv.tv_usec = wake % 1000000;
+		FD_ZERO(&selset);
+		FD_SET(fd, &selset);
+		if (select(fd + 1, &selset, NULL, NULL, &tv) == -1 && errno != EINTR)
+			break;
+
+		while ((sd = rpp_poll()) >= 0)
+			recv_msg(sd, stats, strms);
+	}
+
+	log_errors = 0;
+	rpp_shutdown();
+	return 0;
+}
+
+/**
+ * @brief
+ *	Get the CPU time (user + system) used so far by a process
+ *
+ * @param[in] pid - the process
+ *
+ * @return seconds of CPU, -1 if not known
+ */
+static double
+proc_cpu(pid_t pid)
+{
+	char path[64];
+	char buf[1024];
+	char *p;
+	unsigned long utime;
+	unsigned long stime;
+	FILE *fp;
+
+	snprintf(path, sizeof(path), "/proc/%d/stat", (int) pid);
+	if ((fp = fopen(path, "r")) == NULL)
+		return -1;
+	p = fgets(buf, sizeof(buf), fp);
+	fclose(fp);
+	if (p == NULL)
+		return -1;
+
+	/* skip past the command name, which may contain blanks */
+	if ((p = strrchr(buf, ')')) == NULL)
+		return -1;
+	if (sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+		&utime, &stime) != 2)
+		return -1;
+	return ((double) (utime + stime) / sysconf(_SC_CLK_TCK));
+}
+
+/**
+ * @brief
+ *	qsort comparison function for latency samples
+ */
+static int
+cmp_lat(const void *a, const void *b)
+{
+	unsigned int x = *(const unsigned int *) a;
+	unsigned int y = *(const unsigned int *) b;
+
+	return ((x > y) - (x < y));
+}
+
+/**
+ * @brief
+ *	Add up the counters of all the leaves and print the report
+ *
+ * @param[in] cpu - CPU seconds used by the router during the run, or -1
+ *
+ * @return void
+ */
+static void
+report(double cpu)
+{
+	unsigned int *lat;
+	unsigned long long sent;
+	unsigned long long recvd;
+	unsigned long long bytes;
+	unsigned long long max;
+	size_t n;
+	int k;
+	int i;
+
+	lat = malloc(sizeof(unsigned int) * LG_MAX_SAMPLES * (size_t) num_leaves);
+	if (lat == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		return;
+	}
+
+	printf("%d leaves, %d seconds\n", num_leaves, duration);
+	printf("%-6s %12s %12s %12s %10s %10s %10s %10s\n",
+		"kind", "sent", "recvd", "msgs/s", "KB/s", "p50_us", "p99_us", "max_us");
+	for (k = 0; k < LG_NKINDS; k++) {
+		lg_stats_t *st;
+
+		if (interval[k] == 0)
+			continue;
+		sent = recvd = bytes = max = 0;
+		n = 0;
+		for (i = 0; i < num_leaves; i++) {
+			st = &all_stats[i * LG_NKINDS + k];
+			sent += st->sent;
+			recvd += st->recvd;
+			bytes += st->recvd_bytes;
+			if (st->max_lat > max)
+				max = st->max_lat;
+			memcpy(lat + n, st->samples, st->nsamples * sizeof(unsigned int));
+			n += st->nsamples;
+		}
+		qsort(lat, n, sizeof(unsigned int), cmp_lat);
+		printf("%-6s %12llu %12llu %12.1f %10.1f %10u %10u %10llu\n",
+			kind_names[k], sent, recvd, (double) recvd / duration,
+			(double) bytes / 1024 / duration,
+			n ? lat[n / 2] : 0, n ? lat[(n * 99) / 100] : 0, max);
+	}
+	if (cpu >= 0)
+		printf("router cpu: %.2f seconds, %.1f%% of a cpu\n", cpu, cpu * 100 / duration);
+
+	free(lat);
+}
+
+/**
+ * @brief
+ *	Sleep till the given time
+ *
+ * @param[in] when - time to wake up, usec since the epoch
+ *
+ * @return void
+ */
+static void
+sleep_till(long long when)
+{
+	long long left;
+
+	while ((left = when - now_us()) > 0) {
+		struct timeval tv;
+
+		tv.tv_sec = left / 1000000;
+		tv.tv_usec = left % 1000000;
+		select(0, NULL, NULL, NULL, &tv);
+	}
+}
+
+int
+main(int argc, char *argv[])
+{
+	pid_t *pids;
+	double cpu0 = -1;
+	double cpu1 = -1;
+	int errflg = 0;
+	int failed = 0;
+	int status;
+	int c;
+	int i;
+
+	while ((c = getopt(argc, argv, "n:d:w:H:p:r:i:s:m:M:t:T:c:")) != EOF) {
+		switch (c) {
+			case 'n':
+				num_leaves = atoi(optarg);
+				break;
+			case 'd':
+				duration = atoi(optarg);
+				break;
+			case 'w':
+				settle = atoi(optarg);
+				break;
+			case 'H':
+				leaf_host = optarg;
+				break;
+			case 'p':
+				base_port = atoi(optarg);
+				break;
+			case 'r':
+				routers = optarg;
+				break;
+			case 'i':
+				interval[LG_IS] = atoi(optarg);
+				break;
+			case 's':
+				msg_size[LG_IS] = atoi(optarg);
+				break;
+			case 'm':
+				interval[LG_MCAST] = atoi(optarg);
+				break;
+			case 'M':
+				msg_size[LG_MCAST] = atoi(optarg);
+				break;
+			case 't':
+				interval[LG_P2P] = atoi(optarg);
+				break;
+			case 'T':
+				msg_size[LG_P2P] = atoi(optarg);
+				break;
+			case 'c':
+				router_pid = (pid_t) atoi(optarg);
+				break;
+			default:
+				errflg++;
+		}
+	}
+	for (i = 0; i < LG_NKINDS; i++) {
+		if (interval[i] < 0 || msg_size[i] < 0)
+			errflg++;
+	}
+	if (errflg || optind != argc || num_leaves < 2 || duration <= 0) {
+		fprintf(stderr, "usage: tpp_loadgen [-n leaves] [-d seconds] [-w settle seconds]\n"
+			"\t[-H leaf host] [-p base port] [-r routers]\n"
+			"\t[-i is msec] [-s is bytes] [-m mcast msec] [-M mcast bytes]\n"
+			"\t[-t p2p msec] [-T p2p bytes] [-c router pid]\n");
+		return 1;
+	}
+
+	if (set_msgdaemonname("tpp_loadgen")) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+
+	if (pbs_loadconf(0) == 0) {
+		fprintf(stderr, "%s: Configuration error\n", argv[0]);
+		return 1;
+	}
+
+	if (routers == NULL)
+		routers = pbs_conf.pbs_leaf_routers;
+	if (leaf_host == NULL)
+		leaf_host = pbs_conf.pbs_leaf_name;
+	if (leaf_host == NULL) {
+		char my_hostname[PBS_MAXHOSTNAME+1];
+
+		if (gethostname(my_hostname, (sizeof(my_hostname) - 1)) < 0) {
+			fprintf(stderr, "Failed to get hostname\n");
+			return 1;
+		}
+		leaf_host = strdup(my_hostname);
+	}
+	if (leaf_host == NULL || (leaf_host = strdup(leaf_host)) == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	/* the leaves are reached by the first of their names */
+	leaf_host[strcspn(leaf_host, ",:")] = '\0';
+
+	if (settle == -1)
+		settle = 5 + num_leaves / 200;
+
+	c = 0;
+	for (i = 0; i < LG_NKINDS; i++) {
+		if (msg_size[i] > c)
+			c = msg_size[i];
+	}
+	if ((payload = malloc(c + 1)) == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	memset(payload, 'x', c);
+	payload[c] = '\0';
+
+	/* the leaves write their counters here, for the parent to add up */
+	all_stats = mmap(NULL, sizeof(lg_stats_t) * LG_NKINDS * num_leaves,
+		PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (all_stats == MAP_FAILED) {
+		fprintf(stderr, "mmap failed, errno=%d\n", errno);
+		return 1;
+	}
+	if ((pids = calloc(num_leaves, sizeof(pid_t))) == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+
+	start_us = now_us() + settle * 1000000LL;
+	end_us = start_us + duration * 1000000LL;
+
+	fflush(stdout);
+	for (i = 0; i < num_leaves; i++) {
+		if ((pids[i] = fork()) == 0)
+			exit(run_leaf(i));
+		if (pids[i] == -1) {
+			fprintf(stderr, "fork failed for leaf %d, errno=%d\n", i, errno);
+			for (c = 0; c < i; c++)
+				kill(pids[c], SIGTERM);
+			return 1;
+		}
+	}
+
+	if (router_pid != -1) {
+		sleep_till(start_us);
+		cpu0 = proc_cpu(router_pid);
+		sleep_till(end_us);
+		cpu1 = proc_cpu(router_pid);
+		if (cpu0 < 0 || cpu1 < 0)
+			fprintf(stderr, "Could not get the cpu usage of process %d\n", (int) router_pid);
+	}
+
+	for (i = 0; i < num_leaves; i++) {
+		if (waitpid(pids[i], &status, 0) == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+			failed++;
+	}
+	if (failed)
+		fprintf(stderr, "%d leaves failed\n", failed);
+
+	report((cpu0 < 0 || cpu1 < 0) ? -1 : cpu1 - cpu0);
+	return (failed ? 1 : 0);
+}
@@ -0,0 +1,73 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2018 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# PBS Pro is free software. You can redistribute it and/or modify it under the
+# terms of the GNU Affero General Public License as published by the Free
+# Software Foundation, either version 3 of the License, or (at your option) any
+# later version.
+#
+# PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY
+# WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE.
+# See the GNU Affero General Public License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# For a copy of the commercial license terms and conditions,
+# go to: (http://www.pbspro.com/UserArea/agreement.html)
+# or contact the Altair Legal Department.
+#
+# Altair’s dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of PBS Pro and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair’s trademarks, including but not limited to "PBS™",
+# "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's
+# trademark licensing policies.
+
+from tests.functional import *
+
+
+class TestAcctRecordFormat(TestFunctional):
+    """
+    Test the layout of the job start and end accounting records
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        a = {'type': 'string', 'flag': 'h'}
+        self.server.manager(MGR_CMD_CREATE, RSC, a, id='foo_str')
+
+    def test_start_end_record_fields(self):
+        """
+        Test that the S and E records carry their fields in the expected
+        order, that a string value containing a space is quoted, and that
+        the E record is written in one piece
+        """
+        J = Job(TEST_USER, attrs={'Resource_List.foo_str': 'a b'})
+        J.set_sleep_time(1)
+        jid = self.server.submit(J)
+
+        common = 'user=%s group=\S+ (project=\S+ )?jobname=\S+ ' % \
+            TEST_USER
+        common += 'queue=workq ctime=\d+ qtime=\d+ etime=\d+ start=\d+ '
+        common += 'exec_host=\S+ exec_vnode=\S+ (Resource_List\.\S+ )*'
+        common += 'Resource_List\.foo_str="a b" (Resource_List\.\S+ )*'
+
+        self.server.accounting_match(
+            "S;%s;%s.*" % (jid, common), regexp=True)
+
+        end = 'session=\d+ (alt_id=\S+ )?end=\d+ Exit_status=0 '
+        end += '(resources_used\.\S+ +)+(eligible_time=\S+ )?run_count=1$'
+        self.server.accounting_match(
+            "E;%s;%s%s" % (jid, common, end), regexp=True)
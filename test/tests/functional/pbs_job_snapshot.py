@@ -0,0 +1,124 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2018 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# PBS Pro is free software. You can redistribute it and/or modify it under the
+# terms of the GNU Affero General Public License as published by the Free
+# Software Foundation, either version 3 of the License, or (at your option) any
+# later version.
+#
+# PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY
+# WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE.
+# See the GNU Affero General Public License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# For a copy of the commercial license terms and conditions,
+# go to: (http://www.pbspro.com/UserArea/agreement.html)
+# or contact the Altair Legal Department.
+#
+# Altair’s dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of PBS Pro and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair’s trademarks, including but not limited to "PBS™",
+# "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's
+# trademark licensing policies.
+
+from tests.functional import *
+
+
+class TestJobSnapshot(TestFunctional):
+    """
+    Test recovering jobs from the job snapshot written with
+    PBS_SERVER_SNAPSHOT set in pbs.conf
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        self.du.set_pbs_config(confs={'PBS_SERVER_SNAPSHOT': 10})
+        self.assertTrue(self.server.restart(), 'Failed to restart server')
+        self.server.manager(MGR_CMD_SET, SERVER, {'log_events': 2047,
+                                                  'scheduling': 'False'})
+        self.snapfile = os.path.join(self.server.pbs_conf['PBS_HOME'],
+                                     'server_priv', 'job_snapshot')
+
+    def submit_jobs(self, names):
+        """
+        Submit a queued job for each name, return the job ids
+        """
+        jids = []
+        for name in names:
+            j = Job(TEST_USER, attrs={ATTR_N: name})
+            jids.append(self.server.submit(j))
+        return jids
+
+    def test_snapshot_accept(self):
+        """
+        Test that the jobs are recovered from the snapshot written
+        at shutdown
+        """
+        jids = self.submit_jobs(['snap1', 'snap2', 'snap3'])
+        start = int(time.time())
+        self.server.restart()
+        self.server.log_match('3 jobs recovered from the job snapshot, '
+                              '0 missing from it read from the database',
+                              starttime=start)
+        for jid, name in zip(jids, ['snap1', 'snap2', 'snap3']):
+            self.server.expect(JOB, {'job_state': 'Q', ATTR_N: name},
+                               id=jid)
+
+    def test_snapshot_reject(self):
+        """
+        Test that a damaged snapshot is not used and that the jobs are
+        recovered from the database instead
+        """
+        jids = self.submit_jobs(['snap1'])
+        self.server.stop()
+        self.du.run_cmd(self.server.hostname,
+                        cmd=['truncate', '-s', '-8', self.snapfile],
+                        sudo=True)
+        start = int(time.time())
+        self.server.start()
+        self.server.log_match('Ignoring job snapshot .*: bad size',
+                              regexp=True, starttime=start)
+        self.server.log_match('jobs recovered from the job snapshot',
+                              starttime=start, existence=False,
+                              max_attempts=1)
+        self.server.expect(JOB, {'job_state': 'Q', ATTR_N: 'snap1'},
+                           id=jids[0])
+
+    def test_snapshot_stale(self):
+        """
+        Test that a job changed after the periodic snapshot was taken is
+        recovered from the database while the others come from the
+        snapshot, when the server is killed before it writes a new one
+        """
+        jids = self.submit_jobs(['before1', 'before2'])
+        start = int(time.time())
+        self.server.log_match('job snapshot written', starttime=start,
+                              max_attempts=30, interval=1)
+        self.server.alterjob(jids[1], {ATTR_N: 'after'})
+        self.server.stop('-KILL')
+        start = int(time.time())
+        self.server.start()
+        self.server.log_match('1 jobs recovered from the job snapshot, '
+                              '0 missing from it read from the database',
+                              starttime=start)
+        self.server.expect(JOB, {ATTR_N: 'before1'}, id=jids[0])
+        self.server.expect(JOB, {ATTR_N: 'after'}, id=jids[1])
+
+    def tearDown(self):
+        self.du.unset_pbs_config(confs=['PBS_SERVER_SNAPSHOT'])
+        self.server.restart()
+        TestFunctional.tearDown(self)
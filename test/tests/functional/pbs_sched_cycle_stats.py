@@ -0,0 +1,87 @@
+# coding: utf-8
+# Copyright (C) 1994-2018 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# PBS Pro is free software. You can redistribute it and/or modify it under the
+# terms of the GNU Affero General Public License as published by the Free
+# Software Foundation, either version 3 of the License, or (at your option) any
+# later version.
+#
+# PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY
+# WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE.
+# See the GNU Affero General Public License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# For a copy of the commercial license terms and conditions,
+# go to: (http://www.pbspro.com/UserArea/agreement.html)
+# or contact the Altair Legal Department.
+#
+# Altair’s dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of PBS Pro and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair’s trademarks, including but not limited to "PBS™",
+# "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's
+# trademark licensing policies.
+
+
+from tests.functional import *
+import json
+
+
+class TestSchedCycleStats(TestFunctional):
+    """
+    Test the per-phase scheduling cycle statistics written to
+    sched_priv/cycle_stats
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        self.stats_file = os.path.join(self.scheduler.pbs_conf['PBS_HOME'],
+                                       'sched_priv', 'cycle_stats')
+        self.du.rm(self.scheduler.hostname, self.stats_file, sudo=True,
+                   force=True)
+
+    def test_cycle_stats(self):
+        """
+        Test that a cycle which runs a job writes a line of JSON with
+        the time spent and the number of calls of each phase
+        """
+        self.scheduler.set_sched_config({'cycle_stats': 'true'})
+        j = Job(TEST_USER)
+        jid = self.server.submit(j)
+        self.server.expect(JOB, {ATTR_state: 'R'}, id=jid)
+
+        ret = self.du.cat(self.scheduler.hostname, self.stats_file,
+                          sudo=True)
+        self.assertEqual(ret['rc'], 0, 'cycle_stats file not written')
+        stats = [json.loads(line) for line in ret['out'] if line]
+        self.assertTrue(len(stats) > 0)
+        runs = [s for s in stats if s['phases']['run']['calls'] > 0]
+        self.assertTrue(len(runs) > 0, 'No cycle ran a job')
+        for phase in ['cycle', 'query', 'sort', 'node_search', 'calendar',
+                      'preempt', 'run']:
+            self.assertIn(phase, runs[-1]['phases'])
+            self.assertTrue(runs[-1]['phases'][phase]['time'] >= 0)
+        self.assertEqual(runs[-1]['phases']['cycle']['calls'], 1)
+        self.assertEqual(runs[-1]['sched'], 'default')
+
+    def test_cycle_stats_off(self):
+        """
+        Test that no statistics are written by default
+        """
+        j = Job(TEST_USER)
+        jid = self.server.submit(j)
+        self.server.expect(JOB, {ATTR_state: 'R'}, id=jid)
+        self.assertFalse(self.du.isfile(self.scheduler.hostname,
+                                        self.stats_file, sudo=True))
@@ -0,0 +1,105 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2018 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# PBS Pro is free software. You can redistribute it and/or modify it under the
+# terms of the GNU Affero General Public License as published by the Free
+# Software Foundation, either version 3 of the License, or (at your option) any
+# later version.
+#
+# PBS Pro is distributed in the hope that it will be useful, but WITHOUT ANY
+# WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE.
+# See the GNU Affero General Public License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# For a copy of the commercial license terms and conditions,
+# go to: (http://www.pbspro.com/UserArea/agreement.html)
+# or contact the Altair Legal Department.
+#
+# Altair’s dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of PBS Pro and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair’s trademarks, including but not limited to "PBS™",
+# "PBS Professional®", and "PBS Pro™" and Altair’s logos is subject to Altair's
+# trademark licensing policies.
+
+from tests.functional import *
+
+
+class TestTaskStarter(TestFunctional):
+    """
+    Test starting the tasks of multi-node jobs from pbs_task_starter
+    ($task_starter in the MoM configuration)
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        if len(self.moms) != 2:
+            self.skipTest("test requires two MoMs as input, " +
+                          "use -p moms=<mom1:mom2>")
+        self.momA = self.moms.values()[0]
+        self.momB = self.moms.values()[1]
+        for mom in [self.momA, self.momB]:
+            mom.add_config({'$task_starter': 'True'})
+        self.server.manager(MGR_CMD_SET, SERVER,
+                            {'job_history_enable': 'True'})
+        self.pbsdsh = os.path.join(self.server.pbs_conf['PBS_EXEC'],
+                                   "bin", "pbsdsh")
+
+    def submit_job(self, script):
+        """
+        Submit a job on both MoMs running the given script
+        """
+        j = Job(TEST_USER)
+        j.set_attributes({'Resource_List.select': '2',
+                          'Resource_List.place': 'scatter'})
+        j.create_script(script)
+        return self.server.submit(j)
+
+    def test_starter_runs_tasks(self):
+        """
+        Test that the tasks spawned by pbsdsh are started by
+        pbs_task_starter and that their exits end the job
+        """
+        start = int(time.time())
+        jid = self.submit_job("%s /bin/true" % self.pbsdsh)
+        self.server.expect(JOB, {'job_state': 'F', 'Exit_status': 0},
+                           id=jid, extend='x', offset=2)
+        self.momB.log_match("started pbs_task_starter", starttime=start)
+
+    def test_starter_off_with_tasks_running(self):
+        """
+        Test that when $task_starter is turned off while tasks started
+        by pbs_task_starter are running, their exits are still reported
+        and the later tasks are forked by MoM
+        """
+        script = "%s sleep 20 &\n" % self.pbsdsh
+        script += "sleep 10\n"
+        script += "%s /bin/true\n" % self.pbsdsh
+        script += "wait\n"
+        start = int(time.time())
+        jid = self.submit_job(script)
+        self.server.expect(JOB, {'job_state': 'R'}, id=jid)
+        self.momB.log_match("started pbs_task_starter", starttime=start)
+        for mom in [self.momA, self.momB]:
+            mom.unset_mom_config('$task_starter')
+        self.server.expect(JOB, {'job_state': 'F', 'Exit_status': 0},
+                           id=jid, extend='x', offset=20, interval=2)
+        self.momB.log_match("pbs_task_starter done", starttime=start)
+
+    def tearDown(self):
+        for mom in self.moms.values():
+            mom.unset_mom_config('$task_starter')
+        TestFunctional.tearDown(self)